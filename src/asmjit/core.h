@@ -2024,6 +2024,8 @@ namespace asmjit {
 #include "core/logger.h"
 #include "core/operand.h"
 #include "core/osutils.h"
+#include "core/peepholepass.h"
+#include "core/schedpass.h"
 #include "core/string.h"
 #include "core/support.h"
 #include "core/target.h"
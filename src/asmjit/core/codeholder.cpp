@@ -99,12 +99,25 @@ static void CodeHolder_resetInternal(CodeHolder* self, uint32_t resetPolicy) noe
   self->_logger = nullptr;
   self->_errorHandler = nullptr;
 
-  // Reset all sections.
+  // Reset all sections. A soft reset keeps the buffer of the first section,
+  // which is reused by the next `init()`.
+  if (resetPolicy == Globals::kResetHard && self->_cachedBuffer._data) {
+    ::free(self->_cachedBuffer._data);
+    self->_cachedBuffer = CodeBuffer {};
+  }
+
   uint32_t numSections = self->_sections.size();
   for (i = 0; i < numSections; i++) {
     Section* section = self->_sections[i];
-    if (section->_buffer.data() && !section->_buffer.isExternal())
-      ::free(section->_buffer._data);
+    if (section->_buffer.data() && !section->_buffer.isExternal()) {
+      if (i == 0 && resetPolicy == Globals::kResetSoft && !self->_cachedBuffer._data) {
+        self->_cachedBuffer._data = section->_buffer._data;
+        self->_cachedBuffer._capacity = section->_buffer._capacity;
+      }
+      else {
+        ::free(section->_buffer._data);
+      }
+    }
     section->_buffer._data = nullptr;
     section->_buffer._capacity = 0;
   }
@@ -115,15 +128,17 @@ static void CodeHolder_resetInternal(CodeHolder* self, uint32_t resetPolicy) noe
   self->_emitters.reset();
   self->_namedLabels.reset();
   self->_relocations.reset();
+  self->_patchPoints.reset();
   self->_labelEntries.reset();
   self->_sections.reset();
   self->_sectionsByOrder.reset();
 
+  self->_unresolvedLabels.reset();
   self->_unresolvedLinkCount = 0;
   self->_addressTableSection = nullptr;
   self->_addressTableEntries.reset();
 
-  allocator->reset(&self->_zone);
+  allocator->reset(&self->_zone, resetPolicy);
   self->_zone.reset(resetPolicy);
 }
 
@@ -146,7 +161,8 @@ CodeHolder::CodeHolder() noexcept
     _zone(16384 - Zone::kBlockOverhead),
     _allocator(&_zone),
     _unresolvedLinkCount(0),
-    _addressTableSection(nullptr) {}
+    _addressTableSection(nullptr),
+    _cachedBuffer() {}
 
 CodeHolder::~CodeHolder() noexcept {
   CodeHolder_resetInternal(this, Globals::kResetHard);
@@ -181,6 +197,11 @@ Error CodeHolder::init(const Environment& environment, uint64_t baseAddress) noe
     if (ASMJIT_LIKELY(section)) {
       section->_flags = Section::kFlagExec | Section::kFlagConst;
       CodeHolder_setSectionDefaultName(section, '.', 't', 'e', 'x', 't');
+
+      // Reuse the buffer kept by a soft reset.
+      section->_buffer._data = _cachedBuffer._data;
+      section->_buffer._capacity = _cachedBuffer._capacity;
+      _cachedBuffer = CodeBuffer {};
       _sections.appendUnsafe(section);
       _sectionsByOrder.appendUnsafe(section);
     }
@@ -287,6 +308,22 @@ void CodeHolder::setErrorHandler(ErrorHandler* errorHandler) noexcept {
 // [asmjit::CodeHolder - Code Buffer]
 // ============================================================================
 
+// Updates pointers used by assemblers attached to `cb` after its data has changed.
+static void CodeHolder_updateAssemblers(CodeHolder* self, CodeBuffer* cb) noexcept {
+  for (BaseEmitter* emitter : self->emitters()) {
+    if (emitter->isAssembler()) {
+      BaseAssembler* a = static_cast<BaseAssembler*>(emitter);
+      if (&a->_section->_buffer == cb) {
+        size_t offset = cb->_data ? a->offset() : size_t(0);
+
+        a->_bufferData = cb->_data;
+        a->_bufferEnd  = cb->_data + cb->_capacity;
+        a->_bufferPtr  = cb->_data + offset;
+      }
+    }
+  }
+}
+
 static Error CodeHolder_reserveInternal(CodeHolder* self, CodeBuffer* cb, size_t n) noexcept {
   uint8_t* oldData = cb->_data;
   uint8_t* newData;
@@ -303,19 +340,7 @@ static Error CodeHolder_reserveInternal(CodeHolder* self, CodeBuffer* cb, size_t
   cb->_capacity = n;
 
   // Update pointers used by assemblers, if attached.
-  for (BaseEmitter* emitter : self->emitters()) {
-    if (emitter->isAssembler()) {
-      BaseAssembler* a = static_cast<BaseAssembler*>(emitter);
-      if (&a->_section->_buffer == cb) {
-        size_t offset = a->offset();
-
-        a->_bufferData = newData;
-        a->_bufferEnd  = newData + n;
-        a->_bufferPtr  = newData + offset;
-      }
-    }
-  }
-
+  CodeHolder_updateAssemblers(self, cb);
   return kErrorOk;
 }
 
@@ -368,6 +393,32 @@ Error CodeHolder::reserveBuffer(CodeBuffer* cb, size_t n) noexcept {
   return CodeHolder_reserveInternal(this, cb, n);
 }
 
+Error CodeHolder::setExternalBuffer(CodeBuffer* cb, void* data, size_t capacity) noexcept {
+  if (!data) {
+    if (cb->isExternal()) {
+      cb->_data = nullptr;
+      cb->_size = 0;
+      cb->_capacity = 0;
+      cb->_flags = 0;
+      CodeHolder_updateAssemblers(this, cb);
+    }
+    return kErrorOk;
+  }
+
+  if (ASMJIT_UNLIKELY(cb->size() != 0))
+    return DebugUtils::errored(kErrorInvalidState);
+
+  if (cb->_data && !cb->isExternal())
+    ::free(cb->_data);
+
+  cb->_data = static_cast<uint8_t*>(data);
+  cb->_capacity = capacity;
+  cb->_flags = CodeBuffer::kFlagIsExternal | CodeBuffer::kFlagIsFixed;
+
+  CodeHolder_updateAssemblers(this, cb);
+  return kErrorOk;
+}
+
 // ============================================================================
 // [asmjit::CodeHolder - Sections]
 // ============================================================================
@@ -509,6 +560,13 @@ static uint32_t CodeHolder_hashNameAndGetSize(const char* name, size_t& nameSize
 }
 
 LabelLink* CodeHolder::newLabelLink(LabelEntry* le, uint32_t sectionId, size_t offset, intptr_t rel, const OffsetFormat& format) noexcept {
+  // A link to a label bound to another section can only be resolved by
+  // `resolveUnresolvedLinks()`, which only visits `_unresolvedLabels`.
+  if (le->isBound() && !le->_links) {
+    if (ASMJIT_UNLIKELY(_unresolvedLabels.append(&_allocator, le) != kErrorOk))
+      return nullptr;
+  }
+
   LabelLink* link = _allocator.allocT<LabelLink>();
   if (ASMJIT_UNLIKELY(!link)) return nullptr;
 
@@ -624,10 +682,15 @@ ASMJIT_API Error CodeHolder::resolveUnresolvedLinks() noexcept {
   if (!hasUnresolvedLinks())
     return kErrorOk;
 
+  // Only labels that are bound and have links are visited, links of labels
+  // that are not bound yet cannot be resolved anyway.
   Error err = kErrorOk;
-  for (LabelEntry* le : labelEntries()) {
-    if (!le->isBound())
-      continue;
+  uint32_t count = _unresolvedLabels.size();
+  uint32_t remaining = 0;
+
+  for (uint32_t i = 0; i < count; i++) {
+    LabelEntry* le = _unresolvedLabels[i];
+    ASMJIT_ASSERT(le->isBound());
 
     LabelLinkIterator link(le);
     if (link) {
@@ -667,8 +730,13 @@ ASMJIT_API Error CodeHolder::resolveUnresolvedLinks() noexcept {
         link.next();
       } while (link);
     }
+
+    // Keep labels that have links, which couldn't be resolved.
+    if (le->_links)
+      _unresolvedLabels[remaining++] = le;
   }
 
+  _unresolvedLabels.truncate(remaining);
   return err;
 }
 
@@ -730,6 +798,13 @@ ASMJIT_API Error CodeHolder::bindLabel(const Label& label, uint32_t toSectionId,
     link.resolveAndNext(this);
   }
 
+  // Links from other sections are resolved by `resolveUnresolvedLinks()`.
+  if (le->_links) {
+    Error appendErr = _unresolvedLabels.append(&_allocator, le);
+    if (ASMJIT_UNLIKELY(appendErr))
+      return appendErr;
+  }
+
   return err;
 }
 
@@ -758,6 +833,71 @@ Error CodeHolder::newRelocEntry(RelocEntry** dst, uint32_t relocType) noexcept {
   return kErrorOk;
 }
 
+// ============================================================================
+// [asmjit::CodeHolder - Patch Points]
+// ============================================================================
+
+Error CodeHolder::newPatchPoint(PatchPoint** dst, uint32_t sectionId, uint64_t offset, const OffsetFormat& format) noexcept {
+  *dst = nullptr;
+
+  if (ASMJIT_UNLIKELY(!isSectionValid(sectionId)))
+    return DebugUtils::errored(kErrorInvalidSection);
+
+  // The whole region must be already emitted and must contain the value.
+  size_t bufferSize = _sections[sectionId]->bufferSize();
+  if (ASMJIT_UNLIKELY(offset > bufferSize || bufferSize - size_t(offset) < format.regionSize() ||
+                      format.valueOffset() + format.valueSize() > format.regionSize()))
+    return DebugUtils::errored(kErrorInvalidArgument);
+
+  ASMJIT_PROPAGATE(_patchPoints.willGrow(&_allocator));
+
+  uint32_t patchPointId = _patchPoints.size();
+  if (ASMJIT_UNLIKELY(patchPointId == Globals::kInvalidId))
+    return DebugUtils::errored(kErrorTooManyRelocations);
+
+  PatchPoint* pp = _allocator.allocT<PatchPoint>();
+  if (ASMJIT_UNLIKELY(!pp))
+    return DebugUtils::errored(kErrorOutOfMemory);
+
+  pp->_id = patchPointId;
+  pp->_sectionId = sectionId;
+  pp->_offset = offset;
+  pp->_format = format;
+  _patchPoints.appendUnsafe(pp);
+
+  *dst = pp;
+  return kErrorOk;
+}
+
+Error CodeHolder::patch(uint32_t patchPointId, int64_t value) noexcept {
+  if (ASMJIT_UNLIKELY(patchPointId >= _patchPoints.size()))
+    return DebugUtils::errored(kErrorInvalidArgument);
+
+  const PatchPoint* pp = _patchPoints[patchPointId];
+  const OffsetFormat& format = pp->format();
+
+  CodeBuffer& buf = _sections[pp->sectionId()]->buffer();
+  ASMJIT_ASSERT(buf.size() - size_t(pp->offset()) >= format.regionSize());
+
+  // An unsigned value that fits into the immediate is encoded as a signed one
+  // having the same bits, which is what `writeOffset()` accepts.
+  uint32_t valueBits = format.immBitCount() + format.immDiscardLsb();
+  if (format.type() == OffsetFormat::kTypeCommon && valueBits < 64 && (uint64_t(value) >> valueBits) == 0)
+    value = int64_t(uint64_t(value) << (64 - valueBits)) >> (64 - valueBits);
+
+  uint8_t* dst = buf._data + size_t(pp->offset());
+  uint8_t saved[8];
+  memcpy(saved, dst + format.valueOffset(), format.valueSize());
+
+  if (ASMJIT_UNLIKELY(!CodeWriterUtils::clearOffset(dst, format) ||
+                      !CodeWriterUtils::writeOffset(dst, value, format))) {
+    memcpy(dst + format.valueOffset(), saved, format.valueSize());
+    return DebugUtils::errored(kErrorInvalidImmediate);
+  }
+
+  return kErrorOk;
+}
+
 // ============================================================================
 // [asmjit::BaseEmitter - Expression Evaluation]
 // ============================================================================
@@ -1106,11 +1246,175 @@ Error CodeHolder::copyFlattenedData(void* dst, size_t dstSize, uint32_t copyOpti
   return kErrorOk;
 }
 
+// ============================================================================
+// [asmjit::CodeHolder - Clone]
+// ============================================================================
+
+// Clones the expression `src` into `dst` zone, labels are mapped by their ids.
+static Error CodeHolder_cloneExpression(CodeHolder* dst, const Expression* src, Expression** out) noexcept {
+  Expression* exp = dst->_zone.newT<Expression>();
+  if (ASMJIT_UNLIKELY(!exp))
+    return DebugUtils::errored(kErrorOutOfMemory);
+
+  *exp = *src;
+  for (size_t i = 0; i < 2; i++) {
+    if (src->valueType[i] == Expression::kValueLabel)
+      exp->value[i].label = dst->_labelEntries[src->value[i].label->id()];
+    else if (src->valueType[i] == Expression::kValueExpression)
+      ASMJIT_PROPAGATE(CodeHolder_cloneExpression(dst, src->value[i].expression, &exp->value[i].expression));
+  }
+
+  *out = exp;
+  return kErrorOk;
+}
+
+static Error CodeHolder_cloneInternal(const CodeHolder* self, CodeHolder* dst) noexcept {
+  ASMJIT_PROPAGATE(dst->init(self->environment(), self->baseAddress()));
+
+  // Clone sections, the first section is always created by `init()`.
+  uint32_t numSections = self->sectionCount();
+  for (uint32_t i = 0; i < numSections; i++) {
+    const Section* src = self->_sections[i];
+    Section* section = dst->_sections[0];
+
+    if (i != 0)
+      ASMJIT_PROPAGATE(dst->newSection(&section, src->name(), SIZE_MAX, src->flags(), src->alignment(), src->order()));
+
+    section->_flags = src->_flags;
+    section->_alignment = src->_alignment;
+    section->_offset = src->_offset;
+
+    size_t size = src->bufferSize();
+    if (size) {
+      ASMJIT_PROPAGATE(dst->reserveBuffer(&section->_buffer, size));
+      memcpy(section->_buffer._data, src->_buffer._data, size);
+      section->_buffer._size = size;
+    }
+  }
+
+  if (self->_addressTableSection)
+    dst->_addressTableSection = dst->_sections[self->_addressTableSection->id()];
+
+  // Clone labels first as both label links and expressions reference them.
+  uint32_t numLabels = self->labelCount();
+  ASMJIT_PROPAGATE(dst->_labelEntries.reserve(&dst->_allocator, numLabels));
+
+  for (uint32_t i = 0; i < numLabels; i++) {
+    const LabelEntry* src = self->_labelEntries[i];
+    LabelEntry* le = dst->_allocator.allocZeroedT<LabelEntry>();
+
+    if (ASMJIT_UNLIKELY(!le))
+      return DebugUtils::errored(kErrorOutOfMemory);
+
+    le->_hashCode = src->_hashCode;
+    le->_setId(i);
+    le->_type = src->_type;
+    le->_flags = src->_flags;
+    le->_parentId = src->_parentId;
+    le->_offset = src->_offset;
+    le->_section = src->isBound() ? dst->_sections[src->section()->id()] : nullptr;
+    dst->_labelEntries.appendUnsafe(le);
+
+    if (src->hasName()) {
+      ASMJIT_PROPAGATE(le->_name.setData(&dst->_zone, src->name(), src->nameSize()));
+      dst->_namedLabels.insert(dst->allocator(), le);
+    }
+  }
+
+  for (uint32_t i = 0; i < numLabels; i++) {
+    LabelEntry* le = dst->_labelEntries[i];
+    for (const LabelLink* src = self->_labelEntries[i]->links(); src; src = src->next) {
+      LabelLink* link = dst->newLabelLink(le, src->sectionId, src->offset, src->rel, src->format);
+      if (ASMJIT_UNLIKELY(!link))
+        return DebugUtils::errored(kErrorOutOfMemory);
+      link->relocId = src->relocId;
+    }
+  }
+
+  // Clone relocations, keeping their ids as label links refer to them.
+  for (const RelocEntry* src : self->_relocations) {
+    RelocEntry* re;
+    ASMJIT_PROPAGATE(dst->newRelocEntry(&re, src->relocType()));
+
+    re->_format = src->_format;
+    re->_sourceSectionId = src->_sourceSectionId;
+    re->_targetSectionId = src->_targetSectionId;
+    re->_sourceOffset = src->_sourceOffset;
+    re->_payload = src->_payload;
+
+    if (src->relocType() == RelocEntry::kTypeExpression) {
+      Expression* exp;
+      ASMJIT_PROPAGATE(CodeHolder_cloneExpression(dst, src->payloadAsExpression(), &exp));
+      re->_payload = uint64_t(uintptr_t(exp));
+    }
+    else if (src->relocType() == RelocEntry::kTypeX64AddressEntry) {
+      ASMJIT_PROPAGATE(dst->addAddressToAddressTable(src->payload()));
+      dst->_addressTableEntries.get(src->payload())->_slot = self->_addressTableEntries.get(src->payload())->_slot;
+    }
+  }
+
+  // Virtual sizes are copied last as adding addresses to the address table
+  // above increases the virtual size of its section.
+  for (uint32_t i = 0; i < numSections; i++)
+    dst->_sections[i]->_virtualSize = self->_sections[i]->_virtualSize;
+
+  ASMJIT_PROPAGATE(dst->_patchPoints.reserve(&dst->_allocator, self->_patchPoints.size()));
+  for (const PatchPoint* src : self->_patchPoints) {
+    PatchPoint* pp = dst->_allocator.allocT<PatchPoint>();
+    if (ASMJIT_UNLIKELY(!pp))
+      return DebugUtils::errored(kErrorOutOfMemory);
+
+    *pp = *src;
+    dst->_patchPoints.appendUnsafe(pp);
+  }
+
+  return kErrorOk;
+}
+
+Error CodeHolder::cloneInto(CodeHolder* dst) const noexcept {
+  if (ASMJIT_UNLIKELY(!isInitialized()))
+    return DebugUtils::errored(kErrorNotInitialized);
+
+  if (ASMJIT_UNLIKELY(!dst || dst == this))
+    return DebugUtils::errored(kErrorInvalidArgument);
+
+  dst->reset(Globals::kResetSoft);
+
+  Error err = CodeHolder_cloneInternal(this, dst);
+  if (ASMJIT_UNLIKELY(err))
+    dst->reset(Globals::kResetSoft);
+  return err;
+}
+
 // ============================================================================
 // [asmjit::CodeHolder - Unit]
 // ============================================================================
 
 #if defined(ASMJIT_TEST)
+// Emits `labelCount` labels to `.text` like an assembler would do. Each label
+// is used by a 32-bit displacement and a relocation before it's bound.
+static void CodeHolderTest_emitLabels(CodeHolder& code, uint32_t labelCount) noexcept {
+  CodeBuffer& buf = code.textSection()->_buffer;
+  OffsetFormat format;
+  format.resetToDataValue(4);
+
+  for (uint32_t i = 0; i < labelCount; i++) {
+    LabelEntry* le;
+    RelocEntry* re;
+
+    EXPECT(code.newLabelEntry(&le) == kErrorOk);
+    EXPECT(code.newRelocEntry(&re, RelocEntry::kTypeRelToAbs) == kErrorOk);
+    EXPECT(code.growBuffer(&buf, 4) == kErrorOk);
+
+    size_t offset = buf.size();
+    memset(buf.data() + offset, 0, 4);
+    buf._size += 4;
+
+    EXPECT(code.newLabelLink(le, 0, offset, 0, format) != nullptr);
+    EXPECT(code.bindLabel(Label(le->id()), 0, buf.size()) == kErrorOk);
+  }
+}
+
 UNIT(code_holder) {
   CodeHolder code;
 
@@ -1144,6 +1448,125 @@ UNIT(code_holder) {
   EXPECT(code.sections()[3] == section3);
   EXPECT(code.sectionsByOrder()[3] == section3);
 
+  code.reset();
+
+  INFO("Verifying that a soft reset recycles all memory");
+  {
+    ZoneBlockPool::setEnabled(true);
+
+    // The first rounds allocate (kept container storage may be picked up by
+    // another container first), all rounds that follow must reuse the memory
+    // kept by the soft reset. 1000 labels need container storage that doesn't
+    // fit into ZoneAllocator slots.
+    uint8_t* textData = nullptr;
+    size_t zoneBlockAllocs = 0;
+    size_t dynamicAllocs = 0;
+
+    for (uint32_t round = 0; round < 10; round++) {
+      EXPECT(code.init(env) == kErrorOk);
+      CodeHolderTest_emitLabels(code, 1000);
+      EXPECT(!code.hasUnresolvedLinks());
+
+      if (round <= 1) {
+        textData = code.textSection()->data();
+        zoneBlockAllocs = ZoneBlockPool::statistics().missCount();
+        dynamicAllocs = code.allocator()->dynamicAllocCount();
+      }
+      else {
+        EXPECT(code.textSection()->data() == textData,
+               "Round %u reallocated the .text buffer", round);
+        EXPECT(ZoneBlockPool::statistics().missCount() == zoneBlockAllocs,
+               "Round %u allocated %zu zone blocks", round, ZoneBlockPool::statistics().missCount() - zoneBlockAllocs);
+        EXPECT(code.allocator()->dynamicAllocCount() == dynamicAllocs,
+               "Round %u allocated %zu dynamic blocks", round, code.allocator()->dynamicAllocCount() - dynamicAllocs);
+      }
+
+      code.reset(Globals::kResetSoft);
+    }
+
+    code.reset(Globals::kResetHard);
+    EXPECT(code.allocator()->dynamicAllocCount() == 0);
+  }
+
+  INFO("Verifying CodeHolder::cloneInto() and patch points");
+  {
+    // Template: a 32-bit immediate, a LA64 12-bit immediate at bit 10, and a
+    // displacement to a label bound in `.data`, which is resolved later.
+    static const uint8_t textData[] = { 0xB8, 0x00, 0x00, 0x00, 0x00, 0x03, 0x80, 0x00, 0x02, 0x00, 0x00, 0x00, 0x00 };
+    static const uint8_t dataData[] = { 0x11, 0x22, 0x33, 0x44 };
+
+    EXPECT(code.init(env) == kErrorOk);
+    CodeBuffer& text = code.textSection()->_buffer;
+    EXPECT(code.reserveBuffer(&text, sizeof(textData)) == kErrorOk);
+    memcpy(text.data(), textData, sizeof(textData));
+    text._size = sizeof(textData);
+
+    Section* dataSection;
+    EXPECT(code.newSection(&dataSection, ".data", SIZE_MAX, 0, 8) == kErrorOk);
+    EXPECT(code.reserveBuffer(&dataSection->_buffer, sizeof(dataData)) == kErrorOk);
+    memcpy(dataSection->data(), dataData, sizeof(dataData));
+    dataSection->_buffer._size = sizeof(dataData);
+
+    LabelEntry* dataLabel;
+    OffsetFormat dispFormat;
+    dispFormat.resetToDataValue(4);
+    EXPECT(code.newNamedLabelEntry(&dataLabel, "data", SIZE_MAX, Label::kTypeGlobal) == kErrorOk);
+    EXPECT(code.newLabelLink(dataLabel, 0, 9, 0, dispFormat) != nullptr);
+    EXPECT(code.bindLabel(Label(dataLabel->id()), dataSection->id(), 0) == kErrorOk);
+
+    RelocEntry* re;
+    EXPECT(code.newRelocEntry(&re, RelocEntry::kTypeAbsToAbs) == kErrorOk);
+    re->_sourceSectionId = 0;
+    re->_targetSectionId = dataSection->id();
+    re->_payload = 0x1234;
+
+    OffsetFormat imm32Format;
+    OffsetFormat imm12Format;
+    imm32Format.resetToDataValue(4);
+    imm12Format.resetToImmValue(OffsetFormat::kTypeCommon, 4, 10, 12, 0);
+
+    PatchPoint* imm32;
+    PatchPoint* imm12;
+    PatchPoint* invalid;
+    EXPECT(code.newPatchPoint(&imm32, 0, 1, imm32Format) == kErrorOk);
+    EXPECT(code.newPatchPoint(&imm12, 0, 5, imm12Format) == kErrorOk);
+    EXPECT(code.newPatchPoint(&invalid, 0, 10, imm32Format) == kErrorInvalidArgument);
+
+    CodeHolder clone;
+    for (uint32_t round = 0; round < 2; round++) {
+      EXPECT(code.cloneInto(&clone) == kErrorOk);
+      EXPECT(clone.sectionCount() == 2);
+      EXPECT(clone.labelCount() == 1);
+      EXPECT(clone.unresolvedLinkCount() == 1);
+      EXPECT(clone.relocEntries().size() == 1);
+      EXPECT(clone.relocEntry(0)->payload() == 0x1234);
+      EXPECT(clone.labelIdByName("data") == dataLabel->id());
+      EXPECT(strcmp(clone.sectionById(1)->name(), ".data") == 0);
+      EXPECT(clone.textSection()->data() != code.textSection()->data());
+      EXPECT(memcmp(clone.sectionById(1)->data(), dataData, sizeof(dataData)) == 0);
+
+      EXPECT(clone.patch(imm32->id(), 0xFFFFFFFFu) == kErrorOk);
+      EXPECT(clone.patch(imm12->id(), -1) == kErrorOk);
+      EXPECT(clone.patch(imm12->id(), 0x7FF) == kErrorOk);
+      EXPECT(clone.patch(imm12->id(), 0x1000) == kErrorInvalidImmediate);
+      EXPECT(clone.patch(2, 0) == kErrorInvalidArgument);
+
+      const uint8_t* p = clone.textSection()->data();
+      EXPECT(Support::readU32uLE(p + 1) == 0xFFFFFFFFu);
+      EXPECT(Support::readU32uLE(p + 5) == ((0x7FFu << 10) | 0x02000003u),
+             "Patching the 12-bit immediate must keep the remaining bits of the word");
+
+      clone.sectionById(1)->setOffset(16);
+      EXPECT(clone.resolveUnresolvedLinks() == kErrorOk);
+      EXPECT(!clone.hasUnresolvedLinks());
+      EXPECT(Support::readU32uLE(p + 9) == 16 - 9);
+    }
+
+    // The template itself must stay untouched.
+    EXPECT(memcmp(code.textSection()->data(), textData, sizeof(textData)) == 0);
+    EXPECT(code.unresolvedLinkCount() == 1);
+    code.reset();
+  }
 }
 #endif
 
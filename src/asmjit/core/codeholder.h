@@ -140,7 +140,7 @@ struct Expression {
 
   //! Sets the value type at `index` to \ref kValueExpression and its content to `expression`.
   inline void setValueAsExpression(size_t index, Expression* expression) noexcept {
-    valueType[index] = kValueLabel;
+    valueType[index] = kValueExpression;
     value[index].expression = expression;
   }
 };
@@ -612,6 +612,37 @@ public:
   //! \}
 };
 
+// ============================================================================
+// [asmjit::PatchPoint]
+// ============================================================================
+
+//! Patch point - location of a value encoded in a section, which can be changed
+//! by \ref CodeHolder::patch() after the code was generated.
+//!
+//! Patch points are created by \ref CodeHolder::newPatchPoint() and are cloned
+//! by \ref CodeHolder::cloneInto() together with the code, so the same id can be
+//! used to patch each clone.
+struct PatchPoint {
+  //! Patch point id.
+  uint32_t _id;
+  //! Section id where the value is encoded.
+  uint32_t _sectionId;
+  //! Offset of the patched region (relative to start of the section).
+  uint64_t _offset;
+  //! Format of the patched value.
+  OffsetFormat _format;
+
+  //! \name Accessors
+  //! \{
+
+  inline uint32_t id() const noexcept { return _id; }
+  inline uint32_t sectionId() const noexcept { return _sectionId; }
+  inline uint64_t offset() const noexcept { return _offset; }
+  inline const OffsetFormat& format() const noexcept { return _format; }
+
+  //! \}
+};
+
 // ============================================================================
 // [asmjit::CodeHolder]
 // ============================================================================
@@ -655,15 +686,21 @@ public:
   ZoneVector<LabelEntry*> _labelEntries;
   //! Relocation entries.
   ZoneVector<RelocEntry*> _relocations;
+  //! Patch points.
+  ZoneVector<PatchPoint*> _patchPoints;
   //! Label name -> LabelEntry (only named labels).
   ZoneHash<LabelEntry> _namedLabels;
 
+  //! Labels that are bound, but still have links, which were not resolved.
+  ZoneVector<LabelEntry*> _unresolvedLabels;
   //! Count of label links, which are not resolved.
   size_t _unresolvedLinkCount;
   //! Pointer to an address table section (or null if this section doesn't exist).
   Section* _addressTableSection;
   //! Address table entries.
   ZoneTree<AddressTableEntry> _addressTableEntries;
+  //! Buffer of the first section kept by a soft reset, reused by `init()`.
+  CodeBuffer _cachedBuffer;
 
   //! Options that can be used with \ref copySectionData() and \ref copyFlattenedData().
   enum CopyOptions : uint32_t {
@@ -700,8 +737,51 @@ public:
   //! Initializes CodeHolder to hold code described by code `info`.
   ASMJIT_API Error init(const Environment& environment, uint64_t baseAddress = Globals::kNoBaseAddress) noexcept;
   //! Detaches all code-generators attached and resets the `CodeHolder`.
+  //!
+  //! A soft reset keeps the memory used by the holder for the next `init()`:
+  //! zone blocks, which contain label entries, label links, relocations, and
+  //! sections, large container storage, and the buffer of `.text` section.
+  //! Code generated repeatedly by the same `CodeHolder` thus stops allocating
+  //! memory after the first rounds, if it doesn't get larger. A hard reset
+  //! releases everything.
   ASMJIT_API void reset(uint32_t resetPolicy = Globals::kResetSoft) noexcept;
 
+  //! Clones the code held by this `CodeHolder` into `dst`.
+  //!
+  //! The `dst` is soft reset and initialized to the same environment and base
+  //! address first, then sections and their data, labels, label links,
+  //! relocations, and patch points are copied, keeping their ids. Attached
+  //! emitters, logger, and error handler are not cloned. Since `dst` is soft
+  //! reset, cloning repeatedly into the same `dst` reuses its memory.
+  //!
+  //! This makes it possible to assemble a template once and to specialize its
+  //! clones by \ref patch() instead of running the assembler for each variant:
+  //!
+  //! ```
+  //! CodeHolder tmpl;
+  //! tmpl.init(rt.environment());
+  //!
+  //! x86::Assembler a(&tmpl);
+  //! a.mov(x86::eax, 0);          // B8 imm32, the immediate is the last 4 bytes.
+  //! size_t immOffset = a.offset() - 4;
+  //! a.ret();
+  //!
+  //! OffsetFormat format;
+  //! format.resetToDataValue(4);
+  //!
+  //! PatchPoint* pp;
+  //! tmpl.newPatchPoint(&pp, 0, immOffset, format);
+  //!
+  //! CodeHolder code;
+  //! tmpl.cloneInto(&code);
+  //! code.patch(pp->id(), 42);
+  //! rt.add(&fn, &code);
+  //! ```
+  //!
+  //! Returns \ref kErrorNotInitialized if this `CodeHolder` is not initialized.
+  //! If an error happens `dst` is reset.
+  ASMJIT_API Error cloneInto(CodeHolder* dst) const noexcept;
+
   //! \}
 
   //! \name Attach & Detach
@@ -792,6 +872,18 @@ public:
   //! behavior of the function is undefined.
   ASMJIT_API Error reserveBuffer(CodeBuffer* cb, size_t n) noexcept;
 
+  //! Makes `cb` use an external `data` of the given `capacity` as its buffer.
+  //!
+  //! The buffer `cb` must be empty. The external buffer is fixed, it's never
+  //! reallocated nor freed by `CodeHolder` and emitting more than `capacity`
+  //! bytes fails with \ref kErrorTooLarge. If `data` is null the current
+  //! external buffer is detached and `cb` becomes empty regardless of its
+  //! content.
+  //!
+  //! \note The buffer `cb` must be managed by `CodeHolder` - otherwise the
+  //! behavior of the function is undefined.
+  ASMJIT_API Error setExternalBuffer(CodeBuffer* cb, void* data, size_t capacity) noexcept;
+
   //! \}
 
   //! \name Sections
@@ -976,6 +1068,9 @@ public:
   //! was used as a destination in code of a different section. It's only useful
   //! to people that use multiple sections as it will do nothing if the code only
   //! contains a single section in which cross-section links are not possible.
+  //!
+  //! Only labels that are bound and still have links are visited, so the cost
+  //! is proportional to the number of such labels and not to all labels.
   ASMJIT_API Error resolveUnresolvedLinks() noexcept;
 
   //! Binds a label to a given `sectionId` and `offset` (relative to start of the section).
@@ -1003,6 +1098,37 @@ public:
 
   //! \}
 
+  //! \name Patch Points
+  //! \{
+
+  //! Tests whether the code contains patch points.
+  inline bool hasPatchPoints() const noexcept { return !_patchPoints.empty(); }
+  //! Returns array of `PatchPoint*` records.
+  inline const ZoneVector<PatchPoint*>& patchPoints() const noexcept { return _patchPoints; }
+
+  //! Returns a PatchPoint of the given `id`.
+  inline PatchPoint* patchPoint(uint32_t id) const noexcept { return _patchPoints[id]; }
+
+  //! Creates a new patch point of a value described by `format`, which is
+  //! encoded in a region at `offset` of the section `sectionId`.
+  //!
+  //! The region must be already emitted, patch points are usually created
+  //! right after the instruction that contains the value was emitted.
+  ASMJIT_API Error newPatchPoint(PatchPoint** dst, uint32_t sectionId, uint64_t offset, const OffsetFormat& format) noexcept;
+
+  //! Replaces the value of the patch point `patchPointId` by `value`.
+  //!
+  //! The value is encoded in the same way as label displacements are, except
+  //! that values of \ref OffsetFormat::kTypeCommon can be also unsigned, so
+  //! `0xFFFFFFFF` can be patched into a 32-bit immediate. Returns \ref
+  //! kErrorInvalidImmediate and keeps the previous value if `value` cannot be
+  //! encoded.
+  //!
+  //! \note Patching must happen before the code is relocated or copied.
+  ASMJIT_API Error patch(uint32_t patchPointId, int64_t value) noexcept;
+
+  //! \}
+
   //! \name Utilities
   //! \{
 
@@ -167,4 +167,52 @@ bool CodeWriterUtils::writeOffset(void* dst, int64_t offset64, const OffsetForma
   }
 }
 
+bool CodeWriterUtils::clearOffset(void* dst, const OffsetFormat& format) noexcept {
+  // All bits of the encoded value are set when encoding -1, so its encoding
+  // is a mask of the bits that `writeOffset()` would write to.
+  int64_t allOnes = int64_t(~uint64_t(0) << format.immDiscardLsb());
+  dst = static_cast<char*>(dst) + format.valueOffset();
+
+  switch (format.valueSize()) {
+    case 1: {
+      uint32_t mask;
+      if (!encodeOffset32(&mask, allOnes, format))
+        return false;
+
+      Support::writeU8(dst, uint8_t(Support::readU8(dst) & ~mask));
+      return true;
+    }
+
+    case 2: {
+      uint32_t mask;
+      if (!encodeOffset32(&mask, allOnes, format))
+        return false;
+
+      Support::writeU16uLE(dst, uint16_t(Support::readU16uLE(dst) & ~mask));
+      return true;
+    }
+
+    case 4: {
+      uint32_t mask;
+      if (!encodeOffset32(&mask, allOnes, format))
+        return false;
+
+      Support::writeU32uLE(dst, Support::readU32uLE(dst) & ~mask);
+      return true;
+    }
+
+    case 8: {
+      uint64_t mask;
+      if (!encodeOffset64(&mask, allOnes, format))
+        return false;
+
+      Support::writeU64uLE(dst, Support::readU64uLE(dst) & ~mask);
+      return true;
+    }
+
+    default:
+      return false;
+  }
+}
+
 ASMJIT_END_NAMESPACE
@@ -197,6 +197,7 @@ bool encodeOffset32(uint32_t* dst, int64_t offset64, const OffsetFormat& format)
 bool encodeOffset64(uint64_t* dst, int64_t offset64, const OffsetFormat& format) noexcept;
 
 bool writeOffset(void* dst, int64_t offset64, const OffsetFormat& format) noexcept;
+bool clearOffset(void* dst, const OffsetFormat& format) noexcept;
 
 } // {CodeWriterUtils}
 
@@ -69,7 +69,10 @@ BaseCompiler::BaseCompiler() noexcept
     _vRegZone(4096 - Zone::kBlockOverhead),
     _vRegArray(),
     _localConstPool(nullptr),
-    _globalConstPool(nullptr) {
+    _globalConstPool(nullptr),
+    _raThreadCount(1),
+    _raAllocator(kRAAllocatorBinPack),
+    _raMaxDenseLiveBits(kRAMaxDenseLiveBitsDefault) {
 
   _emitterType = uint8_t(kTypeCompiler);
   _validationFlags = uint8_t(InstAPI::kValidationFlagVirtRegs);
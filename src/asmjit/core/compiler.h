@@ -81,6 +81,22 @@ public:
   ASMJIT_NONCOPYABLE(BaseCompiler)
   typedef BaseBuilder Base;
 
+  //! Global register allocator used by the register allocation pass.
+  enum RAAllocator : uint32_t {
+    //! Bin-packing allocator with live range splitting, move coalescing, and
+    //! stack slot sharing, which favors code quality (default).
+    kRAAllocatorBinPack = 0,
+    //! Linear-scan allocator, which favors compilation speed over code quality.
+    kRAAllocatorLinearScan = 1
+  };
+
+  //! Register allocator limits.
+  enum RALimits : uint32_t {
+    //! Default maximum number of live bits of a function that are allocated
+    //! densely, see \ref setRAMaxDenseLiveBits().
+    kRAMaxDenseLiveBitsDefault = 1u << 20
+  };
+
   //! Current function.
   FuncNode* _func;
   //! Allocates `VirtReg` objects.
@@ -95,6 +111,13 @@ public:
   //! Global constant pool, flushed by `finalize()`.
   ConstPoolNode* _globalConstPool;
 
+  //! Maximum number of threads used by the register allocator.
+  uint32_t _raThreadCount;
+  //! Global register allocator, see \ref RAAllocator.
+  uint32_t _raAllocator;
+  //! Maximum number of live bits of a function that are allocated densely.
+  uint32_t _raMaxDenseLiveBits;
+
   //! \name Construction & Destruction
   //! \{
 
@@ -295,6 +318,51 @@ public:
 
   //! \}
 
+  //! \name Register Allocation
+  //! \{
+
+  //! Returns the maximum number of threads the register allocator can use to
+  //! process functions concurrently, 1 by default (serial allocation).
+  inline uint32_t raThreadCount() const noexcept { return _raThreadCount; }
+
+  //! Sets the maximum number of threads the register allocator can use to
+  //! process functions concurrently. Zero means to use all hardware threads.
+  //!
+  //! The emitted code is identical regardless of the thread count. Functions
+  //! are only processed concurrently when nothing is being logged and when
+  //! they don't share virtual registers or jump targets, otherwise the register
+  //! allocator falls back to serial allocation.
+  inline void setRAThreadCount(uint32_t count) noexcept { _raThreadCount = count; }
+
+  //! Returns the global register allocator used by the register allocation
+  //! pass, see \ref RAAllocator.
+  inline uint32_t raAllocator() const noexcept { return _raAllocator; }
+
+  //! Selects the global register allocator used by the register allocation
+  //! pass, see \ref RAAllocator.
+  //!
+  //! The linear-scan allocator assigns registers in a single pass over live
+  //! ranges sorted by their start and skips the analysis required only by
+  //! optimizations (dominators, loops, move coalescing, live range splitting,
+  //! and stack slot sharing). It's suitable for code that is executed a few
+  //! times, where compilation time matters more than code quality.
+  inline void setRAAllocator(uint32_t allocator) noexcept { _raAllocator = allocator; }
+
+  //! Returns the maximum number of live bits (reachable blocks multiplied by
+  //! virtual registers) of a function that are allocated densely.
+  inline uint32_t raMaxDenseLiveBits() const noexcept { return _raMaxDenseLiveBits; }
+
+  //! Sets the maximum number of live bits (reachable blocks multiplied by
+  //! virtual registers) of a function that are allocated densely.
+  //!
+  //! Liveness of larger functions uses sparse GEN/KILL sets and only tracks
+  //! registers that can be live across blocks, which uses less memory. The
+  //! emitted code is the same, so a low value is mostly useful for testing,
+  //! see \ref kRAMaxDenseLiveBitsDefault.
+  inline void setRAMaxDenseLiveBits(uint32_t maxBits) noexcept { _raMaxDenseLiveBits = maxBits; }
+
+  //! \}
+
 #ifndef ASMJIT_NO_DEPRECATED
   ASMJIT_DEPRECATED("alloc() has no effect, it will be removed in the future")
   inline void alloc(BaseReg&) {}
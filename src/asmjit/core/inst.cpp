@@ -161,4 +161,27 @@ Error InstAPI::queryFeatures(uint32_t arch, const BaseInst& inst, const Operand_
 }
 #endif // !ASMJIT_NO_INTROSPECTION
 
+// ============================================================================
+// [asmjit::InstAPI - QuerySchedInfo]
+// ============================================================================
+
+#ifndef ASMJIT_NO_INTROSPECTION
+Error InstAPI::querySchedInfo(uint32_t arch, const BaseInst& inst, const Operand_* operands, size_t opCount, InstSchedInfo* out) noexcept {
+  if (ASMJIT_UNLIKELY(opCount > Globals::kMaxOpCount))
+    return DebugUtils::errored(kErrorInvalidArgument);
+
+#if !defined(ASMJIT_NO_X86)
+  if (Environment::isFamilyX86(arch))
+    return x86::InstInternal::querySchedInfo(arch, inst, operands, opCount, out);
+#endif
+
+#if !defined(ASMJIT_NO_LOONG)
+  if (Environment::isFamilyLOONGARCH(arch))
+    return la64::InstInternal::querySchedInfo(arch, inst, operands, opCount, out);
+#endif
+
+  return DebugUtils::errored(kErrorInvalidArch);
+}
+#endif // !ASMJIT_NO_INTROSPECTION
+
 ASMJIT_END_NAMESPACE
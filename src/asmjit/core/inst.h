@@ -505,6 +505,68 @@ struct InstRWInfo {
   //! \}
 };
 
+// ============================================================================
+// [asmjit::InstSchedInfo]
+// ============================================================================
+
+//! Scheduling information of an instruction, used by \ref SchedPass.
+//!
+//! Register dependencies are not part of this structure, they are provided
+//! by \ref InstRWInfo. Scheduling information describes what cannot be
+//! expressed by operands and approximates the instruction's latency.
+struct InstSchedInfo {
+  //! Scheduling flags, see \ref Flags.
+  uint32_t _flags;
+  //! Approximate latency of the instruction in cycles (at least 1).
+  uint32_t _latency;
+
+  //! Scheduling flags.
+  enum Flags : uint32_t {
+    //! Instruction must stay where it is and no instruction can be moved across
+    //! it (control flow, fences, instructions with implicit operands, etc...).
+    kFlagBarrier = 0x00000001u,
+    //! Instruction reads memory, which is not described by a memory operand.
+    kFlagMemRead = 0x00000002u,
+    //! Instruction writes memory, which is not described by a memory operand.
+    kFlagMemWrite = 0x00000004u,
+    //! The first register operand is written even when \ref InstRWInfo reports
+    //! it as read only (used by architectures that don't provide complete RW
+    //! information yet).
+    kFlagWriteFirstOp = 0x00000008u
+  };
+
+  //! \name Commons
+  //! \{
+
+  //! Resets this scheduling information to no flags and latency of one cycle.
+  inline void reset() noexcept {
+    _flags = 0;
+    _latency = 1;
+  }
+
+  //! \}
+
+  //! \name Accessors
+  //! \{
+
+  //! Returns scheduling flags, see \ref Flags.
+  inline uint32_t flags() const noexcept { return _flags; }
+  //! Tests whether the scheduling information has the given `flag`.
+  inline bool hasFlag(uint32_t flag) const noexcept { return (_flags & flag) != 0; }
+  //! Adds the given `flags`.
+  inline void addFlags(uint32_t flags) noexcept { _flags |= flags; }
+
+  //! Tests whether the instruction cannot be moved, see \ref kFlagBarrier.
+  inline bool isBarrier() const noexcept { return hasFlag(kFlagBarrier); }
+
+  //! Returns the approximate latency of the instruction in cycles.
+  inline uint32_t latency() const noexcept { return _latency; }
+  //! Sets the approximate latency of the instruction to `latency` cycles.
+  inline void setLatency(uint32_t latency) noexcept { _latency = latency; }
+
+  //! \}
+};
+
 // ============================================================================
 // [asmjit::InstAPI]
 // ============================================================================
@@ -548,6 +610,9 @@ ASMJIT_API Error queryRWInfo(uint32_t arch, const BaseInst& inst, const Operand_
 
 //! Gets CPU features required by the given instruction.
 ASMJIT_API Error queryFeatures(uint32_t arch, const BaseInst& inst, const Operand_* operands, size_t opCount, BaseFeatures* out) noexcept;
+
+//! Gets scheduling information of the given instruction, see \ref InstSchedInfo.
+ASMJIT_API Error querySchedInfo(uint32_t arch, const BaseInst& inst, const Operand_* operands, size_t opCount, InstSchedInfo* out) noexcept;
 #endif // !ASMJIT_NO_INTROSPECTION
 
 } // {InstAPI}
@@ -33,6 +33,14 @@
 #include "../core/zonelist.h"
 #include "../core/zonetree.h"
 
+#include <atomic>
+
+#if defined(ASMJIT_TEST)
+  #include <chrono>
+  #include <thread>
+  #include <vector>
+#endif
+
 ASMJIT_BEGIN_NAMESPACE
 
 // ============================================================================
@@ -50,8 +58,24 @@ enum JitAllocatorConstants : uint32_t {
   //! Minimum granularity (and the default granularity for pool #0).
   kJitAllocatorBaseGranularity = 64,
 
+  //! Minimum granularity of a size class.
+  kJitAllocatorMinSizeClassGranularity = 16,
+  //! Maximum granularity of a size class.
+  kJitAllocatorMaxSizeClassGranularity = 4096,
+
   //! Maximum block size (32MB).
-  kJitAllocatorMaxBlockSize = 1024 * 1024 * 32
+  kJitAllocatorMaxBlockSize = 1024 * 1024 * 32,
+
+  //! Number of bins of a thread cache per pool (bin N caches areas of N+1 granules).
+  kJitAllocatorThreadCacheBinCount = 16,
+  //! Maximum number of allocations a single thread cache bin can hold.
+  kJitAllocatorThreadCacheBinCapacity = 8,
+  //! Number of allocations reserved at once when a thread cache bin is refilled.
+  kJitAllocatorThreadCacheRefillCount = 4,
+  //! Number of releases a thread cache can defer before it has to take the lock.
+  kJitAllocatorThreadCacheReleaseCapacity = 32,
+  //! Number of allocators a single thread can have a cache for.
+  kJitAllocatorThreadCacheSlotCount = 8
 };
 
 static inline uint32_t JitAllocator_defaultFillPattern() noexcept {
@@ -71,6 +95,7 @@ template<typename T, uint32_t B>
 class BitVectorRangeIterator {
 public:
   const T* _ptr;
+  const T* _summary;
   size_t _idx;
   size_t _end;
   T _bitWord;
@@ -82,15 +107,20 @@ public:
     init(data, numBitWords);
   }
 
-  ASMJIT_INLINE BitVectorRangeIterator(const T* data, size_t numBitWords, size_t start, size_t end) noexcept {
-    init(data, numBitWords, start, end);
+  ASMJIT_INLINE BitVectorRangeIterator(const T* data, size_t numBitWords, size_t start, size_t end, const T* summary = nullptr) noexcept {
+    init(data, numBitWords, start, end, summary);
   }
 
   ASMJIT_INLINE void init(const T* data, size_t numBitWords) noexcept {
     init(data, numBitWords, 0, numBitWords * kBitWordSize);
   }
 
-  ASMJIT_INLINE void init(const T* data, size_t numBitWords, size_t start, size_t end) noexcept {
+  //! Initializes the iterator to iterate `[start, end)` range of `data`.
+  //!
+  //! The optional `summary` is a bit-vector having a bit per each word of `data`,
+  //! where a set bit means that the word doesn't contain any bits of interest
+  //! (`B`). If provided it's used to skip such words without visiting them.
+  ASMJIT_INLINE void init(const T* data, size_t numBitWords, size_t start, size_t end, const T* summary = nullptr) noexcept {
     ASMJIT_ASSERT(numBitWords >= (end + kBitWordSize - 1) / kBitWordSize);
     DebugUtils::unused(numBitWords);
 
@@ -102,18 +132,49 @@ public:
       bitWord = (*ptr ^ kXorMask) & (Support::allOnes<T>() << (start % kBitWordSize));
 
     _ptr = ptr;
+    _summary = summary;
     _idx = idx;
     _end = end;
     _bitWord = bitWord;
   }
 
+  //! Returns the index of the first word at or after `wordIndex` that is not marked in `_summary`.
+  ASMJIT_INLINE size_t _nextUnmarkedWord(size_t wordIndex, size_t wordEnd) const noexcept {
+    // The summary has no word past `wordEnd`, which happens when the number of
+    // words is a multiple of `kBitWordSize`.
+    if (wordIndex >= wordEnd)
+      return wordEnd;
+
+    size_t summaryIndex = wordIndex / kBitWordSize;
+    T summaryWord = ~_summary[summaryIndex] & (Support::allOnes<T>() << (wordIndex % kBitWordSize));
+
+    while (summaryWord == 0) {
+      if (++summaryIndex * kBitWordSize >= wordEnd)
+        return wordEnd;
+      summaryWord = ~_summary[summaryIndex];
+    }
+
+    return Support::min<size_t>(summaryIndex * kBitWordSize + Support::ctz(summaryWord), wordEnd);
+  }
+
   ASMJIT_INLINE bool nextRange(size_t* rangeStart, size_t* rangeEnd, size_t rangeHint = std::numeric_limits<size_t>::max()) noexcept {
     // Skip all empty BitWords.
     while (_bitWord == 0) {
-      _idx += kBitWordSize;
+      if (_summary) {
+        size_t wordIndex = _idx / kBitWordSize;
+        size_t nextIndex = _nextUnmarkedWord(wordIndex + 1, (_end + kBitWordSize - 1) / kBitWordSize);
+
+        _ptr += nextIndex - wordIndex;
+        _idx = nextIndex * kBitWordSize;
+      }
+      else {
+        _ptr++;
+        _idx += kBitWordSize;
+      }
+
       if (_idx >= _end)
         return false;
-      _bitWord = (*++_ptr) ^ kXorMask;
+      _bitWord = (*_ptr) ^ kXorMask;
     }
 
     size_t i = Support::ctz(_bitWord);
@@ -163,13 +224,22 @@ class JitAllocatorPool {
 public:
   ASMJIT_NONCOPYABLE(JitAllocatorPool)
 
-  inline JitAllocatorPool(uint32_t granularity) noexcept
+  enum Flags : uint32_t {
+    //! Each allocation gets its own block, which is released as soon as the allocation is released.
+    kFlagDirect = 0x00000001u
+  };
+
+  inline JitAllocatorPool(uint32_t granularity, uint32_t blockSize, uint32_t maxSize, uint32_t flags) noexcept
     : blocks(),
       cursor(nullptr),
       blockCount(0),
       granularity(uint16_t(granularity)),
       granularityLog2(uint8_t(Support::ctz(granularity))),
       emptyBlockCount(0),
+      requestedLargePageBlockCount(0),
+      blockSize(blockSize),
+      maxSize(maxSize),
+      flags(flags),
       totalAreaSize(0),
       totalAreaUsed(0),
       totalOverheadBytes(0) {}
@@ -178,11 +248,14 @@ public:
     blocks.reset();
     cursor = nullptr;
     blockCount = 0;
+    requestedLargePageBlockCount = 0;
     totalAreaSize = 0;
     totalAreaUsed = 0;
     totalOverheadBytes = 0;
   }
 
+  inline bool isDirect() const noexcept { return (flags & kFlagDirect) != 0; }
+
   inline size_t byteSizeFromAreaSize(uint32_t areaSize) const noexcept { return size_t(areaSize) * granularity; }
   inline uint32_t areaSizeFromByteSize(size_t size) const noexcept { return uint32_t((size + granularity - 1) >> granularityLog2); }
 
@@ -204,6 +277,14 @@ public:
   uint8_t granularityLog2;
   //! Count of empty blocks (either 0 or 1 as we won't keep more blocks empty).
   uint8_t emptyBlockCount;
+  //! Count of blocks allocated with large pages requested.
+  uint32_t requestedLargePageBlockCount;
+  //! Base size of a block of this pool.
+  uint32_t blockSize;
+  //! Maximum size of an allocation served by this pool (only used by size classes).
+  uint32_t maxSize;
+  //! Pool flags, see \ref Flags.
+  uint32_t flags;
 
   //! Number of bits reserved across all blocks.
   size_t totalAreaSize;
@@ -217,6 +298,29 @@ public:
 // [asmjit::JitAllocator - Block]
 // ============================================================================
 
+//! Node that indexes a dual-mapped block by its Read+Write pointer, see
+//! `JitAllocatorPrivateImpl::rwTree`.
+class JitAllocatorBlockRWNode : public ZoneTreeNodeT<JitAllocatorBlockRWNode> {
+public:
+  ASMJIT_NONCOPYABLE(JitAllocatorBlockRWNode)
+
+  //! Block that owns this node.
+  JitAllocatorBlock* _block;
+
+  inline explicit JitAllocatorBlockRWNode(JitAllocatorBlock* block) noexcept
+    : ZoneTreeNodeT(),
+      _block(block) {}
+
+  inline JitAllocatorBlock* block() const noexcept { return _block; }
+
+  inline bool operator<(const JitAllocatorBlockRWNode& other) const noexcept;
+  inline bool operator>(const JitAllocatorBlockRWNode& other) const noexcept;
+
+  // Queries blocks by `key`, which must be in `[RWPtr, RWPtr + BlockSize)` range.
+  inline bool operator<(const uint8_t* key) const noexcept;
+  inline bool operator>(const uint8_t* key) const noexcept;
+};
+
 class JitAllocatorBlock : public ZoneTreeNodeT<JitAllocatorBlock>,
                           public ZoneListNode<JitAllocatorBlock> {
 public:
@@ -228,7 +332,11 @@ public:
     //! Block is dirty (largestUnusedArea, searchStart, searchEnd).
     kFlagDirty = 0x00000002u,
     //! Block is dual-mapped.
-    kFlagDualMapped = 0x00000004u
+    kFlagDualMapped = 0x00000004u,
+    //! Block was allocated with large pages requested.
+    kFlagLargePages = 0x00000008u,
+    //! Block is being emptied by `JitAllocator::compact()`, nothing can be allocated in it.
+    kFlagCompacting = 0x00000010u
   };
 
   //! Link to the pool that owns this block.
@@ -238,6 +346,8 @@ public:
   VirtMem::DualMapping _mapping;
   //! Virtual memory size (block size) [bytes].
   size_t _blockSize;
+  //! Node in `JitAllocatorPrivateImpl::rwTree` (only used by dual-mapped blocks).
+  JitAllocatorBlockRWNode _rwNode;
 
   //! Block flags.
   uint32_t _flags;
@@ -251,11 +361,22 @@ public:
   uint32_t _searchStart;
   //! End of a search range (for unused bits).
   uint32_t _searchEnd;
+  //! End of the area that was made executable by `JitAllocator::protectPending()` (aligned to page size).
+  //!
+  //! Area below is never reused until the whole block is released, as it cannot be written.
+  uint32_t _protectedEnd;
+  //! End of the highest area allocated since the last `JitAllocator::protectPending()`.
+  uint32_t _pendingEnd;
 
   //! Used bit-vector (0 = unused, 1 = used).
   Support::BitWord* _usedBitVector;
   //! Stop bit-vector (0 = don't care, 1 = stop).
   Support::BitWord* _stopBitVector;
+  //! Summary of `_usedBitVector` having a bit per each of its words (0 = has unused bits, 1 = fully used).
+  //!
+  //! Used to skip fully used words when searching for an unused area, which
+  //! makes the search in large and mostly used blocks much faster.
+  Support::BitWord* _fullBitVector;
 
   inline JitAllocatorBlock(
     JitAllocatorPool* pool,
@@ -264,19 +385,24 @@ public:
     uint32_t blockFlags,
     Support::BitWord* usedBitVector,
     Support::BitWord* stopBitVector,
+    Support::BitWord* fullBitVector,
     uint32_t areaSize) noexcept
     : ZoneTreeNodeT(),
       _pool(pool),
       _mapping(mapping),
       _blockSize(blockSize),
+      _rwNode(this),
       _flags(blockFlags),
       _areaSize(areaSize),
       _areaUsed(0),
       _largestUnusedArea(areaSize),
       _searchStart(0),
       _searchEnd(areaSize),
+      _protectedEnd(0),
+      _pendingEnd(0),
       _usedBitVector(usedBitVector),
-      _stopBitVector(stopBitVector) {}
+      _stopBitVector(stopBitVector),
+      _fullBitVector(fullBitVector) {}
 
   inline JitAllocatorPool* pool() const noexcept { return _pool; }
 
@@ -302,16 +428,29 @@ public:
     _pool->totalAreaUsed -= value;
   }
 
+  //! Updates `_fullBitVector` of all words of `_usedBitVector` that intersect `[areaStart, areaEnd)`.
+  inline void updateFullBitVector(uint32_t areaStart, uint32_t areaEnd) noexcept {
+    using Support::kBitWordSizeInBits;
+
+    uint32_t wordStart = areaStart / kBitWordSizeInBits;
+    uint32_t wordEnd = (areaEnd + kBitWordSizeInBits - 1) / kBitWordSizeInBits;
+
+    for (uint32_t i = wordStart; i < wordEnd; i++)
+      Support::bitVectorSetBit(_fullBitVector, i, _usedBitVector[i] == Support::allOnes<Support::BitWord>());
+  }
+
   inline void markAllocatedArea(uint32_t allocatedAreaStart, uint32_t allocatedAreaEnd) noexcept {
     uint32_t allocatedAreaSize = allocatedAreaEnd - allocatedAreaStart;
 
     // Mark the newly allocated space as occupied and also the sentinel.
     Support::bitVectorFill(_usedBitVector, allocatedAreaStart, allocatedAreaSize);
     Support::bitVectorSetBit(_stopBitVector, allocatedAreaEnd - 1, true);
+    updateFullBitVector(allocatedAreaStart, allocatedAreaEnd);
 
     // Update search region and statistics.
     _pool->totalAreaUsed += allocatedAreaSize;
     _areaUsed += allocatedAreaSize;
+    _pendingEnd = Support::max(_pendingEnd, allocatedAreaEnd);
 
     if (areaAvailable() == 0) {
       _searchStart = _areaSize;
@@ -331,15 +470,20 @@ public:
   inline void markReleasedArea(uint32_t releasedAreaStart, uint32_t releasedAreaEnd) noexcept {
     uint32_t releasedAreaSize = releasedAreaEnd - releasedAreaStart;
 
-    // Update the search region and statistics.
+    // Update the search region and statistics, protected area is not searched.
+    bool isReusable = releasedAreaEnd > _protectedEnd;
     _pool->totalAreaUsed -= releasedAreaSize;
     _areaUsed -= releasedAreaSize;
-    _searchStart = Support::min(_searchStart, releasedAreaStart);
-    _searchEnd = Support::max(_searchEnd, releasedAreaEnd);
+
+    if (isReusable) {
+      _searchStart = Support::min(_searchStart, releasedAreaStart);
+      _searchEnd = Support::max(_searchEnd, releasedAreaEnd);
+    }
 
     // Unmark occupied bits and also the sentinel.
     Support::bitVectorClear(_usedBitVector, releasedAreaStart, releasedAreaSize);
     Support::bitVectorSetBit(_stopBitVector, releasedAreaEnd - 1, false);
+    updateFullBitVector(releasedAreaStart, releasedAreaEnd);
 
     if (areaUsed() == 0) {
       _searchStart = 0;
@@ -348,7 +492,7 @@ public:
       addFlags(kFlagEmpty);
       clearFlags(kFlagDirty);
     }
-    else {
+    else if (isReusable) {
       addFlags(kFlagDirty);
     }
   }
@@ -361,18 +505,24 @@ public:
     ASMJIT_ASSERT(shrunkAreaStart != 0);
     ASMJIT_ASSERT(shrunkAreaSize != 0);
 
-    // Update the search region and statistics.
+    // Update the search region and statistics, protected area is not searched.
+    bool isReusable = shrunkAreaEnd > _protectedEnd;
     _pool->totalAreaUsed -= shrunkAreaSize;
     _areaUsed -= shrunkAreaSize;
-    _searchStart = Support::min(_searchStart, shrunkAreaStart);
-    _searchEnd = Support::max(_searchEnd, shrunkAreaEnd);
+
+    if (isReusable) {
+      _searchStart = Support::min(_searchStart, shrunkAreaStart);
+      _searchEnd = Support::max(_searchEnd, shrunkAreaEnd);
+    }
 
     // Unmark the released space and move the sentinel.
     Support::bitVectorClear(_usedBitVector, shrunkAreaStart, shrunkAreaSize);
     Support::bitVectorSetBit(_stopBitVector, shrunkAreaEnd - 1, false);
     Support::bitVectorSetBit(_stopBitVector, shrunkAreaStart - 1, true);
+    updateFullBitVector(shrunkAreaStart, shrunkAreaEnd);
 
-    addFlags(kFlagDirty);
+    if (isReusable)
+      addFlags(kFlagDirty);
   }
 
   // RBTree default CMP uses '<' and '>' operators.
@@ -384,6 +534,94 @@ public:
   inline bool operator>(const uint8_t* key) const noexcept { return roPtr() > key; }
 };
 
+inline bool JitAllocatorBlockRWNode::operator<(const JitAllocatorBlockRWNode& other) const noexcept { return _block->rwPtr() < other._block->rwPtr(); }
+inline bool JitAllocatorBlockRWNode::operator>(const JitAllocatorBlockRWNode& other) const noexcept { return _block->rwPtr() > other._block->rwPtr(); }
+
+inline bool JitAllocatorBlockRWNode::operator<(const uint8_t* key) const noexcept { return _block->rwPtr() + _block->blockSize() <= key; }
+inline bool JitAllocatorBlockRWNode::operator>(const uint8_t* key) const noexcept { return _block->rwPtr() > key; }
+
+// ============================================================================
+// [asmjit::JitAllocator - ThreadCache]
+// ============================================================================
+
+class JitAllocatorPrivateImpl;
+
+//! Cache of allocations owned by a single thread, used when
+//! `JitAllocator::kOptionUseThreadCaches` is set.
+//!
+//! The cache is referenced by both the allocator (to be able to wipe it out)
+//! and the thread-local directory of the thread that owns it. Whichever side
+//! detaches last is responsible for freeing it.
+class JitAllocatorThreadCache : public ZoneListNode<JitAllocatorThreadCache> {
+public:
+  ASMJIT_NONCOPYABLE(JitAllocatorThreadCache)
+
+  enum State : uint32_t {
+    //! Cache is referenced by both the allocator and the owning thread.
+    kStateAttached = 0,
+    //! The owning thread has terminated, the allocator should reclaim the cache.
+    kStateThreadDetached = 1,
+    //! The allocator has been destroyed, the owning thread should free the cache.
+    kStateAllocatorDetached = 2
+  };
+
+  //! Allocations of the same size (in granules) cached by a thread.
+  struct Bin {
+    uint32_t count;
+    void* roPtrs[kJitAllocatorThreadCacheBinCapacity];
+    void* rwPtrs[kJitAllocatorThreadCacheBinCapacity];
+  };
+
+  //! Allocator that owns this cache.
+  JitAllocatorPrivateImpl* _impl;
+  //! Cache state, see \ref State.
+  std::atomic<uint32_t> _state;
+  //! Number of deferred releases.
+  uint32_t _releaseCount;
+  //! Deferred releases (RO pointers).
+  void* _releaseQueue[kJitAllocatorThreadCacheReleaseCapacity];
+  //! Bins of all pools (`poolCount * kJitAllocatorThreadCacheBinCount`).
+  Bin* _bins;
+
+  inline JitAllocatorThreadCache(JitAllocatorPrivateImpl* impl, Bin* bins) noexcept
+    : ZoneListNode(),
+      _impl(impl),
+      _state(kStateAttached),
+      _releaseCount(0),
+      _bins(bins) {}
+
+  inline JitAllocatorPrivateImpl* impl() const noexcept { return _impl; }
+  inline uint32_t state() const noexcept { return _state.load(std::memory_order_acquire); }
+
+  //! Detaches the cache from one side and returns true if the other side has been
+  //! already detached, which means that the caller is responsible for freeing it.
+  inline bool detach(uint32_t state) noexcept { return _state.exchange(state, std::memory_order_acq_rel) != kStateAttached; }
+
+  inline Bin& bin(size_t poolId, uint32_t areaSize) noexcept {
+    ASMJIT_ASSERT(areaSize != 0 && areaSize <= kJitAllocatorThreadCacheBinCount);
+    return _bins[poolId * kJitAllocatorThreadCacheBinCount + areaSize - 1];
+  }
+};
+
+//! Thread-local directory of thread caches, one per allocator.
+//!
+//! The destructor runs when the thread terminates and detaches all caches the
+//! thread still has so their allocators can reclaim them.
+class JitAllocatorThreadCacheDirectory {
+public:
+  JitAllocatorThreadCache* _caches[kJitAllocatorThreadCacheSlotCount];
+
+  inline ~JitAllocatorThreadCacheDirectory() noexcept {
+    for (size_t i = 0; i < kJitAllocatorThreadCacheSlotCount; i++) {
+      JitAllocatorThreadCache* cache = _caches[i];
+      if (cache && cache->detach(JitAllocatorThreadCache::kStateThreadDetached))
+        ::free(cache);
+    }
+  }
+};
+
+static thread_local JitAllocatorThreadCacheDirectory JitAllocatorThreadCache_directory;
+
 // ============================================================================
 // [asmjit::JitAllocator - PrivateImpl]
 // ============================================================================
@@ -400,13 +638,19 @@ public:
   mutable Lock lock;
   //! System page size (also a minimum block size).
   uint32_t pageSize;
+  //! Large page size (only used with `JitAllocator::kOptionUseLargePages`, zero if not supported).
+  size_t largePageSize;
 
   //! Blocks from all pools in RBTree.
   ZoneTree<JitAllocatorBlock> tree;
+  //! Dual-mapped blocks from all pools in RBTree keyed by their Read+Write pointers.
+  ZoneTree<JitAllocatorBlockRWNode> rwTree;
   //! Allocator pools.
   JitAllocatorPool* pools;
   //! Number of allocator pools.
   size_t poolCount;
+  //! Thread caches (only used with `JitAllocator::kOptionUseThreadCaches`).
+  ZoneList<JitAllocatorThreadCache> threadCaches;
 };
 
 static const JitAllocator::Impl JitAllocatorImpl_none {};
@@ -427,10 +671,18 @@ static inline JitAllocatorPrivateImpl* JitAllocatorImpl_new(const JitAllocator::
   uint32_t granularity = params->granularity;
   uint32_t fillPattern = params->fillPattern;
 
-  // Setup pool count to [1..3].
+  // Setup pool count to [1..3], or to the number of size classes.
   size_t poolCount = 1;
-  if (options & JitAllocator::kOptionUseMultiplePools)
-    poolCount = kJitAllocatorMultiPoolCount;;
+  if (options & JitAllocator::kOptionUseSizeClasses) {
+    poolCount = params->sizeClassCount;
+    if (poolCount == 0 || poolCount > JitAllocator::kMaxSizeClassCount) {
+      options &= ~JitAllocator::kOptionUseSizeClasses;
+      poolCount = 1;
+    }
+  }
+
+  if ((options & JitAllocator::kOptionUseMultiplePools) && !(options & JitAllocator::kOptionUseSizeClasses))
+    poolCount = kJitAllocatorMultiPoolCount;
 
   // Setup block size [64kB..256MB].
   if (blockSize < 64 * 1024 || blockSize > 256 * 1024 * 1024 || !Support::isPowerOf2(blockSize))
@@ -440,6 +692,14 @@ static inline JitAllocatorPrivateImpl* JitAllocatorImpl_new(const JitAllocator::
   if (granularity < 64 || granularity > 256 || !Support::isPowerOf2(granularity))
     granularity = kJitAllocatorBaseGranularity;
 
+  // Dual mapping never maps memory as RWX, so there is nothing to protect. Thread caches would hand out
+  // memory that could have been protected in the meantime, so they cannot be used with protection.
+  if (options & JitAllocator::kOptionUseDualMapping)
+    options &= ~JitAllocator::kOptionUseBatchedProtection;
+
+  if (options & JitAllocator::kOptionUseBatchedProtection)
+    options &= ~JitAllocator::kOptionUseThreadCaches;
+
   // Setup fill-pattern.
   if (!(options & JitAllocator::kOptionCustomFillPattern))
     fillPattern = JitAllocator_defaultFillPattern();
@@ -457,9 +717,37 @@ static inline JitAllocatorPrivateImpl* JitAllocatorImpl_new(const JitAllocator::
   impl->granularity = granularity;
   impl->fillPattern = fillPattern;
   impl->pageSize = vmInfo.pageSize;
+  impl->largePageSize = (options & JitAllocator::kOptionUseLargePages) ? VirtMem::largePageSize() : size_t(0);
+
+  if (options & JitAllocator::kOptionUseSizeClasses) {
+    // Each size class has its own pool, the base granularity is the smallest granularity of all classes.
+    impl->granularity = kJitAllocatorMaxSizeClassGranularity;
+
+    for (size_t poolId = 0; poolId < poolCount; poolId++) {
+      const JitAllocator::SizeClass& sizeClass = params->sizeClasses[poolId];
+
+      uint32_t classGranularity = sizeClass.granularity;
+      if (classGranularity < kJitAllocatorMinSizeClassGranularity || classGranularity > kJitAllocatorMaxSizeClassGranularity || !Support::isPowerOf2(classGranularity))
+        classGranularity = granularity;
 
-  for (size_t poolId = 0; poolId < poolCount; poolId++)
-    new(&pools[poolId]) JitAllocatorPool(granularity << poolId);
+      uint32_t classBlockSize = sizeClass.blockSize;
+      if (classBlockSize < vmInfo.pageSize || classBlockSize > 256 * 1024 * 1024 || !Support::isPowerOf2(classBlockSize))
+        classBlockSize = blockSize;
+
+      uint32_t classMaxSize = sizeClass.maxSize ? sizeClass.maxSize : std::numeric_limits<uint32_t>::max();
+      uint32_t classFlags = 0;
+
+      if (sizeClass.flags & JitAllocator::kSizeClassDirect)
+        classFlags |= JitAllocatorPool::kFlagDirect;
+
+      impl->granularity = Support::min(impl->granularity, classGranularity);
+      new(&pools[poolId]) JitAllocatorPool(classGranularity, classBlockSize, classMaxSize, classFlags);
+    }
+  }
+  else {
+    for (size_t poolId = 0; poolId < poolCount; poolId++)
+      new(&pools[poolId]) JitAllocatorPool(granularity << poolId, blockSize, std::numeric_limits<uint32_t>::max(), 0);
+  }
 
   return impl;
 }
@@ -470,6 +758,15 @@ static inline void JitAllocatorImpl_destroy(JitAllocatorPrivateImpl* impl) noexc
 }
 
 static inline size_t JitAllocatorImpl_sizeToPoolId(const JitAllocatorPrivateImpl* impl, size_t size) noexcept {
+  // Size classes are checked in order, sizes that don't fit any class go to the last one.
+  if (impl->options & JitAllocator::kOptionUseSizeClasses) {
+    size_t lastPoolId = impl->poolCount - 1;
+    for (size_t poolId = 0; poolId < lastPoolId; poolId++)
+      if (size <= impl->pools[poolId].maxSize)
+        return poolId;
+    return lastPoolId;
+  }
+
   size_t poolId = impl->poolCount - 1;
   size_t granularity = size_t(impl->granularity) << poolId;
 
@@ -488,18 +785,35 @@ static inline size_t JitAllocatorImpl_bitVectorSizeToByteSize(uint32_t areaSize)
   return ((areaSize + kBitWordSizeInBits - 1u) / kBitWordSizeInBits) * sizeof(Support::BitWord);
 }
 
-static inline size_t JitAllocatorImpl_calculateIdealBlockSize(JitAllocatorPrivateImpl* impl, JitAllocatorPool* pool, size_t allocationSize) noexcept {
-  JitAllocatorBlock* last = pool->blocks.last();
-  size_t blockSize = last ? last->blockSize() : size_t(impl->blockSize);
+// Returns the size of all bit-vectors (used, stop, and full) required by a block of `areaSize`.
+static inline size_t JitAllocatorImpl_blockBitVectorsByteSize(uint32_t areaSize) noexcept {
+  using Support::kBitWordSizeInBits;
+  uint32_t numBitWords = (areaSize + kBitWordSizeInBits - 1u) / kBitWordSizeInBits;
+  return JitAllocatorImpl_bitVectorSizeToByteSize(areaSize) * 2u + JitAllocatorImpl_bitVectorSizeToByteSize(numBitWords);
+}
 
-  if (blockSize < kJitAllocatorMaxBlockSize)
-    blockSize *= 2u;
+static inline size_t JitAllocatorImpl_calculateIdealBlockSize(JitAllocatorPrivateImpl* impl, JitAllocatorPool* pool, size_t allocationSize) noexcept {
+  size_t blockSize;
 
-  if (allocationSize > blockSize) {
-    blockSize = Support::alignUp(allocationSize, impl->blockSize);
+  if (pool->isDirect()) {
+    // Blocks of direct pools are not shared, so they only need to fit the allocation.
+    blockSize = Support::alignUp<size_t>(allocationSize, impl->pageSize);
     if (ASMJIT_UNLIKELY(blockSize < allocationSize))
       return 0; // Overflown.
   }
+  else {
+    JitAllocatorBlock* last = pool->blocks.last();
+    blockSize = last ? last->blockSize() : size_t(pool->blockSize);
+
+    if (blockSize < kJitAllocatorMaxBlockSize)
+      blockSize *= 2u;
+
+    if (allocationSize > blockSize) {
+      blockSize = Support::alignUp<size_t>(allocationSize, pool->blockSize);
+      if (ASMJIT_UNLIKELY(blockSize < allocationSize))
+        return 0; // Overflown.
+    }
+  }
 
   return blockSize;
 }
@@ -512,6 +826,24 @@ ASMJIT_FAVOR_SPEED static void JitAllocatorImpl_fillPattern(void* mem, uint32_t
     p[i] = pattern;
 }
 
+// Maps virtual memory of a block of `blockSize`.
+static Error JitAllocatorImpl_mapBlock(JitAllocatorPrivateImpl* impl, VirtMem::DualMapping* virtMem, size_t blockSize, uint32_t vmFlags) noexcept {
+  if (impl->options & JitAllocator::kOptionUseDualMapping)
+    return VirtMem::allocDualMapping(virtMem, blockSize, vmFlags);
+
+  ASMJIT_PROPAGATE(VirtMem::alloc(&virtMem->ro, blockSize, vmFlags));
+  virtMem->rw = virtMem->ro;
+  return kErrorOk;
+}
+
+// Unmaps virtual memory mapped by `JitAllocatorImpl_mapBlock()`.
+static void JitAllocatorImpl_unmapBlock(JitAllocatorPrivateImpl* impl, VirtMem::DualMapping* virtMem, size_t blockSize) noexcept {
+  if (impl->options & JitAllocator::kOptionUseDualMapping)
+    VirtMem::releaseDualMapping(virtMem, blockSize);
+  else
+    VirtMem::release(virtMem->ro, blockSize);
+}
+
 // Allocate a new `JitAllocatorBlock` for the given `blockSize`.
 //
 // NOTE: The block doesn't have `kFlagEmpty` flag set, because the new block
@@ -520,33 +852,44 @@ static JitAllocatorBlock* JitAllocatorImpl_newBlock(JitAllocatorPrivateImpl* imp
   using Support::BitWord;
   using Support::kBitWordSizeInBits;
 
-  uint32_t areaSize = uint32_t((blockSize + pool->granularity - 1) >> pool->granularityLog2);
-  uint32_t numBitWords = (areaSize + kBitWordSizeInBits - 1u) / kBitWordSizeInBits;
+  uint32_t vmFlags = (impl->options & JitAllocator::kOptionUseBatchedProtection) ? VirtMem::kAccessRW : VirtMem::kAccessRWX;
+  uint32_t blockFlags = (impl->options & JitAllocator::kOptionUseDualMapping) ? uint32_t(JitAllocatorBlock::kFlagDualMapped) : uint32_t(0);
 
-  JitAllocatorBlock* block = static_cast<JitAllocatorBlock*>(::malloc(sizeof(JitAllocatorBlock)));
-  BitWord* bitWords = nullptr;
   VirtMem::DualMapping virtMem {};
   Error err = kErrorOutOfMemory;
 
-  if (block != nullptr)
-    bitWords = static_cast<BitWord*>(::malloc(size_t(numBitWords) * 2 * sizeof(BitWord)));
-
-  uint32_t blockFlags = 0;
-  if (bitWords != nullptr) {
-    if (impl->options & JitAllocator::kOptionUseDualMapping) {
-      err = VirtMem::allocDualMapping(&virtMem, blockSize, VirtMem::kAccessRWX);
-      blockFlags |= JitAllocatorBlock::kFlagDualMapped;
-    }
-    else {
-      err = VirtMem::alloc(&virtMem.ro, blockSize, VirtMem::kAccessRWX);
-      virtMem.rw = virtMem.ro;
+  // Blocks backed by large pages must be a multiple of the large page size.
+  // If large pages are not available the block keeps its original size, as
+  // rounding it up would only waste address space.
+  if (impl->largePageSize) {
+    size_t lpBlockSize = Support::alignUp(blockSize, impl->largePageSize);
+    if (lpBlockSize >= blockSize) {
+      err = JitAllocatorImpl_mapBlock(impl, &virtMem, lpBlockSize, vmFlags | VirtMem::kMMapLargePages);
+      if (err == kErrorOk) {
+        blockSize = lpBlockSize;
+        blockFlags |= JitAllocatorBlock::kFlagLargePages;
+      }
     }
   }
 
+  if (err != kErrorOk) {
+    err = JitAllocatorImpl_mapBlock(impl, &virtMem, blockSize, vmFlags);
+    if (ASMJIT_UNLIKELY(err != kErrorOk))
+      return nullptr;
+  }
+
+  uint32_t areaSize = uint32_t((blockSize + pool->granularity - 1) >> pool->granularityLog2);
+  uint32_t numBitWords = (areaSize + kBitWordSizeInBits - 1u) / kBitWordSizeInBits;
+  size_t bitVectorsSize = JitAllocatorImpl_blockBitVectorsByteSize(areaSize);
+
+  JitAllocatorBlock* block = static_cast<JitAllocatorBlock*>(::malloc(sizeof(JitAllocatorBlock)));
+  BitWord* bitWords = static_cast<BitWord*>(::malloc(bitVectorsSize));
+
   // Out of memory.
-  if (ASMJIT_UNLIKELY(!block || !bitWords || err != kErrorOk)) {
+  if (ASMJIT_UNLIKELY(!block || !bitWords)) {
     if (bitWords) ::free(bitWords);
     if (block) ::free(block);
+    JitAllocatorImpl_unmapBlock(impl, &virtMem, blockSize);
     return nullptr;
   }
 
@@ -554,8 +897,8 @@ static JitAllocatorBlock* JitAllocatorImpl_newBlock(JitAllocatorPrivateImpl* imp
   if (impl->options & JitAllocator::kOptionFillUnusedMemory)
     JitAllocatorImpl_fillPattern(virtMem.rw, impl->fillPattern, blockSize);
 
-  memset(bitWords, 0, size_t(numBitWords) * 2 * sizeof(BitWord));
-  return new(block) JitAllocatorBlock(pool, virtMem, blockSize, blockFlags, bitWords, bitWords + numBitWords, areaSize);
+  memset(bitWords, 0, bitVectorsSize);
+  return new(block) JitAllocatorBlock(pool, virtMem, blockSize, blockFlags, bitWords, bitWords + numBitWords, bitWords + numBitWords * 2u, areaSize);
 }
 
 static void JitAllocatorImpl_deleteBlock(JitAllocatorPrivateImpl* impl, JitAllocatorBlock* block) noexcept {
@@ -578,12 +921,15 @@ static void JitAllocatorImpl_insertBlock(JitAllocatorPrivateImpl* impl, JitAlloc
 
   // Add to RBTree and List.
   impl->tree.insert(block);
+  if (block->hasFlag(JitAllocatorBlock::kFlagDualMapped))
+    impl->rwTree.insert(&block->_rwNode);
   pool->blocks.append(block);
 
   // Update statistics.
   pool->blockCount++;
+  pool->requestedLargePageBlockCount += uint32_t(block->hasFlag(JitAllocatorBlock::kFlagLargePages));
   pool->totalAreaSize += block->areaSize();
-  pool->totalOverheadBytes += sizeof(JitAllocatorBlock) + JitAllocatorImpl_bitVectorSizeToByteSize(block->areaSize()) * 2u;
+  pool->totalOverheadBytes += sizeof(JitAllocatorBlock) + JitAllocatorImpl_blockBitVectorsByteSize(block->areaSize());
 }
 
 static void JitAllocatorImpl_removeBlock(JitAllocatorPrivateImpl* impl, JitAllocatorBlock* block) noexcept {
@@ -594,12 +940,67 @@ static void JitAllocatorImpl_removeBlock(JitAllocatorPrivateImpl* impl, JitAlloc
     pool->cursor = block->hasPrev() ? block->prev() : block->next();
 
   impl->tree.remove(block);
+  if (block->hasFlag(JitAllocatorBlock::kFlagDualMapped))
+    impl->rwTree.remove(&block->_rwNode);
   pool->blocks.unlink(block);
 
   // Update statistics.
   pool->blockCount--;
+  pool->requestedLargePageBlockCount -= uint32_t(block->hasFlag(JitAllocatorBlock::kFlagLargePages));
   pool->totalAreaSize -= block->areaSize();
-  pool->totalOverheadBytes -= sizeof(JitAllocatorBlock) + JitAllocatorImpl_bitVectorSizeToByteSize(block->areaSize()) * 2u;
+  pool->totalOverheadBytes -= sizeof(JitAllocatorBlock) + JitAllocatorImpl_blockBitVectorsByteSize(block->areaSize());
+}
+
+// Makes the whole block writable again, must only be called when the block has no used area.
+static void JitAllocatorImpl_unprotectBlock(JitAllocatorPrivateImpl* impl, JitAllocatorBlock* block) noexcept {
+  DebugUtils::unused(impl);
+
+  if (block->_protectedEnd) {
+    VirtMem::protect(block->roPtr(), block->pool()->byteSizeFromAreaSize(block->_protectedEnd), VirtMem::kAccessRW);
+    block->_protectedEnd = 0;
+  }
+  block->_pendingEnd = 0;
+}
+
+// Makes the area allocated since the last call executable, see `JitAllocator::protectPending()`.
+static Error JitAllocatorImpl_protectBlock(JitAllocatorPrivateImpl* impl, JitAllocatorBlock* block) noexcept {
+  if (block->_pendingEnd <= block->_protectedEnd)
+    return kErrorOk;
+
+  JitAllocatorPool* pool = block->pool();
+  size_t start = pool->byteSizeFromAreaSize(block->_protectedEnd);
+  size_t end = Support::min(Support::alignUp<size_t>(pool->byteSizeFromAreaSize(block->_pendingEnd), impl->pageSize), block->blockSize());
+
+  ASMJIT_PROPAGATE(VirtMem::protect(block->roPtr() + start, end - start, VirtMem::kAccessRX));
+
+  // The rest of the last protected page cannot be used anymore, it's not searched until the block is released.
+  block->_protectedEnd = pool->areaSizeFromByteSize(end);
+  block->_pendingEnd = block->_protectedEnd;
+  block->_searchStart = Support::max(block->_searchStart, block->_protectedEnd);
+
+  if (block->_searchStart >= block->_searchEnd) {
+    block->_largestUnusedArea = 0;
+    block->clearFlags(JitAllocatorBlock::kFlagDirty);
+  }
+  else {
+    block->makeDirty();
+  }
+
+  return kErrorOk;
+}
+
+static Error JitAllocatorImpl_protectPending(JitAllocatorPrivateImpl* impl) noexcept {
+  size_t poolCount = impl->poolCount;
+
+  for (size_t poolId = 0; poolId < poolCount; poolId++) {
+    JitAllocatorBlock* block = impl->pools[poolId].blocks.first();
+    while (block) {
+      ASMJIT_PROPAGATE(JitAllocatorImpl_protectBlock(impl, block));
+      block = block->next();
+    }
+  }
+
+  return kErrorOk;
 }
 
 static void JitAllocatorImpl_wipeOutBlock(JitAllocatorPrivateImpl* impl, JitAllocatorBlock* block) noexcept {
@@ -608,6 +1009,8 @@ static void JitAllocatorImpl_wipeOutBlock(JitAllocatorPrivateImpl* impl, JitAllo
   if (block->hasFlag(JitAllocatorBlock::kFlagEmpty))
     return;
 
+  JitAllocatorImpl_unprotectBlock(impl, block);
+
   uint32_t areaSize = block->areaSize();
   uint32_t granularity = pool->granularity;
   size_t numBitWords = pool->bitWordCountFromAreaSize(areaSize);
@@ -626,6 +1029,7 @@ static void JitAllocatorImpl_wipeOutBlock(JitAllocatorPrivateImpl* impl, JitAllo
 
   memset(block->_usedBitVector, 0, size_t(numBitWords) * sizeof(Support::BitWord));
   memset(block->_stopBitVector, 0, size_t(numBitWords) * sizeof(Support::BitWord));
+  memset(block->_fullBitVector, 0, JitAllocatorImpl_bitVectorSizeToByteSize(uint32_t(numBitWords)));
 
   block->_areaUsed = 0;
   block->_largestUnusedArea = areaSize;
@@ -635,126 +1039,19 @@ static void JitAllocatorImpl_wipeOutBlock(JitAllocatorPrivateImpl* impl, JitAllo
   block->clearFlags(JitAllocatorBlock::kFlagDirty);
 }
 
-// ============================================================================
-// [asmjit::JitAllocator - Construction / Destruction]
-// ============================================================================
-
-JitAllocator::JitAllocator(const CreateParams* params) noexcept {
-  _impl = JitAllocatorImpl_new(params);
-  if (ASMJIT_UNLIKELY(!_impl))
-    _impl = const_cast<JitAllocator::Impl*>(&JitAllocatorImpl_none);
-}
-
-JitAllocator::~JitAllocator() noexcept {
-  if (_impl == &JitAllocatorImpl_none)
-    return;
-
-  reset(Globals::kResetHard);
-  JitAllocatorImpl_destroy(static_cast<JitAllocatorPrivateImpl*>(_impl));
-}
-
-// ============================================================================
-// [asmjit::JitAllocator - Reset]
-// ============================================================================
-
-void JitAllocator::reset(uint32_t resetPolicy) noexcept {
-  if (_impl == &JitAllocatorImpl_none)
-    return;
-
-  JitAllocatorPrivateImpl* impl = static_cast<JitAllocatorPrivateImpl*>(_impl);
-  impl->tree.reset();
-  size_t poolCount = impl->poolCount;
-
-  for (size_t poolId = 0; poolId < poolCount; poolId++) {
-    JitAllocatorPool& pool = impl->pools[poolId];
-    JitAllocatorBlock* block = pool.blocks.first();
-
-    JitAllocatorBlock* blockToKeep = nullptr;
-    if (resetPolicy != Globals::kResetHard && !(impl->options & kOptionImmediateRelease)) {
-      blockToKeep = block;
-      block = block->next();
-    }
-
-    while (block) {
-      JitAllocatorBlock* next = block->next();
-      JitAllocatorImpl_deleteBlock(impl, block);
-      block = next;
-    }
-
-    pool.reset();
-
-    if (blockToKeep) {
-      blockToKeep->_listNodes[0] = nullptr;
-      blockToKeep->_listNodes[1] = nullptr;
-      JitAllocatorImpl_wipeOutBlock(impl, blockToKeep);
-      JitAllocatorImpl_insertBlock(impl, blockToKeep);
-      pool.emptyBlockCount = 1;
-    }
-  }
-}
-
-// ============================================================================
-// [asmjit::JitAllocator - Statistics]
-// ============================================================================
-
-JitAllocator::Statistics JitAllocator::statistics() const noexcept {
-  Statistics statistics;
-  statistics.reset();
-
-  if (ASMJIT_LIKELY(_impl != &JitAllocatorImpl_none)) {
-    JitAllocatorPrivateImpl* impl = static_cast<JitAllocatorPrivateImpl*>(_impl);
-    LockGuard guard(impl->lock);
-
-    size_t poolCount = impl->poolCount;
-    for (size_t poolId = 0; poolId < poolCount; poolId++) {
-      const JitAllocatorPool& pool = impl->pools[poolId];
-      statistics._blockCount   += size_t(pool.blockCount);
-      statistics._reservedSize += size_t(pool.totalAreaSize) * pool.granularity;
-      statistics._usedSize     += size_t(pool.totalAreaUsed) * pool.granularity;
-      statistics._overheadSize += size_t(pool.totalOverheadBytes);
-    }
-  }
-
-  return statistics;
-}
-
-// ============================================================================
-// [asmjit::JitAllocator - Alloc / Release]
-// ============================================================================
-
-Error JitAllocator::alloc(void** roPtrOut, void** rwPtrOut, size_t size) noexcept {
-  if (ASMJIT_UNLIKELY(_impl == &JitAllocatorImpl_none))
-    return DebugUtils::errored(kErrorNotInitialized);
-
-  JitAllocatorPrivateImpl* impl = static_cast<JitAllocatorPrivateImpl*>(_impl);
+static Error JitAllocatorImpl_allocArea(JitAllocatorPrivateImpl* impl, JitAllocatorPool* pool, uint32_t areaSize, void** roPtrOut, void** rwPtrOut, bool canCreateBlock = true) noexcept {
   constexpr uint32_t kNoIndex = std::numeric_limits<uint32_t>::max();
-
-  *roPtrOut = nullptr;
-  *rwPtrOut = nullptr;
-
-  // Align to the minimum granularity by default.
-  size = Support::alignUp<size_t>(size, impl->granularity);
-  if (ASMJIT_UNLIKELY(size == 0))
-    return DebugUtils::errored(kErrorInvalidArgument);
-
-  if (ASMJIT_UNLIKELY(size > std::numeric_limits<uint32_t>::max() / 2))
-    return DebugUtils::errored(kErrorTooLarge);
-
-  LockGuard guard(impl->lock);
-  JitAllocatorPool* pool = &impl->pools[JitAllocatorImpl_sizeToPoolId(impl, size)];
-
   uint32_t areaIndex = kNoIndex;
-  uint32_t areaSize = uint32_t(pool->areaSizeFromByteSize(size));
 
-  // Try to find the requested memory area in existing blocks.
-  JitAllocatorBlock* block = pool->blocks.first();
+  // Try to find the requested memory area in existing blocks (direct pools never share blocks).
+  JitAllocatorBlock* block = pool->isDirect() ? nullptr : pool->blocks.first();
   if (block) {
     JitAllocatorBlock* initial = block;
     do {
       JitAllocatorBlock* next = block->hasNext() ? block->next() : pool->blocks.first();
-      if (block->areaAvailable() >= areaSize) {
-        if (block->isDirty() || block->largestUnusedArea() >= areaSize) {
-          BitVectorRangeIterator<Support::BitWord, 0> it(block->_usedBitVector, pool->bitWordCountFromAreaSize(block->areaSize()), block->_searchStart, block->_searchEnd);
+      if (block->areaAvailable() >= areaSize && !block->hasFlag(JitAllocatorBlock::kFlagCompacting)) {
+        if ((block->isDirty() || block->largestUnusedArea() >= areaSize) && block->_searchStart < block->_searchEnd) {
+          BitVectorRangeIterator<Support::BitWord, 0> it(block->_usedBitVector, pool->bitWordCountFromAreaSize(block->areaSize()), block->_searchStart, block->_searchEnd, block->_fullBitVector);
 
           size_t rangeStart = 0;
           size_t rangeEnd = block->areaSize();
@@ -795,7 +1092,10 @@ Error JitAllocator::alloc(void** roPtrOut, void** rwPtrOut, size_t size) noexcep
 
   // Allocate a new block if there is no region of a required width.
   if (areaIndex == kNoIndex) {
-    size_t blockSize = JitAllocatorImpl_calculateIdealBlockSize(impl, pool, size);
+    if (!canCreateBlock)
+      return kErrorOutOfMemory;
+
+    size_t blockSize = JitAllocatorImpl_calculateIdealBlockSize(impl, pool, pool->byteSizeFromAreaSize(areaSize));
     if (ASMJIT_UNLIKELY(!blockSize))
       return DebugUtils::errored(kErrorOutOfMemory);
 
@@ -819,23 +1119,14 @@ Error JitAllocator::alloc(void** roPtrOut, void** rwPtrOut, size_t size) noexcep
 
   // Return a pointer to the allocated memory.
   size_t offset = pool->byteSizeFromAreaSize(areaIndex);
-  ASMJIT_ASSERT(offset <= block->blockSize() - size);
+  ASMJIT_ASSERT(offset <= block->blockSize() - pool->byteSizeFromAreaSize(areaSize));
 
   *roPtrOut = block->roPtr() + offset;
   *rwPtrOut = block->rwPtr() + offset;
   return kErrorOk;
 }
 
-Error JitAllocator::release(void* roPtr) noexcept {
-  if (ASMJIT_UNLIKELY(_impl == &JitAllocatorImpl_none))
-    return DebugUtils::errored(kErrorNotInitialized);
-
-  if (ASMJIT_UNLIKELY(!roPtr))
-    return DebugUtils::errored(kErrorInvalidArgument);
-
-  JitAllocatorPrivateImpl* impl = static_cast<JitAllocatorPrivateImpl*>(_impl);
-  LockGuard guard(impl->lock);
-
+static Error JitAllocatorImpl_releaseArea(JitAllocatorPrivateImpl* impl, void* roPtr) noexcept {
   JitAllocatorBlock* block = impl->tree.get(static_cast<uint8_t*>(roPtr));
   if (ASMJIT_UNLIKELY(!block))
     return DebugUtils::errored(kErrorInvalidState);
@@ -849,19 +1140,21 @@ Error JitAllocator::release(void* roPtr) noexcept {
   uint32_t areaEnd = uint32_t(Support::bitVectorIndexOf(block->_stopBitVector, areaIndex, true)) + 1;
   uint32_t areaSize = areaEnd - areaIndex;
 
+  bool isProtected = areaIndex < block->_protectedEnd;
   block->markReleasedArea(areaIndex, areaEnd);
 
-  // Fill the released memory if the secure mode is enabled.
-  if (impl->options & kOptionFillUnusedMemory)
+  // Fill the released memory if the secure mode is enabled (protected memory is not writable).
+  if ((impl->options & JitAllocator::kOptionFillUnusedMemory) && !isProtected)
     JitAllocatorImpl_fillPattern(block->rwPtr() + areaIndex * pool->granularity, impl->fillPattern, areaSize * pool->granularity);
 
   // Release the whole block if it became empty.
   if (block->areaUsed() == 0) {
-    if (pool->emptyBlockCount || (impl->options & kOptionImmediateRelease)) {
+    if (pool->emptyBlockCount || pool->isDirect() || (impl->options & JitAllocator::kOptionImmediateRelease)) {
       JitAllocatorImpl_removeBlock(impl, block);
       JitAllocatorImpl_deleteBlock(impl, block);
     }
     else {
+      JitAllocatorImpl_unprotectBlock(impl, block);
       pool->emptyBlockCount++;
     }
   }
@@ -869,46 +1162,647 @@ Error JitAllocator::release(void* roPtr) noexcept {
   return kErrorOk;
 }
 
-Error JitAllocator::shrink(void* roPtr, size_t newSize) noexcept {
-  if (ASMJIT_UNLIKELY(_impl == &JitAllocatorImpl_none))
-    return DebugUtils::errored(kErrorNotInitialized);
-
+static Error JitAllocatorImpl_shrinkArea(JitAllocatorPrivateImpl* impl, void* roPtr, size_t newSize) noexcept {
+  JitAllocatorBlock* block = impl->tree.get(static_cast<uint8_t*>(roPtr));
+  if (ASMJIT_UNLIKELY(!block))
+    return DebugUtils::errored(kErrorInvalidArgument);
+
+  // Offset relative to the start of the block.
+  JitAllocatorPool* pool = block->pool();
+  size_t offset = (size_t)((uint8_t*)roPtr - block->roPtr());
+
+  // The first bit representing the allocated area and its size.
+  uint32_t areaStart = uint32_t(offset >> pool->granularityLog2);
+  uint32_t areaEnd = uint32_t(Support::bitVectorIndexOf(block->_stopBitVector, areaStart, true)) + 1;
+
+  uint32_t areaPrevSize = areaEnd - areaStart;
+  uint32_t areaShrunkSize = pool->areaSizeFromByteSize(newSize);
+
+  if (ASMJIT_UNLIKELY(areaShrunkSize > areaPrevSize))
+    return DebugUtils::errored(kErrorInvalidState);
+
+  uint32_t areaDiff = areaPrevSize - areaShrunkSize;
+  if (areaDiff) {
+    block->markShrunkArea(areaStart + areaShrunkSize, areaEnd);
+
+    // Fill released memory if the secure mode is enabled (protected memory is not writable).
+    if ((impl->options & JitAllocator::kOptionFillUnusedMemory) && areaStart >= block->_protectedEnd)
+      JitAllocatorImpl_fillPattern(block->rwPtr() + (areaStart + areaShrunkSize) * pool->granularity, impl->fillPattern, areaDiff * pool->granularity);
+  }
+
+  return kErrorOk;
+}
+
+// ============================================================================
+// [asmjit::JitAllocator - ThreadCache Utilities]
+// ============================================================================
+
+// Returns a thread cache of the calling thread or creates a new one. Returns
+// null if the thread already has caches of too many live allocators.
+static JitAllocatorThreadCache* JitAllocatorImpl_threadCache(JitAllocatorPrivateImpl* impl) noexcept {
+  JitAllocatorThreadCacheDirectory& directory = JitAllocatorThreadCache_directory;
+  size_t freeSlot = SIZE_MAX;
+
+  for (size_t i = 0; i < kJitAllocatorThreadCacheSlotCount; i++) {
+    JitAllocatorThreadCache* cache = directory._caches[i];
+    if (cache) {
+      if (cache->state() == JitAllocatorThreadCache::kStateAttached) {
+        if (cache->impl() == impl)
+          return cache;
+        continue;
+      }
+
+      // The allocator that owned this cache has been destroyed.
+      ::free(cache);
+      directory._caches[i] = nullptr;
+    }
+
+    if (freeSlot == SIZE_MAX)
+      freeSlot = i;
+  }
+
+  if (freeSlot == SIZE_MAX)
+    return nullptr;
+
+  size_t binCount = impl->poolCount * kJitAllocatorThreadCacheBinCount;
+  void* p = ::malloc(sizeof(JitAllocatorThreadCache) + binCount * sizeof(JitAllocatorThreadCache::Bin));
+  if (ASMJIT_UNLIKELY(!p))
+    return nullptr;
+
+  JitAllocatorThreadCache::Bin* bins = reinterpret_cast<JitAllocatorThreadCache::Bin*>(static_cast<uint8_t*>(p) + sizeof(JitAllocatorThreadCache));
+  for (size_t i = 0; i < binCount; i++)
+    bins[i].count = 0;
+
+  JitAllocatorThreadCache* cache = new(p) JitAllocatorThreadCache(impl, bins);
+  {
+    LockGuard guard(impl->lock);
+    impl->threadCaches.append(cache);
+  }
+
+  directory._caches[freeSlot] = cache;
+  return cache;
+}
+
+// Releases everything deferred by `cache` - the lock must be held.
+static void JitAllocatorImpl_flushReleaseQueue(JitAllocatorPrivateImpl* impl, JitAllocatorThreadCache* cache) noexcept {
+  uint32_t count = cache->_releaseCount;
+  for (uint32_t i = 0; i < count; i++) {
+    Error err = JitAllocatorImpl_releaseArea(impl, cache->_releaseQueue[i]);
+    ASMJIT_ASSERT(err == kErrorOk);
+    DebugUtils::unused(err);
+  }
+  cache->_releaseCount = 0;
+}
+
+// Returns all memory held by `cache` back to the allocator - the lock must be held.
+static void JitAllocatorImpl_flushThreadCache(JitAllocatorPrivateImpl* impl, JitAllocatorThreadCache* cache) noexcept {
+  JitAllocatorImpl_flushReleaseQueue(impl, cache);
+
+  size_t binCount = impl->poolCount * kJitAllocatorThreadCacheBinCount;
+  for (size_t i = 0; i < binCount; i++) {
+    JitAllocatorThreadCache::Bin& bin = cache->_bins[i];
+    for (uint32_t j = 0; j < bin.count; j++)
+      JitAllocatorImpl_releaseArea(impl, bin.roPtrs[j]);
+    bin.count = 0;
+  }
+}
+
+// Returns a thread cache of the calling thread, doesn't create a new one.
+static JitAllocatorThreadCache* JitAllocatorImpl_findThreadCache(JitAllocatorPrivateImpl* impl) noexcept {
+  JitAllocatorThreadCacheDirectory& directory = JitAllocatorThreadCache_directory;
+  for (size_t i = 0; i < kJitAllocatorThreadCacheSlotCount; i++) {
+    JitAllocatorThreadCache* cache = directory._caches[i];
+    if (cache && cache->impl() == impl && cache->state() == JitAllocatorThreadCache::kStateAttached)
+      return cache;
+  }
+  return nullptr;
+}
+
+// Reclaims caches of threads that have terminated - the lock must be held.
+static void JitAllocatorImpl_reclaimThreadCaches(JitAllocatorPrivateImpl* impl) noexcept {
+  JitAllocatorThreadCache* cache = impl->threadCaches.first();
+  while (cache) {
+    JitAllocatorThreadCache* next = cache->next();
+    if (cache->state() == JitAllocatorThreadCache::kStateThreadDetached) {
+      JitAllocatorImpl_flushThreadCache(impl, cache);
+      impl->threadCaches.unlink(cache);
+      ::free(cache);
+    }
+    cache = next;
+  }
+}
+
+// Detaches all thread caches from the allocator, called on destruction.
+static void JitAllocatorImpl_detachThreadCaches(JitAllocatorPrivateImpl* impl) noexcept {
+  JitAllocatorThreadCache* cache = impl->threadCaches.first();
+  while (cache) {
+    JitAllocatorThreadCache* next = cache->next();
+    impl->threadCaches.unlink(cache);
+    if (cache->detach(JitAllocatorThreadCache::kStateAllocatorDetached))
+      ::free(cache);
+    cache = next;
+  }
+}
+
+// ============================================================================
+// [asmjit::JitAllocator - Construction / Destruction]
+// ============================================================================
+
+JitAllocator::JitAllocator(const CreateParams* params) noexcept {
+  _impl = JitAllocatorImpl_new(params);
+  if (ASMJIT_UNLIKELY(!_impl))
+    _impl = const_cast<JitAllocator::Impl*>(&JitAllocatorImpl_none);
+}
+
+JitAllocator::~JitAllocator() noexcept {
+  if (_impl == &JitAllocatorImpl_none)
+    return;
+
+  reset(Globals::kResetHard);
+  JitAllocatorImpl_detachThreadCaches(static_cast<JitAllocatorPrivateImpl*>(_impl));
+  JitAllocatorImpl_destroy(static_cast<JitAllocatorPrivateImpl*>(_impl));
+}
+
+// ============================================================================
+// [asmjit::JitAllocator - Reset]
+// ============================================================================
+
+void JitAllocator::reset(uint32_t resetPolicy) noexcept {
+  if (_impl == &JitAllocatorImpl_none)
+    return;
+
+  JitAllocatorPrivateImpl* impl = static_cast<JitAllocatorPrivateImpl*>(_impl);
+  impl->tree.reset();
+  impl->rwTree.reset();
+  size_t poolCount = impl->poolCount;
+
+  // Everything cached by threads is going to be released, caches of terminated threads can be freed.
+  JitAllocatorThreadCache* cache = impl->threadCaches.first();
+  while (cache) {
+    JitAllocatorThreadCache* next = cache->next();
+    if (cache->state() == JitAllocatorThreadCache::kStateThreadDetached) {
+      impl->threadCaches.unlink(cache);
+      ::free(cache);
+    }
+    else {
+      size_t binCount = poolCount * kJitAllocatorThreadCacheBinCount;
+      for (size_t i = 0; i < binCount; i++)
+        cache->_bins[i].count = 0;
+      cache->_releaseCount = 0;
+    }
+    cache = next;
+  }
+
+  for (size_t poolId = 0; poolId < poolCount; poolId++) {
+    JitAllocatorPool& pool = impl->pools[poolId];
+    JitAllocatorBlock* block = pool.blocks.first();
+
+    JitAllocatorBlock* blockToKeep = nullptr;
+    if (resetPolicy != Globals::kResetHard && !pool.isDirect() && !(impl->options & kOptionImmediateRelease)) {
+      blockToKeep = block;
+      block = block->next();
+    }
+
+    while (block) {
+      JitAllocatorBlock* next = block->next();
+      JitAllocatorImpl_deleteBlock(impl, block);
+      block = next;
+    }
+
+    pool.reset();
+
+    if (blockToKeep) {
+      blockToKeep->_listNodes[0] = nullptr;
+      blockToKeep->_listNodes[1] = nullptr;
+      JitAllocatorImpl_wipeOutBlock(impl, blockToKeep);
+      JitAllocatorImpl_insertBlock(impl, blockToKeep);
+      pool.emptyBlockCount = 1;
+    }
+  }
+}
+
+// ============================================================================
+// [asmjit::JitAllocator - Statistics]
+// ============================================================================
+
+static inline void JitAllocatorImpl_addPoolStatistics(JitAllocator::Statistics& statistics, const JitAllocatorPool& pool) noexcept {
+  statistics._blockCount          += size_t(pool.blockCount);
+  statistics._requestedLargePageBlockCount += size_t(pool.requestedLargePageBlockCount);
+  statistics._reservedSize        += size_t(pool.totalAreaSize) * pool.granularity;
+  statistics._usedSize            += size_t(pool.totalAreaUsed) * pool.granularity;
+  statistics._overheadSize        += size_t(pool.totalOverheadBytes);
+}
+
+JitAllocator::Statistics JitAllocator::statistics() const noexcept {
+  Statistics statistics;
+  statistics.reset();
+
+  if (ASMJIT_LIKELY(_impl != &JitAllocatorImpl_none)) {
+    JitAllocatorPrivateImpl* impl = static_cast<JitAllocatorPrivateImpl*>(_impl);
+    LockGuard guard(impl->lock);
+
+    size_t poolCount = impl->poolCount;
+    for (size_t poolId = 0; poolId < poolCount; poolId++)
+      JitAllocatorImpl_addPoolStatistics(statistics, impl->pools[poolId]);
+  }
+
+  return statistics;
+}
+
+JitAllocator::Statistics JitAllocator::sizeClassStatistics(size_t index) const noexcept {
+  Statistics statistics;
+  statistics.reset();
+
+  if (ASMJIT_LIKELY(_impl != &JitAllocatorImpl_none)) {
+    JitAllocatorPrivateImpl* impl = static_cast<JitAllocatorPrivateImpl*>(_impl);
+    LockGuard guard(impl->lock);
+
+    if (index < impl->poolCount)
+      JitAllocatorImpl_addPoolStatistics(statistics, impl->pools[index]);
+  }
+
+  return statistics;
+}
+
+// ============================================================================
+// [asmjit::JitAllocator - Alloc / Release]
+// ============================================================================
+
+Error JitAllocator::alloc(void** roPtrOut, void** rwPtrOut, size_t size) noexcept {
+  if (ASMJIT_UNLIKELY(_impl == &JitAllocatorImpl_none))
+    return DebugUtils::errored(kErrorNotInitialized);
+
+  JitAllocatorPrivateImpl* impl = static_cast<JitAllocatorPrivateImpl*>(_impl);
+
+  *roPtrOut = nullptr;
+  *rwPtrOut = nullptr;
+
+  // Align to the minimum granularity by default.
+  size = Support::alignUp<size_t>(size, impl->granularity);
+  if (ASMJIT_UNLIKELY(size == 0))
+    return DebugUtils::errored(kErrorInvalidArgument);
+
+  if (ASMJIT_UNLIKELY(size > std::numeric_limits<uint32_t>::max() / 2))
+    return DebugUtils::errored(kErrorTooLarge);
+
+  size_t poolId = JitAllocatorImpl_sizeToPoolId(impl, size);
+  JitAllocatorPool* pool = &impl->pools[poolId];
+  uint32_t areaSize = uint32_t(pool->areaSizeFromByteSize(size));
+
+  if ((impl->options & kOptionUseThreadCaches) && areaSize <= kJitAllocatorThreadCacheBinCount && !pool->isDirect()) {
+    JitAllocatorThreadCache* cache = JitAllocatorImpl_threadCache(impl);
+    if (cache) {
+      JitAllocatorThreadCache::Bin& bin = cache->bin(poolId, areaSize);
+
+      // Fast path - no lock required.
+      if (bin.count) {
+        bin.count--;
+        *roPtrOut = bin.roPtrs[bin.count];
+        *rwPtrOut = bin.rwPtrs[bin.count];
+        return kErrorOk;
+      }
+
+      // Refill the bin, which also flushes deferred releases of this thread.
+      LockGuard guard(impl->lock);
+      JitAllocatorImpl_flushReleaseQueue(impl, cache);
+      JitAllocatorImpl_reclaimThreadCaches(impl);
+
+      ASMJIT_PROPAGATE(JitAllocatorImpl_allocArea(impl, pool, areaSize, roPtrOut, rwPtrOut));
+      for (uint32_t i = 1; i < kJitAllocatorThreadCacheRefillCount; i++) {
+        if (JitAllocatorImpl_allocArea(impl, pool, areaSize, &bin.roPtrs[bin.count], &bin.rwPtrs[bin.count]) != kErrorOk)
+          break;
+        bin.count++;
+      }
+      return kErrorOk;
+    }
+  }
+
+  LockGuard guard(impl->lock);
+  return JitAllocatorImpl_allocArea(impl, pool, areaSize, roPtrOut, rwPtrOut);
+}
+
+Error JitAllocator::allocMultiple(void** roPtrsOut, void** rwPtrsOut, const size_t* sizes, size_t count) noexcept {
+  if (ASMJIT_UNLIKELY(_impl == &JitAllocatorImpl_none))
+    return DebugUtils::errored(kErrorNotInitialized);
+
+  JitAllocatorPrivateImpl* impl = static_cast<JitAllocatorPrivateImpl*>(_impl);
+
+  for (size_t i = 0; i < count; i++) {
+    roPtrsOut[i] = nullptr;
+    rwPtrsOut[i] = nullptr;
+  }
+
+  if (ASMJIT_UNLIKELY(count == 0))
+    return DebugUtils::errored(kErrorInvalidArgument);
+
+  // All regions must share the same pool, so use the largest granularity all sizes are aligned to, or
+  // the size class of the largest region.
+  size_t totalSize = 0;
+  size_t sizeMask = 0;
+  size_t largestSize = 0;
+
+  for (size_t i = 0; i < count; i++) {
+    size_t size = Support::alignUp<size_t>(sizes[i], impl->granularity);
+    if (ASMJIT_UNLIKELY(size == 0))
+      return DebugUtils::errored(kErrorInvalidArgument);
+
+    totalSize += size;
+    sizeMask |= size;
+    largestSize = Support::max(largestSize, size);
+
+    if (ASMJIT_UNLIKELY(totalSize < size || totalSize > std::numeric_limits<uint32_t>::max() / 2))
+      return DebugUtils::errored(kErrorTooLarge);
+  }
+
+  size_t poolSelector = (impl->options & kOptionUseSizeClasses) ? largestSize : sizeMask;
+  JitAllocatorPool* pool = &impl->pools[JitAllocatorImpl_sizeToPoolId(impl, poolSelector)];
+  // Sizes don't have to be aligned to the granularity of a size class, so sum the areas of all regions.
+  uint32_t areaSize = 0;
+  for (size_t i = 0; i < count; i++)
+    areaSize += pool->areaSizeFromByteSize(sizes[i]);
+
+  LockGuard guard(impl->lock);
+
+  uint8_t* ro;
+  uint8_t* rw;
+  ASMJIT_PROPAGATE(JitAllocatorImpl_allocArea(impl, pool, areaSize, (void**)&ro, (void**)&rw));
+
+  JitAllocatorBlock* block = impl->tree.get(ro);
+  uint32_t areaIndex = uint32_t(size_t(ro - block->roPtr()) >> pool->granularityLog2);
+
+  // Split the area into separate allocations by adding sentinels between them.
+  for (size_t i = 0; i < count; i++) {
+    uint32_t regionSize = pool->areaSizeFromByteSize(sizes[i]);
+
+    roPtrsOut[i] = ro;
+    rwPtrsOut[i] = rw;
+
+    areaIndex += regionSize;
+    Support::bitVectorSetBit(block->_stopBitVector, areaIndex - 1, true);
+
+    ro += pool->byteSizeFromAreaSize(regionSize);
+    rw += pool->byteSizeFromAreaSize(regionSize);
+  }
+
+  return kErrorOk;
+}
+
+Error JitAllocator::queryRW(void* rwPtr, void** roPtrOut, size_t* sizeOut) const noexcept {
+  *roPtrOut = nullptr;
+  *sizeOut = 0;
+
+  if (ASMJIT_UNLIKELY(_impl == &JitAllocatorImpl_none))
+    return DebugUtils::errored(kErrorNotInitialized);
+
+  JitAllocatorPrivateImpl* impl = static_cast<JitAllocatorPrivateImpl*>(_impl);
+  LockGuard guard(impl->lock);
+
+  // Dual-mapped blocks are indexed by their Read+Write pointers, other blocks
+  // have both pointers equal.
+  uint8_t* rw = static_cast<uint8_t*>(rwPtr);
+  JitAllocatorBlock* block = nullptr;
+
+  JitAllocatorBlockRWNode* rwNode = impl->rwTree.get(rw);
+  if (rwNode) {
+    block = rwNode->block();
+  }
+  else {
+    block = impl->tree.get(rw);
+    if (block && block->hasFlag(JitAllocatorBlock::kFlagDualMapped))
+      block = nullptr;
+  }
+
+  if (ASMJIT_UNLIKELY(!block))
+    return DebugUtils::errored(kErrorInvalidArgument);
+
+  JitAllocatorPool* pool = block->pool();
+  size_t offset = size_t(rw - block->rwPtr());
+  uint32_t areaStart = uint32_t(offset >> pool->granularityLog2);
+
+  // Must point to the first granule of a used area.
+  bool isStart = Support::isAligned<size_t>(offset, pool->granularity) &&
+                 Support::bitVectorGetBit(block->_usedBitVector, areaStart) &&
+                 (areaStart == 0 ||
+                  !Support::bitVectorGetBit(block->_usedBitVector, areaStart - 1) ||
+                   Support::bitVectorGetBit(block->_stopBitVector, areaStart - 1));
+
+  if (ASMJIT_UNLIKELY(!isStart))
+    return DebugUtils::errored(kErrorInvalidArgument);
+
+  uint32_t areaEnd = uint32_t(Support::bitVectorIndexOf(block->_stopBitVector, areaStart, true)) + 1;
+  *roPtrOut = block->roPtr() + offset;
+  *sizeOut = pool->byteSizeFromAreaSize(areaEnd - areaStart);
+  return kErrorOk;
+}
+
+Error JitAllocator::protectPending() noexcept {
+  if (ASMJIT_UNLIKELY(_impl == &JitAllocatorImpl_none))
+    return DebugUtils::errored(kErrorNotInitialized);
+
+  JitAllocatorPrivateImpl* impl = static_cast<JitAllocatorPrivateImpl*>(_impl);
+  if (!(impl->options & kOptionUseBatchedProtection))
+    return kErrorOk;
+
+  LockGuard guard(impl->lock);
+  return JitAllocatorImpl_protectPending(impl);
+}
+
+Error JitAllocator::flushThreadCache() noexcept {
+  if (ASMJIT_UNLIKELY(_impl == &JitAllocatorImpl_none))
+    return DebugUtils::errored(kErrorNotInitialized);
+
+  JitAllocatorPrivateImpl* impl = static_cast<JitAllocatorPrivateImpl*>(_impl);
+  if (!(impl->options & kOptionUseThreadCaches))
+    return kErrorOk;
+
+  LockGuard guard(impl->lock);
+  JitAllocatorImpl_reclaimThreadCaches(impl);
+
+  JitAllocatorThreadCache* cache = JitAllocatorImpl_findThreadCache(impl);
+  if (cache)
+    JitAllocatorImpl_flushThreadCache(impl, cache);
+  return kErrorOk;
+}
+
+Error JitAllocator::release(void* roPtr) noexcept {
+  if (ASMJIT_UNLIKELY(_impl == &JitAllocatorImpl_none))
+    return DebugUtils::errored(kErrorNotInitialized);
+
+  if (ASMJIT_UNLIKELY(!roPtr))
+    return DebugUtils::errored(kErrorInvalidArgument);
+
+  JitAllocatorPrivateImpl* impl = static_cast<JitAllocatorPrivateImpl*>(_impl);
+
+  if (impl->options & kOptionUseThreadCaches) {
+    JitAllocatorThreadCache* cache = JitAllocatorImpl_threadCache(impl);
+    if (cache) {
+      cache->_releaseQueue[cache->_releaseCount++] = roPtr;
+      if (cache->_releaseCount < kJitAllocatorThreadCacheReleaseCapacity)
+        return kErrorOk;
+
+      LockGuard guard(impl->lock);
+      JitAllocatorImpl_flushReleaseQueue(impl, cache);
+      return kErrorOk;
+    }
+  }
+
+  LockGuard guard(impl->lock);
+  return JitAllocatorImpl_releaseArea(impl, roPtr);
+}
+
+Error JitAllocator::shrink(void* roPtr, size_t newSize) noexcept {
+  if (ASMJIT_UNLIKELY(_impl == &JitAllocatorImpl_none))
+    return DebugUtils::errored(kErrorNotInitialized);
+
   if (ASMJIT_UNLIKELY(!roPtr))
     return DebugUtils::errored(kErrorInvalidArgument);
 
-  if (ASMJIT_UNLIKELY(newSize == 0))
-    return release(roPtr);
+  if (ASMJIT_UNLIKELY(newSize == 0))
+    return release(roPtr);
+
+  JitAllocatorPrivateImpl* impl = static_cast<JitAllocatorPrivateImpl*>(_impl);
+  LockGuard guard(impl->lock);
+  return JitAllocatorImpl_shrinkArea(impl, roPtr, newSize);
+}
+
+// ============================================================================
+// [asmjit::JitAllocator - Compaction]
+// ============================================================================
+
+JitAllocator::MoveHandler::MoveHandler() noexcept {}
+JitAllocator::MoveHandler::~MoveHandler() noexcept {}
+
+bool JitAllocator::MoveHandler::canMove(void* roPtr, size_t size) noexcept {
+  DebugUtils::unused(roPtr, size);
+  return true;
+}
+
+// Moves all allocations out of `block`, returns true if the block became empty and was released.
+static bool JitAllocatorImpl_compactBlock(JitAllocatorPrivateImpl* impl, JitAllocatorBlock* block, JitAllocator::MoveHandler* handler, JitAllocator::CompactResult& result) noexcept {
+  JitAllocatorPool* pool = block->pool();
+  size_t numBitWords = pool->bitWordCountFromAreaSize(block->areaSize());
+  uint32_t searchStart = 0;
+
+  for (;;) {
+    // Restart the search after each move as the used bit-vector changes.
+    BitVectorRangeIterator<Support::BitWord, 1> it(block->_usedBitVector, numBitWords, searchStart, block->areaSize());
+
+    size_t rangeStart, rangeEnd;
+    if (!it.nextRange(&rangeStart, &rangeEnd))
+      return false;
+
+    uint32_t areaStart = uint32_t(rangeStart);
+    uint32_t areaEnd = uint32_t(Support::bitVectorIndexOf(block->_stopBitVector, areaStart, true)) + 1;
+    uint32_t areaSize = areaEnd - areaStart;
+    searchStart = areaEnd;
+
+    JitAllocator::Move move {};
+    move.oldRo = block->roPtr() + pool->byteSizeFromAreaSize(areaStart);
+    move.size = pool->byteSizeFromAreaSize(areaSize);
+
+    if (!handler->canMove(move.oldRo, move.size))
+      continue;
+
+    // Stop if there is no space left in other blocks, they are only getting fuller.
+    if (JitAllocatorImpl_allocArea(impl, pool, areaSize, &move.newRo, &move.newRw, false) != kErrorOk)
+      return false;
+
+    memcpy(move.newRw, block->rwPtr() + pool->byteSizeFromAreaSize(areaStart), move.size);
+    if (handler->relocate(move) != kErrorOk) {
+      JitAllocatorImpl_releaseArea(impl, move.newRo);
+      continue;
+    }
+
+    result._movedCount++;
+    result._movedSize += move.size;
+
+    if (block->areaUsed() == areaSize) {
+      size_t blockSize = block->blockSize();
+
+      block->markReleasedArea(areaStart, areaEnd);
+      JitAllocatorImpl_removeBlock(impl, block);
+      JitAllocatorImpl_deleteBlock(impl, block);
+
+      result._releasedBlockCount++;
+      result._releasedSize += blockSize;
+      return true;
+    }
 
-  JitAllocatorPrivateImpl* impl = static_cast<JitAllocatorPrivateImpl*>(_impl);
-  LockGuard guard(impl->lock);
-  JitAllocatorBlock* block = impl->tree.get(static_cast<uint8_t*>(roPtr));
+    JitAllocatorImpl_releaseArea(impl, move.oldRo);
+  }
+}
 
-  if (ASMJIT_UNLIKELY(!block))
+Error JitAllocator::compact(MoveHandler* handler, CompactResult* resultOut) noexcept {
+  CompactResult result;
+  result.reset();
+
+  if (resultOut)
+    *resultOut = result;
+
+  if (ASMJIT_UNLIKELY(_impl == &JitAllocatorImpl_none))
+    return DebugUtils::errored(kErrorNotInitialized);
+
+  if (ASMJIT_UNLIKELY(!handler))
     return DebugUtils::errored(kErrorInvalidArgument);
 
-  // Offset relative to the start of the block.
-  JitAllocatorPool* pool = block->pool();
-  size_t offset = (size_t)((uint8_t*)roPtr - block->roPtr());
+  JitAllocatorPrivateImpl* impl = static_cast<JitAllocatorPrivateImpl*>(_impl);
+  LockGuard guard(impl->lock);
 
-  // The first bit representing the allocated area and its size.
-  uint32_t areaStart = uint32_t(offset >> pool->granularityLog2);
-  uint32_t areaEnd = uint32_t(Support::bitVectorIndexOf(block->_stopBitVector, areaStart, true)) + 1;
+  // Areas held by thread caches look used, but their threads can hand them out
+  // or release them without the lock, so they must not be moved. Caches of the
+  // calling thread and of terminated threads are flushed, other threads cannot
+  // be stopped from using theirs, so compaction is refused while they exist.
+  if (impl->options & kOptionUseThreadCaches) {
+    JitAllocatorImpl_reclaimThreadCaches(impl);
+    JitAllocatorThreadCache* ownCache = JitAllocatorImpl_findThreadCache(impl);
 
-  uint32_t areaPrevSize = areaEnd - areaStart;
-  uint32_t areaShrunkSize = pool->areaSizeFromByteSize(newSize);
+    for (JitAllocatorThreadCache* cache = impl->threadCaches.first(); cache; cache = cache->next())
+      if (cache != ownCache)
+        return DebugUtils::errored(kErrorInvalidState);
 
-  if (ASMJIT_UNLIKELY(areaShrunkSize > areaPrevSize))
-    return DebugUtils::errored(kErrorInvalidState);
+    if (ownCache)
+      JitAllocatorImpl_flushThreadCache(impl, ownCache);
+  }
 
-  uint32_t areaDiff = areaPrevSize - areaShrunkSize;
-  if (areaDiff) {
-    block->markShrunkArea(areaStart + areaShrunkSize, areaEnd);
+  size_t poolCount = impl->poolCount;
+  for (size_t poolId = 0; poolId < poolCount; poolId++) {
+    JitAllocatorPool* pool = &impl->pools[poolId];
+    if (pool->blockCount < 2)
+      continue;
+
+    // Keep the most used block, it's the best destination.
+    JitAllocatorBlock* mostUsed = pool->blocks.first();
+    for (JitAllocatorBlock* block = mostUsed->next(); block; block = block->next())
+      if (block->areaUsed() > mostUsed->areaUsed())
+        mostUsed = block;
+
+    // Mark all mostly unused blocks first, so they are not used as destinations.
+    uint32_t candidateCount = 0;
+    for (JitAllocatorBlock* block = pool->blocks.first(); block; block = block->next()) {
+      if (block != mostUsed && block->areaUsed() != 0 && block->areaUsed() <= block->areaSize() / 4u) {
+        block->addFlags(JitAllocatorBlock::kFlagCompacting);
+        candidateCount++;
+      }
+    }
 
-    // Fill released memory if the secure mode is enabled.
-    if (impl->options & kOptionFillUnusedMemory)
-      JitAllocatorImpl_fillPattern(block->rwPtr() + (areaStart + areaShrunkSize) * pool->granularity, fillPattern(), areaDiff * pool->granularity);
+    JitAllocatorBlock* block = pool->blocks.first();
+    while (candidateCount) {
+      JitAllocatorBlock* next = block->next();
+      if (block->hasFlag(JitAllocatorBlock::kFlagCompacting)) {
+        // A block that couldn't be emptied can be used as a destination by the remaining ones.
+        if (!JitAllocatorImpl_compactBlock(impl, block, handler, result))
+          block->clearFlags(JitAllocatorBlock::kFlagCompacting);
+        candidateCount--;
+      }
+      block = next;
+    }
   }
 
+  if (resultOut)
+    *resultOut = result;
+
+  if (impl->options & kOptionUseBatchedProtection)
+    return JitAllocatorImpl_protectPending(impl);
   return kErrorOk;
 }
 
@@ -1044,6 +1938,17 @@ public:
     return roPtr;
   }
 
+  void allocMultiple(void** ptrs, const size_t* sizes, size_t count) noexcept {
+    void* rwPtrs[16];
+    EXPECT(count <= ASMJIT_ARRAY_SIZE(rwPtrs));
+
+    Error err = _allocator.allocMultiple(ptrs, rwPtrs, sizes, count);
+    EXPECT(err == kErrorOk, "JitAllocator failed to allocate %zu regions\n", count);
+
+    for (size_t i = 0; i < count; i++)
+      _insert(ptrs[i], sizes[i]);
+  }
+
   void release(void* p) noexcept {
     _remove(p);
     EXPECT(_allocator.release(p) == kErrorOk, "JitAllocator failed to release '%p'\n", p);
@@ -1071,6 +1976,7 @@ static void JitAllocatorTest_shuffle(void** ptrArray, size_t count, Random& prng
 static void JitAllocatorTest_usage(JitAllocator& allocator) noexcept {
   JitAllocator::Statistics stats = allocator.statistics();
   INFO("    Block Count       : %9llu [Blocks]"        , (unsigned long long)(stats.blockCount()));
+  INFO("    Large Page Blocks : %9llu [Requested]"     , (unsigned long long)(stats.requestedLargePageBlockCount()));
   INFO("    Reserved (VirtMem): %9llu [Bytes]"         , (unsigned long long)(stats.reservedSize()));
   INFO("    Used     (VirtMem): %9llu [Bytes] (%.1f%%)", (unsigned long long)(stats.usedSize()), stats.usedSizeAsPercent());
   INFO("    Overhead (HeapMem): %9llu [Bytes] (%.1f%%)", (unsigned long long)(stats.overheadSize()), stats.overheadSizeAsPercent());
@@ -1104,6 +2010,535 @@ static void BitVectorRangeIterator_testRandom(Random& rnd, size_t count) noexcep
   }
 }
 
+// Verifies that iterating with a summary of words having no `Bit` bits yields the same ranges as without it.
+template<typename T, size_t kPatternSize, bool Bit>
+static void BitVectorRangeIterator_testSummary(Random& rnd, size_t count) noexcept {
+  constexpr size_t kBitWordSize = Support::bitSizeOf<T>();
+  constexpr T kEmptyWord = Bit == 0 ? Support::allOnes<T>() : T(0);
+
+  for (size_t i = 0; i < count; i++) {
+    T in[kPatternSize];
+    T summary[(kPatternSize + kBitWordSize - 1) / kBitWordSize] {};
+
+    // Make most words empty so the summary has something to skip.
+    for (size_t j = 0; j < kPatternSize; j++) {
+      uint32_t r = rnd.nextUInt32();
+      in[j] = (r & 0x7u) ? kEmptyWord : T(uint64_t(r >> 8) * 0x0101010101010101);
+      Support::bitVectorSetBit(summary, j, in[j] == kEmptyWord);
+    }
+
+    size_t start = rnd.nextUInt32() % (kPatternSize * kBitWordSize);
+    size_t end = start + rnd.nextUInt32() % (kPatternSize * kBitWordSize - start + 1);
+
+    BitVectorRangeIterator<T, Bit> a(in, kPatternSize, start, end);
+    BitVectorRangeIterator<T, Bit> b(in, kPatternSize, start, end, summary);
+
+    size_t aStart = 0, aEnd = 0, bStart = 0, bEnd = 0;
+    for (;;) {
+      bool aValid = a.nextRange(&aStart, &aEnd);
+      bool bValid = b.nextRange(&bStart, &bEnd);
+
+      EXPECT(aValid == bValid, "Iterator with summary ended at a different position");
+      if (!aValid)
+        break;
+
+      EXPECT(aStart == bStart && aEnd == bEnd, "Iterator with summary returned [%zu:%zu] instead of [%zu:%zu]", bStart, bEnd, aStart, aEnd);
+    }
+  }
+}
+
+// Small slots, medium objects, and large objects that are mapped directly.
+static void JitAllocatorTest_setupSizeClasses(JitAllocator::CreateParams& params) noexcept {
+  params.sizeClassCount = 3;
+  params.sizeClasses[0] = JitAllocator::SizeClass { 32, 16, 0, 0 };
+  params.sizeClasses[1] = JitAllocator::SizeClass { 32768, 64, 0, 0 };
+  params.sizeClasses[2] = JitAllocator::SizeClass { 0, 64, 0, JitAllocator::kSizeClassDirect };
+}
+
+static void JitAllocatorTest_sizeClasses() noexcept {
+  INFO("JitAllocator - Size classes");
+
+  JitAllocator::CreateParams params {};
+  params.options = JitAllocator::kOptionUseSizeClasses;
+  JitAllocatorTest_setupSizeClasses(params);
+
+  JitAllocatorWrapper wrapper(&params);
+  JitAllocator* allocator = &wrapper._allocator;
+
+  constexpr size_t kSmallCount = 1000;
+  constexpr size_t kMediumCount = 1000;
+  constexpr size_t kLargeCount = 20;
+
+  void* small[kSmallCount];
+  void* medium[kMediumCount];
+  void* large[kLargeCount];
+
+  Random prng(300);
+  size_t i;
+
+  for (i = 0; i < kSmallCount; i++)
+    small[i] = wrapper.alloc(32);
+
+  for (i = 0; i < kMediumCount; i++)
+    medium[i] = wrapper.alloc(100 + prng.nextUInt32() % 200);
+
+  for (i = 0; i < kLargeCount; i++)
+    large[i] = wrapper.alloc(65536 + prng.nextUInt32() % 65536);
+
+  JitAllocator::Statistics smallStats = allocator->sizeClassStatistics(0);
+  JitAllocator::Statistics mediumStats = allocator->sizeClassStatistics(1);
+  JitAllocator::Statistics largeStats = allocator->sizeClassStatistics(2);
+
+  EXPECT(smallStats.usedSize() == kSmallCount * 32,
+         "Size class #0 should use exactly %zu bytes, not %zu", kSmallCount * 32, smallStats.usedSize());
+  EXPECT(mediumStats.usedSize() >= kMediumCount * 100 && mediumStats.usedSize() <= kMediumCount * 320,
+         "Size class #1 uses unexpected number of bytes (%zu)", mediumStats.usedSize());
+  EXPECT(largeStats.blockCount() == kLargeCount,
+         "Size class #2 should have a block per allocation (%zu blocks instead of %zu)", largeStats.blockCount(), kLargeCount);
+  EXPECT(allocator->sizeClassStatistics(3).blockCount() == 0,
+         "Statistics of a non-existing size class must be empty");
+
+  JitAllocator::Statistics stats = allocator->statistics();
+  EXPECT(stats.usedSize() == smallStats.usedSize() + mediumStats.usedSize() + largeStats.usedSize(),
+         "Statistics of size classes don't sum up to the statistics of the allocator");
+
+  for (i = 0; i < kLargeCount; i++)
+    wrapper.release(large[i]);
+
+  EXPECT(allocator->sizeClassStatistics(2).blockCount() == 0,
+         "Blocks of a direct size class must be released immediately");
+
+  for (i = 0; i < kSmallCount; i++)
+    wrapper.release(small[i]);
+
+  for (i = 0; i < kMediumCount; i++)
+    wrapper.release(medium[i]);
+
+  EXPECT(allocator->statistics().usedSize() == 0,
+         "JitAllocator leaked %zu bytes", allocator->statistics().usedSize());
+}
+
+// Keeps track of live allocations, each allocation stores its index in the first 4 bytes.
+class JitAllocatorTestMoveHandler : public JitAllocator::MoveHandler {
+public:
+  void** _ptrs;
+  size_t _count;
+  size_t _relocatedCount;
+
+  inline JitAllocatorTestMoveHandler(void** ptrs, size_t count) noexcept
+    : _ptrs(ptrs),
+      _count(count),
+      _relocatedCount(0) {}
+
+  // Allocations from the first eighth are pinned, they are all in the first block.
+  bool canMove(void* roPtr, size_t size) noexcept override {
+    DebugUtils::unused(size);
+    uint32_t index = Support::readU32u(roPtr);
+    return index < _count && _ptrs[index] == roPtr && index >= _count / 8u;
+  }
+
+  Error relocate(const JitAllocator::Move& move) noexcept override {
+    uint32_t index = Support::readU32u(move.newRw);
+    if (index >= _count || _ptrs[index] != move.oldRo)
+      return DebugUtils::errored(kErrorInvalidState);
+
+    _ptrs[index] = move.newRo;
+    _relocatedCount++;
+    return kErrorOk;
+  }
+};
+
+// Allocations spread over many blocks must all be found by their Read+Write pointers.
+static void JitAllocatorTest_queryRW() noexcept {
+  struct TestParams {
+    const char* name;
+    uint32_t options;
+  };
+
+  static TestParams testParams[] = {
+    { "Default", 0 },
+    { "kOptionUseDualMapping", JitAllocator::kOptionUseDualMapping },
+    { "kOptionUseMultiplePools | kOptionUseDualMapping", JitAllocator::kOptionUseMultiplePools | JitAllocator::kOptionUseDualMapping }
+  };
+
+  constexpr size_t kCount = 2000;
+
+  for (uint32_t testId = 0; testId < ASMJIT_ARRAY_SIZE(testParams); testId++) {
+    INFO("JitAllocator(%s) - QueryRW", testParams[testId].name);
+
+    JitAllocator::CreateParams params {};
+    params.options = testParams[testId].options;
+    JitAllocator allocator(&params);
+
+    std::vector<void*> ro(kCount);
+    std::vector<void*> rw(kCount);
+
+    for (size_t i = 0; i < kCount; i++)
+      EXPECT(allocator.alloc(&ro[i], &rw[i], 64 + (i % 7) * 256) == kErrorOk);
+    EXPECT(allocator.statistics().blockCount() > 1);
+
+    for (size_t i = 0; i < kCount; i++) {
+      void* roQueried;
+      size_t size;
+
+      EXPECT(allocator.queryRW(rw[i], &roQueried, &size) == kErrorOk);
+      EXPECT(roQueried == ro[i] && size >= 64 + (i % 7) * 256, "QueryRW of allocation #%zu returned invalid result", i);
+      EXPECT(allocator.queryRW(static_cast<uint8_t*>(rw[i]) + 1, &roQueried, &size) == kErrorInvalidArgument);
+
+      if (ro[i] != rw[i])
+        EXPECT(allocator.queryRW(ro[i], &roQueried, &size) == kErrorInvalidArgument);
+    }
+
+    for (size_t i = 0; i < kCount; i++)
+      EXPECT(allocator.release(ro[i]) == kErrorOk);
+  }
+}
+
+// Blocks are only rounded up to the large page size if they actually use large pages.
+static void JitAllocatorTest_largePages() noexcept {
+  size_t largePageSize = VirtMem::largePageSize();
+  INFO("JitAllocator - Large pages (large page size %zu)", largePageSize);
+
+  JitAllocator::CreateParams params {};
+  params.options = JitAllocator::kOptionUseLargePages;
+  JitAllocator allocator(&params);
+
+  void* ro;
+  void* rw;
+  EXPECT(allocator.alloc(&ro, &rw, 64) == kErrorOk);
+
+  JitAllocator::Statistics stats = allocator.statistics();
+  INFO("  %zu of %zu blocks requested large pages, %zu bytes reserved",
+       stats.requestedLargePageBlockCount(), stats.blockCount(), stats.reservedSize());
+
+  EXPECT(stats.blockCount() == 1);
+  if (stats.requestedLargePageBlockCount())
+    EXPECT(largePageSize != 0 && stats.reservedSize() % largePageSize == 0);
+  else
+    EXPECT(largePageSize == 0 || stats.reservedSize() < largePageSize,
+           "JitAllocator rounded a block that doesn't use large pages to the large page size");
+
+  EXPECT(allocator.release(ro) == kErrorOk);
+}
+
+static void JitAllocatorTest_compaction() noexcept {
+  struct TestParams {
+    const char* name;
+    uint32_t options;
+  };
+
+  static TestParams testParams[] = {
+    { "Default", 0 },
+    { "kOptionUseDualMapping", JitAllocator::kOptionUseDualMapping },
+    { "kOptionUseThreadCaches", JitAllocator::kOptionUseThreadCaches },
+    { "kOptionUseThreadCaches | kOptionUseDualMapping", JitAllocator::kOptionUseThreadCaches | JitAllocator::kOptionUseDualMapping }
+  };
+
+  constexpr size_t kCount = 4000;
+  constexpr size_t kSize = 256;
+
+  for (uint32_t testId = 0; testId < ASMJIT_ARRAY_SIZE(testParams); testId++) {
+    INFO("JitAllocator(%s) - Compaction", testParams[testId].name);
+
+    JitAllocator::CreateParams params {};
+    params.options = testParams[testId].options;
+    bool threadCaches = (params.options & JitAllocator::kOptionUseThreadCaches) != 0;
+
+    JitAllocator allocator(&params);
+    void* ptrs[kCount];
+    Random prng(400);
+
+    for (size_t i = 0; i < kCount; i++) {
+      void* rw;
+      EXPECT(allocator.alloc(&ptrs[i], &rw, kSize) == kErrorOk, "JitAllocator failed to allocate %zu bytes", kSize);
+      memset(rw, 0, kSize);
+      Support::writeU32u(rw, uint32_t(i));
+    }
+
+    // Release most allocations so the blocks become mostly unused.
+    size_t liveCount = kCount;
+    for (size_t i = 0; i < kCount; i++) {
+      if (prng.nextUInt32() % 10u != 0u) {
+        allocator.release(ptrs[i]);
+        ptrs[i] = nullptr;
+        liveCount--;
+      }
+    }
+
+    if (threadCaches) {
+      // A cache of another live thread prevents compaction, a cache of a thread
+      // that has terminated is reclaimed.
+      std::atomic<uint32_t> state(0);
+      std::thread thread([&]() {
+        void* ro;
+        void* rw;
+        if (allocator.alloc(&ro, &rw, kSize) == kErrorOk)
+          allocator.release(ro);
+
+        state.store(1);
+        while (state.load() != 2)
+          std::this_thread::yield();
+      });
+
+      while (state.load() != 1)
+        std::this_thread::yield();
+
+      JitAllocatorTestMoveHandler handler(ptrs, kCount);
+      EXPECT(allocator.compact(&handler) == kErrorInvalidState,
+             "JitAllocator::compact() must fail while another thread has a cache");
+      EXPECT(handler._relocatedCount == 0);
+
+      state.store(2);
+      thread.join();
+    }
+
+    // Statistics must only report memory that is actually allocated.
+    EXPECT(allocator.flushThreadCache() == kErrorOk);
+
+    JitAllocator::Statistics before = allocator.statistics();
+    JitAllocatorTestMoveHandler handler(ptrs, kCount);
+    JitAllocator::CompactResult result;
+
+    EXPECT(allocator.compact(&handler, &result) == kErrorOk, "JitAllocator::compact() failed");
+    JitAllocator::Statistics after = allocator.statistics();
+
+    INFO("  Moved %zu allocations (%zu bytes), released %zu blocks (%zu bytes)",
+         result.movedCount(), result.movedSize(), result.releasedBlockCount(), result.releasedSize());
+
+    EXPECT(result.movedCount() == handler._relocatedCount, "Number of moves doesn't match the number of relocations");
+    EXPECT(result.releasedBlockCount() != 0, "Compaction should have released at least one block");
+    EXPECT(before.usedSize() == liveCount * kSize, "Statistics must only report live allocations");
+    EXPECT(after.usedSize() == before.usedSize(), "Compaction must not change the used size");
+    EXPECT(after.blockCount() == before.blockCount() - result.releasedBlockCount(), "Compaction reported wrong number of released blocks");
+    EXPECT(after.reservedSize() == before.reservedSize() - result.releasedSize(), "Compaction reported wrong released size");
+
+    // All allocations must have the original content, wherever they are.
+    for (size_t i = 0; i < kCount; i++) {
+      if (ptrs[i]) {
+        EXPECT(Support::readU32u(ptrs[i]) == uint32_t(i), "Allocation #%zu has invalid content after compaction", i);
+        allocator.release(ptrs[i]);
+      }
+    }
+
+    // Releases are deferred by thread caches.
+    EXPECT(allocator.flushThreadCache() == kErrorOk);
+    EXPECT(allocator.statistics().usedSize() == 0, "JitAllocator leaked %zu bytes", allocator.statistics().usedSize());
+  }
+}
+
+// Compares the throughput of publishing code with RWX mappings, dual mappings, and batched protection.
+static void JitAllocatorTest_protection(size_t count) noexcept {
+  struct TestParams {
+    const char* name;
+    uint32_t options;
+    size_t batchSize;
+  };
+
+  static TestParams testParams[] = {
+    { "RWX", 0, 1 },
+    { "kOptionUseDualMapping", JitAllocator::kOptionUseDualMapping, 1 },
+    { "kOptionUseBatchedProtection (batch of 1)", JitAllocator::kOptionUseBatchedProtection, 1 },
+    { "kOptionUseBatchedProtection (batch of 100)", JitAllocator::kOptionUseBatchedProtection, 100 }
+  };
+
+  constexpr size_t kCodeSize = 200;
+
+  INFO("JitAllocator - Protection (%zu allocations of %zu bytes)", count, kCodeSize);
+  void** ptrArray = (void**)::malloc(sizeof(void*) * count);
+  EXPECT(ptrArray != nullptr, "Couldn't allocate pointer-array");
+
+  for (uint32_t testId = 0; testId < ASMJIT_ARRAY_SIZE(testParams); testId++) {
+    JitAllocator::CreateParams params {};
+    params.options = testParams[testId].options;
+
+    JitAllocator allocator(&params);
+    size_t batchSize = testParams[testId].batchSize;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < count; i++) {
+      void* rw;
+      EXPECT(allocator.alloc(&ptrArray[i], &rw, kCodeSize) == kErrorOk, "JitAllocator failed to allocate %zu bytes", kCodeSize);
+      memset(rw, 0xC3, kCodeSize);
+
+      if ((i + 1) % batchSize == 0 || i + 1 == count)
+        EXPECT(allocator.protectPending() == kErrorOk, "JitAllocator failed to protect pending memory");
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+
+    // Protected memory must still be readable.
+    for (size_t i = 0; i < count; i++)
+      EXPECT(static_cast<const uint8_t*>(ptrArray[i])[kCodeSize - 1] == 0xC3, "Protected memory has unexpected content");
+
+    JitAllocator::Statistics stats = allocator.statistics();
+    INFO("  %-44s: %8.2f [ms] (%zu bytes reserved)", testParams[testId].name, std::chrono::duration<double, std::milli>(end - start).count(), stats.reservedSize());
+
+    for (size_t i = 0; i < count; i++)
+      EXPECT(allocator.release(ptrArray[i]) == kErrorOk, "JitAllocator failed to release memory");
+  }
+
+  ::free(ptrArray);
+}
+
+// Fills large blocks with small allocations, releases a part of them randomly, and measures
+// how long it takes to allocate in such fragmented blocks.
+static void JitAllocatorTest_fragmentation(size_t count) noexcept {
+  INFO("JitAllocator - Fragmentation (4MB blocks, %zu allocations)", count);
+
+  JitAllocator::CreateParams params {};
+  params.blockSize = 4 * 1024 * 1024;
+  params.granularity = 64;
+
+  JitAllocatorWrapper wrapper(&params);
+  Random prng(200);
+
+  void** ptrArray = (void**)::malloc(sizeof(void*) * count);
+  EXPECT(ptrArray != nullptr, "Couldn't allocate pointer-array");
+
+  size_t i;
+  for (i = 0; i < count; i++)
+    ptrArray[i] = wrapper.alloc((prng.nextUInt32() % 128) + 1);
+
+  // Release every 8th allocation on average to leave small holes everywhere.
+  size_t liveCount = 0;
+  for (i = 0; i < count; i++) {
+    if ((prng.nextUInt32() & 0x7u) == 0)
+      wrapper.release(ptrArray[i]);
+    else
+      ptrArray[liveCount++] = ptrArray[i];
+  }
+  JitAllocatorTest_usage(wrapper._allocator);
+
+  auto start = std::chrono::high_resolution_clock::now();
+  for (i = 0; i < count / 4; i++) {
+    size_t index = prng.nextUInt32() % liveCount;
+    wrapper.release(ptrArray[index]);
+    ptrArray[index] = wrapper.alloc((prng.nextUInt32() % 256) + 1);
+  }
+  auto end = std::chrono::high_resolution_clock::now();
+
+  INFO("  Released and allocated %zu blocks in %.2f [ms]", count / 4, std::chrono::duration<double, std::milli>(end - start).count());
+  JitAllocatorTest_usage(wrapper._allocator);
+
+  for (i = 0; i < liveCount; i++)
+    wrapper.release(ptrArray[i]);
+
+  ::free(ptrArray);
+}
+
+// Each thread keeps a window of live allocations, writes a per-thread pattern to each of them
+// and verifies it before the release, which detects allocations that were handed out twice.
+static void JitAllocatorTest_contentionThread(JitAllocator* allocator, uint32_t threadId, size_t iterations, bool* failed) noexcept {
+  enum : uint32_t { kWindowSize = 64 };
+
+  struct Entry {
+    uint32_t* ro;
+    uint32_t* rw;
+    size_t size;
+  };
+
+  Entry window[kWindowSize] {};
+  Random prng(threadId);
+
+  for (size_t i = 0; i < iterations + kWindowSize; i++) {
+    Entry& entry = window[i % kWindowSize];
+
+    if (entry.ro) {
+      for (size_t j = 0; j < entry.size / 4u; j++)
+        if (entry.ro[j] != threadId)
+          *failed = true;
+      allocator->release(entry.ro);
+      entry.ro = nullptr;
+    }
+
+    if (i >= iterations)
+      continue;
+
+    size_t size = (prng.nextUInt32() % 512) + 16;
+    void* ro;
+    void* rw;
+
+    if (allocator->alloc(&ro, &rw, size) != kErrorOk) {
+      *failed = true;
+      continue;
+    }
+
+    // Mimic `JitRuntime::_add()`, which allocates an estimated size and then shrinks it.
+    if (size > 128 && (i & 1) != 0) {
+      size -= 64;
+      if (allocator->shrink(ro, size) != kErrorOk)
+        *failed = true;
+    }
+
+    entry.ro = static_cast<uint32_t*>(ro);
+    entry.rw = static_cast<uint32_t*>(rw);
+    entry.size = size;
+
+    for (size_t j = 0; j < size / 4u; j++)
+      entry.rw[j] = threadId;
+  }
+}
+
+static void JitAllocatorTest_contention(size_t iterations) noexcept {
+  uint32_t maxThreads = Support::min<uint32_t>(Support::max<uint32_t>(std::thread::hardware_concurrency(), 2u), 16u);
+
+  struct TestParams {
+    const char* name;
+    uint32_t options;
+  };
+
+  static TestParams testParams[] = {
+    { "Default", 0 },
+    { "kOptionUseThreadCaches", JitAllocator::kOptionUseThreadCaches }
+  };
+
+  for (uint32_t testId = 0; testId < ASMJIT_ARRAY_SIZE(testParams); testId++) {
+    INFO("JitAllocator(%s) - Contention (%zu allocations per thread)", testParams[testId].name, iterations);
+
+    for (uint32_t threadCount = 1; threadCount <= maxThreads; threadCount *= 2) {
+      JitAllocator::CreateParams params {};
+      params.options = testParams[testId].options;
+
+      JitAllocator allocator(&params);
+      std::vector<std::thread> threads;
+      bool failed[16] {};
+
+      auto start = std::chrono::high_resolution_clock::now();
+      for (uint32_t i = 0; i < threadCount; i++)
+        threads.emplace_back(JitAllocatorTest_contentionThread, &allocator, i + 1, iterations, &failed[i]);
+      for (std::thread& thread : threads)
+        thread.join();
+      auto end = std::chrono::high_resolution_clock::now();
+
+      double ms = std::chrono::duration<double, std::milli>(end - start).count();
+      INFO("  %2u threads: %8.2f [ms] (%.1f allocations/us)", threadCount, ms, double(iterations) * threadCount / (ms * 1000.0));
+
+      for (uint32_t i = 0; i < threadCount; i++)
+        EXPECT(!failed[i], "JitAllocator returned overlapping or invalid memory to thread #%u", i);
+
+      JitAllocator::Statistics stats = allocator.statistics();
+      EXPECT(stats.usedSize() == 0 || params.options & JitAllocator::kOptionUseThreadCaches,
+             "JitAllocator leaked %zu bytes", stats.usedSize());
+    }
+
+    // Shrinking must always take effect.
+    {
+      JitAllocator::CreateParams params {};
+      params.options = testParams[testId].options;
+      JitAllocator allocator(&params);
+
+      void* ro;
+      void* rw;
+      EXPECT(allocator.alloc(&ro, &rw, 4096) == kErrorOk);
+      size_t usedBefore = allocator.statistics().usedSize();
+
+      EXPECT(allocator.shrink(ro, 64) == kErrorOk);
+      size_t usedAfter = allocator.statistics().usedSize();
+      EXPECT(usedAfter < usedBefore, "JitAllocator::shrink() didn't release any memory");
+      EXPECT(allocator.release(ro) == kErrorOk);
+    }
+  }
+}
+
 UNIT(jit_allocator) {
   size_t kCount = BrokenAPI::hasArg("--quick") ? 1000 : 100000;
 
@@ -1122,6 +2557,13 @@ UNIT(jit_allocator) {
     { "kOptionUseMultiplePools", JitAllocator::kOptionUseMultiplePools, 0, 0 },
     { "kOptionFillUnusedMemory", JitAllocator::kOptionFillUnusedMemory, 0, 0 },
     { "kOptionImmediateRelease", JitAllocator::kOptionImmediateRelease, 0, 0 },
+    { "kOptionUseThreadCaches", JitAllocator::kOptionUseThreadCaches, 0, 0 },
+    { "kOptionUseLargePages", JitAllocator::kOptionUseLargePages, 0, 0 },
+    { "kOptionUseLargePages | kOptionUseDualMapping", JitAllocator::kOptionUseLargePages | JitAllocator::kOptionUseDualMapping, 0, 0 },
+    { "kOptionUseThreadCaches | kOptionUseMultiplePools", JitAllocator::kOptionUseThreadCaches | JitAllocator::kOptionUseMultiplePools, 0, 0 },
+    { "kOptionUseSizeClasses", JitAllocator::kOptionUseSizeClasses, 0, 0 },
+    { "kOptionUseSizeClasses | kOptionUseThreadCaches", JitAllocator::kOptionUseSizeClasses | JitAllocator::kOptionUseThreadCaches, 0, 0 },
+    { "kOptionUseBatchedProtection", JitAllocator::kOptionUseBatchedProtection, 0, 0 },
     { "kOptionUseDualMapping | kOptionFillUnusedMemory", JitAllocator::kOptionUseDualMapping | JitAllocator::kOptionFillUnusedMemory, 0, 0 }
   };
 
@@ -1137,6 +2579,27 @@ UNIT(jit_allocator) {
     BitVectorRangeIterator_testRandom<uint64_t, 64, 0>(rnd, kCount);
   }
 
+  INFO("BitVectorRangeIterator<uint32_t> with summary");
+  {
+    Random rnd;
+    BitVectorRangeIterator_testSummary<uint32_t, 96, 0>(rnd, kCount);
+  }
+
+  INFO("BitVectorRangeIterator<uint64_t> with summary");
+  {
+    Random rnd;
+    BitVectorRangeIterator_testSummary<uint64_t, 160, 0>(rnd, kCount);
+  }
+
+  // The number of words is a multiple of the summary word size, so the summary
+  // has no word past the last one, which must never be read.
+  INFO("BitVectorRangeIterator<uint64_t> with summary (words %% 64 == 0)");
+  {
+    Random rnd;
+    BitVectorRangeIterator_testSummary<uint64_t, 128, 0>(rnd, kCount);
+    BitVectorRangeIterator_testSummary<uint64_t, 64, 1>(rnd, kCount);
+  }
+
   for (uint32_t testId = 0; testId < ASMJIT_ARRAY_SIZE(testParams); testId++) {
     INFO("JitAllocator(%s)", testParams[testId].name);
 
@@ -1145,6 +2608,9 @@ UNIT(jit_allocator) {
     params.blockSize = testParams[testId].blockSize;
     params.granularity = testParams[testId].granularity;
 
+    if (params.options & JitAllocator::kOptionUseSizeClasses)
+      JitAllocatorTest_setupSizeClasses(params);
+
     size_t fixedBlockSize = 256;
 
     JitAllocatorWrapper wrapper(&params);
@@ -1236,8 +2702,33 @@ UNIT(jit_allocator) {
       wrapper.release(ptrArray[kCount - i - 1]);
     JitAllocatorTest_usage(wrapper._allocator);
 
+    INFO("  Allocating multiple adjacent blocks at once...");
+    for (i = 0; i < kCount; i += 8) {
+      size_t sizes[8];
+      for (size_t j = 0; j < 8; j++)
+        sizes[j] = (prng.nextUInt32() % 1024) + 8;
+      wrapper.allocMultiple(ptrArray + i, sizes, Support::min<size_t>(kCount - i, 8));
+    }
+    JitAllocatorTest_usage(wrapper._allocator);
+
+    INFO("  Shuffling allocated blocks...");
+    JitAllocatorTest_shuffle(ptrArray, unsigned(kCount), prng);
+
+    INFO("  Releasing all allocated blocks individually...");
+    for (i = 0; i < kCount; i++)
+      wrapper.release(ptrArray[i]);
+    JitAllocatorTest_usage(wrapper._allocator);
+
     ::free(ptrArray);
   }
+
+  JitAllocatorTest_sizeClasses();
+  JitAllocatorTest_queryRW();
+  JitAllocatorTest_largePages();
+  JitAllocatorTest_compaction();
+  JitAllocatorTest_protection(BrokenAPI::hasArg("--quick") ? 1000 : 20000);
+  JitAllocatorTest_fragmentation(BrokenAPI::hasArg("--quick") ? 10000 : 100000);
+  JitAllocatorTest_contention(BrokenAPI::hasArg("--quick") ? 10000 : 100000);
 }
 #endif
 
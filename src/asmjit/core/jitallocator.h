@@ -112,10 +112,112 @@ public:
     //! either no blocks or have all blocks fully occupied.
     kOptionImmediateRelease = 0x00000008u,
 
+    //! Enables per-thread caches that serve small allocations without taking
+    //! the allocator's lock.
+    //!
+    //! Each thread that uses the allocator gets a small cache of allocations
+    //! that were reserved in batches (per pool and per size in granules) and
+    //! a queue of deferred releases. The allocator's lock is only taken when
+    //! a cache has to be refilled, when the release queue is full, or when a
+    //! new block has to be created. Allocations larger than what the caches
+    //! handle always use the lock.
+    //!
+    //! Implications of using this option:
+    //!
+    //!   - Memory held by thread caches is reported as used by `statistics()`.
+    //!   - `release()` only validates the pointer when the release queue is
+    //!     flushed, so it cannot report an invalid pointer immediately.
+    //!   - A cache of a terminated thread is returned to the allocator lazily,
+    //!     the next time any other thread refills its cache.
+    //!   - A single thread can only have caches of a limited number of live
+    //!     allocators, any other allocator would use the lock as usual.
+    kOptionUseThreadCaches = 0x00000010u,
+
+    //! Back blocks by large pages (huge pages) to reduce TLB misses when a lot
+    //! of code is generated and executed.
+    //!
+    //! When this option is set each block is at least one large page in size
+    //! (see \ref VirtMem::largePageSize()) and its virtual memory is allocated
+    //! with \ref VirtMem::kMMapLargePages. This works for both single and dual
+    //! mapping. If large pages cannot be used a block falls back to regular
+    //! pages and keeps its regular size, use
+    //! \ref Statistics::requestedLargePageBlockCount() to find out how many
+    //! blocks were allocated with large pages requested.
+    kOptionUseLargePages = 0x00000020u,
+
+    //! Use size classes specified by \ref CreateParams::sizeClasses instead of
+    //! pools of a fixed granularity.
+    //!
+    //! Each size class has its own pool of blocks, so allocations of very
+    //! different sizes don't share blocks, which prevents fragmentation of
+    //! workloads that mix many small allocations with a few large ones. This
+    //! option takes precedence over \ref kOptionUseMultiplePools.
+    kOptionUseSizeClasses = 0x00000040u,
+
+    //! Never map memory as RWX without using dual mapping - blocks are mapped
+    //! as RW while being filled and made RX by \ref protectPending().
+    //!
+    //! This is an alternative to \ref kOptionUseDualMapping that doesn't need
+    //! a file descriptor and two mappings per block. The allocator records the
+    //! area allocated since the last call to `protectPending()` in each block
+    //! and protects it by a single `VirtMem::protect()` call per block, so the
+    //! cost of system calls is amortized across all functions added between
+    //! two calls.
+    //!
+    //! Implications of using this option:
+    //!
+    //!   - Memory returned by `alloc()` cannot be executed before
+    //!     `protectPending()` is called, and it cannot be written after that.
+    //!     Nothing can be written to memory allocated by other threads when
+    //!     `protectPending()` is called, see \ref JitRuntime::commit().
+    //!   - Protected memory is not reused until the whole block is released,
+    //!     as only whole pages can be protected. Up to a page per block can be
+    //!     wasted by each call to `protectPending()`.
+    //!   - The option is ignored if \ref kOptionUseDualMapping is set, and
+    //!     \ref kOptionUseThreadCaches is ignored if this option is set.
+    kOptionUseBatchedProtection = 0x00000080u,
+
     //! Use a custom fill pattern, must be combined with `kFlagFillUnusedMemory`.
     kOptionCustomFillPattern = 0x10000000u
   };
 
+  enum Limits : uint32_t {
+    //! Maximum number of size classes, see \ref CreateParams::sizeClasses.
+    kMaxSizeClassCount = 8
+  };
+
+  //! Size class flags, see \ref SizeClass::flags.
+  enum SizeClassFlags : uint32_t {
+    //! Each allocation of the size class gets its own block that is mapped
+    //! directly and unmapped as soon as the allocation is released.
+    //!
+    //! Use it for large allocations that would otherwise waste a big part
+    //! of a shared block.
+    kSizeClassDirect = 0x00000001u
+  };
+
+  //! Describes a size class, see \ref kOptionUseSizeClasses.
+  //!
+  //! Size classes are checked in order and an allocation is served by the
+  //! first class having `maxSize` greater than or equal to its size. The last
+  //! size class serves all allocations that don't fit any other class.
+  //!
+  //! A size class that has `maxSize` equal to `granularity` works as a slab
+  //! of fixed-size slots as each allocation consumes exactly one slot.
+  struct SizeClass {
+    //! Maximum size of allocations served by this class in bytes (0 means unlimited).
+    uint32_t maxSize;
+    //! Granularity of this class in bytes, must be a power of 2 in [16, 4096]
+    //! range, otherwise \ref CreateParams::granularity is used.
+    uint32_t granularity;
+    //! Base size of a block of this class in bytes, must be a power of 2
+    //! greater than or equal to page size, otherwise \ref CreateParams::blockSize
+    //! is used. Ignored by classes having \ref kSizeClassDirect flag.
+    uint32_t blockSize;
+    //! Size class flags, see \ref SizeClassFlags.
+    uint32_t flags;
+  };
+
   //! \name Construction & Destruction
   //! \{
 
@@ -159,6 +261,15 @@ public:
     //! Only used if \ref kOptionCustomFillPattern is set.
     uint32_t fillPattern;
 
+    //! Number of size classes in `sizeClasses` array.
+    //!
+    //! Only used if \ref kOptionUseSizeClasses is set, must be within [1, 8]
+    //! range, otherwise size classes are not used.
+    uint32_t sizeClassCount;
+
+    //! Size classes, see \ref SizeClass.
+    SizeClass sizeClasses[kMaxSizeClassCount];
+
     // Reset the content of `CreateParams`.
     inline void reset() noexcept { memset(this, 0, sizeof(*this)); }
   };
@@ -204,6 +315,42 @@ public:
   //! \remarks This function is thread-safe.
   ASMJIT_API Error alloc(void** roPtrOut, void** rwPtrOut, size_t size) noexcept;
 
+  //! Allocate `count` adjacent memory regions having the given `sizes` at once.
+  //!
+  //! The regions are carved from a single continuous area that is found by
+  //! a single search, but each region is a separate allocation that can be
+  //! released or shrunk individually. Pointers to regions are stored to
+  //! `roPtrsOut` and `rwPtrsOut` arrays, which must have `count` elements.
+  //!
+  //! \remarks This function is thread-safe.
+  ASMJIT_API Error allocMultiple(void** roPtrsOut, void** rwPtrsOut, const size_t* sizes, size_t count) noexcept;
+
+  //! Queries an allocation by the `rwPtr` returned by `alloc()`.
+  //!
+  //! Stores its Read+Execute pointer to `roPtrOut` and its size (aligned to
+  //! the granularity of its pool) to `sizeOut`. Returns `kErrorInvalidArgument`
+  //! if `rwPtr` doesn't point to the beginning of a live allocation.
+  //!
+  //! \remarks This function is thread-safe.
+  ASMJIT_API Error queryRW(void* rwPtr, void** roPtrOut, size_t* sizeOut) const noexcept;
+
+  //! Makes all memory allocated since the last call executable and read-only.
+  //!
+  //! Only does something if \ref kOptionUseBatchedProtection is set.
+  //!
+  //! \remarks This function is thread-safe.
+  ASMJIT_API Error protectPending() noexcept;
+
+  //! Returns memory held by the cache of the calling thread and by caches of
+  //! terminated threads to the allocator.
+  //!
+  //! Only does something if \ref kOptionUseThreadCaches is set. Afterwards
+  //! `statistics()` only reports memory that is actually allocated by the
+  //! calling thread and by other threads that have their own caches.
+  //!
+  //! \remarks This function is thread-safe.
+  ASMJIT_API Error flushThreadCache() noexcept;
+
   //! Release a memory returned by `alloc()`.
   //!
   //! \remarks This function is thread-safe.
@@ -216,6 +363,101 @@ public:
 
   //! \}
 
+  //! \name Compaction
+  //! \{
+
+  //! Describes an allocation moved by \ref compact().
+  struct Move {
+    //! Old address of the allocation (Read+Execute).
+    void* oldRo;
+    //! New address of the allocation (Read+Execute).
+    void* newRo;
+    //! New address of the allocation (Read+Write), can be used to patch the copied code.
+    void* newRw;
+    //! Size of the allocation in bytes (aligned to the granularity of its pool).
+    size_t size;
+  };
+
+  //! Handler used by \ref compact() to approve and finalize moves.
+  //!
+  //! Handler functions are called while the allocator is locked, they must
+  //! not call any other member function of the allocator.
+  class ASMJIT_VIRTAPI MoveHandler {
+  public:
+    ASMJIT_BASE_CLASS(MoveHandler)
+
+    ASMJIT_API MoveHandler() noexcept;
+    ASMJIT_API virtual ~MoveHandler() noexcept;
+
+    //! Called for each allocation that can be moved to another block, returns
+    //! whether the allocation should be moved.
+    //!
+    //! The default implementation approves all moves. An allocation that the
+    //! handler doesn't know (for example memory held by thread caches) must
+    //! not be approved.
+    ASMJIT_API virtual bool canMove(void* roPtr, size_t size) noexcept;
+
+    //! Called after the allocation was copied to its new location.
+    //!
+    //! The handler must relocate the copied code if it's not position
+    //! independent (for example by \ref CodeHolder::relocateToBase() and
+    //! \ref CodeHolder::copyFlattenedData() to `move.newRw`) and update all
+    //! references to the old address. If an error is returned the move is
+    //! reverted and the old allocation is kept.
+    virtual Error relocate(const Move& move) noexcept = 0;
+  };
+
+  //! Result of \ref compact().
+  struct CompactResult {
+    //! Number of moved allocations.
+    size_t _movedCount;
+    //! Number of bytes moved.
+    size_t _movedSize;
+    //! Number of blocks released.
+    size_t _releasedBlockCount;
+    //! Number of bytes of virtual memory released.
+    size_t _releasedSize;
+
+    inline void reset() noexcept {
+      _movedCount = 0;
+      _movedSize = 0;
+      _releasedBlockCount = 0;
+      _releasedSize = 0;
+    }
+
+    //! Returns the number of moved allocations.
+    inline size_t movedCount() const noexcept { return _movedCount; }
+    //! Returns the number of bytes moved.
+    inline size_t movedSize() const noexcept { return _movedSize; }
+    //! Returns the number of blocks released.
+    inline size_t releasedBlockCount() const noexcept { return _releasedBlockCount; }
+    //! Returns the number of bytes of virtual memory released.
+    inline size_t releasedSize() const noexcept { return _releasedSize; }
+  };
+
+  //! Moves allocations out of mostly unused blocks to other blocks of the same
+  //! pool and releases blocks that became empty.
+  //!
+  //! A block is considered mostly unused if at most a quarter of it is used.
+  //! The most used block of each pool is never emptied and no new blocks are
+  //! created, so compaction never increases the memory reserved. Each move has
+  //! to be approved and finalized by `handler`, see \ref MoveHandler.
+  //!
+  //! The caller is responsible for making sure that nobody executes the code
+  //! being moved, and for flushing the instruction cache of moved code (see
+  //! \ref JitRuntime::flush()). If \ref kOptionUseBatchedProtection is used
+  //! the moved code is protected before `compact()` returns.
+  //!
+  //! If \ref kOptionUseThreadCaches is used the cache of the calling thread is
+  //! flushed first. Caches of other threads cannot be flushed safely, so \ref
+  //! kErrorInvalidState is returned if any other thread, which is still running,
+  //! has allocated or released memory through this allocator.
+  //!
+  //! \remarks This function is thread-safe.
+  ASMJIT_API Error compact(MoveHandler* handler, CompactResult* resultOut = nullptr) noexcept;
+
+  //! \}
+
   //! \name Statistics
   //! \{
 
@@ -229,16 +471,26 @@ public:
     size_t _reservedSize;
     //! Allocation overhead (in bytes) required to maintain all blocks.
     size_t _overheadSize;
+    //! Number of blocks allocated with large pages requested.
+    size_t _requestedLargePageBlockCount;
 
     inline void reset() noexcept {
       _blockCount = 0;
       _usedSize = 0;
       _reservedSize = 0;
       _overheadSize = 0;
+      _requestedLargePageBlockCount = 0;
     }
 
     //! Returns count of blocks managed by `JitAllocator` at the moment.
     inline size_t blockCount() const noexcept { return _blockCount; }
+    //! Returns count of blocks allocated with large pages requested, see
+    //! \ref kOptionUseLargePages.
+    //!
+    //! \note This is not the number of blocks backed by large pages. If the
+    //! memory was mapped as transparent huge pages the kernel only accepted
+    //! the advice and it can back any part of the block by regular pages.
+    inline size_t requestedLargePageBlockCount() const noexcept { return _requestedLargePageBlockCount; }
 
     //! Returns how many bytes are currently used.
     inline size_t usedSize() const noexcept { return _usedSize; }
@@ -267,6 +519,15 @@ public:
   //! \remarks This function is thread-safe.
   ASMJIT_API Statistics statistics() const noexcept;
 
+  //! Returns statistics of a size class at the given `index`.
+  //!
+  //! If \ref kOptionUseSizeClasses is not used the `index` refers to one of
+  //! the internal pools instead. Returns empty statistics if `index` is out
+  //! of range.
+  //!
+  //! \remarks This function is thread-safe.
+  ASMJIT_API Statistics sizeClassStatistics(size_t index) const noexcept;
+
   //! \}
 };
 
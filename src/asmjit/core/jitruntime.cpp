@@ -26,6 +26,7 @@
 
 #include "../core/cpuinfo.h"
 #include "../core/jitruntime.h"
+#include "../core/osutils_p.h"
 
 ASMJIT_BEGIN_NAMESPACE
 
@@ -56,20 +57,48 @@ static inline void JitRuntime_flushInstructionCache(const void* p, size_t size)
 // ============================================================================
 
 JitRuntime::JitRuntime(const JitAllocator::CreateParams* params) noexcept
-  : _allocator(params) {
+  : _allocator(params),
+    _publicationZone(1024),
+    _publicationAllocator(&_publicationZone),
+    _publicationOpen(false) {
   _environment = hostEnvironment();
   _environment.setFormat(Environment::kFormatJIT);
 }
 
-JitRuntime::~JitRuntime() noexcept {}
+JitRuntime::~JitRuntime() noexcept {
+  // Nobody can execute the code anymore, so there is no point of flushing.
+  _pendingFlushes.release(&_publicationAllocator);
+}
 
 // ============================================================================
 // [asmjit::JitRuntime - Interface]
 // ============================================================================
 
-Error JitRuntime::_add(void** dst, CodeHolder* code) noexcept {
+// Memory is made read-only by `JitAllocator::protectPending()`, which is called by each `add()` when
+// batched protection is used without a publication window, so nobody else can write at that time.
+static inline bool JitRuntime_needsSerializedAdd(const JitRuntime* rt) noexcept {
+  return rt->_allocator.hasOption(JitAllocator::kOptionUseBatchedProtection) && !rt->isPublicationOpen();
+}
+
+// Returns the memory used by the `.text` section of `code` if it was attached by `attachZeroCopyBuffer()`.
+static inline bool JitRuntime_queryZeroCopyBuffer(JitRuntime* rt, CodeHolder* code, uint8_t** roOut, uint8_t** rwOut, size_t* sizeOut) noexcept {
+  CodeBuffer& buffer = code->textSection()->_buffer;
+  if (!buffer.isExternal() || !buffer.data())
+    return false;
+
+  *rwOut = buffer.data();
+  return rt->allocator()->queryRW(buffer.data(), (void**)roOut, sizeOut) == kErrorOk;
+}
+
+static Error JitRuntime_addCode(JitRuntime* rt, void** dst, CodeHolder* code) noexcept {
+  JitAllocator* allocator = rt->allocator();
   *dst = nullptr;
 
+  uint8_t* zeroCopyRo = nullptr;
+  uint8_t* zeroCopyRw = nullptr;
+  size_t zeroCopySize = 0;
+  bool isZeroCopy = JitRuntime_queryZeroCopyBuffer(rt, code, &zeroCopyRo, &zeroCopyRw, &zeroCopySize);
+
   ASMJIT_PROPAGATE(code->flatten());
   ASMJIT_PROPAGATE(code->resolveUnresolvedLinks());
 
@@ -79,12 +108,22 @@ Error JitRuntime::_add(void** dst, CodeHolder* code) noexcept {
 
   uint8_t* ro;
   uint8_t* rw;
-  ASMJIT_PROPAGATE(_allocator.alloc((void**)&ro, (void**)&rw, estimatedCodeSize));
+
+  // Use the memory of a zero-copy buffer if the whole code fits into it, otherwise copy as usual.
+  bool isInPlace = isZeroCopy && code->textSection()->offset() == 0 && estimatedCodeSize <= zeroCopySize;
+  if (isInPlace) {
+    ro = zeroCopyRo;
+    rw = zeroCopyRw;
+  }
+  else {
+    ASMJIT_PROPAGATE(allocator->alloc((void**)&ro, (void**)&rw, estimatedCodeSize));
+  }
 
   // Relocate the code.
   Error err = code->relocateToBase(uintptr_t((void*)ro));
   if (ASMJIT_UNLIKELY(err)) {
-    _allocator.release(ro);
+    if (!isInPlace)
+      allocator->release(ro);
     return err;
   }
 
@@ -97,8 +136,10 @@ Error JitRuntime::_add(void** dst, CodeHolder* code) noexcept {
     size_t bufferSize = size_t(section->bufferSize());
     size_t virtualSize = size_t(section->virtualSize());
 
+    // Data of a zero-copy buffer are already in place.
     ASMJIT_ASSERT(offset + bufferSize <= codeSize);
-    memcpy(rw + offset, section->data(), bufferSize);
+    if (section->data() != rw + offset)
+      memcpy(rw + offset, section->data(), bufferSize);
 
     if (virtualSize > bufferSize) {
       ASMJIT_ASSERT(offset + virtualSize <= codeSize);
@@ -106,16 +147,188 @@ Error JitRuntime::_add(void** dst, CodeHolder* code) noexcept {
     }
   }
 
-  if (codeSize < estimatedCodeSize)
-    _allocator.shrink(ro, codeSize);
+  // A zero-copy buffer is usually much larger than the code.
+  size_t allocatedSize = isInPlace ? zeroCopySize : estimatedCodeSize;
+  if (codeSize < allocatedSize)
+    allocator->shrink(ro, codeSize);
 
-  flush(ro, codeSize);
-  *dst = ro;
+  // The code now lives in executable memory, which must not be referenced by the `CodeHolder` anymore.
+  if (isZeroCopy) {
+    code->setExternalBuffer(&code->textSection()->_buffer, nullptr, 0);
+    if (!isInPlace)
+      allocator->release(zeroCopyRo);
+  }
+
+  err = rt->_publish(ro, codeSize);
+  if (ASMJIT_UNLIKELY(err)) {
+    allocator->release(ro);
+    return err;
+  }
 
+  *dst = ro;
   return kErrorOk;
 }
 
+static Error JitRuntime_addBatch(JitRuntime* rt, void** dsts, CodeHolder** codes, size_t count) noexcept {
+  JitAllocator* allocator = rt->allocator();
+
+  for (size_t i = 0; i < count; i++)
+    dsts[i] = nullptr;
+
+  if (ASMJIT_UNLIKELY(count == 0))
+    return DebugUtils::errored(kErrorInvalidArgument);
+
+  // Estimated sizes and RW pointers are only needed until all functions are
+  // relocated, so use the stack for small batches and the heap for larger ones.
+  size_t stackSizes[64];
+  void* stackRws[64];
+
+  size_t* sizes = stackSizes;
+  void** rws = stackRws;
+
+  if (count > ASMJIT_ARRAY_SIZE(stackSizes)) {
+    sizes = static_cast<size_t*>(::malloc(count * (sizeof(size_t) + sizeof(void*))));
+    if (ASMJIT_UNLIKELY(!sizes))
+      return DebugUtils::errored(kErrorOutOfMemory);
+    rws = reinterpret_cast<void**>(sizes + count);
+  }
+
+  Error err = kErrorOk;
+
+  for (size_t i = 0; i < count; i++) {
+    CodeHolder* code = codes[i];
+
+    err = code->flatten();
+    if (!err)
+      err = code->resolveUnresolvedLinks();
+    if (ASMJIT_UNLIKELY(err))
+      goto Done;
+
+    sizes[i] = code->codeSize();
+    if (ASMJIT_UNLIKELY(sizes[i] == 0)) {
+      err = DebugUtils::errored(kErrorNoCodeGenerated);
+      goto Done;
+    }
+  }
+
+  err = allocator->allocMultiple(dsts, rws, sizes, count);
+  if (ASMJIT_UNLIKELY(err))
+    goto Done;
+
+  for (size_t i = 0; i < count; i++) {
+    CodeHolder* code = codes[i];
+    uint8_t* rw = static_cast<uint8_t*>(rws[i]);
+
+    err = code->relocateToBase(uintptr_t(dsts[i]));
+    if (ASMJIT_UNLIKELY(err)) {
+      for (size_t j = 0; j < count; j++) {
+        allocator->release(dsts[j]);
+        dsts[j] = nullptr;
+      }
+      goto Done;
+    }
+
+    size_t codeSize = code->codeSize();
+    for (Section* section : code->_sections) {
+      size_t offset = size_t(section->offset());
+      size_t bufferSize = size_t(section->bufferSize());
+      size_t virtualSize = size_t(section->virtualSize());
+
+      ASMJIT_ASSERT(offset + bufferSize <= codeSize);
+      memcpy(rw + offset, section->data(), bufferSize);
+
+      if (virtualSize > bufferSize) {
+        ASMJIT_ASSERT(offset + virtualSize <= codeSize);
+        memset(rw + offset + bufferSize, 0, virtualSize - bufferSize);
+      }
+    }
+
+    if (codeSize < sizes[i])
+      allocator->shrink(dsts[i], codeSize);
+  }
+
+  // All functions are adjacent, so a single flush covers all of them.
+  err = rt->_publish(dsts[0], size_t(static_cast<uint8_t*>(dsts[count - 1]) - static_cast<uint8_t*>(dsts[0])) + sizes[count - 1]);
+  if (ASMJIT_UNLIKELY(err)) {
+    for (size_t i = 0; i < count; i++) {
+      allocator->release(dsts[i]);
+      dsts[i] = nullptr;
+    }
+    goto Done;
+  }
+
+  // Zero-copy buffers are not used by batches, they were copied like other sections.
+  for (size_t i = 0; i < count; i++)
+    if (codes[i]->textSection()->buffer().isExternal())
+      rt->detachZeroCopyBuffer(codes[i]);
+
+Done:
+  if (sizes != stackSizes)
+    ::free(sizes);
+
+  return err;
+}
+
+Error JitRuntime::_add(void** dst, CodeHolder* code) noexcept {
+  if (!JitRuntime_needsSerializedAdd(this))
+    return JitRuntime_addCode(this, dst, code);
+
+  LockGuard guard(_publicationLock);
+  return JitRuntime_addCode(this, dst, code);
+}
+
+Error JitRuntime::addBatch(void** dsts, CodeHolder** codes, size_t count) noexcept {
+  if (!JitRuntime_needsSerializedAdd(this))
+    return JitRuntime_addBatch(this, dsts, codes, count);
+
+  LockGuard guard(_publicationLock);
+  return JitRuntime_addBatch(this, dsts, codes, count);
+}
+
+Error JitRuntime::attachZeroCopyBuffer(CodeHolder* code, size_t capacity) noexcept {
+  if (ASMJIT_UNLIKELY(!code->isInitialized()))
+    return DebugUtils::errored(kErrorNotInitialized);
+
+  if (ASMJIT_UNLIKELY(capacity == 0))
+    return DebugUtils::errored(kErrorInvalidArgument);
+
+  // Memory could be protected by another thread while the code is being emitted.
+  if (ASMJIT_UNLIKELY(_allocator.hasOption(JitAllocator::kOptionUseBatchedProtection)))
+    return DebugUtils::errored(kErrorFeatureNotEnabled);
+
+  CodeBuffer& buffer = code->textSection()->_buffer;
+  if (ASMJIT_UNLIKELY(buffer.size() != 0 || buffer.isExternal()))
+    return DebugUtils::errored(kErrorInvalidState);
+
+  void* ro;
+  void* rw;
+  ASMJIT_PROPAGATE(_allocator.alloc(&ro, &rw, capacity));
+
+  Error err = code->setExternalBuffer(&buffer, rw, capacity);
+  if (ASMJIT_UNLIKELY(err))
+    _allocator.release(ro);
+  return err;
+}
+
+Error JitRuntime::detachZeroCopyBuffer(CodeHolder* code) noexcept {
+  uint8_t* ro;
+  uint8_t* rw;
+  size_t size;
+
+  if (ASMJIT_UNLIKELY(!code->isInitialized() || !JitRuntime_queryZeroCopyBuffer(this, code, &ro, &rw, &size)))
+    return DebugUtils::errored(kErrorInvalidState);
+
+  code->setExternalBuffer(&code->textSection()->_buffer, nullptr, 0);
+  return _allocator.release(ro);
+}
+
 Error JitRuntime::_release(void* p) noexcept {
+  // The released memory can be unmapped, so don't keep ranges that could point to it.
+  if (isPublicationOpen()) {
+    LockGuard guard(_publicationLock);
+    _flushPending();
+  }
+
   return _allocator.release(p);
 }
 
@@ -123,6 +336,85 @@ void JitRuntime::flush(const void* p, size_t size) noexcept {
   JitRuntime_flushInstructionCache(p, size);
 }
 
+// ============================================================================
+// [asmjit::JitRuntime - Publication]
+// ============================================================================
+
+Error JitRuntime::beginPublication() noexcept {
+  LockGuard guard(_publicationLock);
+  if (ASMJIT_UNLIKELY(isPublicationOpen()))
+    return DebugUtils::errored(kErrorInvalidState);
+
+  _publicationOpen.store(true, std::memory_order_release);
+  return kErrorOk;
+}
+
+Error JitRuntime::commit() noexcept {
+  LockGuard guard(_publicationLock);
+  if (ASMJIT_UNLIKELY(!isPublicationOpen()))
+    return DebugUtils::errored(kErrorInvalidState);
+
+  // Pending memory must be executable before it's flushed.
+  Error err = _allocator.protectPending();
+  _flushPending();
+  _publicationOpen.store(false, std::memory_order_release);
+  return err;
+}
+
+Error JitRuntime::_publish(const void* p, size_t size) noexcept {
+  if (isPublicationOpen()) {
+    LockGuard guard(_publicationLock);
+
+    // The window could have been closed in the meantime.
+    if (isPublicationOpen()) {
+      uintptr_t start = uintptr_t(p);
+      if (_pendingFlushes.append(&_publicationAllocator, FlushRange { start, start + size }) == kErrorOk)
+        return kErrorOk;
+
+      // Flush everything that is pending and this range immediately if we are out of memory.
+      ASMJIT_PROPAGATE(_allocator.protectPending());
+      _flushPending();
+    }
+  }
+  else {
+    ASMJIT_PROPAGATE(_allocator.protectPending());
+  }
+
+  flush(p, size);
+  return kErrorOk;
+}
+
+void JitRuntime::_flushPending() noexcept {
+  FlushRange* ranges = _pendingFlushes.data();
+  size_t count = _pendingFlushes.size();
+
+  if (count) {
+    Support::qSort(ranges, count, [](const FlushRange& a, const FlushRange& b) noexcept {
+      return a.start < b.start ? -1 : a.start > b.start ? 1 : 0;
+    });
+
+    // Merge ranges if there is no page between them that could be unmapped, a gap within
+    // a page that holds the end of the previous range or the start of the next one is fine.
+    uintptr_t pageSize = VirtMem::info().pageSize;
+
+    FlushRange current = ranges[0];
+    for (size_t i = 1; i < count; i++) {
+      uintptr_t lastPage = Support::alignDown(current.end - 1u, pageSize);
+      if (Support::alignDown(ranges[i].start, pageSize) <= lastPage + pageSize) {
+        current.end = Support::max(current.end, ranges[i].end);
+      }
+      else {
+        flush(reinterpret_cast<const void*>(current.start), size_t(current.end - current.start));
+        current = ranges[i];
+      }
+    }
+    flush(reinterpret_cast<const void*>(current.start), size_t(current.end - current.start));
+  }
+
+  // Keep the capacity for the next publication window.
+  _pendingFlushes.clear();
+}
+
 ASMJIT_END_NAMESPACE
 
 #endif
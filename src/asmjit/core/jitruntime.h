@@ -29,7 +29,12 @@
 
 #include "../core/codeholder.h"
 #include "../core/jitallocator.h"
+#include "../core/osutils.h"
 #include "../core/target.h"
+#include "../core/zone.h"
+#include "../core/zonevector.h"
+
+#include <atomic>
 
 ASMJIT_BEGIN_NAMESPACE
 
@@ -48,9 +53,29 @@ class ASMJIT_VIRTAPI JitRuntime : public Target {
 public:
   ASMJIT_NONCOPYABLE(JitRuntime)
 
+  //! Range of memory that needs an instruction cache flush.
+  struct FlushRange {
+    uintptr_t start;
+    uintptr_t end;
+  };
+
   //! Virtual memory allocator.
   JitAllocator _allocator;
 
+  //! Lock that protects the publication window.
+  mutable Lock _publicationLock;
+  //! Zone used by `_pendingFlushes`.
+  Zone _publicationZone;
+  //! Zone allocator used by `_pendingFlushes`.
+  ZoneAllocator _publicationAllocator;
+  //! Ranges that were published, but not flushed yet.
+  ZoneVector<FlushRange> _pendingFlushes;
+  //! Whether a publication window is open.
+  //!
+  //! Only changed with `_publicationLock` locked, but read without it to avoid
+  //! locking when no publication window is open.
+  std::atomic<bool> _publicationOpen;
+
   //! \name Construction & Destruction
   //! \{
 
@@ -71,6 +96,9 @@ public:
   //! Returns the associated `JitAllocator`.
   inline JitAllocator* allocator() const noexcept { return const_cast<JitAllocator*>(&_allocator); }
 
+  //! Tests whether a publication window is open, see \ref beginPublication().
+  inline bool isPublicationOpen() const noexcept { return _publicationOpen.load(std::memory_order_acquire); }
+
   //! \}
 
   //! \name Utilities
@@ -99,9 +127,75 @@ public:
   //! Type-unsafe version of `add()`.
   ASMJIT_API virtual Error _add(void** dst, CodeHolder* code) noexcept;
 
+  //! Adds `count` code holders at once.
+  //!
+  //! Works like calling `add()` for each code holder, but all functions share
+  //! a single allocation request to `JitAllocator` and a single instruction
+  //! cache flush, which makes publishing many small functions much cheaper.
+  //! Each function stored in `dsts` is a separate allocation that must be
+  //! released by `release()` as usual.
+  //!
+  //! Either all functions are added or none - if any code holder fails, all
+  //! `dsts` are set to `nullptr` and the `Error` code is returned.
+  ASMJIT_API Error addBatch(void** dsts, CodeHolder** codes, size_t count) noexcept;
+
   //! Type-unsafe version of `release()`.
   ASMJIT_API virtual Error _release(void* p) noexcept;
 
+  //! Makes the `.text` section of `code` use `capacity` bytes of memory
+  //! allocated by the runtime's allocator as its buffer.
+  //!
+  //! Code emitted to `.text` is written directly to the memory it will be
+  //! executed from, so `add()` only relocates it in place, copies other
+  //! sections after it, and shrinks the allocation, which saves a copy of
+  //! the whole `.text` section and one allocation. The buffer has a fixed
+  //! capacity, emitting more than `capacity` bytes fails with `kErrorTooLarge`.
+  //! If other sections don't fit into the capacity `add()` falls back to a
+  //! regular allocation and copy.
+  //!
+  //! After `code` is successfully added its `.text` section is empty, as the
+  //! code lives in the executable memory. If `code` is not going to be added
+  //! the buffer must be released by `detachZeroCopyBuffer()`.
+  //!
+  //! Not available if the allocator uses \ref JitAllocator::kOptionUseBatchedProtection,
+  //! returns `kErrorFeatureNotEnabled` in that case.
+  ASMJIT_API Error attachZeroCopyBuffer(CodeHolder* code, size_t capacity) noexcept;
+
+  //! Releases a buffer attached by `attachZeroCopyBuffer()` that was not
+  //! added, the `.text` section of `code` becomes empty.
+  ASMJIT_API Error detachZeroCopyBuffer(CodeHolder* code) noexcept;
+
+  //! Opens a publication window.
+  //!
+  //! While the window is open `add()` and `addBatch()` don't flush the
+  //! instruction cache, they only record ranges that need to be flushed.
+  //! The code added during the window must not be executed before the
+  //! window is closed by `commit()`, which merges adjacent ranges and
+  //! flushes each merged range once. This makes adding thousands of
+  //! functions much cheaper on hosts that need an explicit cache flush.
+  //!
+  //! Releasing a function while the window is open flushes all pending
+  //! ranges first, as the released memory could be unmapped.
+  //!
+  //! When the allocator uses \ref JitAllocator::kOptionUseBatchedProtection
+  //! the memory is also made executable by `commit()` instead of by each
+  //! `add()`, which means that a single `VirtMem::protect()` call per block
+  //! is needed. In that case `commit()` must not be called while other
+  //! threads are still adding code.
+  //!
+  //! Returns `kErrorInvalidState` if the window is already open.
+  //!
+  //! \remarks This function is thread-safe.
+  ASMJIT_API Error beginPublication() noexcept;
+
+  //! Flushes all ranges recorded since `beginPublication()` and closes the
+  //! publication window.
+  //!
+  //! Returns `kErrorInvalidState` if the window is not open.
+  //!
+  //! \remarks This function is thread-safe.
+  ASMJIT_API Error commit() noexcept;
+
   //! Flushes an instruction cache.
   //!
   //! This member function is called after the code has been copied to the
@@ -116,6 +210,18 @@ public:
   ASMJIT_API virtual void flush(const void* p, size_t size) noexcept;
 
   //! \}
+
+  //! \cond INTERNAL
+  //! \name Internal
+  //! \{
+
+  //! Protects and flushes `[p, p + size)` or defers both if a publication window is open.
+  ASMJIT_API Error _publish(const void* p, size_t size) noexcept;
+  //! Flushes all pending ranges, must be called with `_publicationLock` locked.
+  ASMJIT_API void _flushPending() noexcept;
+
+  //! \}
+  //! \endcond
 };
 
 //! \}
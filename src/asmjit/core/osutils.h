@@ -76,6 +76,7 @@ public:
   inline ~Lock() noexcept;
 
   inline void lock() noexcept;
+  inline bool tryLock() noexcept;
   inline void unlock() noexcept;
 };
 //! \endcond
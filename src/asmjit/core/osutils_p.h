@@ -45,6 +45,7 @@ static_assert(alignof(Lock::Handle) == alignof(CRITICAL_SECTION), "asmjit::Lock:
 inline Lock::Lock() noexcept { InitializeCriticalSection(reinterpret_cast<CRITICAL_SECTION*>(&_handle)); }
 inline Lock::~Lock() noexcept { DeleteCriticalSection(reinterpret_cast<CRITICAL_SECTION*>(&_handle)); }
 inline void Lock::lock() noexcept { EnterCriticalSection(reinterpret_cast<CRITICAL_SECTION*>(&_handle)); }
+inline bool Lock::tryLock() noexcept { return TryEnterCriticalSection(reinterpret_cast<CRITICAL_SECTION*>(&_handle)) != 0; }
 inline void Lock::unlock() noexcept { LeaveCriticalSection(reinterpret_cast<CRITICAL_SECTION*>(&_handle)); }
 
 #elif !defined(__EMSCRIPTEN__)
@@ -57,6 +58,7 @@ inline Lock::Lock() noexcept { pthread_mutex_init(&_handle, nullptr); }
 #endif
 inline Lock::~Lock() noexcept { pthread_mutex_destroy(&_handle); }
 inline void Lock::lock() noexcept { pthread_mutex_lock(&_handle); }
+inline bool Lock::tryLock() noexcept { return pthread_mutex_trylock(&_handle) == 0; }
 inline void Lock::unlock() noexcept { pthread_mutex_unlock(&_handle); }
 
 #else
@@ -65,6 +67,7 @@ inline void Lock::unlock() noexcept { pthread_mutex_unlock(&_handle); }
 inline Lock::Lock() noexcept {}
 inline Lock::~Lock() noexcept {}
 inline void Lock::lock() noexcept {}
+inline bool Lock::tryLock() noexcept { return true; }
 inline void Lock::unlock() noexcept {}
 
 #endif
@@ -0,0 +1,180 @@
+// AsmJit - Machine code generation for C++
+//
+//  * Official AsmJit Home Page: https://asmjit.com
+//  * Official Github Repository: https://github.com/asmjit/asmjit
+//
+// Copyright (c) 2008-2020 The AsmJit Authors
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#include "../core/api-build_p.h"
+#ifndef ASMJIT_NO_BUILDER
+
+#include "../core/logger.h"
+#include "../core/peepholepass.h"
+
+ASMJIT_BEGIN_NAMESPACE
+
+// ============================================================================
+// [asmjit::BasePeepholePass - Helpers]
+// ============================================================================
+
+// Labels and comments don't emit any code, so a jump to a label that is bound
+// after them is a jump to the next instruction.
+static ASMJIT_INLINE bool BasePeepholePass_isTransparent(const BaseNode* node) noexcept {
+  return node->type() == BaseNode::kNodeLabel || node->isComment();
+}
+
+static bool BasePeepholePass_isLabelNext(const BaseNode* node, uint32_t labelId) noexcept {
+  node = node->next();
+  while (node && BasePeepholePass_isTransparent(node)) {
+    if (node->type() == BaseNode::kNodeLabel && node->as<LabelNode>()->labelId() == labelId)
+      return true;
+    node = node->next();
+  }
+  return false;
+}
+
+static ASMJIT_INLINE uint32_t BasePeepholePass_jumpTargetOf(const InstNode* node) noexcept {
+  return node->op(node->opCount() - 1).as<Label>().id();
+}
+
+// ============================================================================
+// [asmjit::BasePeepholePass - Construction / Destruction]
+// ============================================================================
+
+BasePeepholePass::BasePeepholePass(const char* name) noexcept
+  : Pass(name) {
+  resetRuleCounters();
+}
+BasePeepholePass::~BasePeepholePass() noexcept {}
+
+// ============================================================================
+// [asmjit::BasePeepholePass - Accessors]
+// ============================================================================
+
+const char* BasePeepholePass::ruleName(uint32_t rule) noexcept {
+  switch (rule) {
+    case kRuleRedundantMove: return "RedundantMove";
+    case kRuleIdentityOp   : return "IdentityOp";
+    case kRuleJumpToNext   : return "JumpToNext";
+    case kRuleJumpChain    : return "JumpChain";
+    default:
+      return "<Unknown>";
+  }
+}
+
+// ============================================================================
+// [asmjit::BasePeepholePass - Run]
+// ============================================================================
+
+Error BasePeepholePass::run(Zone* zone, Logger* logger) {
+  DebugUtils::unused(zone);
+
+  uint32_t counters[kRuleCount] {};
+  bool changed;
+
+  do {
+    changed = false;
+    BaseNode* node = _cb->firstNode();
+
+    while (node) {
+      BaseNode* next = node->next();
+
+      if (node->type() == BaseNode::kNodeInst) {
+        InstNode* inst = node->as<InstNode>();
+        uint32_t jumpType = jumpTypeOf(inst);
+        uint32_t rule = kRuleCount;
+
+        if (jumpType != kJumpNone) {
+          // Follow unconditional jumps the target label is followed by. A chain
+          // that is too long is most likely an infinite loop, which is kept.
+          // Jumps forced to use a short form are never retargeted as the final
+          // destination could be out of their range.
+          uint32_t targetId = BasePeepholePass_jumpTargetOf(inst);
+          uint32_t finalId = targetId;
+          uint32_t chainLimit = (inst->instOptions() & BaseInst::kOptionShortForm) ? 0u : uint32_t(kMaxJumpChain + 1);
+
+          for (uint32_t i = 0; i < chainLimit; i++) {
+            LabelNode* labelNode;
+            ASMJIT_PROPAGATE(_cb->labelNodeOf(&labelNode, finalId));
+
+            // Skip labels that were not bound yet.
+            if (!labelNode->prev() && _cb->firstNode() != labelNode)
+              break;
+
+            BaseNode* dest = labelNode->next();
+            while (dest && BasePeepholePass_isTransparent(dest))
+              dest = dest->next();
+
+            if (!dest || dest->type() != BaseNode::kNodeInst || jumpTypeOf(dest->as<InstNode>()) != kJumpUnconditional || dest == inst)
+              break;
+
+            if (i == kMaxJumpChain) {
+              finalId = targetId;
+              break;
+            }
+
+            finalId = BasePeepholePass_jumpTargetOf(dest->as<InstNode>());
+          }
+
+          if (finalId != targetId) {
+            inst->op(inst->opCount() - 1) = Label(finalId);
+            counters[kRuleJumpChain]++;
+            changed = true;
+          }
+
+          if (BasePeepholePass_isLabelNext(inst, finalId))
+            rule = kRuleJumpToNext;
+        }
+        else if (!isRedundantInst(inst, &rule)) {
+          rule = kRuleCount;
+        }
+
+        if (rule != kRuleCount) {
+          _cb->removeNode(inst);
+          counters[rule]++;
+          changed = true;
+        }
+      }
+
+      node = next;
+    }
+  } while (changed);
+
+  for (uint32_t i = 0; i < kRuleCount; i++)
+    _ruleCounters[i] += counters[i];
+
+#ifndef ASMJIT_NO_LOGGING
+  if (logger && logger->hasFlag(FormatOptions::kFlagDebugPasses)) {
+    StringTmp<256> sb;
+    sb.appendFormat("[%s]", name());
+    for (uint32_t i = 0; i < kRuleCount; i++)
+      sb.appendFormat(" %s=%u", ruleName(i), counters[i]);
+    sb.append('\n');
+    logger->log(sb);
+  }
+#else
+  DebugUtils::unused(logger);
+#endif
+
+  return kErrorOk;
+}
+
+ASMJIT_END_NAMESPACE
+
+#endif // !ASMJIT_NO_BUILDER
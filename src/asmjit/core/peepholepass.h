@@ -0,0 +1,154 @@
+// AsmJit - Machine code generation for C++
+//
+//  * Official AsmJit Home Page: https://asmjit.com
+//  * Official Github Repository: https://github.com/asmjit/asmjit
+//
+// Copyright (c) 2008-2020 The AsmJit Authors
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#ifndef ASMJIT_CORE_PEEPHOLEPASS_H_INCLUDED
+#define ASMJIT_CORE_PEEPHOLEPASS_H_INCLUDED
+
+#include "../core/api-config.h"
+#ifndef ASMJIT_NO_BUILDER
+
+#include "../core/builder.h"
+
+ASMJIT_BEGIN_NAMESPACE
+
+//! \addtogroup asmjit_builder
+//! \{
+
+// ============================================================================
+// [asmjit::BasePeepholePass]
+// ============================================================================
+
+//! Peephole optimization pass (base class).
+//!
+//! Removes instructions that have no effect and simplifies jumps to labels.
+//! Jump rules are architecture independent and use \ref jumpTypeOf() to
+//! recognize jumps, all other rules are implemented by \ref isRedundantInst()
+//! of architecture specific passes, like \ref x86::PeepholePass. Both can be
+//! overridden to add more rules.
+//!
+//! The pass only looks at \ref InstNode nodes, so when used with \ref
+//! BaseCompiler it should run after the register allocator, which is
+//! guaranteed when it's added after the compiler has been attached to \ref
+//! CodeHolder:
+//!
+//! ```
+//! x86::Compiler cc(&code);
+//! cc.addPassT<x86::PeepholePass>();
+//! ```
+class ASMJIT_VIRTAPI BasePeepholePass : public Pass {
+public:
+  ASMJIT_NONCOPYABLE(BasePeepholePass)
+  typedef Pass Base;
+
+  //! Peephole rule.
+  enum Rule : uint32_t {
+    //! Move of a register to itself (`mov rax, rax`), removed.
+    kRuleRedundantMove = 0,
+    //! Operation that doesn't change its destination (`add rax, 0`), removed.
+    kRuleIdentityOp = 1,
+    //! Jump to a label that immediately follows the jump, removed.
+    kRuleJumpToNext = 2,
+    //! Jump to an unconditional jump, retargeted to the final destination.
+    kRuleJumpChain = 3,
+
+    //! Count of rules.
+    kRuleCount = 4
+  };
+
+  //! Type of a jump returned by \ref jumpTypeOf().
+  enum JumpType : uint32_t {
+    //! Not a jump to a label or a jump that has side effects.
+    kJumpNone = 0,
+    //! Conditional jump.
+    kJumpConditional = 1,
+    //! Unconditional jump.
+    kJumpUnconditional = 2
+  };
+
+  //! Peephole limits.
+  enum Limits : uint32_t {
+    //! Maximum number of unconditional jumps followed when resolving a chain.
+    kMaxJumpChain = 16
+  };
+
+  //! Number of times each rule was applied.
+  uint32_t _ruleCounters[kRuleCount];
+
+  //! \name Construction & Destruction
+  //! \{
+
+  ASMJIT_API BasePeepholePass(const char* name) noexcept;
+  ASMJIT_API virtual ~BasePeepholePass() noexcept;
+
+  //! \}
+
+  //! \name Accessors
+  //! \{
+
+  //! Returns how many times the given `rule` was applied by all runs of the pass.
+  inline uint32_t ruleCounter(uint32_t rule) const noexcept {
+    ASMJIT_ASSERT(rule < kRuleCount);
+    return _ruleCounters[rule];
+  }
+
+  //! Resets all rule counters to zero.
+  inline void resetRuleCounters() noexcept {
+    for (uint32_t i = 0; i < kRuleCount; i++)
+      _ruleCounters[i] = 0;
+  }
+
+  //! Returns the name of the given `rule`.
+  ASMJIT_API static const char* ruleName(uint32_t rule) noexcept;
+
+  //! \}
+
+  //! \name Peephole Interface
+  //! \{
+
+  //! Returns the type of the jump `node` (see \ref JumpType). Only jumps that
+  //! have a label as their last operand and that have no other side effects
+  //! may be reported, as they can be removed or retargeted. Jumps with a limited
+  //! range must not be reported, jumps that use \ref BaseInst::kOptionShortForm
+  //! are never retargeted.
+  virtual uint32_t jumpTypeOf(const InstNode* node) const noexcept = 0;
+
+  //! Tests whether the instruction `node` can be removed as it has no effect,
+  //! and stores the rule that matched to `ruleOut`.
+  virtual bool isRedundantInst(const InstNode* node, uint32_t* ruleOut) const noexcept = 0;
+
+  //! \}
+
+  //! \name Pass Interface
+  //! \{
+
+  ASMJIT_API Error run(Zone* zone, Logger* logger) override;
+
+  //! \}
+};
+
+//! \}
+
+ASMJIT_END_NAMESPACE
+
+#endif // !ASMJIT_NO_BUILDER
+#endif // ASMJIT_CORE_PEEPHOLEPASS_H_INCLUDED
@@ -68,6 +68,7 @@ ASMJIT_BEGIN_NAMESPACE
 class BaseRAPass;
 class RABlock;
 class BaseNode;
+class InstNode;
 struct RAStackSlot;
 
 typedef ZoneVector<RABlock*> RABlocks;
@@ -586,6 +587,27 @@ public:
     return intersects(*this, other);
   }
 
+  //! Tests whether any span overlaps the range [start, end).
+  inline bool overlaps(uint32_t start, uint32_t end) const noexcept {
+    const T* span = _data.data();
+    const T* spanEnd = span + _data.size();
+    uint32_t n = _data.size();
+
+    // Find the first span that ends after `start` (spans are sorted).
+    while (n) {
+      uint32_t half = n / 2u;
+      if (span[half].b <= start) {
+        span += half + 1;
+        n -= half + 1;
+      }
+      else {
+        n = half;
+      }
+    }
+
+    return span != spanEnd && span->a < end;
+  }
+
   ASMJIT_INLINE Error nonOverlappingUnionOf(ZoneAllocator* allocator, const RALiveSpans<T>& x, const RALiveSpans<T>& y, const DataType& yData) noexcept {
     uint32_t finalSize = x.size() + y.size();
     ASMJIT_PROPAGATE(_data.reserve(allocator, finalSize));
@@ -937,6 +959,9 @@ public:
   RATiedReg* _tiedReg = nullptr;
   //! Stack slot associated with the register.
   RAStackSlot* _stackSlot = nullptr;
+  //! Instruction that defines the register from constant operands, it can be
+  //! emitted again instead of reloading the register from its stack slot.
+  InstNode* _rematNode = nullptr;
 
   //! Copy of a signature used by \ref VirtReg.
   RegInfo _info {};
@@ -962,9 +987,13 @@ public:
   uint8_t _homeRegId = BaseReg::kIdBad;
   //! Global hint register ID (provided by RA or user).
   uint8_t _hintRegId = BaseReg::kIdBad;
+  //! Split home register ID (if any, assigned by RA), only valid within `_splitSpans`.
+  uint8_t _splitRegId = BaseReg::kIdBad;
 
   //! Live spans of the `VirtReg`.
   LiveRegSpans _liveSpans {};
+  //! Live spans (subset of `_liveSpans`) where `_splitRegId` is the home register.
+  LiveRegSpans _splitSpans {};
   //! Live statistics.
   RALiveStats _liveStats {};
 
@@ -985,7 +1014,9 @@ public:
     //! Stack allocation is preferred.
     kFlagStackPreferred = 0x00000004u,
     //! Marked for stack argument reassignment.
-    kFlagStackArgToStack = 0x00000008u
+    kFlagStackArgToStack = 0x00000008u,
+    //! Stack slot is referenced by the code (RegHome memory operand).
+    kFlagStackReferenced = 0x00000010u
   };
 
   enum ArgIndex : uint32_t {
@@ -1026,6 +1057,7 @@ public:
 
   //! Tests whether this RAWorkReg has been coalesced with another one (cannot be used anymore).
   inline bool isCoalesced() const noexcept { return hasFlag(kFlagCoalesced); }
+  inline void markCoalesced() noexcept { addFlags(kFlagCoalesced); }
 
   inline const RegInfo& info() const noexcept { return _info; }
   inline uint32_t group() const noexcept { return _info.group(); }
@@ -1041,6 +1073,11 @@ public:
   inline bool hasStackSlot() const noexcept { return _stackSlot != nullptr; }
   inline RAStackSlot* stackSlot() const noexcept { return _stackSlot; }
 
+  //! Tests whether the register can be rematerialized by \ref rematNode() instead of using a stack slot.
+  inline bool isRematerializable() const noexcept { return _rematNode != nullptr; }
+  inline InstNode* rematNode() const noexcept { return _rematNode; }
+  inline void setRematNode(InstNode* node) noexcept { _rematNode = node; }
+
   inline LiveRegSpans& liveSpans() noexcept { return _liveSpans; }
   inline const LiveRegSpans& liveSpans() const noexcept { return _liveSpans; }
 
@@ -1060,6 +1097,26 @@ public:
   inline uint32_t homeRegId() const noexcept { return _homeRegId; }
   inline void setHomeRegId(uint32_t physId) noexcept { _homeRegId = uint8_t(physId); }
 
+  //! Tests whether this WorkReg has a split home register, which is only valid within \ref splitSpans().
+  inline bool hasSplitRegId() const noexcept { return _splitRegId != BaseReg::kIdBad; }
+  inline uint32_t splitRegId() const noexcept { return _splitRegId; }
+  inline void setSplitRegId(uint32_t physId) noexcept { _splitRegId = uint8_t(physId); }
+
+  inline LiveRegSpans& splitSpans() noexcept { return _splitSpans; }
+  inline const LiveRegSpans& splitSpans() const noexcept { return _splitSpans; }
+
+  //! Returns the home register of this WorkReg within the range [start, end), which
+  //! is either the global home register or the split home register, if valid there.
+  inline uint32_t homeRegIdAt(uint32_t start, uint32_t end) const noexcept {
+    if (hasHomeRegId())
+      return homeRegId();
+
+    if (hasSplitRegId() && _splitSpans.overlaps(start, end))
+      return splitRegId();
+
+    return BaseReg::kIdBad;
+  }
+
   inline bool hasHintRegId() const noexcept { return _hintRegId != BaseReg::kIdBad; }
   inline uint32_t hintRegId() const noexcept { return _hintRegId; }
   inline void setHintRegId(uint32_t physId) noexcept { _hintRegId = uint8_t(physId); }
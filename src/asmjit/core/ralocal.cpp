@@ -94,7 +94,7 @@ Error RALocalAllocator::makeInitialAssignment() noexcept {
 
         // Overwritten argument.
         uint32_t workId = workReg->workId();
-        if (!liveIn.bitAt(workId))
+        if (!raIsLive(liveIn, workId))
           continue;
 
         uint32_t group = workReg->group();
@@ -182,7 +182,7 @@ Error RALocalAllocator::switchToAssignment(
         ASMJIT_ASSERT(workId != RAAssignment::kWorkNone);
 
         // KILL if it's not live on entry.
-        if (!liveIn.bitAt(workId)) {
+        if (!raIsLive(liveIn, workId)) {
           onKillReg(group, workId, physId);
           continue;
         }
@@ -280,7 +280,7 @@ Cleared:
           // DST assigned, CUR unassigned.
           uint32_t altPhysId = cur.workToPhysId(group, dstWorkId);
           if (altPhysId == RAAssignment::kPhysNone) {
-            if (liveIn.bitAt(dstWorkId))
+            if (raIsLive(liveIn, dstWorkId))
               willLoadRegs |= physMask; // Scheduled for `onLoadReg()`.
             affectedRegs &= ~physMask;  // Unaffected from now.
             continue;
@@ -333,7 +333,7 @@ Cleared:
           uint32_t workId = dst.physToWorkId(group, physId);
 
           // The algorithm is broken if it tries to load a register that is not in LIVE-IN.
-          ASMJIT_ASSERT(liveIn.bitAt(workId) == true);
+          ASMJIT_ASSERT(raIsLive(liveIn, workId));
 
           ASMJIT_PROPAGATE(onLoadReg(group, workId, physId));
           if (dst.isPhysDirty(group, physId))
@@ -522,7 +522,8 @@ Error RALocalAllocator::allocInst(InstNode* node) noexcept {
             uint32_t opIndex = Support::ctz(tiedReg->useRewriteMask()) / uint32_t(sizeof(Operand) / sizeof(uint32_t));
             uint32_t rmSize = tiedReg->rmSize();
 
-            if (rmSize <= workReg->virtReg()->virtSize()) {
+            // Rematerializable registers don't have a valid stack slot.
+            if (rmSize <= workReg->virtReg()->virtSize() && !workReg->isRematerializable()) {
               Operand& op = node->operands()[opIndex];
               op = _pass->workRegAsMem(workReg);
               op.as<BaseMem>().setSize(rmSize);
@@ -850,7 +851,7 @@ Error RALocalAllocator::spillAfterAllocation(InstNode* node) noexcept {
     if (tiedReg->isLast()) {
       uint32_t workId = tiedReg->workId();
       RAWorkReg* workReg = workRegById(workId);
-      if (!workReg->hasHomeRegId()) {
+      if (homeRegIdOf(workReg) == BaseReg::kIdBad) {
         uint32_t group = workReg->group();
         uint32_t assignedId = _curAssignment.workToPhysId(group, workId);
         if (assignedId != RAAssignment::kPhysNone) {
@@ -884,7 +885,16 @@ Error RALocalAllocator::allocBranch(InstNode* node, RABlock* target, RABlock* co
   ASMJIT_PROPAGATE(allocInst(node));
   ASMJIT_PROPAGATE(spillRegsBeforeEntry(target));
 
-  if (target->hasEntryAssignment()) {
+  // If the target doesn't have an entry assignment yet it's created from the
+  // current one, which can only differ if it assigns split registers. In that
+  // case the switch is necessary as well (the code goes to a trampoline).
+  bool needsSwitch = target->hasEntryAssignment();
+  if (!needsSwitch) {
+    ASMJIT_PROPAGATE(_pass->setBlockEntryAssignment(target, block(), _curAssignment));
+    needsSwitch = !_pass->_splitWorkRegs.empty();
+  }
+
+  if (needsSwitch) {
     BaseNode* injectionPoint = _pass->extraBlock()->prev();
     BaseNode* prevCursor = _cc->setCursor(injectionPoint);
 
@@ -924,9 +934,6 @@ Error RALocalAllocator::allocBranch(InstNode* node, RABlock* target, RABlock* co
     _cc->_setCursor(prevCursor);
     _curAssignment.swap(_tmpAssignment);
   }
-  else {
-    ASMJIT_PROPAGATE(_pass->setBlockEntryAssignment(target, block(), _curAssignment));
-  }
 
   return kErrorOk;
 }
@@ -980,8 +987,8 @@ uint32_t RALocalAllocator::decideOnAssignment(uint32_t group, uint32_t workId, u
   RAWorkReg* workReg = workRegById(workId);
 
   // Prefer home register id, if possible.
-  if (workReg->hasHomeRegId()) {
-    uint32_t homeId = workReg->homeRegId();
+  uint32_t homeId = homeRegIdOf(workReg);
+  if (homeId != BaseReg::kIdBad) {
     if (Support::bitTest(allocableRegs, homeId))
       return homeId;
   }
@@ -1001,9 +1008,10 @@ uint32_t RALocalAllocator::decideOnReassignment(uint32_t group, uint32_t workId,
   RAWorkReg* workReg = workRegById(workId);
 
   // Prefer allocating back to HomeId, if possible.
-  if (workReg->hasHomeRegId()) {
-    if (Support::bitTest(allocableRegs, workReg->homeRegId()))
-      return workReg->homeRegId();
+  uint32_t homeId = homeRegIdOf(workReg);
+  if (homeId != BaseReg::kIdBad) {
+    if (Support::bitTest(allocableRegs, homeId))
+      return homeId;
   }
 
   // TODO: [Register Allocator] This could be improved.
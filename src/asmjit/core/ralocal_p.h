@@ -111,6 +111,11 @@ public:
   //! Sets the currently processed block.
   inline void setBlock(RABlock* block) noexcept { _block = block; }
 
+  //! Returns the home register of `workReg` valid in the current block, see \ref RAWorkReg::homeRegIdAt().
+  inline uint32_t homeRegIdOf(const RAWorkReg* workReg) const noexcept {
+    return workReg->homeRegIdAt(_block->firstPosition(), _block->endPosition());
+  }
+
   //! Returns the currently processed `InstNode`.
   inline InstNode* node() const noexcept { return _node; }
   //! Returns the currently processed `RAInst`.
@@ -178,18 +183,22 @@ public:
 
   enum CostModel : uint32_t {
     kCostOfFrequency = 1048576,
-    kCostOfDirtyFlag = kCostOfFrequency / 4
+    kCostOfDirtyFlag = kCostOfFrequency / 4,
+
+    //! Maximum frequency used by the cost model (frequencies are weighted by loop depth).
+    kMaxCostFrequency = 1024
   };
 
   inline uint32_t costByFrequency(float freq) const noexcept {
-    return uint32_t(int32_t(freq * float(kCostOfFrequency)));
+    return uint32_t(int32_t(Support::min(freq, float(kMaxCostFrequency)) * float(kCostOfFrequency)));
   }
 
   inline uint32_t calculateSpillCost(uint32_t group, uint32_t workId, uint32_t assignedId) const noexcept {
     RAWorkReg* workReg = workRegById(workId);
     uint32_t cost = costByFrequency(workReg->liveStats().freq());
 
-    if (_curAssignment.isPhysDirty(group, assignedId))
+    // Spilling a rematerializable register never saves it.
+    if (_curAssignment.isPhysDirty(group, assignedId) && !workReg->isRematerializable())
       cost += kCostOfDirtyFlag;
 
     return cost;
@@ -231,19 +240,25 @@ public:
   }
 
   //! Emits a load from [VirtReg/WorkReg]'s spill slot to a physical register
-  //! and makes it assigned and clean.
+  //! and makes it assigned and clean. Rematerializable registers are recreated
+  //! by their definition instead.
   inline Error onLoadReg(uint32_t group, uint32_t workId, uint32_t physId) noexcept {
     _curAssignment.assign(group, workId, physId, RAAssignment::kClean);
+    if (workRegById(workId)->isRematerializable())
+      return _pass->emitRemat(workId, physId);
     return _pass->emitLoad(workId, physId);
   }
 
   //! Emits a save a physical register to a [VirtReg/WorkReg]'s spill slot,
-  //! keeps it assigned, and makes it clean.
+  //! keeps it assigned, and makes it clean. Rematerializable registers are
+  //! never saved.
   inline Error onSaveReg(uint32_t group, uint32_t workId, uint32_t physId) noexcept {
     ASMJIT_ASSERT(_curAssignment.workToPhysId(group, workId) == physId);
     ASMJIT_ASSERT(_curAssignment.physToWorkId(group, physId) == workId);
 
     _curAssignment.makeClean(group, workId, physId);
+    if (workRegById(workId)->isRematerializable())
+      return kErrorOk;
     return _pass->emitSave(workId, physId);
   }
 
@@ -31,6 +31,12 @@
 #include "../core/type.h"
 #include "../core/zonestack.h"
 
+#if !defined(__EMSCRIPTEN__)
+  #define ASMJIT_RA_HAS_THREADS
+  #include <atomic>
+  #include <thread>
+#endif
+
 ASMJIT_BEGIN_NAMESPACE
 
 // ============================================================================
@@ -76,6 +82,273 @@ Error RABlock::prependSuccessor(RABlock* successor) noexcept {
 BaseRAPass::BaseRAPass() noexcept : FuncPass("BaseRAPass") {}
 BaseRAPass::~BaseRAPass() noexcept {}
 
+BaseRAPass* BaseRAPass::newWorker(Zone* zone) noexcept {
+  DebugUtils::unused(zone);
+  return nullptr;
+}
+
+// ============================================================================
+// [asmjit::BaseRAPass - Run]
+// ============================================================================
+
+//! Locks the compiler while a pass inserts or removes nodes, does nothing if
+//! the pass runs serially.
+class RACompilerLockGuard {
+public:
+  ASMJIT_NONCOPYABLE(RACompilerLockGuard)
+
+  Lock* _lock;
+
+  inline explicit RACompilerLockGuard(Lock* lock) noexcept
+    : _lock(lock) { if (_lock) _lock->lock(); }
+  inline ~RACompilerLockGuard() noexcept { if (_lock) _lock->unlock(); }
+};
+
+#ifdef ASMJIT_RA_HAS_THREADS
+//! Shared state of passes that allocate functions concurrently.
+struct RAWorkerContext {
+  FuncNode** funcs;
+  Error* errors;
+  uint32_t funcCount;
+  std::atomic<uint32_t> nextIndex;
+  Lock lock;
+};
+
+// Marks `index` as owned by the function at `funcIndex`, returns false if it's
+// already owned by another function.
+static ASMJIT_INLINE bool RAPass_claim(uint32_t* owners, uint32_t count, uint32_t index, uint32_t funcIndex) noexcept {
+  if (index >= count)
+    return true;
+
+  if (owners[index] == Globals::kInvalidId)
+    owners[index] = funcIndex;
+  return owners[index] == funcIndex;
+}
+
+// Functions can only be allocated concurrently if no virtual register or label
+// is referenced by more than one of them, as the register allocator attaches
+// its own data to both.
+static bool RAPass_hasIndependentFunctions(BaseCompiler* cc, FuncNode** funcs, uint32_t funcCount, Zone* zone) noexcept {
+  uint32_t virtCount = cc->virtRegs().size();
+  uint32_t labelCount = uint32_t(cc->code()->labelCount());
+
+  uint32_t* virtOwners = zone->allocT<uint32_t>(Support::max<size_t>(virtCount, 1) * sizeof(uint32_t));
+  uint32_t* labelOwners = zone->allocT<uint32_t>(Support::max<size_t>(labelCount, 1) * sizeof(uint32_t));
+
+  if (ASMJIT_UNLIKELY(!virtOwners || !labelOwners))
+    return false;
+
+  for (uint32_t i = 0; i < virtCount; i++)
+    virtOwners[i] = Globals::kInvalidId;
+
+  for (uint32_t i = 0; i < labelCount; i++)
+    labelOwners[i] = Globals::kInvalidId;
+
+  for (uint32_t funcIndex = 0; funcIndex < funcCount; funcIndex++) {
+    FuncNode* func = funcs[funcIndex];
+    BaseNode* stop = func->endNode()->next();
+
+    for (uint32_t argIndex = 0; argIndex < func->argCount(); argIndex++) {
+      for (uint32_t valueIndex = 0; valueIndex < Globals::kMaxValuePack; valueIndex++) {
+        VirtReg* vReg = func->argPack(argIndex)[valueIndex];
+        if (vReg && !RAPass_claim(virtOwners, virtCount, Operand::virtIdToIndex(vReg->id()), funcIndex))
+          return false;
+      }
+    }
+
+    for (BaseNode* node = func; node != stop; node = node->next()) {
+      if (node->isLabel()) {
+        if (!RAPass_claim(labelOwners, labelCount, node->as<LabelNode>()->labelId(), funcIndex))
+          return false;
+      }
+      else if (node->isInst()) {
+        InstNode* inst = node->as<InstNode>();
+        bool isInvoke = node->type() == BaseNode::kNodeInvoke;
+
+        if (inst->hasExtraReg() && Operand::isVirtId(inst->extraReg().id())) {
+          if (!RAPass_claim(virtOwners, virtCount, Operand::virtIdToIndex(inst->extraReg().id()), funcIndex))
+            return false;
+        }
+
+        Operand* opArray = inst->operands();
+        uint32_t opCount = inst->opCount();
+
+        for (uint32_t i = 0; i < opCount; i++) {
+          const Operand& op = opArray[i];
+          if (op.isReg()) {
+            if (Operand::isVirtId(op.id()) && !RAPass_claim(virtOwners, virtCount, Operand::virtIdToIndex(op.id()), funcIndex))
+              return false;
+          }
+          else if (op.isMem()) {
+            const BaseMem& mem = op.as<BaseMem>();
+            if (mem.hasBaseReg() && Operand::isVirtId(mem.baseId())) {
+              if (!RAPass_claim(virtOwners, virtCount, Operand::virtIdToIndex(mem.baseId()), funcIndex))
+                return false;
+            }
+            else if (mem.hasBaseLabel() && !isInvoke) {
+              if (!RAPass_claim(labelOwners, labelCount, mem.baseId(), funcIndex))
+                return false;
+            }
+
+            if (mem.hasIndexReg() && Operand::isVirtId(mem.indexId())) {
+              if (!RAPass_claim(virtOwners, virtCount, Operand::virtIdToIndex(mem.indexId()), funcIndex))
+                return false;
+            }
+          }
+          else if (op.isLabel() && !isInvoke) {
+            // Calls to other functions are fine, jumps are not.
+            if (!RAPass_claim(labelOwners, labelCount, op.id(), funcIndex))
+              return false;
+          }
+        }
+
+        if (isInvoke) {
+          InvokeNode* invokeNode = node->as<InvokeNode>();
+          uint32_t argCount = invokeNode->argCount();
+
+          for (uint32_t argIndex = 0; argIndex <= argCount; argIndex++) {
+            const InvokeNode::OperandPack& pack = argIndex < argCount ? invokeNode->argPack(argIndex) : invokeNode->retPack();
+            for (uint32_t valueIndex = 0; valueIndex < Globals::kMaxValuePack; valueIndex++) {
+              const Operand& op = pack[valueIndex];
+              if (op.isReg() && Operand::isVirtId(op.id()) && !RAPass_claim(virtOwners, virtCount, Operand::virtIdToIndex(op.id()), funcIndex))
+                return false;
+            }
+          }
+        }
+      }
+    }
+  }
+
+  return true;
+}
+
+static void RAPass_runWorker(RAWorkerContext* ctx, BaseRAPass* pass, Zone* zone) noexcept {
+  pass->_compilerLock = &ctx->lock;
+
+  for (;;) {
+    uint32_t funcIndex = ctx->nextIndex.fetch_add(1, std::memory_order_relaxed);
+    if (funcIndex >= ctx->funcCount)
+      break;
+    ctx->errors[funcIndex] = pass->runOnFunction(zone, nullptr, ctx->funcs[funcIndex]);
+  }
+
+  pass->_compilerLock = nullptr;
+}
+
+static void RAPass_workerThread(RAWorkerContext* ctx, BaseRAPass* pass) noexcept {
+  Zone zone(65536 - Zone::kBlockOverhead);
+  RAPass_runWorker(ctx, pass, &zone);
+}
+
+// Starts a thread that runs `pass` at `thread`, returns false if the thread
+// couldn't be created.
+static bool RAPass_startWorkerThread(std::thread* thread, RAWorkerContext* ctx, BaseRAPass* pass) noexcept {
+#if defined(__cpp_exceptions) || defined(_CPPUNWIND)
+  try {
+    new(thread) std::thread(RAPass_workerThread, ctx, pass);
+  }
+  catch (...) {
+    return false;
+  }
+#else
+  new(thread) std::thread(RAPass_workerThread, ctx, pass);
+#endif
+  return true;
+}
+
+static Error RAPass_runConcurrently(BaseRAPass* self, Zone* zone, uint32_t threadCount) noexcept {
+  BaseCompiler* cc = self->cc();
+
+  Zone tmpZone(4096 - Zone::kBlockOverhead);
+  ZoneAllocator tmpAllocator(&tmpZone);
+  ZoneVector<FuncNode*> funcs;
+
+  BaseNode* node = cc->firstNode();
+  while (node) {
+    if (node->type() == BaseNode::kNodeFunc) {
+      FuncNode* func = node->as<FuncNode>();
+      ASMJIT_PROPAGATE(funcs.append(&tmpAllocator, func));
+      node = func->endNode();
+    }
+    node = node->next();
+  }
+
+  uint32_t funcCount = funcs.size();
+  threadCount = Support::min(threadCount, funcCount);
+
+  if (threadCount <= 1 || !RAPass_hasIndependentFunctions(cc, funcs.data(), funcCount, &tmpZone))
+    return self->FuncPass::run(zone, nullptr);
+
+  ZoneVector<BaseRAPass*> workers;
+  ASMJIT_PROPAGATE(workers.reserve(&tmpAllocator, threadCount - 1));
+
+  for (uint32_t i = 1; i < threadCount; i++) {
+    BaseRAPass* worker = self->newWorker(&tmpZone);
+    if (!worker)
+      break;
+    worker->_cb = cc;
+    workers.appendUnsafe(worker);
+  }
+
+  Error* errors = tmpZone.allocT<Error>(funcCount * sizeof(Error));
+  std::thread* threads = tmpZone.allocT<std::thread>(workers.size() * sizeof(std::thread));
+
+  if (ASMJIT_UNLIKELY(!errors || (!workers.empty() && !threads))) {
+    for (BaseRAPass* worker : workers)
+      worker->~BaseRAPass();
+    return DebugUtils::errored(kErrorOutOfMemory);
+  }
+
+  RAWorkerContext ctx;
+  ctx.funcs = funcs.data();
+  ctx.errors = errors;
+  ctx.funcCount = funcCount;
+  ctx.nextIndex.store(0, std::memory_order_relaxed);
+
+  for (uint32_t i = 0; i < funcCount; i++)
+    errors[i] = kErrorOk;
+
+  // Functions that threads which failed to start would process are processed
+  // by the remaining threads, including the calling one.
+  uint32_t startedCount = 0;
+  while (startedCount < workers.size() && RAPass_startWorkerThread(&threads[startedCount], &ctx, workers[startedCount]))
+    startedCount++;
+
+  RAPass_runWorker(&ctx, self, zone);
+  self->_lastThreadCount = startedCount + 1;
+
+  for (uint32_t i = 0; i < workers.size(); i++) {
+    if (i < startedCount) {
+      threads[i].join();
+      threads[i].~thread();
+    }
+    workers[i]->~BaseRAPass();
+  }
+
+  // Report the error of the first failing function, as the serial path would.
+  for (uint32_t i = 0; i < funcCount; i++)
+    ASMJIT_PROPAGATE(errors[i]);
+
+  return kErrorOk;
+}
+#endif
+
+Error BaseRAPass::run(Zone* zone, Logger* logger) {
+  _lastThreadCount = 1;
+
+#ifdef ASMJIT_RA_HAS_THREADS
+  uint32_t threadCount = cc()->raThreadCount();
+  if (threadCount == 0)
+    threadCount = Support::max<uint32_t>(std::thread::hardware_concurrency(), 1u);
+
+  // Logging requires the functions to be processed in order.
+  if (threadCount > 1 && !logger)
+    return RAPass_runConcurrently(this, zone, threadCount);
+#endif
+
+  return Base::run(zone, logger);
+}
+
 // ============================================================================
 // [asmjit::BaseRAPass - RunOnFunction]
 // ============================================================================
@@ -111,6 +384,8 @@ static void RAPass_reset(BaseRAPass* self, FuncDetail* funcDetail) noexcept {
     self->_strategy[group].reset();
     self->_globalLiveSpans[group] = nullptr;
   }
+  self->_splitWorkRegs.reset();
+  self->_coalescedMoveCount = 0;
   self->_globalMaxLiveCount.reset();
   self->_temporaryMem.reset();
 
@@ -184,26 +459,54 @@ Error BaseRAPass::runOnFunction(Zone* zone, Logger* logger, FuncNode* func) {
   // We alter the compiler cursor, because it doesn't make sense to reference
   // it after the compilation - some nodes may disappear and the old cursor
   // can go out anyway.
+  RACompilerLockGuard guard(_compilerLock);
   cc()->_setCursor(cc()->lastNode());
 
   return err;
 }
 
 Error BaseRAPass::onPerformAllSteps() noexcept {
-  ASMJIT_PROPAGATE(buildCFG());
+  // Steps that insert or remove nodes, or create virtual registers, must hold
+  // the compiler lock when functions are allocated concurrently. Analysis and
+  // global allocation only touch the function being processed.
+  {
+    RACompilerLockGuard guard(_compilerLock);
+    ASMJIT_PROPAGATE(buildCFG());
+  }
+
   ASMJIT_PROPAGATE(buildViews());
-  ASMJIT_PROPAGATE(removeUnreachableBlocks());
 
-  ASMJIT_PROPAGATE(buildDominators());
+  {
+    RACompilerLockGuard guard(_compilerLock);
+    ASMJIT_PROPAGATE(removeUnreachableBlocks());
+  }
+
+  // Dominators, loops, and move coalescing only improve the quality of the
+  // code, which the linear-scan allocator trades for compilation speed.
+  bool linearScan = isLinearScan();
+  if (!linearScan) {
+    ASMJIT_PROPAGATE(buildDominators());
+    ASMJIT_PROPAGATE(buildLoops());
+  }
+
   ASMJIT_PROPAGATE(buildLiveness());
   ASMJIT_PROPAGATE(assignArgIndexToWorkRegs());
 
+  if (!linearScan) {
+    RACompilerLockGuard guard(_compilerLock);
+    ASMJIT_PROPAGATE(coalesceMoves());
+  }
+
+  ASMJIT_PROPAGATE(findRematerializableRegs());
+
 #ifndef ASMJIT_NO_LOGGING
   if (logger() && logger()->hasFlag(FormatOptions::kFlagAnnotations))
     ASMJIT_PROPAGATE(annotateCode());
 #endif
 
   ASMJIT_PROPAGATE(runGlobalAllocator());
+
+  RACompilerLockGuard guard(_compilerLock);
   ASMJIT_PROPAGATE(runLocalAllocator());
 
   ASMJIT_PROPAGATE(updateStackFrame());
@@ -576,6 +879,74 @@ const RABlock* BaseRAPass::_nearestCommonDominator(const RABlock* a, const RABlo
   return entryBlock;
 }
 
+// ============================================================================
+// [asmjit::BaseRAPass - CFG - Loops]
+// ============================================================================
+
+// A back-edge is an edge `B -> H` where `H` dominates `B`. The natural loop of
+// `H` consists of `H` and all blocks that can reach any of its back-edges
+// without going through `H`. Back-edges of irreducible loops (where the target
+// doesn't dominate the source) are ignored.
+Error BaseRAPass::buildLoops() noexcept {
+#ifndef ASMJIT_NO_LOGGING
+  Logger* logger = debugLogger();
+  ASMJIT_RA_LOG_FORMAT("[RAPass::BuildLoops]\n");
+#endif
+
+  if (_blocks.empty())
+    return kErrorOk;
+
+  ZoneStack<RABlock*> stack;
+  ASMJIT_PROPAGATE(stack.init(allocator()));
+
+  uint32_t numLoops = 0;
+  for (RABlock* header : _pov) {
+    uint64_t timestamp = 0;
+
+    for (RABlock* pred : header->predecessors()) {
+      if (!pred->isReachable() || !dominates(header, pred))
+        continue;
+
+      if (!timestamp) {
+        timestamp = nextTimestamp();
+        header->setTimestamp(timestamp);
+        header->addFlags(RABlock::kFlagIsLoopHeader);
+        header->_weight++;
+        numLoops++;
+      }
+
+      if (pred->hasTimestamp(timestamp))
+        continue;
+
+      pred->setTimestamp(timestamp);
+      pred->_weight++;
+      ASMJIT_PROPAGATE(stack.append(pred));
+
+      while (!stack.empty()) {
+        RABlock* block = stack.pop();
+        for (RABlock* p : block->predecessors()) {
+          if (!p->isReachable() || p->hasTimestamp(timestamp))
+            continue;
+
+          p->setTimestamp(timestamp);
+          p->_weight++;
+          ASMJIT_PROPAGATE(stack.append(p));
+        }
+      }
+    }
+  }
+
+  ASMJIT_RA_LOG_COMPLEX({
+    for (RABlock* block : _pov) {
+      if (block->weight())
+        logger->logf("  #%u -> {Depth: %u%s}\n", block->blockId(), block->weight(), block->isLoopHeader() ? " Header" : "");
+    }
+  });
+
+  ASMJIT_RA_LOG_FORMAT("  Done (%u loops)\n", numLoops);
+  return kErrorOk;
+}
+
 // ============================================================================
 // [asmjit::BaseRAPass - CFG - Utilities]
 // ============================================================================
@@ -789,6 +1160,250 @@ namespace LiveOps {
   }
 }
 
+static void RAPass_updateLiveStats(RAWorkReg* workReg) noexcept {
+  // Uses inside loops are weighted by their loop depth so registers used
+  // in hot loops get higher priority and are less likely to be spilled.
+  float refs = 0.0f;
+  for (BaseNode* node : workReg->_refs)
+    refs += BaseRAPass::loopWeightFactor(node->as<InstNode>()->passData<RAInst>()->block()->weight());
+
+  LiveRegSpans& spans = workReg->liveSpans();
+  uint32_t width = spans.width();
+  float freq = width ? float(double(refs) / double(width)) : float(0);
+
+  RALiveStats& stats = workReg->liveStats();
+  stats._width = width;
+  stats._freq = freq;
+  stats._priority = freq + float(int(workReg->virtReg()->weight())) * 0.01f;
+}
+
+// Calculates GEN/KILL bits of `block` and marks KILL/LAST of its tied registers.
+// Work registers touched for the first time are appended to `touched`, if not null.
+static ASMJIT_INLINE Error RAPass_buildBlockGenKill(
+  RABlock* block,
+  ZoneBitVector& gen,
+  ZoneBitVector& kill,
+  ZoneVector<uint32_t>& nUsesPerWorkReg,
+  ZoneVector<uint32_t>& nOutsPerWorkReg,
+  ZoneVector<uint32_t>* touched,
+  ZoneAllocator* allocator,
+  uint32_t* nInstsOut) noexcept {
+
+  BaseNode* node = block->last();
+  BaseNode* stop = block->first();
+
+  uint32_t nInsts = 0;
+  for (;;) {
+    if (node->isInst()) {
+      InstNode* inst = node->as<InstNode>();
+      RAInst* raInst = inst->passData<RAInst>();
+      ASMJIT_ASSERT(raInst != nullptr);
+
+      RATiedReg* tiedRegs = raInst->tiedRegs();
+      uint32_t count = raInst->tiedCount();
+
+      for (uint32_t j = 0; j < count; j++) {
+        RATiedReg* tiedReg = &tiedRegs[j];
+        uint32_t workId = tiedReg->workId();
+
+        // Update `nUses` and `nOuts`.
+        nUsesPerWorkReg[workId] += 1u;
+        nOutsPerWorkReg[workId] += uint32_t(tiedReg->isWrite());
+
+        // Mark as:
+        //   KILL - if this VirtReg is killed afterwards.
+        //   LAST - if this VirtReg is last in this basic block.
+        if (kill.bitAt(workId)) {
+          tiedReg->addFlags(RATiedReg::kKill);
+        }
+        else if (!gen.bitAt(workId)) {
+          tiedReg->addFlags(RATiedReg::kLast);
+          if (touched)
+            ASMJIT_PROPAGATE(touched->append(allocator, workId));
+        }
+
+        if (tiedReg->isWriteOnly()) {
+          // KILL.
+          kill.setBit(workId, true);
+        }
+        else {
+          // GEN.
+          kill.setBit(workId, false);
+          gen.setBit(workId, true);
+        }
+      }
+
+      nInsts++;
+    }
+
+    if (node == stop)
+      break;
+
+    node = node->prev();
+    ASMJIT_ASSERT(node != nullptr);
+  }
+
+  *nInstsOut = nInsts;
+  return kErrorOk;
+}
+
+static Error RAPass_buildDenseGenKill(
+  BaseRAPass* self,
+  ZoneVector<uint32_t>& nUsesPerWorkReg,
+  ZoneVector<uint32_t>& nOutsPerWorkReg,
+  ZoneVector<uint32_t>& nInstsPerBlock) noexcept {
+
+  uint32_t numWorkRegs = self->workRegCount();
+  uint32_t numReachableBlocks = self->reachableBlockCount();
+
+  for (uint32_t i = 0; i < numReachableBlocks; i++) {
+    RABlock* block = self->_pov[i];
+    ASMJIT_PROPAGATE(block->resizeLiveBits(numWorkRegs));
+
+    uint32_t nInsts;
+    ASMJIT_PROPAGATE(RAPass_buildBlockGenKill(block, block->gen(), block->kill(), nUsesPerWorkReg, nOutsPerWorkReg, nullptr, nullptr, &nInsts));
+    nInstsPerBlock[block->blockId()] = nInsts;
+  }
+
+  return kErrorOk;
+}
+
+// Dense GEN/KILL/IN/OUT bits of all blocks need `blocks * workRegs` bits, which
+// is too much for large functions. However, a work register that is never used
+// before it's written within a block (it's GEN and not KILL in no block) can
+// never be LIVE-IN or LIVE-OUT. GEN/KILL are first calculated per block by using bits
+// shared by all blocks and stored sparsely, then work registers are renumbered
+// so the ones that can be live across blocks come first, and finally the live
+// bits of each block are sized by their count (returned in `numLiveRegsOut`).
+static Error RAPass_buildSparseGenKill(
+  BaseRAPass* self,
+  ZoneVector<uint32_t>& nUsesPerWorkReg,
+  ZoneVector<uint32_t>& nOutsPerWorkReg,
+  ZoneVector<uint32_t>& nInstsPerBlock,
+  uint32_t* numLiveRegsOut) noexcept {
+
+  ZoneAllocator* allocator = self->allocator();
+  uint32_t numWorkRegs = self->workRegCount();
+  uint32_t numReachableBlocks = self->reachableBlockCount();
+
+  ZoneBitVector gen;
+  ZoneBitVector kill;
+  ZoneBitVector isLive;
+  ZoneVector<uint32_t> touched;
+
+  // GEN/KILL entries of all blocks in POV order, each `(workId << 2) | (GEN << 1) | KILL`.
+  ZoneVector<uint32_t> entries;
+  ZoneVector<uint32_t> entryIndexes;
+
+  ASMJIT_PROPAGATE(gen.resize(allocator, numWorkRegs));
+  ASMJIT_PROPAGATE(kill.resize(allocator, numWorkRegs));
+  ASMJIT_PROPAGATE(isLive.resize(allocator, numWorkRegs));
+  ASMJIT_PROPAGATE(entryIndexes.reserve(allocator, numReachableBlocks + 1));
+
+  for (uint32_t i = 0; i < numReachableBlocks; i++) {
+    RABlock* block = self->_pov[i];
+    entryIndexes.appendUnsafe(entries.size());
+
+    uint32_t nInsts;
+    touched.clear();
+    ASMJIT_PROPAGATE(RAPass_buildBlockGenKill(block, gen, kill, nUsesPerWorkReg, nOutsPerWorkReg, &touched, allocator, &nInsts));
+    nInstsPerBlock[block->blockId()] = nInsts;
+
+    ASMJIT_PROPAGATE(entries.willGrow(allocator, touched.size()));
+    for (uint32_t workId : touched) {
+      bool isGen = gen.bitAt(workId);
+      bool isKill = kill.bitAt(workId);
+
+      entries.appendUnsafe((workId << 2) | (uint32_t(isGen) << 1) | uint32_t(isKill));
+      if (isGen && !isKill)
+        isLive.setBit(workId, true);
+
+      gen.setBit(workId, false);
+      kill.setBit(workId, false);
+    }
+  }
+  entryIndexes.appendUnsafe(entries.size());
+
+  // Renumber work registers, registers that can be live across blocks first.
+  ZoneVector<uint32_t> newIds;
+  ZoneVector<uint32_t> oldCounts;
+  RAWorkRegs oldWorkRegs;
+
+  ASMJIT_PROPAGATE(newIds.resize(allocator, numWorkRegs));
+  ASMJIT_PROPAGATE(oldCounts.resize(allocator, numWorkRegs * 2));
+  ASMJIT_PROPAGATE(oldWorkRegs.concat(allocator, self->_workRegs));
+
+  uint32_t numLiveRegs = 0;
+  for (uint32_t workId = 0; workId < numWorkRegs; workId++)
+    if (isLive.bitAt(workId))
+      newIds[workId] = numLiveRegs++;
+
+  uint32_t nextId = numLiveRegs;
+  for (uint32_t workId = 0; workId < numWorkRegs; workId++)
+    if (!isLive.bitAt(workId))
+      newIds[workId] = nextId++;
+
+  for (uint32_t workId = 0; workId < numWorkRegs; workId++) {
+    oldCounts[workId] = nUsesPerWorkReg[workId];
+    oldCounts[numWorkRegs + workId] = nOutsPerWorkReg[workId];
+  }
+
+  for (uint32_t workId = 0; workId < numWorkRegs; workId++) {
+    uint32_t newId = newIds[workId];
+    RAWorkReg* workReg = oldWorkRegs[workId];
+
+    workReg->_workId = newId;
+    self->_workRegs[newId] = workReg;
+    nUsesPerWorkReg[newId] = oldCounts[workId];
+    nOutsPerWorkReg[newId] = oldCounts[numWorkRegs + workId];
+  }
+
+  for (uint32_t i = 0; i < numReachableBlocks; i++) {
+    RABlock* block = self->_pov[i];
+    BaseNode* node = block->first();
+    BaseNode* stop = block->last();
+
+    for (;;) {
+      if (node->isInst()) {
+        RAInst* raInst = node->as<InstNode>()->passData<RAInst>();
+        RATiedReg* tiedRegs = raInst->tiedRegs();
+        uint32_t count = raInst->tiedCount();
+
+        for (uint32_t j = 0; j < count; j++)
+          tiedRegs[j]._workId = newIds[tiedRegs[j].workId()];
+      }
+
+      if (node == stop)
+        break;
+      node = node->next();
+    }
+
+    ASMJIT_PROPAGATE(block->resizeLiveBits(numLiveRegs));
+    for (uint32_t entryIndex = entryIndexes[i]; entryIndex < entryIndexes[i + 1]; entryIndex++) {
+      uint32_t entry = entries[entryIndex];
+      uint32_t workId = newIds[entry >> 2];
+
+      if (workId < numLiveRegs) {
+        if (entry & 0x2u) block->gen().setBit(workId, true);
+        if (entry & 0x1u) block->kill().setBit(workId, true);
+      }
+    }
+  }
+
+  gen.release(allocator);
+  kill.release(allocator);
+  isLive.release(allocator);
+  touched.release(allocator);
+  entries.release(allocator);
+  entryIndexes.release(allocator);
+  newIds.release(allocator);
+  oldCounts.release(allocator);
+  oldWorkRegs.release(allocator);
+
+  *numLiveRegsOut = numLiveRegs;
+  return kErrorOk;
+}
+
 ASMJIT_FAVOR_SPEED Error BaseRAPass::buildLiveness() noexcept {
 #ifndef ASMJIT_NO_LOGGING
   Logger* logger = debugLogger();
@@ -819,65 +1434,18 @@ ASMJIT_FAVOR_SPEED Error BaseRAPass::buildLiveness() noexcept {
   ASMJIT_PROPAGATE(nOutsPerWorkReg.resize(allocator(), numWorkRegs));
   ASMJIT_PROPAGATE(nInstsPerBlock.resize(allocator(), numAllBlocks));
 
-  // --------------------------------------------------------------------------
-  // Calculate GEN/KILL of each block.
-  // --------------------------------------------------------------------------
-
-  for (i = 0; i < numReachableBlocks; i++) {
-    RABlock* block = _pov[i];
-    ASMJIT_PROPAGATE(block->resizeLiveBits(numWorkRegs));
-
-    BaseNode* node = block->last();
-    BaseNode* stop = block->first();
-
-    uint32_t nInsts = 0;
-    for (;;) {
-      if (node->isInst()) {
-        InstNode* inst = node->as<InstNode>();
-        RAInst* raInst = inst->passData<RAInst>();
-        ASMJIT_ASSERT(raInst != nullptr);
-
-        RATiedReg* tiedRegs = raInst->tiedRegs();
-        uint32_t count = raInst->tiedCount();
-
-        for (uint32_t j = 0; j < count; j++) {
-          RATiedReg* tiedReg = &tiedRegs[j];
-          uint32_t workId = tiedReg->workId();
-
-          // Update `nUses` and `nOuts`.
-          nUsesPerWorkReg[workId] += 1u;
-          nOutsPerWorkReg[workId] += uint32_t(tiedReg->isWrite());
-
-          // Mark as:
-          //   KILL - if this VirtReg is killed afterwards.
-          //   LAST - if this VirtReg is last in this basic block.
-          if (block->kill().bitAt(workId))
-            tiedReg->addFlags(RATiedReg::kKill);
-          else if (!block->gen().bitAt(workId))
-            tiedReg->addFlags(RATiedReg::kLast);
-
-          if (tiedReg->isWriteOnly()) {
-            // KILL.
-            block->kill().setBit(workId, true);
-          }
-          else {
-            // GEN.
-            block->kill().setBit(workId, false);
-            block->gen().setBit(workId, true);
-          }
-        }
-
-        nInsts++;
-      }
-
-      if (node == stop)
-        break;
-
-      node = node->prev();
-      ASMJIT_ASSERT(node != nullptr);
-    }
+  // Large functions use sparse GEN/KILL sets and only registers that can be
+  // live across blocks are tracked by dense LIVE-IN/LIVE-OUT bits, see
+  // `RAPass_buildSparseGenKill()`. The limit is `BaseCompiler::raMaxDenseLiveBits()`.
+  if (uint64_t(numReachableBlocks) * numWorkRegs > cc()->raMaxDenseLiveBits()) {
+    uint32_t numLiveRegs;
+    ASMJIT_PROPAGATE(RAPass_buildSparseGenKill(this, nUsesPerWorkReg, nOutsPerWorkReg, nInstsPerBlock, &numLiveRegs));
 
-    nInstsPerBlock[block->blockId()] = nInsts;
+    numBitWords = ZoneBitVector::_wordsPerBits(numLiveRegs);
+    ASMJIT_RA_LOG_FORMAT("  Sparse (%u of %u registers live across blocks)\n", numLiveRegs, numWorkRegs);
+  }
+  else {
+    ASMJIT_PROPAGATE(RAPass_buildDenseGenKill(this, nUsesPerWorkReg, nOutsPerWorkReg, nInstsPerBlock));
   }
 
   // --------------------------------------------------------------------------
@@ -996,7 +1564,7 @@ ASMJIT_FAVOR_SPEED Error BaseRAPass::buildLiveness() noexcept {
           // We couldn't calculate this in previous steps, but since we know all LIVE-OUT
           // at this point it becomes trivial. If this is the last instruction that uses
           // this `workReg` and it's not LIVE-OUT then it is KILLed here.
-          if (tiedReg->isLast() && !block->liveOut().bitAt(workId))
+          if (tiedReg->isLast() && !raIsLive(block->liveOut(), workId))
             tiedReg->addFlags(RATiedReg::kKill);
 
           LiveRegSpans& liveSpans = workReg->liveSpans();
@@ -1046,18 +1614,8 @@ ASMJIT_FAVOR_SPEED Error BaseRAPass::buildLiveness() noexcept {
   // Calculate WorkReg statistics.
   // --------------------------------------------------------------------------
 
-  for (i = 0; i < numWorkRegs; i++) {
-    RAWorkReg* workReg = _workRegs[i];
-
-    LiveRegSpans& spans = workReg->liveSpans();
-    uint32_t width = spans.width();
-    float freq = width ? float(double(workReg->_refs.size()) / double(width)) : float(0);
-
-    RALiveStats& stats = workReg->liveStats();
-    stats._width = width;
-    stats._freq = freq;
-    stats._priority = freq + float(int(workReg->virtReg()->weight())) * 0.01f;
-  }
+  for (i = 0; i < numWorkRegs; i++)
+    RAPass_updateLiveStats(_workRegs[i]);
 
   ASMJIT_RA_LOG_COMPLEX({
     sb.clear();
@@ -1090,7 +1648,7 @@ Error BaseRAPass::assignArgIndexToWorkRegs() noexcept {
 
       // Overwritten argument.
       uint32_t workId = workReg->workId();
-      if (!liveIn.bitAt(workId))
+      if (!raIsLive(liveIn, workId))
         continue;
 
       workReg->setArgIndex(argIndex, valueIndex);
@@ -1105,6 +1663,261 @@ Error BaseRAPass::assignArgIndexToWorkRegs() noexcept {
   return kErrorOk;
 }
 
+// ============================================================================
+// [asmjit::BaseRAPass - Coalescing]
+// ============================================================================
+
+static ASMJIT_INLINE bool RAPass_instUsesWorkReg(const BaseNode* node, uint32_t workId) noexcept {
+  const RAInst* raInst = node->passData<RAInst>();
+  uint32_t count = raInst->tiedCount();
+
+  for (uint32_t i = 0; i < count; i++)
+    if (raInst->tiedAt(i)->workId() == workId)
+      return true;
+  return false;
+}
+
+static ASMJIT_INLINE void RAPass_removeRef(ZoneVector<BaseNode*>& refs, BaseNode* node) noexcept {
+  uint32_t index = refs.indexOf(node);
+  if (index != Globals::kNotFound)
+    refs.removeAt(index);
+}
+
+ASMJIT_FAVOR_SPEED Error BaseRAPass::coalesceMoves() noexcept {
+#ifndef ASMJIT_NO_LOGGING
+  Logger* logger = debugLogger();
+#endif
+
+  ASMJIT_RA_LOG_FORMAT("[RAPass::CoalesceMoves]\n");
+
+  uint32_t i;
+  uint32_t numAllBlocks = blockCount();
+
+  // Collect all move instructions marked by the architecture-specific CFG builder.
+  ZoneVector<InstNode*> moves;
+  for (i = 0; i < numAllBlocks; i++) {
+    RABlock* block = _blocks[i];
+    if (!block->isReachable())
+      continue;
+
+    BaseNode* node = block->first();
+    BaseNode* stop = block->last();
+
+    for (;;) {
+      if (node->isInst() && node->passData<RAInst>()->isMove())
+        ASMJIT_PROPAGATE(moves.append(allocator(), node->as<InstNode>()));
+
+      if (node == stop)
+        break;
+
+      node = node->next();
+      ASMJIT_ASSERT(node != nullptr);
+    }
+  }
+
+  if (moves.empty()) {
+    ASMJIT_RA_LOG_FORMAT("  Done (no moves)\n");
+    return kErrorOk;
+  }
+
+  // Moves within the most nested loops are the most expensive, coalesce them
+  // first so they are not blocked by interference created by other merges.
+  moves.sort([](const InstNode* a, const InstNode* b) noexcept {
+    return int(b->passData<RAInst>()->block()->weight()) - int(a->passData<RAInst>()->block()->weight());
+  });
+
+  LiveRegSpans tmpSpans;
+  uint32_t numMoves = moves.size();
+
+  for (i = 0; i < numMoves; i++) {
+    InstNode* node = moves[i];
+    RAInst* raInst = node->passData<RAInst>();
+    RABlock* block = raInst->block();
+
+    if (raInst->tiedCount() != 2)
+      continue;
+
+    // The move cannot be removed if it's the only node of its block.
+    if (block->first() == node && block->last() == node)
+      continue;
+
+    RATiedReg* outTied = nullptr;
+    RATiedReg* useTied = nullptr;
+
+    for (uint32_t j = 0; j < 2; j++) {
+      RATiedReg* tiedReg = raInst->tiedAt(j);
+      if (tiedReg->isWriteOnly())
+        outTied = tiedReg;
+      else if (tiedReg->isReadOnly())
+        useTied = tiedReg;
+    }
+
+    if (!outTied || !useTied || outTied->hasOutId() || useTied->hasUseId())
+      continue;
+
+    // Keep the source register by default as it's usually defined first. Function
+    // arguments must be kept as they are looked up through their `VirtReg`.
+    RAWorkReg* keep = workRegById(useTied->workId());
+    RAWorkReg* drop = workRegById(outTied->workId());
+
+    if (drop->hasArgIndex()) {
+      if (keep->hasArgIndex())
+        continue;
+      std::swap(keep, drop);
+    }
+
+    if (keep->signature() != drop->signature() ||
+        keep->typeId() != drop->typeId() ||
+        keep->virtReg()->virtSize() != drop->virtReg()->virtSize() ||
+        keep->hasStackSlot() || drop->hasStackSlot())
+      continue;
+
+    // Registers interfere if their live spans overlap.
+    Error err = tmpSpans.nonOverlappingUnionOf(allocator(), keep->liveSpans(), drop->liveSpans(), LiveRegData(keep->virtId()));
+    if (err == 0xFFFFFFFFu)
+      continue;
+    ASMJIT_PROPAGATE(err);
+
+    // Registers also interfere if any other instruction references both of them,
+    // as one would be killed and the other defined by it (spans only touch).
+    uint32_t keepId = keep->workId();
+    uint32_t dropId = drop->workId();
+
+    bool sharesInst = false;
+    for (BaseNode* ref : drop->_refs) {
+      if (ref != node && RAPass_instUsesWorkReg(ref, keepId)) {
+        sharesInst = true;
+        break;
+      }
+    }
+
+    if (sharesInst)
+      continue;
+
+    // Live bits of large functions don't cover registers that are never live
+    // across blocks, so `keep` cannot take over LIVE-IN/OUT bits of `drop` then.
+    uint32_t numLiveRegs = entryBlock()->liveIn().size();
+    if (dropId < numLiveRegs && keepId >= numLiveRegs)
+      continue;
+
+    ASMJIT_RA_LOG_FORMAT("  %s <- %s {#%u}\n", keep->name(), drop->name(), block->blockId());
+
+    // Retarget all references of `drop` to `keep`.
+    RAPass_removeRef(keep->_refs, node);
+    RAPass_removeRef(keep->_writes, node);
+
+    for (BaseNode* ref : drop->_refs) {
+      if (ref == node)
+        continue;
+
+      RAInst* refInst = ref->passData<RAInst>();
+      uint32_t tiedCount = refInst->tiedCount();
+
+      for (uint32_t j = 0; j < tiedCount; j++) {
+        RATiedReg* tiedReg = refInst->tiedAt(j);
+        if (tiedReg->workId() == dropId)
+          tiedReg->_workId = keepId;
+      }
+
+      ASMJIT_PROPAGATE(keep->_refs.append(allocator(), ref));
+    }
+
+    for (BaseNode* ref : drop->_writes)
+      if (ref != node)
+        ASMJIT_PROPAGATE(keep->_writes.append(allocator(), ref));
+
+    keep->liveSpans().swap(tmpSpans);
+    if (!keep->hasHintRegId() && drop->hasHintRegId())
+      keep->setHintRegId(drop->hintRegId());
+    keep->addClobberSurvivalMask(drop->clobberSurvivalMask());
+
+    drop->_refs.reset();
+    drop->_writes.reset();
+    drop->liveSpans().reset();
+    drop->liveStats() = RALiveStats();
+    drop->markCoalesced();
+
+    // Only LIVE-IN and LIVE-OUT are used after the liveness analysis.
+    for (uint32_t blockId = 0; blockId < numAllBlocks; blockId++) {
+      RABlock* b = _blocks[blockId];
+      if (!b->isReachable())
+        continue;
+
+      if (raIsLive(b->liveIn(), dropId)) {
+        b->liveIn().setBit(dropId, false);
+        b->liveIn().setBit(keepId, true);
+      }
+
+      if (raIsLive(b->liveOut(), dropId)) {
+        b->liveOut().setBit(dropId, false);
+        b->liveOut().setBit(keepId, true);
+      }
+    }
+
+    RAWorkRegs& groupRegs = workRegs(drop->group());
+    groupRegs.removeAt(groupRegs.indexOf(drop));
+
+    // Remove the move, which is now a no-op.
+    if (block->first() == node)
+      block->setFirst(node->next());
+    if (block->last() == node)
+      block->setLast(node->prev());
+
+    node->resetPassData();
+    cc()->removeNode(node);
+
+    RAPass_updateLiveStats(keep);
+    _coalescedMoveCount++;
+  }
+
+  tmpSpans.release(allocator());
+  moves.release(allocator());
+
+  ASMJIT_RA_LOG_FORMAT("  Done (%u of %u moves eliminated)\n", _coalescedMoveCount, numMoves);
+  return kErrorOk;
+}
+
+// ============================================================================
+// [asmjit::BaseRAPass - Rematerialization]
+// ============================================================================
+
+Error BaseRAPass::findRematerializableRegs() noexcept {
+#ifndef ASMJIT_NO_LOGGING
+  Logger* logger = debugLogger();
+#endif
+
+  ASMJIT_RA_LOG_FORMAT("[RAPass::FindRematerializableRegs]\n");
+
+  uint32_t numWorkRegs = workRegCount();
+  uint32_t count = 0;
+
+  const ZoneBitVector& entryLiveIn = entryBlock()->liveIn();
+
+  for (uint32_t workId = 0; workId < numWorkRegs; workId++) {
+    RAWorkReg* workReg = _workRegs[workId];
+
+    // The only definition must reach all uses of the register, and the register
+    // must never be accessed through its stack slot (function arguments, RegHome).
+    if (workReg->isCoalesced() || workReg->_writes.size() != 1 || workReg->hasArgIndex() || workReg->hasStackSlot())
+      continue;
+
+    if (raIsLive(entryLiveIn, workId))
+      continue;
+
+    BaseNode* node = workReg->_writes[0];
+    if (!node->passData<RAInst>()->isRematerializable())
+      continue;
+
+    workReg->setRematNode(node->as<InstNode>());
+    count++;
+
+    ASMJIT_RA_LOG_FORMAT("  %s\n", workReg->name());
+  }
+
+  ASMJIT_RA_LOG_FORMAT("  Done (%u rematerializable)\n", count);
+  return kErrorOk;
+}
+
 // ============================================================================
 // [asmjit::BaseRAPass - Allocation - Global]
 // ============================================================================
@@ -1124,6 +1937,13 @@ static void RAPass_dumpSpans(String& sb, uint32_t index, const LiveRegSpans& liv
 #endif
 
 Error BaseRAPass::runGlobalAllocator() noexcept {
+  if (isLinearScan()) {
+    for (uint32_t group = 0; group < BaseReg::kGroupVirt; group++) {
+      ASMJIT_PROPAGATE(linearScan(group));
+    }
+    return kErrorOk;
+  }
+
   ASMJIT_PROPAGATE(initGlobalLiveSpans());
 
   for (uint32_t group = 0; group < BaseReg::kGroupVirt; group++) {
@@ -1252,6 +2072,11 @@ ASMJIT_FAVOR_SPEED Error BaseRAPass::binPack(uint32_t group) noexcept {
     numWorkRegs = dstIndex;
   }
 
+  // Split the rest at loop boundaries, if possible.
+  uint32_t splitCount = 0;
+  if (!workRegs.empty())
+    ASMJIT_PROPAGATE(splitLiveRanges(group, workRegs, &splitCount));
+
   ASMJIT_RA_LOG_COMPLEX({
     for (uint32_t physId = 0; physId < physCount; physId++) {
       LiveRegSpans& live = _globalLiveSpans[group][physId];
@@ -1267,6 +2092,23 @@ ASMJIT_FAVOR_SPEED Error BaseRAPass::binPack(uint32_t group) noexcept {
   // Maybe unused if logging is disabled.
   DebugUtils::unused(physCount);
 
+  if (splitCount) {
+    ASMJIT_RA_LOG_COMPLEX({
+      sb.clear();
+      sb.appendFormat("  Split (%u): ", splitCount);
+      bool first = true;
+      for (RAWorkReg* workReg : workRegs) {
+        if (!workReg->hasSplitRegId())
+          continue;
+        if (!first) sb.append(", ");
+        sb.appendFormat("%s@%u", workReg->name(), workReg->splitRegId());
+        first = false;
+      }
+      sb.append('\n');
+      logger->log(sb);
+    });
+  }
+
   if (workRegs.empty()) {
     ASMJIT_RA_LOG_FORMAT("  Completed.\n");
   }
@@ -1292,6 +2134,202 @@ ASMJIT_FAVOR_SPEED Error BaseRAPass::binPack(uint32_t group) noexcept {
   return kErrorOk;
 }
 
+ASMJIT_FAVOR_SPEED Error BaseRAPass::linearScan(uint32_t group) noexcept {
+  if (workRegCount(group) == 0)
+    return kErrorOk;
+
+#ifndef ASMJIT_NO_LOGGING
+  Logger* logger = debugLogger();
+  StringTmp<512> sb;
+
+  ASMJIT_RA_LOG_FORMAT("[RAPass::LinearScan] Available=%u (0x%08X) Count=%u\n",
+    Support::popcnt(_availableRegs[group]),
+    _availableRegs[group],
+    workRegCount(group));
+#endif
+
+  RAWorkRegs workRegs;
+  RAWorkRegs spilledRegs;
+
+  ASMJIT_PROPAGATE(workRegs.concat(allocator(), this->workRegs(group)));
+  workRegs.sort([](const RAWorkReg* a, const RAWorkReg* b) noexcept {
+    uint32_t aStart = a->liveSpans().empty() ? 0u : a->liveSpans()[0].a;
+    uint32_t bStart = b->liveSpans().empty() ? 0u : b->liveSpans()[0].a;
+    return aStart != bStart ? int(aStart) - int(bStart) : int(a->workId()) - int(b->workId());
+  });
+
+  uint32_t availableRegs = _availableRegs[group];
+  uint32_t activeEnd[Globals::kMaxPhysRegs] {};
+  RAWorkReg* activeRegs[Globals::kMaxPhysRegs] {};
+
+  for (RAWorkReg* workReg : workRegs) {
+    const LiveRegSpans& spans = workReg->liveSpans();
+    if (spans.empty())
+      continue;
+
+    uint32_t start = spans[0].a;
+    uint32_t end = spans[spans.size() - 1].b;
+
+    // Expire active registers that end before `start`.
+    uint32_t freeRegs = 0;
+    Support::BitWordIterator<uint32_t> it(availableRegs);
+    while (it.hasNext()) {
+      uint32_t physId = it.next();
+      if (activeEnd[physId] <= start)
+        freeRegs |= Support::bitMask(physId);
+    }
+
+    uint32_t physId = BaseReg::kIdBad;
+    if (freeRegs) {
+      if (workReg->hasHintRegId() && (freeRegs & Support::bitMask(workReg->hintRegId()))) {
+        physId = workReg->hintRegId();
+      }
+      else {
+        uint32_t preferredMask = freeRegs & workReg->clobberSurvivalMask();
+        physId = Support::ctz(preferredMask ? preferredMask : freeRegs);
+      }
+    }
+    else {
+      // Spill the active register that ends last, if it ends after `workReg`.
+      uint32_t spillEnd = end;
+      it.init(availableRegs);
+      while (it.hasNext()) {
+        uint32_t candidateId = it.next();
+        if (activeEnd[candidateId] > spillEnd) {
+          physId = candidateId;
+          spillEnd = activeEnd[candidateId];
+        }
+      }
+
+      if (physId != BaseReg::kIdBad) {
+        RAWorkReg* spilledReg = activeRegs[physId];
+        spilledReg->setHomeRegId(BaseReg::kIdBad);
+        ASMJIT_PROPAGATE(spilledRegs.append(allocator(), spilledReg));
+      }
+    }
+
+    if (physId == BaseReg::kIdBad) {
+      ASMJIT_PROPAGATE(spilledRegs.append(allocator(), workReg));
+      continue;
+    }
+
+    workReg->setHomeRegId(physId);
+    activeEnd[physId] = end;
+    activeRegs[physId] = workReg;
+  }
+
+  if (spilledRegs.empty()) {
+    ASMJIT_RA_LOG_FORMAT("  Completed.\n");
+  }
+  else {
+    _strategy[group].setType(RAStrategy::kStrategyComplex);
+    for (RAWorkReg* workReg : spilledRegs)
+      workReg->markStackPreferred();
+
+    ASMJIT_RA_LOG_COMPLEX({
+      sb.clear();
+      sb.appendFormat("  Unassigned (%u): ", spilledRegs.size());
+      for (uint32_t i = 0; i < spilledRegs.size(); i++) {
+        if (i) sb.append(", ");
+        sb.append(spilledRegs[i]->name());
+      }
+      sb.append('\n');
+      logger->log(sb);
+    });
+  }
+
+  return kErrorOk;
+}
+
+Error BaseRAPass::buildSplitSpans(const RAWorkReg* workReg, uint32_t minWeight, LiveRegSpans& out, uint32_t* maxRefWeight) noexcept {
+  const LiveRegSpans& spans = workReg->liveSpans();
+  uint32_t spanCount = spans.size();
+  uint32_t spanIndex = 0;
+
+  out._data.clear();
+
+  // Blocks are ordered by their positions, which makes it possible to
+  // intersect them with live spans, which are sorted too, in a single pass.
+  for (RABlock* block : _blocks) {
+    if (!block->isReachable() || block->weight() < minWeight)
+      continue;
+
+    uint32_t blockStart = block->firstPosition();
+    uint32_t blockEnd = block->endPosition();
+
+    while (spanIndex < spanCount && spans[spanIndex].b <= blockStart)
+      spanIndex++;
+
+    for (uint32_t i = spanIndex; i < spanCount && spans[i].a < blockEnd; i++) {
+      uint32_t a = Support::max(spans[i].a, blockStart);
+      uint32_t b = Support::min(spans[i].b, blockEnd);
+      if (a < b)
+        ASMJIT_PROPAGATE(out.openAt(allocator(), a, b));
+    }
+  }
+
+  if (maxRefWeight) {
+    uint32_t weight = 0;
+    for (BaseNode* node : workReg->_refs)
+      weight = Support::max(weight, node->as<InstNode>()->passData<RAInst>()->block()->weight());
+    *maxRefWeight = weight;
+  }
+
+  return kErrorOk;
+}
+
+Error BaseRAPass::splitLiveRanges(uint32_t group, RAWorkRegs& workRegs, uint32_t* splitCountOut) noexcept {
+  uint32_t availableRegs = _availableRegs[group];
+  uint32_t splitCount = 0;
+
+  LiveRegSpans splitSpans;
+  LiveRegSpans tmpSpans;
+
+  for (RAWorkReg* workReg : workRegs) {
+    uint32_t maxRefWeight;
+    ASMJIT_PROPAGATE(buildSplitSpans(workReg, 1, splitSpans, &maxRefWeight));
+
+    // Try the whole loop nest first (less transitions between register and
+    // memory) and then go deeper until the split succeeds or there is no loop
+    // that uses `workReg` anymore.
+    for (uint32_t weight = 1; weight <= maxRefWeight && !splitSpans.empty(); weight++) {
+      if (weight > 1)
+        ASMJIT_PROPAGATE(buildSplitSpans(workReg, weight, splitSpans));
+
+      uint32_t physRegs = availableRegs;
+      while (physRegs) {
+        uint32_t physId = Support::ctz(physRegs);
+        LiveRegSpans& live = _globalLiveSpans[group][physId];
+
+        Error err = tmpSpans.nonOverlappingUnionOf(allocator(), live, splitSpans, LiveRegData(workReg->virtId()));
+        if (err == kErrorOk) {
+          live.swap(tmpSpans);
+          workReg->setSplitRegId(physId);
+          workReg->_splitSpans.swap(splitSpans);
+          break;
+        }
+
+        if (ASMJIT_UNLIKELY(err != 0xFFFFFFFFu))
+          return err;
+
+        physRegs ^= Support::bitMask(physId);
+      }
+
+      if (workReg->hasSplitRegId()) {
+        ASMJIT_PROPAGATE(_splitWorkRegs.append(allocator(), workReg));
+        splitCount++;
+        break;
+      }
+    }
+  }
+
+  splitSpans.release(allocator());
+  tmpSpans.release(allocator());
+
+  *splitCountOut = splitCount;
+  return kErrorOk;
+}
+
 // ============================================================================
 // [asmjit::BaseRAPass - Allocation - Local]
 // ============================================================================
@@ -1389,7 +2427,21 @@ Error BaseRAPass::runLocalAllocator() noexcept {
       else {
         ASMJIT_PROPAGATE(lra.spillRegsBeforeEntry(consecutive));
         ASMJIT_PROPAGATE(setBlockEntryAssignment(consecutive, block, lra._curAssignment));
-        lra._curAssignment.copyFrom(consecutive->entryPhysToWorkMap(), consecutive->entryWorkToPhysMap());
+
+        // The entry assignment differs from the current one only if it assigns
+        // split registers, which requires moves or loads on this edge.
+        if (_splitWorkRegs.empty()) {
+          lra._curAssignment.copyFrom(consecutive->entryPhysToWorkMap(), consecutive->entryWorkToPhysMap());
+        }
+        else {
+          ASMJIT_PROPAGATE(
+            lra.switchToAssignment(
+              consecutive->entryPhysToWorkMap(),
+              consecutive->entryWorkToPhysMap(),
+              consecutive->liveIn(),
+              false,
+              false));
+        }
       }
     }
 
@@ -1481,9 +2533,44 @@ Error BaseRAPass::setBlockEntryAssignment(RABlock* block, const RABlock* fromBlo
     }
   }
 
+  if (!_splitWorkRegs.empty())
+    assignSplitRegsOnEntry(block, as);
+
   return blockEntryAssigned(as);
 }
 
+void BaseRAPass::assignSplitRegsOnEntry(const RABlock* block, RAAssignment& as) noexcept {
+  const ZoneBitVector& liveIn = block->liveIn();
+
+  for (RAWorkReg* workReg : _splitWorkRegs) {
+    uint32_t workId = workReg->workId();
+    if (!raIsLive(liveIn, workId) || !workReg->splitSpans().overlaps(block->firstPosition(), block->endPosition()))
+      continue;
+
+    uint32_t group = workReg->group();
+    uint32_t splitId = workReg->splitRegId();
+    uint32_t physId = as.workToPhysId(group, workId);
+
+    if (physId == splitId)
+      continue;
+
+    // Scratch registers cannot be assigned upon entry.
+    if (group == BaseReg::kGroupGp && Support::bitTest(block->entryScratchGpRegs(), splitId))
+      continue;
+
+    // Whatever occupies the split register is spilled on the edge that enters
+    // `block` and `workReg` is moved or loaded there. The register enters the
+    // block dirty so the code within the split region never has to save it.
+    if (as.isPhysAssigned(group, splitId))
+      as.unassign(group, as.physToWorkId(group, splitId), splitId);
+
+    if (physId != RAAssignment::kPhysNone)
+      as.unassign(group, workId, physId);
+
+    as.assign(group, workId, splitId, true);
+  }
+}
+
 Error BaseRAPass::setSharedAssignment(uint32_t sharedAssignmentId, const RAAssignment& fromAssignment) noexcept {
   ASMJIT_ASSERT(_sharedAssignments[sharedAssignmentId].empty());
 
@@ -1526,7 +2613,7 @@ Error BaseRAPass::setSharedAssignment(uint32_t sharedAssignmentId, const RAAssig
           uint32_t physId = it.next();
           uint32_t workId = as.physToWorkId(group, physId);
 
-          if (!liveIn.bitAt(workId))
+          if (!raIsLive(liveIn, workId))
             as.unassign(group, workId, physId);
         }
       }
@@ -1596,6 +2683,29 @@ Error BaseRAPass::useTemporaryMem(BaseMem& out, uint32_t size, uint32_t alignmen
   return kErrorOk;
 }
 
+Error BaseRAPass::emitRemat(uint32_t workId, uint32_t dstPhysId) noexcept {
+  RAWorkReg* workReg = workRegById(workId);
+  InstNode* rematNode = workReg->rematNode();
+  ASMJIT_ASSERT(rematNode != nullptr);
+
+  // The first operand is the defined register, the rest are constants.
+  uint32_t opCount = rematNode->opCount();
+  Operand operands[Globals::kMaxOpCount];
+
+  for (uint32_t i = 0; i < opCount; i++)
+    operands[i] = rematNode->op(i);
+  operands[0].as<BaseReg>().setId(dstPhysId);
+
+#ifndef ASMJIT_NO_LOGGING
+  if (_loggerFlags & FormatOptions::kFlagAnnotations) {
+    _tmpString.assignFormat("<REMAT> %s", workReg->name());
+    cc()->setInlineComment(_tmpString.data());
+  }
+#endif
+
+  return cc()->emitInst(rematNode->baseInst(), operands, opCount);
+}
+
 // ============================================================================
 // [asmjit::BaseRAPass - Allocation - Prolog / Epilog]
 // ============================================================================
@@ -1616,10 +2726,32 @@ Error BaseRAPass::updateStackFrame() noexcept {
   if (_numStackArgsToStackSlots)
     ASMJIT_PROPAGATE(_markStackArgsToKeep());
 
+  // Spill slots are only accessed within live spans of their registers, so slots
+  // of registers that don't interfere can share memory. Slots referenced by the
+  // code, stack arguments, and stack virtual registers are excluded.
+  if (!isLinearScan()) {
+    for (RAWorkReg* workReg : _workRegs) {
+      RAStackSlot* slot = workReg->stackSlot();
+      if (slot && !workReg->virtReg()->isStack() && !workReg->hasArgIndex() &&
+          !workReg->hasFlag(RAWorkReg::kFlagStackReferenced) && !workReg->liveSpans().empty()) {
+        slot->setLiveSpans(&workReg->liveSpans());
+      }
+    }
+  }
+
   // Calculate offsets of all stack slots and update StackSize to reflect the calculated local stack size.
   ASMJIT_PROPAGATE(_stackAllocator.calculateStackFrame());
   frame.setLocalStackSize(_stackAllocator.stackSize());
 
+#ifndef ASMJIT_NO_LOGGING
+  Logger* logger = debugLogger();
+  ASMJIT_RA_LOG_FORMAT("[RAPass::UpdateStackFrame] Slots=%u Shared=%u (%u bytes saved) StackSize=%u\n",
+    _stackAllocator.slotCount(),
+    _stackAllocator.sharedSlotCount(),
+    _stackAllocator.sharedBytes(),
+    _stackAllocator.stackSize());
+#endif
+
   // Update the stack frame based on `_argsAssignment` and finalize it.
   // Finalization means to apply final calculation to the stack layout.
   ASMJIT_PROPAGATE(_argsAssignment.updateFuncFrame(frame));
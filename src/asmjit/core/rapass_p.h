@@ -29,6 +29,7 @@
 
 #include "../core/compiler.h"
 #include "../core/emithelper_p.h"
+#include "../core/osutils_p.h"
 #include "../core/raassignment_p.h"
 #include "../core/radefs_p.h"
 #include "../core/rastack_p.h"
@@ -44,6 +45,14 @@ ASMJIT_BEGIN_NAMESPACE
 // [asmjit::RABlock]
 // ============================================================================
 
+//! Tests whether `workId` is set in LIVE-IN or LIVE-OUT bits `liveBits`.
+//!
+//! Live bits of large functions only cover work registers that can be live
+//! across blocks, which are numbered first, see \ref BaseRAPass::buildLiveness().
+static ASMJIT_INLINE bool raIsLive(const ZoneBitVector& liveBits, uint32_t workId) noexcept {
+  return workId < liveBits.size() && liveBits.bitAt(workId);
+}
+
 //! Basic block used by register allocator pass.
 class RABlock {
 public:
@@ -68,6 +77,8 @@ public:
     kFlagIsAllocated      = 0x00000008u,
     //! Block is a function-exit.
     kFlagIsFuncExit       = 0x00000010u,
+    //! Block is a header of a natural loop (set by `buildLoops()`).
+    kFlagIsLoopHeader     = 0x00000020u,
 
     //! Block has a terminator (jump, conditional jump, ret).
     kFlagHasTerminator    = 0x00000100u,
@@ -99,7 +110,7 @@ public:
   //! End position of this block (exclusive).
   uint32_t _endPosition = 0;
 
-  //! Weight of this block (default 0, each loop adds one).
+  //! Weight of this block (default 0, each loop adds one), see `buildLoops()`.
   uint32_t _weight = 0;
   //! Post-order view order, used during POV construction.
   uint32_t _povOrder = 0;
@@ -170,6 +181,7 @@ public:
   inline bool isTargetable() const noexcept { return hasFlag(kFlagIsTargetable); }
   inline bool isAllocated() const noexcept { return hasFlag(kFlagIsAllocated); }
   inline bool isFuncExit() const noexcept { return hasFlag(kFlagIsFuncExit); }
+  inline bool isLoopHeader() const noexcept { return hasFlag(kFlagIsLoopHeader); }
 
   inline void makeConstructed(const RARegsStats& regStats) noexcept {
     _flags |= kFlagIsConstructed;
@@ -206,6 +218,9 @@ public:
 
   inline uint32_t povOrder() const noexcept { return _povOrder; }
 
+  //! Returns the weight of this block, which is its loop depth.
+  inline uint32_t weight() const noexcept { return _weight; }
+
   inline uint32_t entryScratchGpRegs() const noexcept;
   inline uint32_t exitScratchGpRegs() const noexcept { return _exitScratchGpRegs; }
 
@@ -305,6 +320,10 @@ public:
   RATiedReg _tiedRegs[1];
 
   enum Flags : uint32_t {
+    //! Instruction defines its only register from constant operands (candidate for rematerialization).
+    kFlagIsRematerializable = 0x20000000u,
+    //! Instruction is a register to register copy of the whole register (candidate for coalescing).
+    kFlagIsMove = 0x40000000u,
     kFlagIsTransformable = 0x80000000u
   };
 
@@ -340,6 +359,10 @@ public:
 
   //! Tests whether this instruction can be transformed to another instruction if necessary.
   inline bool isTransformable() const noexcept { return hasFlag(kFlagIsTransformable); }
+  //! Tests whether this instruction is a register to register copy.
+  inline bool isMove() const noexcept { return hasFlag(kFlagIsMove); }
+  //! Tests whether this instruction can be emitted again to recreate the register it defines.
+  inline bool isRematerializable() const noexcept { return hasFlag(kFlagIsRematerializable); }
 
   //! Returns the associated block with this RAInst.
   inline RABlock* block() const noexcept { return _block; }
@@ -643,7 +666,12 @@ public:
   typedef FuncPass Base;
 
   enum Weights : uint32_t {
-    kCallArgWeight = 80
+    kCallArgWeight = 80,
+
+    //! Each loop level multiplies the frequency of register uses by this factor.
+    kLoopWeightShift = 3,
+    //! Maximum loop depth considered when weighting register uses.
+    kLoopWeightMaxDepth = 3
   };
 
   typedef RAAssignment::PhysToWorkMap PhysToWorkMap;
@@ -715,6 +743,10 @@ public:
   RALiveCount _globalMaxLiveCount = RALiveCount();
   //! Global live spans per register group.
   LiveRegSpans* _globalLiveSpans[BaseReg::kGroupVirt] {};
+  //! Work registers that have a split home register assigned by `binPack()`.
+  RAWorkRegs _splitWorkRegs;
+  //! Number of moves eliminated by `coalesceMoves()`.
+  uint32_t _coalescedMoveCount = 0;
   //! Temporary stack slot.
   Operand _temporaryMem = Operand();
 
@@ -734,6 +766,12 @@ public:
   //! Temporary string builder used to format comments.
   StringTmp<80> _tmpString;
 
+  //! Lock that guards the compiler when functions are allocated concurrently,
+  //! null if the pass runs serially.
+  Lock* _compilerLock = nullptr;
+  //! Number of threads that allocated registers during the last `run()`.
+  uint32_t _lastThreadCount = 0;
+
   //! \name Construction & Reset
   //! \{
 
@@ -745,6 +783,10 @@ public:
   //! \name Accessors
   //! \{
 
+  //! Returns the number of threads that allocated registers during the last
+  //! `run()`, which is 1 if the functions were processed serially.
+  inline uint32_t lastThreadCount() const noexcept { return _lastThreadCount; }
+
   //! Returns \ref Logger passed to \ref runOnFunction().
   inline Logger* logger() const noexcept { return _logger; }
   //! Returns \ref Logger passed to \ref runOnFunction() or null if `kOptionDebugPasses` is not set.
@@ -770,6 +812,9 @@ public:
 
   inline uint32_t endPosition() const noexcept { return _instructionCount * 2; }
 
+  //! Tests whether the linear-scan allocator was selected, see \ref BaseCompiler::setRAAllocator().
+  inline bool isLinearScan() const noexcept { return cc()->raAllocator() == BaseCompiler::kRAAllocatorLinearScan; }
+
   inline const RARegMask& availableRegs() const noexcept { return _availableRegs; }
   inline const RARegMask& cloberredRegs() const noexcept { return _clobberedRegs; }
 
@@ -783,6 +828,10 @@ public:
     _availableRegCount[group]--;
   }
 
+  //! Runs the register allocator on all functions, possibly concurrently if
+  //! enabled by \ref BaseCompiler::setRAThreadCount().
+  Error run(Zone* zone, Logger* logger) override;
+
   //! Runs the register allocator for the given `func`.
   Error runOnFunction(Zone* zone, Logger* logger, FuncNode* func) override;
 
@@ -802,6 +851,10 @@ public:
   //! up. Called even if the register allocation failed.
   virtual void onDone() noexcept = 0;
 
+  //! Creates a new pass of the same type allocated by `zone`, which is used to
+  //! process functions on another thread. Returns null if not supported.
+  virtual BaseRAPass* newWorker(Zone* zone) noexcept;
+
   //! \}
 
   //! \name CFG - Basic-Block Management
@@ -971,6 +1024,21 @@ public:
 
   //! \}
 
+  //! \name CFG - Loops
+  //! \{
+
+  //! Discovers natural loops by using the dominator-tree and increments the
+  //! weight of each block by one for each loop it belongs to, so the weight
+  //! of a block is its loop depth. Must be called after `buildDominators()`.
+  Error buildLoops() noexcept;
+
+  //! Returns a multiplier of register uses in a block of the given `weight`.
+  static inline float loopWeightFactor(uint32_t weight) noexcept {
+    return float(1u << (Support::min<uint32_t>(weight, kLoopWeightMaxDepth) * kLoopWeightShift));
+  }
+
+  //! \}
+
   //! \name CFG - Utilities
   //! \{
 
@@ -1005,6 +1073,8 @@ public:
   inline const RAWorkRegs& workRegs(uint32_t group) const noexcept { return _workRegsOfGroup[group]; }
 
   inline uint32_t workRegCount() const noexcept { return _workRegs.size(); }
+  //! Returns the number of moves eliminated by `coalesceMoves()` in the current function.
+  inline uint32_t coalescedMoveCount() const noexcept { return _coalescedMoveCount; }
   inline uint32_t workRegCount(uint32_t group) const noexcept { return _workRegsOfGroup[group].size(); }
 
   inline void _buildPhysIndex() noexcept {
@@ -1074,6 +1144,16 @@ public:
   //! finishes as it checks whether the argument is live upon entry.
   Error assignArgIndexToWorkRegs() noexcept;
 
+  //! Coalesces work registers related by a move instruction if their live spans
+  //! don't interfere. The work register that is merged is marked as coalesced and
+  //! removed from its group, and the move instruction is removed from the code.
+  Error coalesceMoves() noexcept;
+
+  //! Marks work registers that have a single definition, which is a rematerializable
+  //! instruction. Such registers are never saved to the stack, the definition is
+  //! emitted again where the register would be reloaded.
+  Error findRematerializableRegs() noexcept;
+
   //! \}
 
   //! \name Register Allocation - Global
@@ -1087,6 +1167,23 @@ public:
 
   Error binPack(uint32_t group) noexcept;
 
+  //! Assigns home registers of `group` by a linear scan over live ranges sorted
+  //! by their start. Live ranges are considered contiguous (holes are ignored)
+  //! and a register that cannot be assigned is spilled, which is either the
+  //! register being processed or an active one that ends later.
+  Error linearScan(uint32_t group) noexcept;
+
+  //! Builds spans of `workReg` that are within blocks having at least `minWeight`
+  //! weight (loop depth) and stores them to `out`. Returns the maximum weight of
+  //! blocks that reference `workReg` in `maxRefWeight`, if not null.
+  Error buildSplitSpans(const RAWorkReg* workReg, uint32_t minWeight, LiveRegSpans& out, uint32_t* maxRefWeight = nullptr) noexcept;
+
+  //! Tries to assign a split home register to each of `workRegs` that couldn't
+  //! be assigned a home register for its whole lifetime. The live range is split
+  //! at loop boundaries so the register can be kept in a register within loops
+  //! and spilled / reloaded outside of them. Returns the number of registers split.
+  Error splitLiveRanges(uint32_t group, RAWorkRegs& workRegs, uint32_t* splitCountOut) noexcept;
+
   //! \}
 
   //! \name Register Allocation - Local
@@ -1095,6 +1192,9 @@ public:
   //! Runs a local register allocator.
   Error runLocalAllocator() noexcept;
   Error setBlockEntryAssignment(RABlock* block, const RABlock* fromBlock, const RAAssignment& fromAssignment) noexcept;
+  //! Assigns split registers that are live-in at `block` and that have their split
+  //! home register valid there into the entry assignment `as` of `block`.
+  void assignSplitRegsOnEntry(const RABlock* block, RAAssignment& as) noexcept;
   Error setSharedAssignment(uint32_t sharedAssignmentId, const RAAssignment& fromAssignment) noexcept;
 
   //! Called after the RA assignment has been assigned to a block.
@@ -1151,6 +1251,9 @@ public:
   virtual Error emitLoad(uint32_t workId, uint32_t dstPhysId) noexcept = 0;
   virtual Error emitSave(uint32_t workId, uint32_t srcPhysId) noexcept = 0;
 
+  //! Emits the rematerialization of `workId` to `dstPhysId`, see \ref RAWorkReg::rematNode().
+  Error emitRemat(uint32_t workId, uint32_t dstPhysId) noexcept;
+
   virtual Error emitJump(const Label& label) noexcept = 0;
   virtual Error emitPreCall(InvokeNode* invokeNode) noexcept = 0;
 
@@ -50,6 +50,9 @@ RAStackSlot* RAStackAllocator::newSlot(uint32_t baseRegId, uint32_t size, uint32
   slot->_weight = 0;
   slot->_offset = 0;
 
+  slot->_liveSpans = nullptr;
+  slot->_sharedSlot = nullptr;
+
   _alignment = Support::max<uint32_t>(_alignment, alignment);
   _slots.appendUnsafe(slot);
   return slot;
@@ -76,6 +79,78 @@ struct RAStackGap {
   uint32_t size;
 };
 
+Error RAStackAllocator::shareSlots() noexcept {
+  uint32_t slotCount = _slots.size();
+  if (slotCount < 2)
+    return kErrorOk;
+
+  // Slots that provide memory to other slots (owners) and the union of live
+  // spans of all slots that use the memory of each owner. Slots are expected
+  // to be sorted by weight so the most used slots become owners.
+  RAStackSlots owners;
+  ASMJIT_PROPAGATE(owners.reserve(allocator(), slotCount));
+
+  LiveRegSpans* ownerSpans = allocator()->allocT<LiveRegSpans>(slotCount * sizeof(LiveRegSpans));
+  if (ASMJIT_UNLIKELY(!ownerSpans))
+    return DebugUtils::errored(kErrorOutOfMemory);
+
+  for (uint32_t i = 0; i < slotCount; i++)
+    new(&ownerSpans[i]) LiveRegSpans();
+
+  LiveRegSpans tmpSpans;
+  LiveRegSpans noSpans;
+  Error err = kErrorOk;
+
+  for (RAStackSlot* slot : _slots) {
+    if (!slot->hasLiveSpans() || slot->isStackArg())
+      continue;
+
+    const LiveRegSpans& slotSpans = *slot->liveSpans();
+    uint32_t ownerCount = owners.size();
+    uint32_t ownerIndex;
+
+    for (ownerIndex = 0; ownerIndex < ownerCount; ownerIndex++) {
+      RAStackSlot* owner = owners[ownerIndex];
+      if (owner->size() != slot->size() || owner->alignment() != slot->alignment())
+        continue;
+
+      err = tmpSpans.nonOverlappingUnionOf(allocator(), ownerSpans[ownerIndex], slotSpans, LiveRegData());
+      if (err == 0xFFFFFFFFu)
+        continue;
+
+      if (ASMJIT_UNLIKELY(err))
+        goto Done;
+
+      ownerSpans[ownerIndex].swap(tmpSpans);
+      slot->_sharedSlot = owner;
+      owner->setWeight(uint32_t(Support::min<uint64_t>(uint64_t(owner->weight()) + slot->weight(), 0xFFFFFFFFu)));
+
+      _sharedSlotCount++;
+      _sharedBytes += slot->size();
+      break;
+    }
+
+    if (ownerIndex == ownerCount) {
+      err = ownerSpans[ownerCount].nonOverlappingUnionOf(allocator(), noSpans, slotSpans, LiveRegData());
+      if (ASMJIT_UNLIKELY(err))
+        goto Done;
+      owners.appendUnsafe(slot);
+    }
+  }
+
+  err = kErrorOk;
+
+Done:
+  for (uint32_t i = 0; i < slotCount; i++)
+    ownerSpans[i].release(allocator());
+
+  allocator()->release(ownerSpans, slotCount * sizeof(LiveRegSpans));
+  tmpSpans.release(allocator());
+  owners.release(allocator());
+
+  return err;
+}
+
 Error RAStackAllocator::calculateStackFrame() noexcept {
   // Base weight added to all registers regardless of their size and alignment.
   uint32_t kBaseRegWeight = 16;
@@ -116,6 +191,19 @@ Error RAStackAllocator::calculateStackFrame() noexcept {
 
   // STEP 3:
   //
+  // Share memory of slots that are never live at the same time. Slots that
+  // provide their memory to others accumulate their weight, so sort again.
+  ASMJIT_PROPAGATE(shareSlots());
+
+  if (_sharedSlotCount) {
+    _slots.sort([](const RAStackSlot* a, const RAStackSlot* b) noexcept {
+      return a->weight() >  b->weight() ? 1 :
+             a->weight() == b->weight() ? 0 : -1;
+    });
+  }
+
+  // STEP 4:
+  //
   // Calculate offset of each slot. We start from the slot that has the highest
   // weight and advance to slots with lower weight. It could look that offsets
   // start from the first slot in our list and then simply increase, but it's
@@ -126,7 +214,7 @@ Error RAStackAllocator::calculateStackFrame() noexcept {
   ZoneVector<RAStackGap> gaps[kSizeCount - 1];
 
   for (RAStackSlot* slot : _slots) {
-    if (slot->isStackArg())
+    if (slot->isStackArg() || slot->isShared())
       continue;
 
     uint32_t slotAlignment = slot->alignment();
@@ -190,6 +278,15 @@ Error RAStackAllocator::calculateStackFrame() noexcept {
     }
   }
 
+  // STEP 5:
+  //
+  // Slots that share memory of other slots use their offsets.
+  if (_sharedSlotCount) {
+    for (RAStackSlot* slot : _slots)
+      if (slot->isShared())
+        slot->setOffset(slot->sharedSlot()->offset());
+  }
+
   _stackSize = Support::alignUp(offset, _alignment);
   return kErrorOk;
 }
@@ -71,6 +71,13 @@ struct RAStackSlot {
   //! Stack offset, calculated by \ref RAStackAllocator::calculateStackFrame().
   int32_t _offset;
 
+  //! Live spans of the register that uses the slot, if known. The content of
+  //! the slot is only needed within these spans, so it can share its memory
+  //! with other slots that don't interfere with it.
+  const LiveRegSpans* _liveSpans;
+  //! Slot that provides the memory of this slot, calculated by \ref RAStackAllocator::calculateStackFrame().
+  RAStackSlot* _sharedSlot;
+
   //! \name Accessors
   //! \{
 
@@ -96,6 +103,14 @@ struct RAStackSlot {
   inline int32_t offset() const noexcept { return _offset; }
   inline void setOffset(int32_t offset) noexcept { _offset = offset; }
 
+  inline bool hasLiveSpans() const noexcept { return _liveSpans != nullptr; }
+  inline const LiveRegSpans* liveSpans() const noexcept { return _liveSpans; }
+  inline void setLiveSpans(const LiveRegSpans* liveSpans) noexcept { _liveSpans = liveSpans; }
+
+  //! Tests whether this slot uses memory of another slot, see \ref sharedSlot().
+  inline bool isShared() const noexcept { return _sharedSlot != nullptr; }
+  inline RAStackSlot* sharedSlot() const noexcept { return _sharedSlot; }
+
   //! \}
 };
 
@@ -127,6 +142,10 @@ public:
   uint32_t _bytesUsed;
   //! Calculated stack size (can be a bit greater than `_bytesUsed`).
   uint32_t _stackSize;
+  //! Count of slots that share memory with another slot.
+  uint32_t _sharedSlotCount;
+  //! Count of bytes saved by sharing slots.
+  uint32_t _sharedBytes;
   //! Minimum stack alignment.
   uint32_t _alignment;
   //! Stack slots vector.
@@ -139,6 +158,8 @@ public:
     : _allocator(nullptr),
       _bytesUsed(0),
       _stackSize(0),
+      _sharedSlotCount(0),
+      _sharedBytes(0),
       _alignment(1),
       _slots() {}
 
@@ -146,6 +167,8 @@ public:
     _allocator = allocator;
     _bytesUsed = 0;
     _stackSize = 0;
+    _sharedSlotCount = 0;
+    _sharedBytes = 0;
     _alignment = 1;
     _slots.reset();
   }
@@ -159,6 +182,8 @@ public:
 
   inline uint32_t bytesUsed() const noexcept { return _bytesUsed; }
   inline uint32_t stackSize() const noexcept { return _stackSize; }
+  inline uint32_t sharedSlotCount() const noexcept { return _sharedSlotCount; }
+  inline uint32_t sharedBytes() const noexcept { return _sharedBytes; }
   inline uint32_t alignment() const noexcept { return _alignment; }
 
   inline RAStackSlots& slots() noexcept { return _slots; }
@@ -172,6 +197,10 @@ public:
 
   RAStackSlot* newSlot(uint32_t baseRegId, uint32_t size, uint32_t alignment, uint32_t flags = 0) noexcept;
 
+  //! Lets slots that have live spans share memory with other slots of the same
+  //! size and alignment if their live spans don't overlap.
+  Error shareSlots() noexcept;
+
   Error calculateStackFrame() noexcept;
   Error adjustSlotOffsets(int32_t offset) noexcept;
 
@@ -0,0 +1,523 @@
+// AsmJit - Machine code generation for C++
+//
+//  * Official AsmJit Home Page: https://asmjit.com
+//  * Official Github Repository: https://github.com/asmjit/asmjit
+//
+// Copyright (c) 2008-2020 The AsmJit Authors
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#include "../core/api-build_p.h"
+#if !defined(ASMJIT_NO_BUILDER) && !defined(ASMJIT_NO_INTROSPECTION)
+
+#include "../core/archtraits.h"
+#include "../core/schedpass.h"
+#include "../core/support.h"
+#include "../core/zonevector.h"
+
+ASMJIT_BEGIN_NAMESPACE
+
+// ============================================================================
+// [asmjit::SchedContext]
+// ============================================================================
+
+// Resources tracked by the scheduler are physical registers of the first four
+// register groups (indexed by `group * kSchedRegsPerGroup + id`), each bit of
+// CPU flags reported by `InstRWInfo`, and memory. Reads of memory are loads
+// and writes are stores, so loads can be reordered freely, but never across a
+// store.
+static constexpr uint32_t kSchedRegsPerGroup = 32;
+static constexpr uint32_t kSchedFlagBitCount = 32;
+static constexpr uint32_t kSchedFlagsResource = BaseReg::kGroupVirt * kSchedRegsPerGroup;
+static constexpr uint32_t kSchedMemResource = kSchedFlagsResource + kSchedFlagBitCount;
+static constexpr uint32_t kSchedResourceCount = kSchedMemResource + 1;
+
+static constexpr uint32_t kSchedNone = 0xFFFFFFFFu;
+
+//! Instruction of a scheduling region.
+struct SchedInst {
+  //! Instruction node.
+  InstNode* node;
+  //! Approximate latency of the instruction.
+  uint32_t latency;
+  //! Length of the longest latency path from this instruction to the end of the region.
+  uint32_t height;
+  //! The earliest cycle the instruction can be issued at.
+  uint32_t readyCycle;
+  //! Number of predecessors that were not scheduled yet.
+  uint32_t predCount;
+  //! Index of the first successor in `SchedContext::_succs`.
+  uint32_t succIndex;
+  //! Number of successors.
+  uint32_t succCount;
+};
+
+//! Dependency between two instructions of a scheduling region.
+struct SchedEdge {
+  uint32_t from;
+  uint32_t to;
+  uint32_t latency;
+};
+
+//! Access of a resource by a single instruction.
+struct SchedUse {
+  enum Flags : uint32_t {
+    kRead = 0x1u,
+    kWrite = 0x2u,
+    kRW = 0x3u
+  };
+
+  uint32_t resource;
+  uint32_t flags;
+};
+
+//! Last write and reads since the last write of a resource.
+struct SchedResource {
+  uint32_t lastWrite;
+  ZoneVector<uint32_t> reads;
+  //! Writes of a CPU flag that are not ordered before `lastWrite` yet.
+  ZoneVector<uint32_t> pendingWrites;
+};
+
+class SchedContext {
+public:
+  ASMJIT_NONCOPYABLE(SchedContext)
+
+  //! Maximum number of resources a single instruction can access.
+  enum Limits : uint32_t {
+    kMaxUses = Globals::kMaxOpCount * 3 + 2 + kSchedFlagBitCount
+  };
+
+  ZoneAllocator* _allocator;
+  BaseBuilder* _cb;
+  const ArchTraits* _archTraits;
+
+  //! Instructions of the current region.
+  ZoneVector<SchedInst> _insts;
+  //! Dependencies of the current region.
+  ZoneVector<SchedEdge> _edges;
+  //! Edge indexes grouped by their `from` instruction.
+  ZoneVector<uint32_t> _succs;
+  //! Instructions that have all predecessors scheduled.
+  ZoneVector<uint32_t> _ready;
+  //! Scheduled order of instructions.
+  ZoneVector<uint32_t> _order;
+  //! Resources accessed by the current region.
+  ZoneVector<uint32_t> _touched;
+
+  SchedResource _resources[kSchedResourceCount];
+
+  SchedContext(ZoneAllocator* allocator, BaseBuilder* cb) noexcept
+    : _allocator(allocator),
+      _cb(cb),
+      _archTraits(&ArchTraits::byArch(cb->arch())) {
+    for (uint32_t i = 0; i < kSchedResourceCount; i++)
+      _resources[i].lastWrite = kSchedNone;
+  }
+
+  inline uint32_t regResource(uint32_t group, uint32_t id) const noexcept {
+    if (group >= BaseReg::kGroupVirt || id >= kSchedRegsPerGroup)
+      return kSchedNone;
+    return group * kSchedRegsPerGroup + id;
+  }
+
+  static inline bool isFlagResource(uint32_t resource) noexcept {
+    return resource >= kSchedFlagsResource && resource < kSchedMemResource;
+  }
+
+  inline uint32_t regResourceByType(uint32_t type, uint32_t id) const noexcept {
+    if (!_archTraits->hasRegType(type))
+      return kSchedNone;
+    return regResource(_archTraits->regTypeToGroup(type), id);
+  }
+
+  Error addEdge(uint32_t from, uint32_t to, uint32_t latency) noexcept {
+    return _edges.append(_allocator, SchedEdge { from, to, latency });
+  }
+
+  // Orders all pending writes of `res` before its last write.
+  Error orderPendingWrites(SchedResource& res) noexcept {
+    for (uint32_t writeIndex : res.pendingWrites)
+      ASMJIT_PROPAGATE(addEdge(writeIndex, res.lastWrite, 0));
+    res.pendingWrites.clear();
+    return kErrorOk;
+  }
+
+  Error analyze(InstNode* node, SchedUse* uses, uint32_t* useCountOut, uint32_t* latencyOut) noexcept;
+  Error add(InstNode* node, const SchedUse* uses, uint32_t useCount, uint32_t latency) noexcept;
+  Error flush() noexcept;
+};
+
+// Collects resources accessed by `node`. Returns `kErrorOk` with `useCountOut`
+// set to `kSchedNone` if the instruction cannot be moved.
+Error SchedContext::analyze(InstNode* node, SchedUse* uses, uint32_t* useCountOut, uint32_t* latencyOut) noexcept {
+  uint32_t arch = _cb->arch();
+  uint32_t opCount = node->opCount();
+  const Operand* operands = node->operands();
+
+  *useCountOut = kSchedNone;
+
+  InstRWInfo rwInfo;
+  InstSchedInfo schedInfo;
+
+  // Instructions that the introspection doesn't understand are never moved.
+  if (InstAPI::queryRWInfo(arch, node->baseInst(), operands, opCount, &rwInfo) != kErrorOk ||
+      InstAPI::querySchedInfo(arch, node->baseInst(), operands, opCount, &schedInfo) != kErrorOk ||
+      schedInfo.isBarrier()) {
+    return kErrorOk;
+  }
+
+  uint32_t useCount = 0;
+  uint32_t memFlags = 0;
+
+  for (uint32_t i = 0; i < opCount; i++) {
+    const Operand& op = operands[i];
+    const OpRWInfo& opRwInfo = rwInfo.operand(i);
+
+    if (op.isReg()) {
+      const BaseReg& reg = op.as<BaseReg>();
+      if (Operand::isVirtId(reg.id()))
+        return kErrorOk;
+
+      uint32_t resource = regResource(reg.group(), reg.id());
+      if (resource == kSchedNone)
+        return kErrorOk;
+
+      uint32_t flags = opRwInfo.opFlags() & SchedUse::kRW;
+      if (i == 0 && schedInfo.hasFlag(InstSchedInfo::kFlagWriteFirstOp))
+        flags = SchedUse::kRW;
+
+      uses[useCount++] = SchedUse { resource, flags };
+    }
+    else if (op.isMem()) {
+      const BaseMem& mem = op.as<BaseMem>();
+      if (mem.isRegHome())
+        return kErrorOk;
+
+      if (mem.hasBaseReg() && mem.baseType() != BaseReg::kTypeIP) {
+        if (Operand::isVirtId(mem.baseId()))
+          return kErrorOk;
+
+        uint32_t resource = regResourceByType(mem.baseType(), mem.baseId());
+        if (resource == kSchedNone)
+          return kErrorOk;
+
+        uint32_t flags = SchedUse::kRead | (opRwInfo.isMemBaseWrite() ? uint32_t(SchedUse::kWrite) : uint32_t(0));
+        uses[useCount++] = SchedUse { resource, flags };
+      }
+
+      if (mem.hasIndexReg()) {
+        if (Operand::isVirtId(mem.indexId()))
+          return kErrorOk;
+
+        uint32_t resource = regResourceByType(mem.indexType(), mem.indexId());
+        if (resource == kSchedNone)
+          return kErrorOk;
+
+        uint32_t flags = SchedUse::kRead | (opRwInfo.isMemIndexWrite() ? uint32_t(SchedUse::kWrite) : uint32_t(0));
+        uses[useCount++] = SchedUse { resource, flags };
+      }
+
+      if (!opRwInfo.isMemFake())
+        memFlags |= opRwInfo.opFlags() & SchedUse::kRW;
+    }
+  }
+
+  if (node->hasExtraReg()) {
+    const RegOnly& extraReg = node->extraReg();
+    if (extraReg.isVirtReg())
+      return kErrorOk;
+
+    uint32_t resource = regResourceByType(extraReg.type(), extraReg.id());
+    if (resource == kSchedNone)
+      return kErrorOk;
+
+    // Consider the extra register both read and written if there is no RW information.
+    uint32_t flags = rwInfo.extraReg().opFlags() & SchedUse::kRW;
+    uses[useCount++] = SchedUse { resource, flags ? flags : uint32_t(SchedUse::kRW) };
+  }
+
+  if (schedInfo.hasFlag(InstSchedInfo::kFlagMemRead))
+    memFlags |= SchedUse::kRead;
+
+  if (schedInfo.hasFlag(InstSchedInfo::kFlagMemWrite))
+    memFlags |= SchedUse::kWrite;
+
+  if (memFlags)
+    uses[useCount++] = SchedUse { kSchedMemResource, memFlags };
+
+  // Instructions often write only some flags (ROL only writes CF and OF), so
+  // each flag is a separate resource.
+  Support::BitWordIterator<uint32_t> flagIt(rwInfo.readFlags() | rwInfo.writeFlags());
+  while (flagIt.hasNext()) {
+    uint32_t bit = flagIt.next();
+    uint32_t mask = Support::bitMask(bit);
+    uint32_t flags = ((rwInfo.readFlags() & mask) ? uint32_t(SchedUse::kRead) : uint32_t(0)) |
+                     ((rwInfo.writeFlags() & mask) ? uint32_t(SchedUse::kWrite) : uint32_t(0));
+    uses[useCount++] = SchedUse { kSchedFlagsResource + bit, flags };
+  }
+
+  ASMJIT_ASSERT(useCount <= kMaxUses);
+  *useCountOut = useCount;
+  *latencyOut = schedInfo.latency();
+  return kErrorOk;
+}
+
+// Adds `node` to the current region and creates edges from all instructions
+// it depends on (read after write, write after read, and write after write).
+//
+// Almost every X86 instruction writes CPU flags, but only few read them, so
+// writes of a CPU flag are not ordered among themselves until the flag is
+// read or the region ends. At that point all previous writes of the flag are
+// ordered before its last write, which is the only one that is observable.
+Error SchedContext::add(InstNode* node, const SchedUse* uses, uint32_t useCount, uint32_t latency) noexcept {
+  uint32_t index = _insts.size();
+  ASMJIT_PROPAGATE(_insts.append(_allocator, SchedInst { node, latency, 0, 0, 0, 0, 0 }));
+
+  for (uint32_t i = 0; i < useCount; i++) {
+    SchedResource& res = _resources[uses[i].resource];
+    uint32_t flags = uses[i].flags;
+
+    if (res.lastWrite == kSchedNone && res.reads.empty())
+      ASMJIT_PROPAGATE(_touched.append(_allocator, uses[i].resource));
+
+    bool afterLastWrite = res.lastWrite != kSchedNone && res.lastWrite != index;
+    if (afterLastWrite && isFlagResource(uses[i].resource)) {
+      if (flags & SchedUse::kRead) {
+        ASMJIT_PROPAGATE(orderPendingWrites(res));
+      }
+      else {
+        ASMJIT_PROPAGATE(res.pendingWrites.append(_allocator, res.lastWrite));
+        afterLastWrite = false;
+      }
+    }
+
+    if (afterLastWrite) {
+      uint32_t edgeLatency = (flags & SchedUse::kRead) ? _insts[res.lastWrite].latency : uint32_t(0);
+      ASMJIT_PROPAGATE(addEdge(res.lastWrite, index, edgeLatency));
+    }
+
+    if (flags & SchedUse::kWrite) {
+      for (uint32_t readIndex : res.reads)
+        if (readIndex != index)
+          ASMJIT_PROPAGATE(addEdge(readIndex, index, 0));
+    }
+  }
+
+  for (uint32_t i = 0; i < useCount; i++) {
+    SchedResource& res = _resources[uses[i].resource];
+    uint32_t flags = uses[i].flags;
+
+    if (flags & SchedUse::kWrite) {
+      res.lastWrite = index;
+      res.reads.clear();
+    }
+    else if (res.reads.empty() || res.reads.last() != index) {
+      ASMJIT_PROPAGATE(res.reads.append(_allocator, index));
+    }
+  }
+
+  return kErrorOk;
+}
+
+// Schedules the current region and relinks its nodes in the scheduled order.
+Error SchedContext::flush() noexcept {
+  uint32_t instCount = _insts.size();
+
+  for (uint32_t resource : _touched)
+    if (isFlagResource(resource))
+      ASMJIT_PROPAGATE(orderPendingWrites(_resources[resource]));
+  uint32_t edgeCount = _edges.size();
+
+  if (instCount > 1) {
+    // Group edges by their `from` instruction.
+    ASMJIT_PROPAGATE(_succs.resize(_allocator, edgeCount));
+
+    for (const SchedEdge& edge : _edges) {
+      _insts[edge.from].succCount++;
+      _insts[edge.to].predCount++;
+    }
+
+    uint32_t succIndex = 0;
+    for (SchedInst& inst : _insts) {
+      inst.succIndex = succIndex;
+      succIndex += inst.succCount;
+      inst.succCount = 0;
+    }
+
+    for (uint32_t i = 0; i < edgeCount; i++) {
+      SchedInst& from = _insts[_edges[i].from];
+      _succs[from.succIndex + from.succCount++] = i;
+    }
+
+    // Edges always go forward, so heights can be calculated in reverse order.
+    uint32_t i = instCount;
+    while (i != 0) {
+      SchedInst& inst = _insts[--i];
+      uint32_t height = inst.latency;
+
+      for (uint32_t j = 0; j < inst.succCount; j++) {
+        const SchedEdge& edge = _edges[_succs[inst.succIndex + j]];
+        height = Support::max(height, edge.latency + _insts[edge.to].height);
+      }
+
+      inst.height = height;
+    }
+
+    _ready.clear();
+    _order.clear();
+    ASMJIT_PROPAGATE(_order.reserve(_allocator, instCount));
+
+    for (i = 0; i < instCount; i++)
+      if (!_insts[i].predCount)
+        ASMJIT_PROPAGATE(_ready.append(_allocator, i));
+
+    // List scheduling of a single-issue machine. An instruction that can be
+    // issued in the current cycle is preferred, then the one with the longest
+    // path to the end of the region, and then the one that comes first.
+    uint32_t cycle = 0;
+    bool changed = false;
+
+    while (!_ready.empty()) {
+      uint32_t bestPos = 0;
+      uint32_t bestIndex = _ready[0];
+
+      for (uint32_t pos = 1; pos < _ready.size(); pos++) {
+        uint32_t index = _ready[pos];
+        const SchedInst& a = _insts[index];
+        const SchedInst& b = _insts[bestIndex];
+
+        bool aReady = a.readyCycle <= cycle;
+        bool bReady = b.readyCycle <= cycle;
+
+        bool better;
+        if (aReady != bReady)
+          better = aReady;
+        else if (!aReady && a.readyCycle != b.readyCycle)
+          better = a.readyCycle < b.readyCycle;
+        else if (a.height != b.height)
+          better = a.height > b.height;
+        else
+          better = index < bestIndex;
+
+        if (better) {
+          bestPos = pos;
+          bestIndex = index;
+        }
+      }
+
+      _ready[bestPos] = _ready.last();
+      _ready.pop();
+
+      SchedInst& best = _insts[bestIndex];
+      uint32_t issueCycle = Support::max(cycle, best.readyCycle);
+      cycle = issueCycle + 1;
+
+      for (uint32_t j = 0; j < best.succCount; j++) {
+        const SchedEdge& edge = _edges[_succs[best.succIndex + j]];
+        SchedInst& succ = _insts[edge.to];
+
+        succ.readyCycle = Support::max(succ.readyCycle, issueCycle + edge.latency);
+        if (--succ.predCount == 0)
+          ASMJIT_PROPAGATE(_ready.append(_allocator, edge.to));
+      }
+
+      changed |= bestIndex != _order.size();
+      _order.appendUnsafe(bestIndex);
+    }
+
+    ASMJIT_ASSERT(_order.size() == instCount);
+
+    if (changed) {
+      BaseNode* first = _insts[0].node;
+      BaseNode* last = _insts[instCount - 1].node;
+
+      BaseNode* prev = first->prev();
+      BaseNode* next = last->next();
+      ASMJIT_ASSERT(prev != nullptr || next != nullptr);
+
+      _cb->removeNodes(first, last);
+      for (uint32_t index : _order) {
+        BaseNode* node = _insts[index].node;
+        if (prev)
+          _cb->addAfter(node, prev);
+        else
+          _cb->addBefore(node, next);
+        prev = node;
+      }
+    }
+  }
+
+  for (uint32_t resource : _touched) {
+    _resources[resource].lastWrite = kSchedNone;
+    _resources[resource].reads.clear();
+  }
+
+  _insts.clear();
+  _edges.clear();
+  _touched.clear();
+  return kErrorOk;
+}
+
+// ============================================================================
+// [asmjit::SchedPass - Construction / Destruction]
+// ============================================================================
+
+SchedPass::SchedPass() noexcept
+  : Pass("SchedPass") {}
+SchedPass::~SchedPass() noexcept {}
+
+// ============================================================================
+// [asmjit::SchedPass - Run]
+// ============================================================================
+
+Error SchedPass::run(Zone* zone, Logger* logger) {
+  DebugUtils::unused(logger);
+
+  ZoneAllocator allocator(zone);
+  SchedContext ctx(&allocator, _cb);
+
+  SchedUse uses[SchedContext::kMaxUses];
+  BaseNode* node = _cb->firstNode();
+
+  while (node) {
+    // Scheduling the region can move `node`, but not the node that follows it.
+    BaseNode* next = node->next();
+    uint32_t useCount = kSchedNone;
+    uint32_t latency = 1;
+
+    if (node->type() == BaseNode::kNodeInst)
+      ASMJIT_PROPAGATE(ctx.analyze(node->as<InstNode>(), uses, &useCount, &latency));
+
+    if (useCount == kSchedNone) {
+      ASMJIT_PROPAGATE(ctx.flush());
+    }
+    else {
+      ASMJIT_PROPAGATE(ctx.add(node->as<InstNode>(), uses, useCount, latency));
+      if (ctx._insts.size() >= kMaxRegionSize)
+        ASMJIT_PROPAGATE(ctx.flush());
+    }
+
+    node = next;
+  }
+
+  return ctx.flush();
+}
+
+ASMJIT_END_NAMESPACE
+
+#endif // !ASMJIT_NO_BUILDER && !ASMJIT_NO_INTROSPECTION
@@ -0,0 +1,95 @@
+// AsmJit - Machine code generation for C++
+//
+//  * Official AsmJit Home Page: https://asmjit.com
+//  * Official Github Repository: https://github.com/asmjit/asmjit
+//
+// Copyright (c) 2008-2020 The AsmJit Authors
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#ifndef ASMJIT_CORE_SCHEDPASS_H_INCLUDED
+#define ASMJIT_CORE_SCHEDPASS_H_INCLUDED
+
+#include "../core/api-config.h"
+#if !defined(ASMJIT_NO_BUILDER) && !defined(ASMJIT_NO_INTROSPECTION)
+
+#include "../core/builder.h"
+#include "../core/inst.h"
+
+ASMJIT_BEGIN_NAMESPACE
+
+//! \addtogroup asmjit_builder
+//! \{
+
+// ============================================================================
+// [asmjit::SchedPass]
+// ============================================================================
+
+//! Instruction scheduling pass.
+//!
+//! Reorders independent instructions within each sequence of \ref InstNode
+//! nodes that is not interrupted by labels, control flow, or any other node,
+//! so that long dependency chains are interleaved instead of being emitted
+//! back-to-back. Dependencies are calculated from \ref InstAPI::queryRWInfo()
+//! and \ref InstAPI::querySchedInfo(), which provides barriers, memory access
+//! and approximate latencies of each architecture. Instructions are then list
+//! scheduled, preferring the instruction that has the longest latency path to
+//! the end of its sequence.
+//!
+//! The pass works with physical registers, instructions that still use virtual
+//! registers are never moved. When used with \ref BaseCompiler the pass must run
+//! after the register allocator, which is guaranteed when it's added after the
+//! compiler has been attached to \ref CodeHolder:
+//!
+//! ```
+//! x86::Compiler cc(&code);
+//! cc.addPassT<SchedPass>();
+//! ```
+class ASMJIT_VIRTAPI SchedPass : public Pass {
+public:
+  ASMJIT_NONCOPYABLE(SchedPass)
+  typedef Pass Base;
+
+  //! Scheduling limits.
+  enum Limits : uint32_t {
+    //! Maximum number of instructions scheduled together, longer sequences are
+    //! split as the scheduler is quadratic in the number of instructions.
+    kMaxRegionSize = 256
+  };
+
+  //! \name Construction & Destruction
+  //! \{
+
+  ASMJIT_API SchedPass() noexcept;
+  ASMJIT_API virtual ~SchedPass() noexcept;
+
+  //! \}
+
+  //! \name Pass Interface
+  //! \{
+
+  ASMJIT_API Error run(Zone* zone, Logger* logger) override;
+
+  //! \}
+};
+
+//! \}
+
+ASMJIT_END_NAMESPACE
+
+#endif // !ASMJIT_NO_BUILDER && !ASMJIT_NO_INTROSPECTION
+#endif // ASMJIT_CORE_SCHEDPASS_H_INCLUDED
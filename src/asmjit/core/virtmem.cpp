@@ -40,6 +40,11 @@
   // Linux has a `memfd_create` syscall that we would like to use, if available.
   #if defined(__linux__)
     #include <sys/syscall.h>
+
+    // Older headers don't define `MFD_HUGETLB`.
+    #ifndef MFD_HUGETLB
+      #define MFD_HUGETLB 0x0004u
+    #endif
   #endif
 
   // Apple recently introduced MAP_JIT flag, which we want to use.
@@ -139,8 +144,20 @@ Error VirtMem::alloc(void** p, size_t size, uint32_t flags) noexcept {
   if (size == 0)
     return DebugUtils::errored(kErrorInvalidArgument);
 
+  DWORD allocationType = MEM_COMMIT | MEM_RESERVE;
+  if (flags & VirtMem::kMMapLargePages) {
+    size_t lpSize = VirtMem::largePageSize();
+    if (!lpSize)
+      return DebugUtils::errored(kErrorFeatureNotEnabled);
+
+    if (size % lpSize != 0)
+      return DebugUtils::errored(kErrorInvalidArgument);
+
+    allocationType |= MEM_LARGE_PAGES;
+  }
+
   DWORD protectFlags = VirtMem_winProtectFlagsFromFlags(flags);
-  void* result = ::VirtualAlloc(nullptr, size, MEM_COMMIT | MEM_RESERVE, protectFlags);
+  void* result = ::VirtualAlloc(nullptr, size, allocationType, protectFlags);
 
   if (!result)
     return DebugUtils::errored(kErrorOutOfMemory);
@@ -173,6 +190,10 @@ Error VirtMem::allocDualMapping(DualMapping* dm, size_t size, uint32_t flags) no
   if (size == 0)
     return DebugUtils::errored(kErrorInvalidArgument);
 
+  // Large pages are not supported by file mappings.
+  if (flags & VirtMem::kMMapLargePages)
+    return DebugUtils::errored(kErrorFeatureNotEnabled);
+
   ScopedHandle handle;
   handle.value = ::CreateFileMappingW(
     INVALID_HANDLE_VALUE,
@@ -220,6 +241,10 @@ Error VirtMem::releaseDualMapping(DualMapping* dm, size_t size) noexcept {
   dm->rw = nullptr;
   return kErrorOk;
 }
+
+static size_t VirtMem_detectLargePageSize() noexcept {
+  return ::GetLargePageMinimum();
+}
 #endif
 
 // ============================================================================
@@ -287,11 +312,13 @@ public:
 
   int _fd;
   FileType _fileType;
+  bool _hugeTlb;
   StringTmp<128> _tmpName;
 
   ASMJIT_INLINE AnonymousMemory() noexcept
     : _fd(-1),
       _fileType(kFileTypeNone),
+      _hugeTlb(false),
       _tmpName() {}
 
   ASMJIT_INLINE ~AnonymousMemory() noexcept {
@@ -300,8 +327,12 @@ public:
   }
 
   ASMJIT_INLINE int fd() const noexcept { return _fd; }
+  //! Tests whether the memory is backed by explicit huge pages (hugetlbfs).
+  ASMJIT_INLINE bool isHugeTlb() const noexcept { return _hugeTlb; }
+
+  Error open(bool preferTmpOverDevShm, bool preferHugeTlb = false) noexcept {
+    _hugeTlb = false;
 
-  Error open(bool preferTmpOverDevShm) noexcept {
 #if defined(__linux__) && defined(__NR_memfd_create)
     // Linux specific 'memfd_create' - if the syscall returns `ENOSYS` it means
     // it's not available and we will never call it again (would be pointless).
@@ -310,6 +341,15 @@ public:
     // available and we must use `shm_open()` and `shm_unlink()`.
     static volatile uint32_t memfd_create_not_supported;
 
+    if (!memfd_create_not_supported && preferHugeTlb) {
+      // Fails if the system has no huge pages reserved, use a regular memfd then.
+      _fd = (int)syscall(__NR_memfd_create, "vmem", MFD_HUGETLB);
+      if (_fd >= 0) {
+        _hugeTlb = true;
+        return kErrorOk;
+      }
+    }
+
     if (!memfd_create_not_supported) {
       _fd = (int)syscall(__NR_memfd_create, "vmem", 0);
       if (ASMJIT_LIKELY(_fd >= 0))
@@ -325,7 +365,7 @@ public:
 
 #if defined(SHM_ANON)
     // Originally FreeBSD extension, apparently works in other BSDs too.
-    DebugUtils::unused(preferTmpOverDevShm);
+    DebugUtils::unused(preferTmpOverDevShm, preferHugeTlb);
     _fd = ::shm_open(SHM_ANON, O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
 
     if (ASMJIT_LIKELY(_fd >= 0))
@@ -333,6 +373,8 @@ public:
     else
       return DebugUtils::errored(VirtMem_asmjitErrorFromErrno(errno));
 #else
+    DebugUtils::unused(preferHugeTlb);
+
     // POSIX API. We have to generate somehow a unique name. This is nothing
     // cryptographic, just using a bit from the stack address to always have
     // a different base for different threads (as threads have their own stack)
@@ -550,6 +592,110 @@ static Error VirtMem_getShmStrategy(uint32_t* strategyOut) noexcept {
 #endif
 }
 
+#if defined(__linux__)
+static size_t VirtMem_readSizeFromFile(const char* fileName, const char* key) noexcept {
+  int fd = ::open(fileName, O_RDONLY);
+  if (fd < 0)
+    return 0;
+
+  char buf[4096];
+  ssize_t n = ::read(fd, buf, sizeof(buf) - 1);
+  ::close(fd);
+
+  if (n <= 0)
+    return 0;
+  buf[n] = '\0';
+
+  const char* p = buf;
+  if (key) {
+    p = strstr(buf, key);
+    if (!p)
+      return 0;
+    p += strlen(key);
+  }
+
+  while (*p == ' ' || *p == '\t')
+    p++;
+
+  size_t value = 0;
+  while (*p >= '0' && *p <= '9')
+    value = value * 10u + size_t(*p++ - '0');
+
+  // '/proc/meminfo' reports sizes in kilobytes.
+  if (key && strncmp(p, " kB", 3) == 0)
+    value *= 1024u;
+
+  return value;
+}
+
+static size_t VirtMem_detectLargePageSize() noexcept {
+  // Prefer the size used by transparent huge pages and fall back to the default size of explicit huge pages.
+  size_t size = VirtMem_readSizeFromFile("/sys/kernel/mm/transparent_hugepage/hpage_pmd_size", nullptr);
+  if (!size)
+    size = VirtMem_readSizeFromFile("/proc/meminfo", "Hugepagesize:");
+
+  if (!Support::isPowerOf2(size))
+    return 0;
+  return size;
+}
+
+// Maps `size` bytes aligned to `alignment` by mapping a larger reservation and trimming it.
+static void* VirtMem_mmapAligned(size_t size, size_t alignment, int protection, int mmFlags, int fd) noexcept {
+  size_t reservedSize = size + alignment;
+  uint8_t* reserved = static_cast<uint8_t*>(mmap(nullptr, reservedSize, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0));
+
+  if (reserved == MAP_FAILED)
+    return MAP_FAILED;
+
+  uint8_t* aligned = Support::alignUp(reserved, alignment);
+  void* ptr = mmap(aligned, size, protection, mmFlags | MAP_FIXED, fd, 0);
+
+  if (ptr == MAP_FAILED) {
+    int e = errno;
+    munmap(reserved, reservedSize);
+    errno = e;
+    return MAP_FAILED;
+  }
+
+  size_t headSize = size_t(aligned - reserved);
+  size_t tailSize = reservedSize - headSize - size;
+
+  if (headSize)
+    munmap(reserved, headSize);
+
+  if (tailSize)
+    munmap(aligned + size, tailSize);
+
+  return ptr;
+}
+
+// Maps `size` bytes by using transparent huge pages, which requires the mapping to be aligned.
+static void* VirtMem_mmapTransparentLargePages(size_t size, size_t lpSize, int protection, int mmFlags, int fd) noexcept {
+#if defined(MADV_HUGEPAGE)
+  void* ptr = VirtMem_mmapAligned(size, lpSize, protection, mmFlags, fd);
+  if (ptr == MAP_FAILED)
+    return MAP_FAILED;
+
+  if (madvise(ptr, size, MADV_HUGEPAGE) != 0) {
+    int e = errno;
+    munmap(ptr, size);
+    errno = e;
+    return MAP_FAILED;
+  }
+
+  return ptr;
+#else
+  DebugUtils::unused(size, lpSize, protection, mmFlags, fd);
+  errno = ENOTSUP;
+  return MAP_FAILED;
+#endif
+}
+#else
+static size_t VirtMem_detectLargePageSize() noexcept {
+  return 0;
+}
+#endif
+
 Error VirtMem::alloc(void** p, size_t size, uint32_t flags) noexcept {
   *p = nullptr;
   if (size == 0)
@@ -558,6 +704,33 @@ Error VirtMem::alloc(void** p, size_t size, uint32_t flags) noexcept {
   int protection = VirtMem_mmProtFromFlags(flags) | VirtMem_mmMaxProtFromFlags(flags);
   int mmFlags = MAP_PRIVATE | MAP_ANONYMOUS | VirtMem_mmMapJitFromFlags(flags);
 
+  if (flags & kMMapLargePages) {
+#if defined(__linux__)
+    size_t lpSize = largePageSize();
+    if (!lpSize)
+      return DebugUtils::errored(kErrorFeatureNotEnabled);
+
+    if (size % lpSize != 0)
+      return DebugUtils::errored(kErrorInvalidArgument);
+
+    void* ptr = MAP_FAILED;
+#if defined(MAP_HUGETLB)
+    ptr = mmap(nullptr, size, protection, mmFlags | MAP_HUGETLB, -1, 0);
+#endif
+
+    if (ptr == MAP_FAILED)
+      ptr = VirtMem_mmapTransparentLargePages(size, lpSize, protection, mmFlags, -1);
+
+    if (ptr == MAP_FAILED)
+      return DebugUtils::errored(VirtMem_asmjitErrorFromErrno(errno));
+
+    *p = ptr;
+    return kErrorOk;
+#else
+    return DebugUtils::errored(kErrorFeatureNotEnabled);
+#endif
+  }
+
   void* ptr = mmap(nullptr, size, protection, mmFlags, -1, 0);
   if (ptr == MAP_FAILED)
     return DebugUtils::errored(kErrorOutOfMemory);
@@ -596,8 +769,22 @@ Error VirtMem::allocDualMapping(DualMapping* dm, size_t size, uint32_t flags) no
     preferTmpOverDevShm = (strategy == kShmStrategyTmpDir);
   }
 
+  size_t lpSize = 0;
+  if (flags & kMMapLargePages) {
+#if defined(__linux__)
+    lpSize = largePageSize();
+    if (!lpSize)
+      return DebugUtils::errored(kErrorFeatureNotEnabled);
+
+    if (size % lpSize != 0)
+      return DebugUtils::errored(kErrorInvalidArgument);
+#else
+    return DebugUtils::errored(kErrorFeatureNotEnabled);
+#endif
+  }
+
   AnonymousMemory anonMem;
-  ASMJIT_PROPAGATE(anonMem.open(preferTmpOverDevShm));
+  ASMJIT_PROPAGATE(anonMem.open(preferTmpOverDevShm, lpSize != 0));
   ASMJIT_PROPAGATE(anonMem.allocate(size));
 
   void* ptr[2];
@@ -605,12 +792,30 @@ Error VirtMem::allocDualMapping(DualMapping* dm, size_t size, uint32_t flags) no
     uint32_t accessFlags = flags & ~VirtMem_dualMappingFilter[i];
     int protection = VirtMem_mmProtFromFlags(accessFlags) | VirtMem_mmMaxProtFromFlags(accessFlags);
 
-    ptr[i] = mmap(nullptr, size, protection, MAP_SHARED, anonMem.fd(), 0);
+#if defined(__linux__)
+    if (lpSize && !anonMem.isHugeTlb())
+      ptr[i] = VirtMem_mmapTransparentLargePages(size, lpSize, protection, MAP_SHARED, anonMem.fd());
+    else
+#endif
+      ptr[i] = mmap(nullptr, size, protection, MAP_SHARED, anonMem.fd(), 0);
+
     if (ptr[i] == MAP_FAILED) {
       // Get the error now before `munmap()` has a chance to clobber it.
       int e = errno;
       if (i == 1)
         munmap(ptr[0], size);
+
+      // Explicit huge pages fail to map if the system doesn't have enough of
+      // them reserved, try transparent huge pages instead.
+      if (i == 0 && anonMem.isHugeTlb()) {
+        anonMem.close();
+        ASMJIT_PROPAGATE(anonMem.open(preferTmpOverDevShm, false));
+        ASMJIT_PROPAGATE(anonMem.allocate(size));
+
+        i--;
+        continue;
+      }
+
       return DebugUtils::errored(VirtMem_asmjitErrorFromErrno(e));
     }
   }
@@ -653,6 +858,18 @@ VirtMem::Info VirtMem::info() noexcept {
   return vmInfo;
 }
 
+size_t VirtMem::largePageSize() noexcept {
+  static std::atomic<size_t> largePageSize;
+  static std::atomic<uint32_t> largePageSizeInitialized;
+
+  if (!largePageSizeInitialized.load()) {
+    largePageSize.store(VirtMem_detectLargePageSize());
+    largePageSizeInitialized.store(1u);
+  }
+
+  return largePageSize.load();
+}
+
 ASMJIT_END_NAMESPACE
 
 #endif
@@ -84,6 +84,18 @@ enum Flags : uint32_t {
   //! A combination of \ref kMMapMaxAccessRead, \ref kMMapMaxAccessWrite, \ref kMMapMaxAccessExecute.
   kMMapMaxAccessRWX = kMMapMaxAccessRead | kMMapMaxAccessWrite | kMMapMaxAccessExecute,
 
+  //! Map the memory by using large pages (also known as huge pages), which
+  //! reduces TLB misses when executing a lot of code.
+  //!
+  //! The size of the mapping must be a multiple of \ref VirtMem::largePageSize().
+  //! On Linux explicit huge pages (`MAP_HUGETLB` or `MFD_HUGETLB`) are tried
+  //! first and transparent huge pages (a mapping aligned to the large page size
+  //! advised by `MADV_HUGEPAGE`) are used when no explicit huge pages are
+  //! available. On Windows `MEM_LARGE_PAGES` is used, which requires the
+  //! process to have `SeLockMemoryPrivilege`. The allocation fails if large
+  //! pages cannot be used, it's up to the caller to retry without this flag.
+  kMMapLargePages = 0x00000100u,
+
   //! Not an access flag, only used by `allocDualMapping()` to override the
   //! default allocation strategy to always use a 'tmp' directory instead of
   //! "/dev/shm" (on POSIX platforms). Please note that this flag will be
@@ -116,6 +128,10 @@ struct DualMapping {
 //! Returns virtual memory information, see `VirtMem::Info` for more details.
 ASMJIT_API Info info() noexcept;
 
+//! Returns the size of a large page or zero if the host doesn't support large
+//! pages, see \ref kMMapLargePages.
+ASMJIT_API size_t largePageSize() noexcept;
+
 //! Allocates virtual memory by either using `mmap()` (POSIX) or `VirtualAlloc()`
 //! (Windows).
 //!
@@ -35,6 +35,167 @@ ASMJIT_BEGIN_NAMESPACE
 // Should be allocated in read-only memory and should never be modified.
 const Zone::Block Zone::_zeroBlock = { nullptr, nullptr, 0 };
 
+// ============================================================================
+// [asmjit::ZoneBlockPool - State]
+// ============================================================================
+
+//! State of a thread-local block pool.
+//!
+//! The state is trivial so it's zero initialized and never destroyed, which
+//! means that it's safe to use it even after the thread-local destructors ran
+//! (for example when a global `Zone` is destroyed after the main thread ended).
+//! In that case the pool is marked as destroyed and blocks are freed directly.
+struct ZoneBlockPoolState {
+  //! Single-linked list of cached blocks (linked by `Zone::Block::next`).
+  Zone::Block* blocks;
+  //! Maximum number of blocks to keep (only used if `hasLimits` is true).
+  size_t maxBlockCount;
+  //! Maximum number of bytes to keep (only used if `hasLimits` is true).
+  size_t maxCachedSize;
+  //! Statistics.
+  ZoneBlockPool::Statistics stats;
+  //! Pool was disabled by `ZoneBlockPool::setEnabled(false)`.
+  bool disabled;
+  //! Pool was destroyed, because the thread is terminating.
+  bool destroyed;
+  //! Custom limits were set by `ZoneBlockPool::setLimits()`.
+  bool hasLimits;
+  //! Thread-local reaper has been registered.
+  bool reaperRegistered;
+
+  inline bool isActive() const noexcept { return !disabled && !destroyed; }
+  inline size_t blockLimit() const noexcept { return hasLimits ? maxBlockCount : size_t(ZoneBlockPool::kDefaultMaxBlockCount); }
+  inline size_t sizeLimit() const noexcept { return hasLimits ? maxCachedSize : size_t(ZoneBlockPool::kDefaultMaxCachedSize); }
+};
+
+static thread_local ZoneBlockPoolState ZoneBlockPool_state;
+
+static void ZoneBlockPool_trim(ZoneBlockPoolState& state, size_t maxBlockCount, size_t maxCachedSize) noexcept {
+  while (state.blocks && (state.stats._blockCount > maxBlockCount || state.stats._cachedSize > maxCachedSize)) {
+    Zone::Block* block = state.blocks;
+    state.blocks = block->next;
+    state.stats._blockCount--;
+    state.stats._cachedSize -= block->size;
+    ::free(block);
+  }
+}
+
+//! Releases all blocks cached by the thread when the thread terminates.
+class ZoneBlockPoolReaper {
+public:
+  bool _registered;
+
+  inline ~ZoneBlockPoolReaper() noexcept {
+    ZoneBlockPoolState& state = ZoneBlockPool_state;
+    ZoneBlockPool_trim(state, 0, 0);
+    state.destroyed = true;
+  }
+};
+
+static thread_local ZoneBlockPoolReaper ZoneBlockPool_reaper;
+
+// Returns a cached block that can hold at least `size` bytes or null if there
+// is no such block. Blocks that are more than twice as large are not used so
+// small zones don't hold large blocks that other zones could use.
+static Zone::Block* ZoneBlockPool_acquire(size_t size) noexcept {
+  ZoneBlockPoolState& state = ZoneBlockPool_state;
+  if (!state.isActive())
+    return nullptr;
+
+  Zone::Block** bestLink = nullptr;
+  Zone::Block** link = &state.blocks;
+
+  while (*link) {
+    Zone::Block* block = *link;
+    if (block->size >= size && block->size - size <= size) {
+      if (!bestLink || block->size < (*bestLink)->size) {
+        bestLink = link;
+        if (block->size == size)
+          break;
+      }
+    }
+    link = &block->next;
+  }
+
+  if (!bestLink) {
+    state.stats._missCount++;
+    return nullptr;
+  }
+
+  Zone::Block* block = *bestLink;
+  *bestLink = block->next;
+
+  state.stats._hitCount++;
+  state.stats._blockCount--;
+  state.stats._cachedSize -= block->size;
+  return block;
+}
+
+// Returns `block` to the pool or frees it if the pool is full or inactive.
+static void ZoneBlockPool_release(Zone::Block* block) noexcept {
+  ZoneBlockPoolState& state = ZoneBlockPool_state;
+  if (!state.isActive()) {
+    ::free(block);
+    return;
+  }
+
+  if (state.stats._blockCount >= state.blockLimit() || block->size > state.sizeLimit() - state.stats._cachedSize) {
+    state.stats._overflowCount++;
+    ::free(block);
+    return;
+  }
+
+  // The reaper has a non-trivial destructor, the first access registers it.
+  if (ASMJIT_UNLIKELY(!state.reaperRegistered)) {
+    ZoneBlockPool_reaper._registered = true;
+    state.reaperRegistered = true;
+  }
+
+  block->prev = nullptr;
+  block->next = state.blocks;
+  state.blocks = block;
+  state.stats._blockCount++;
+  state.stats._cachedSize += block->size;
+}
+
+// ============================================================================
+// [asmjit::ZoneBlockPool - API]
+// ============================================================================
+
+bool ZoneBlockPool::isEnabled() noexcept {
+  return !ZoneBlockPool_state.disabled;
+}
+
+void ZoneBlockPool::setEnabled(bool enabled) noexcept {
+  ZoneBlockPoolState& state = ZoneBlockPool_state;
+  state.disabled = !enabled;
+  if (!enabled)
+    ZoneBlockPool_trim(state, 0, 0);
+}
+
+void ZoneBlockPool::setLimits(size_t maxBlockCount, size_t maxCachedSize) noexcept {
+  ZoneBlockPoolState& state = ZoneBlockPool_state;
+  state.maxBlockCount = maxBlockCount;
+  state.maxCachedSize = maxCachedSize;
+  state.hasLimits = true;
+  ZoneBlockPool_trim(state, maxBlockCount, maxCachedSize);
+}
+
+ZoneBlockPool::Statistics ZoneBlockPool::statistics() noexcept {
+  return ZoneBlockPool_state.stats;
+}
+
+void ZoneBlockPool::resetStatistics() noexcept {
+  ZoneBlockPoolState& state = ZoneBlockPool_state;
+  state.stats._hitCount = 0;
+  state.stats._missCount = 0;
+  state.stats._overflowCount = 0;
+}
+
+void ZoneBlockPool::clear() noexcept {
+  ZoneBlockPool_trim(ZoneBlockPool_state, 0, 0);
+}
+
 // ============================================================================
 // [asmjit::Zone - Init / Reset]
 // ============================================================================
@@ -95,14 +256,14 @@ void Zone::reset(uint32_t resetPolicy) noexcept {
         break;
       }
 
-      ::free(cur);
+      ZoneBlockPool_release(cur);
       cur = prev;
     } while (cur);
 
     cur = next;
     while (cur) {
       next = cur->next;
-      ::free(cur);
+      ZoneBlockPool_release(cur);
       cur = next;
     }
   }
@@ -151,10 +312,17 @@ void* Zone::_alloc(size_t size, size_t alignment) noexcept {
   // new block size, and we also add `kBlockOverhead` to the allocator as it includes
   // members of `Zone::Block` structure.
   newSize += blockAlignmentOverhead;
-  Block* newBlock = static_cast<Block*>(::malloc(newSize + kBlockSize));
+  Block* newBlock = ZoneBlockPool_acquire(newSize);
 
-  if (ASMJIT_UNLIKELY(!newBlock))
-    return nullptr;
+  if (newBlock) {
+    // Blocks provided by the pool can be larger than requested.
+    newSize = newBlock->size;
+  }
+  else {
+    newBlock = static_cast<Block*>(::malloc(newSize + kBlockSize));
+    if (ASMJIT_UNLIKELY(!newBlock))
+      return nullptr;
+  }
 
   // Align the pointer to `minimumAlignment` and adjust the size of this block
   // accordingly. It's the same as using `minimumAlignment - Support::alignUpDiff()`,
@@ -246,18 +414,42 @@ static bool ZoneAllocator_hasDynamicBlock(ZoneAllocator* self, ZoneAllocator::Dy
 // [asmjit::ZoneAllocator - Init / Reset]
 // ============================================================================
 
-void ZoneAllocator::reset(Zone* zone) noexcept {
-  // Free dynamic blocks.
-  DynamicBlock* block = _dynamicBlocks;
+void ZoneAllocator::reset(Zone* zone, uint32_t resetPolicy) noexcept {
+  // Blocks kept by the previous soft reset that were not reused are freed in
+  // any case, so the kept blocks never exceed what was used since.
+  DynamicBlock* block = _unusedDynamicBlocks;
   while (block) {
     DynamicBlock* next = block->next;
     ::free(block);
     block = next;
   }
 
+  DynamicBlock* unused = nullptr;
+  size_t dynamicAllocCount = 0;
+
+  // Free dynamic blocks, or keep them for reuse if this is a soft reset.
+  block = _dynamicBlocks;
+  while (block) {
+    DynamicBlock* next = block->next;
+    if (resetPolicy == Globals::kResetSoft) {
+      block->prev = nullptr;
+      block->next = unused;
+      unused = block;
+    }
+    else {
+      ::free(block);
+    }
+    block = next;
+  }
+
+  if (resetPolicy == Globals::kResetSoft)
+    dynamicAllocCount = _dynamicAllocCount;
+
   // Zero the entire class and initialize to the given `zone`.
   memset(this, 0, sizeof(*this));
   _zone = zone;
+  _unusedDynamicBlocks = unused;
+  _dynamicAllocCount = dynamicAllocCount;
 }
 
 // ============================================================================
@@ -321,10 +513,28 @@ void* ZoneAllocator::_alloc(size_t size, size_t& allocatedSize) noexcept {
     if (ASMJIT_UNLIKELY(kBlockOverhead >= SIZE_MAX - size))
       return nullptr;
 
-    void* p = ::malloc(size + kBlockOverhead);
-    if (ASMJIT_UNLIKELY(!p)) {
-      allocatedSize = 0;
-      return nullptr;
+    // Reuse the smallest block kept by a soft reset that is large enough.
+    DynamicBlock** pBest = nullptr;
+    for (DynamicBlock** pCur = &_unusedDynamicBlocks; *pCur; pCur = &(*pCur)->next) {
+      size_t curSize = (*pCur)->size;
+      if (curSize >= size && (!pBest || curSize < (*pBest)->size))
+        pBest = pCur;
+    }
+
+    void* p;
+    if (pBest) {
+      p = *pBest;
+      *pBest = (*pBest)->next;
+    }
+    else {
+      p = ::malloc(size + kBlockOverhead);
+      if (ASMJIT_UNLIKELY(!p)) {
+        allocatedSize = 0;
+        return nullptr;
+      }
+
+      static_cast<DynamicBlock*>(p)->size = size;
+      _dynamicAllocCount++;
     }
 
     // Link as first in `_dynamicBlocks` double-linked list.
@@ -343,7 +553,7 @@ void* ZoneAllocator::_alloc(size_t size, size_t& allocatedSize) noexcept {
     p = Support::alignUp(static_cast<uint8_t*>(p) + sizeof(DynamicBlock) + sizeof(DynamicBlock*), kBlockAlignment);
     reinterpret_cast<DynamicBlock**>(p)[-1] = block;
 
-    allocatedSize = size;
+    allocatedSize = block->size;
     return p;
   }
 }
@@ -379,4 +589,70 @@ void ZoneAllocator::_releaseDynamic(void* p, size_t size) noexcept {
   ::free(block);
 }
 
+// ============================================================================
+// [asmjit::ZoneBlockPool - Unit]
+// ============================================================================
+
+#if defined(ASMJIT_TEST)
+UNIT(zone_block_pool) {
+  ZoneBlockPool::setEnabled(true);
+  ZoneBlockPool::clear();
+  ZoneBlockPool::resetStatistics();
+
+  INFO("Verifying that blocks of a destroyed zone are pooled");
+  {
+    Zone zone(4096);
+    EXPECT(zone.alloc(100) != nullptr);
+    EXPECT(zone.alloc(5000) != nullptr);
+  }
+
+  ZoneBlockPool::Statistics stats = ZoneBlockPool::statistics();
+  EXPECT(stats.blockCount() == 2);
+  EXPECT(stats.missCount() == 2);
+  EXPECT(stats.hitCount() == 0);
+
+  INFO("Verifying that a new zone reuses pooled blocks");
+  {
+    Zone zone(4096);
+    EXPECT(zone.alloc(100) != nullptr);
+    EXPECT(zone.alloc(4000) != nullptr);
+
+    // A request that is much smaller than a pooled block must not use it.
+    Zone small(64);
+    EXPECT(small.alloc(32) != nullptr);
+  }
+
+  stats = ZoneBlockPool::statistics();
+  EXPECT(stats.hitCount() == 2);
+  EXPECT(stats.missCount() == 3);
+  EXPECT(stats.blockCount() == 3);
+
+  INFO("Verifying that pool limits are respected");
+  ZoneBlockPool::setLimits(1, ZoneBlockPool::kDefaultMaxCachedSize);
+  EXPECT(ZoneBlockPool::statistics().blockCount() == 1);
+  {
+    Zone zone(1024);
+    for (uint32_t i = 0; i < 8; i++)
+      EXPECT(zone.alloc(1000) != nullptr);
+  }
+  stats = ZoneBlockPool::statistics();
+  EXPECT(stats.blockCount() == 1);
+  EXPECT(stats.overflowCount() > 0);
+
+  INFO("Verifying that disabling the pool releases all blocks");
+  ZoneBlockPool::setEnabled(false);
+  EXPECT(!ZoneBlockPool::isEnabled());
+  EXPECT(ZoneBlockPool::statistics().blockCount() == 0);
+  {
+    Zone zone(1024);
+    EXPECT(zone.alloc(100) != nullptr);
+  }
+  EXPECT(ZoneBlockPool::statistics().blockCount() == 0);
+
+  ZoneBlockPool::setLimits(ZoneBlockPool::kDefaultMaxBlockCount, ZoneBlockPool::kDefaultMaxCachedSize);
+  ZoneBlockPool::setEnabled(true);
+  ZoneBlockPool::resetStatistics();
+}
+#endif
+
 ASMJIT_END_NAMESPACE
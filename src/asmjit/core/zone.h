@@ -379,6 +379,83 @@ public:
   //! \}
 };
 
+// ============================================================================
+// [asmjit::ZoneBlockPool]
+// ============================================================================
+
+//! Thread-local pool of blocks released by \ref Zone.
+//!
+//! When a `Zone` is hard reset (or destroyed) its blocks are returned to a
+//! bounded pool owned by the calling thread instead of being released by
+//! `free()`, and `Zone` takes blocks from this pool before calling `malloc()`.
+//! This makes the creation and destruction of short-lived objects that use
+//! `Zone`, like \ref CodeHolder, much cheaper as the same blocks are recycled
+//! across their lifetimes. Blocks kept by the pool are released when the thread
+//! terminates or when \ref ZoneBlockPool::clear() is called.
+//!
+//! \note All functions operate on the pool of the calling thread.
+class ZoneBlockPool {
+public:
+  //! Default limits of each thread-local pool.
+  enum Limits : size_t {
+    //! Default maximum number of blocks a pool keeps.
+    kDefaultMaxBlockCount = 32,
+    //! Default maximum number of bytes a pool keeps (sum of all block sizes).
+    kDefaultMaxCachedSize = 1024 * 1024
+  };
+
+  //! Statistics of a thread-local pool.
+  struct Statistics {
+    //! Number of blocks currently kept by the pool.
+    size_t _blockCount;
+    //! Number of bytes currently kept by the pool.
+    size_t _cachedSize;
+    //! Number of block allocations served by the pool.
+    size_t _hitCount;
+    //! Number of block allocations that had to call `malloc()`.
+    size_t _missCount;
+    //! Number of released blocks that were freed because the pool was full.
+    size_t _overflowCount;
+
+    inline void reset() noexcept {
+      _blockCount = 0;
+      _cachedSize = 0;
+      _hitCount = 0;
+      _missCount = 0;
+      _overflowCount = 0;
+    }
+
+    //! Returns the number of blocks currently kept by the pool.
+    inline size_t blockCount() const noexcept { return _blockCount; }
+    //! Returns the number of bytes currently kept by the pool.
+    inline size_t cachedSize() const noexcept { return _cachedSize; }
+    //! Returns the number of block allocations served by the pool.
+    inline size_t hitCount() const noexcept { return _hitCount; }
+    //! Returns the number of block allocations that had to call `malloc()`.
+    inline size_t missCount() const noexcept { return _missCount; }
+    //! Returns the number of released blocks that were freed because the pool was full.
+    inline size_t overflowCount() const noexcept { return _overflowCount; }
+  };
+
+  //! Tests whether the pool of the calling thread is enabled (enabled by default).
+  static ASMJIT_API bool isEnabled() noexcept;
+  //! Enables or disables the pool of the calling thread. Disabling the pool also
+  //! releases all blocks it keeps.
+  static ASMJIT_API void setEnabled(bool enabled) noexcept;
+
+  //! Sets limits of the pool of the calling thread. Blocks that would exceed
+  //! the new limits are released immediately.
+  static ASMJIT_API void setLimits(size_t maxBlockCount, size_t maxCachedSize) noexcept;
+
+  //! Returns statistics of the pool of the calling thread.
+  static ASMJIT_API Statistics statistics() noexcept;
+  //! Resets hit, miss, and overflow counters of the pool of the calling thread.
+  static ASMJIT_API void resetStatistics() noexcept;
+
+  //! Releases all blocks kept by the pool of the calling thread.
+  static ASMJIT_API void clear() noexcept;
+};
+
 // ============================================================================
 // [b2d::ZoneTmp]
 // ============================================================================
@@ -458,6 +535,8 @@ public:
   struct DynamicBlock {
     DynamicBlock* prev;
     DynamicBlock* next;
+    //! Usable size of the block.
+    size_t size;
   };
 
   //! \endcond
@@ -468,6 +547,10 @@ public:
   Slot* _slots[kLoCount + kHiCount];
   //! Dynamic blocks for larger allocations (no slots).
   DynamicBlock* _dynamicBlocks;
+  //! Dynamic blocks kept by a soft reset, reused before calling `malloc()`.
+  DynamicBlock* _unusedDynamicBlocks;
+  //! Number of dynamic blocks allocated by `malloc()` since the last hard reset.
+  size_t _dynamicAllocCount;
 
   //! \name Construction & Destruction
   //! \{
@@ -499,7 +582,12 @@ public:
   //! Resets this `ZoneAllocator` and also forget about the current `Zone` which
   //! is attached (if any). Reset optionally attaches a new `zone` passed, or
   //! keeps the `ZoneAllocator` in an uninitialized state, if `zone` is null.
-  ASMJIT_API void reset(Zone* zone = nullptr) noexcept;
+  //!
+  //! A soft reset (see \ref Globals::ResetPolicy) keeps dynamic blocks that
+  //! were in use and reuses them for large allocations that follow, so the
+  //! same work repeated after a soft reset doesn't call `malloc()` again.
+  //! Blocks kept by a previous soft reset that were not reused are freed.
+  ASMJIT_API void reset(Zone* zone = nullptr, uint32_t resetPolicy = Globals::kResetHard) noexcept;
 
   //! \}
 
@@ -510,6 +598,10 @@ public:
   //! is not initialized.
   inline Zone* zone() const noexcept { return _zone; }
 
+  //! Returns the number of dynamic blocks (allocations that don't fit into
+  //! slots) allocated by `malloc()` since the last hard reset.
+  inline size_t dynamicAllocCount() const noexcept { return _dynamicAllocCount; }
+
   //! \}
 
   //! \cond
@@ -35,6 +35,7 @@
 #include "./loong/la64globals.h"
 #include "./loong/la64instdb.h"
 #include "./loong/la64operand.h"
+#include "./loong/la64peepholepass.h"
 #include "./loong/la64utils.h"
 
 #endif // ASMJIT_LA64_H_INCLUDED
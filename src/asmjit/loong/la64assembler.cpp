@@ -53,6 +53,40 @@ static constexpr uint32_t kSP = Gp::kIdSp;
 static constexpr uint32_t kZR = Gp::kIdZr;
 static constexpr uint32_t kWX = InstDB::kWX;
 
+// ============================================================================
+// [asmjit::la64::Assembler - Veneers]
+// ============================================================================
+
+static constexpr uint32_t kOpcodeB = 0b010100u << 26;
+static constexpr uint32_t kOpcodeBl = 0b010101u << 26;
+static constexpr uint32_t kOpcodeJirl = 0b010011u << 26;
+static constexpr uint32_t kOpcodePcaddu18i = 0b0001111u << 25;
+
+// Conditional branches come in pairs that only differ in the lowest opcode bit
+// (beq/bne, blt/bge, bltu/bgeu), flipping it inverts the condition.
+static constexpr uint32_t kBranchInvertBit = 1u << 26;
+
+// Register used by long branches, `t8` is what the psABI uses for the same.
+// It's clobbered by them, so `la64::RAPass` never allocates it.
+static constexpr uint32_t kVeneerScratchId = 20;
+static constexpr uint32_t kRaId = 1;
+
+// Maximum forward displacement of a conditional branch (16-bit word offset).
+static constexpr size_t kCondBranchMaxForward = ((size_t(1) << 15) - 1) * 4;
+
+// Slack kept before the deadline so a single instruction or alignment never
+// skips over it.
+static constexpr size_t kVeneerPoolMargin = 256;
+
+// Returns the offset at which a pool of `count` veneers must be emitted so the
+// branch at `firstOffset` (and any after it) can still reach its veneer. The
+// pool starts with a jump over it, so it's `count + 1` instructions long.
+static ASMJIT_INLINE size_t la64VeneerDeadline(size_t firstOffset, size_t count) noexcept {
+  size_t limit = firstOffset + kCondBranchMaxForward;
+  size_t reserved = (count + 1) * 4 + kVeneerPoolMargin;
+  return limit > reserved ? limit - reserved : 0;
+}
+
 // ============================================================================
 // [asmjit::a64::Assembler - ShiftOpToLdStOptMap]
 // ============================================================================
@@ -747,7 +781,10 @@ static inline bool checkValidRegs(const Operand_& o0, const Operand_& o1, const
 // [asmjit::Assembler - Construction / Destruction]
 // ============================================================================
 
-Assembler::Assembler(CodeHolder* code) noexcept : BaseAssembler() {
+Assembler::Assembler(CodeHolder* code) noexcept
+  : BaseAssembler(),
+    _veneerDeadline(SIZE_MAX),
+    _veneerCount(0) {
   if (code)
     code->attach(this);
 }
@@ -784,6 +821,14 @@ Error Assembler::_emit(uint32_t instId, const Operand_& o0, const Operand_& o1,
   const Operand_& o3 = opExt[EmitterUtils::kOp3];
   const Operand_* rmRel = nullptr;
 
+  // Pending branches would go out of range, emit their veneers first.
+  if (ASMJIT_UNLIKELY(offset() >= _veneerDeadline)) {
+    err = _emitVeneerPool();
+    if (ASMJIT_UNLIKELY(err))
+      return err;
+    writer.setCursor(_bufferPtr);
+  }
+
   // uint32_t multipleOpData[4];
   // uint32_t multipleOpCount;
 
@@ -3554,6 +3599,12 @@ EmitOp_Rel:
       if (label->isBoundTo(_section)) {
         // Label bound to the current section.
         offsetValue = label->offset() - uint64_t(offset()) + uint64_t(labelOffset);
+
+        if ((offsetFormat.type() == OffsetFormat::kTypeLa64_BBL || offsetFormat.type() == OffsetFormat::kTypeLa64_BEQ) &&
+            (offsetValue & 0x3u) == 0 &&
+            !Support::isEncodableOffset64(int64_t(offsetValue) >> 2, offsetFormat.immBitCount()))
+          goto EmitOp_LongBranch;
+
         goto EmitOp_DispImm;
       }
       else {
@@ -3564,6 +3615,19 @@ EmitOp_Rel:
         if (ASMJIT_UNLIKELY(!link))
           goto OutOfMemory;
 
+        // Conditional branches only reach ±128KB, track them so a veneer pool
+        // can be emitted before the label goes out of their range.
+        if (offsetFormat.type() == OffsetFormat::kTypeLa64_BEQ) {
+          err = _pendingBranches.append(_code->allocator(), PendingBranch { label, link });
+          if (ASMJIT_UNLIKELY(err))
+            goto Failed;
+
+          if (_veneerDeadline == SIZE_MAX)
+            _veneerDeadline = la64VeneerDeadline(codeOffset, 1);
+          else
+            _veneerDeadline = _veneerDeadline >= 4 ? _veneerDeadline - 4 : 0;
+        }
+
         goto EmitOp;
       }
     }
@@ -3647,6 +3711,52 @@ EmitOp_DispImm:
     }
   }
 
+  // --------------------------------------------------------------------------
+  // [EmitOp - Long Branch]
+  // --------------------------------------------------------------------------
+
+EmitOp_LongBranch:
+  {
+    // The bound label is out of range of the branch. A conditional branch is
+    // inverted to skip a long branch that follows it, `b` and `bl` are replaced
+    // by `pcaddu18i` + `jirl`, which reach ±128GB.
+    bool isConditional = offsetFormat.type() == OffsetFormat::kTypeLa64_BEQ;
+    bool isCall = !isConditional && (opcode.get() & ~Support::lsbMask<uint32_t>(26)) == kOpcodeBl;
+
+    int64_t disp = int64_t(offsetValue) - (isConditional ? 4 : 0);
+    bool isFar = !Support::isEncodableOffset64(disp >> 2, 26);
+
+    if (isFar) {
+      int64_t hi = (disp + (int64_t(1) << 17)) >> 18;
+      if (!Support::isEncodableOffset64(hi, 20))
+        goto InvalidDisplacement;
+    }
+
+    uint32_t size = (isConditional ? 4u : 0u) + (isFar ? 8u : 4u);
+    err = writer.ensureSpace(this, size);
+    if (ASMJIT_UNLIKELY(err))
+      goto Failed;
+
+    if (isConditional)
+      writer.emit32uLE((opcode.get() ^ kBranchInvertBit) | ((size / 4u) << 10));
+
+    if (!isFar) {
+      uint32_t imm = uint32_t(disp >> 2) & Support::lsbMask<uint32_t>(26);
+      writer.emit32uLE(kOpcodeB | ((imm & 0xFFFFu) << 10) | (imm >> 16));
+    }
+    else {
+      int64_t hi = (disp + (int64_t(1) << 17)) >> 18;
+      int64_t lo = (disp - hi * (int64_t(1) << 18)) >> 2;
+
+      uint32_t rd = isCall ? kRaId : kVeneerScratchId;
+      writer.emit32uLE(kOpcodePcaddu18i | ((uint32_t(hi) & 0xFFFFFu) << 5) | rd);
+      writer.emit32uLE(kOpcodeJirl | ((uint32_t(lo) & 0xFFFFu) << 10) | (rd << 5) | (isCall ? kRaId : 0u));
+    }
+
+    _veneerCount++;
+    goto EmitDone;
+  }
+
   // --------------------------------------------------------------------------
   // [EmitOp - Opcode]
   // --------------------------------------------------------------------------
@@ -3715,6 +3825,124 @@ Failed:
 #undef ENC_OPS3
 #undef ENC_OPS4
 
+// ============================================================================
+// [asmjit::Assembler - Veneers]
+// ============================================================================
+
+void Assembler::_updateVeneerDeadline() noexcept {
+  uint32_t sectionId = _section ? _section->id() : uint32_t(Globals::kInvalidId);
+  size_t firstOffset = SIZE_MAX;
+  size_t count = 0;
+
+  // Links of bound labels were either resolved (and released) or they target
+  // another section, in both cases the branch doesn't need a veneer.
+  uint32_t n = _pendingBranches.size();
+  uint32_t j = 0;
+
+  for (uint32_t i = 0; i < n; i++) {
+    const PendingBranch& pb = _pendingBranches[i];
+    if (pb.label->isBound())
+      continue;
+
+    if (pb.link->sectionId == sectionId) {
+      firstOffset = Support::min(firstOffset, pb.link->offset);
+      count++;
+    }
+    _pendingBranches[j++] = pb;
+  }
+
+  _pendingBranches.truncate(j);
+  _veneerDeadline = count ? la64VeneerDeadline(firstOffset, count) : SIZE_MAX;
+}
+
+Error Assembler::_emitVeneerPool(size_t extraSize) {
+  _updateVeneerDeadline();
+  if (offset() + extraSize < _veneerDeadline)
+    return kErrorOk;
+
+  // The pool is emitted in the middle of an instruction or alignment request,
+  // keep its options and comment, and don't let the pool emit another pool.
+  uint32_t savedInstOptions = _instOptions;
+  RegOnly savedExtraReg = _extraReg;
+  const char* savedInlineComment = _inlineComment;
+
+  resetInstOptions();
+  resetExtraReg();
+  resetInlineComment();
+  _veneerDeadline = SIZE_MAX;
+
+  uint32_t sectionId = _section->id();
+  uint32_t n = _pendingBranches.size();
+  uint32_t i = 0;
+  uint32_t j = 0;
+
+  Label skip = newLabel();
+  Error err = b(skip);
+
+  if (!err) {
+    for (; i < n; i++) {
+      PendingBranch pb = _pendingBranches[i];
+      LabelLink* link = pb.link;
+
+      if (link->sectionId != sectionId) {
+        _pendingBranches[j++] = pb;
+        continue;
+      }
+
+      CodeWriter writer(this);
+      err = writer.ensureSpace(this, 4);
+      if (ASMJIT_UNLIKELY(err))
+        break;
+
+      // Redirect the branch to its veneer and move the link to the veneer,
+      // which is patched when the label gets bound. Branches that already
+      // cannot reach the pool are left as is and reported when resolved.
+      size_t veneerOffset = writer.offsetFrom(_bufferData);
+      if (!CodeWriterUtils::writeOffset(_bufferData + link->offset, int64_t(veneerOffset - link->offset), link->format))
+        continue;
+
+      writer.emit32uLE(kOpcodeB);
+      link->offset = veneerOffset;
+      link->format.resetToImmValue(OffsetFormat::kTypeLa64_BBL, 4, 0, 26, 2);
+
+#ifndef ASMJIT_NO_LOGGING
+      if (_logger) {
+        Operand_ noExt[Globals::kMaxOpCount - 3] {};
+        EmitterUtils::logInstructionEmitted(this, Inst::kIdB, 0, Label(pb.label->id()), Operand(), Operand(), noExt, 0, 0, writer.cursor());
+      }
+#endif
+
+      writer.done(this);
+      _veneerCount++;
+    }
+
+    if (!err)
+      err = bind(skip);
+  }
+
+  // Keep the rest if the pool couldn't be completed.
+  for (; i < n; i++)
+    _pendingBranches[j++] = _pendingBranches[i];
+  _pendingBranches.truncate(j);
+
+  _instOptions = savedInstOptions;
+  _extraReg = savedExtraReg;
+  _inlineComment = savedInlineComment;
+
+  _updateVeneerDeadline();
+  return err;
+}
+
+// ============================================================================
+// [asmjit::Assembler - Sections]
+// ============================================================================
+
+Error Assembler::section(Section* section) {
+  ASMJIT_PROPAGATE(Base::section(section));
+  _updateVeneerDeadline();
+  return kErrorOk;
+}
+
 // ============================================================================
 // [asmjit::Assembler - Align]
 // ============================================================================
@@ -3732,6 +3960,9 @@ Error Assembler::align(uint32_t alignMode, uint32_t alignment) {
   if (ASMJIT_UNLIKELY(alignment > Globals::kMaxAlignment || !Support::isPowerOf2(alignment)))
     return reportError(DebugUtils::errored(kErrorInvalidArgument));
 
+  if (ASMJIT_UNLIKELY(offset() + alignment >= _veneerDeadline))
+    ASMJIT_PROPAGATE(_emitVeneerPool(alignment));
+
   uint32_t i = uint32_t(Support::alignUpDiff<size_t>(offset(), alignment));
 
   if (i == 0)
@@ -3806,13 +4037,94 @@ Error Assembler::onAttach(CodeHolder* code) noexcept {
   if (!Environment::isFamilyLOONGARCH(arch))
     return DebugUtils::errored(kErrorInvalidArch);
 
+  _veneerDeadline = SIZE_MAX;
+  _veneerCount = 0;
   return Base::onAttach(code);
 }
 
 Error Assembler::onDetach(CodeHolder* code) noexcept {
+  _pendingBranches.release(code->allocator());
+  _veneerDeadline = SIZE_MAX;
   return Base::onDetach(code);
 }
 
+// ============================================================================
+// [asmjit::Assembler - Unit]
+// ============================================================================
+
+#if defined(ASMJIT_TEST)
+static uint32_t la64ReadWord(const CodeHolder& code, size_t offset) noexcept {
+  return Support::readU32uLE(code.textSection()->buffer().data() + offset);
+}
+
+UNIT(la64_assembler_veneers) {
+  Environment env(Environment::kArchLOONGARCH64);
+
+  // 40000 instructions are more than a conditional branch can reach.
+  constexpr uint32_t kPaddingCount = 40000;
+
+  INFO("Checking long branch to a bound label");
+  {
+    CodeHolder code;
+    code.init(env);
+    Assembler a(&code);
+
+    Label L = a.newLabel();
+    a.bind(L);
+    for (uint32_t i = 0; i < kPaddingCount; i++)
+      a.andi(zero, zero, 0);
+    a.beq(a0, a1, L);
+    a.bl(L);
+
+    EXPECT(a.veneerCount() == 1);
+    EXPECT(code.codeSize() == kPaddingCount * 4 + 12);
+
+    // bne a0, a1, +8; b L; bl L.
+    EXPECT(la64ReadWord(code, kPaddingCount * 4 + 0) == 0x5C000885u);
+    EXPECT(la64ReadWord(code, kPaddingCount * 4 + 4) == 0x518EFFFFu);
+    EXPECT(la64ReadWord(code, kPaddingCount * 4 + 8) == 0x558EFBFFu);
+  }
+
+  INFO("Checking veneer pool of branches to an unbound label");
+  {
+    CodeHolder code;
+    code.init(env);
+    Assembler a(&code);
+
+    Label L = a.newLabel();
+    a.beq(a0, a1, L);
+    a.bne(a2, a3, L);
+    for (uint32_t i = 0; i < kPaddingCount; i++)
+      a.andi(zero, zero, 0);
+    a.bind(L);
+
+    EXPECT(a.veneerCount() == 2);
+    EXPECT(code.codeSize() == kPaddingCount * 4 + 20);
+    EXPECT(!code.hasUnresolvedLinks());
+
+    // Find the pool, which starts with a jump over both veneers.
+    size_t pool = 8;
+    while (pool < code.codeSize() && la64ReadWord(code, pool) != 0x50000C00u)
+      pool += 4;
+    EXPECT(pool < code.codeSize() - 8);
+
+    // Both branches must be redirected to their veneers, which jump to `L`.
+    uint32_t beqDisp = (la64ReadWord(code, 0) >> 10) & 0xFFFFu;
+    uint32_t bneDisp = (la64ReadWord(code, 4) >> 10) & 0xFFFFu;
+    EXPECT(beqDisp * 4 == pool + 4);
+    EXPECT(bneDisp * 4 == pool + 8 - 4);
+
+    for (uint32_t i = 0; i < 2; i++) {
+      size_t veneer = pool + 4 + i * 4;
+      uint32_t w = la64ReadWord(code, veneer);
+      uint32_t disp = (((w >> 10) & 0xFFFFu) | ((w & 0x3FFu) << 16)) * 4;
+      EXPECT((w & 0xFC000000u) == 0x50000000u);
+      EXPECT(veneer + disp == code.codeSize());
+    }
+  }
+}
+#endif
+
 ASMJIT_END_SUB_NAMESPACE
 
 #endif // !ASMJIT_NO_LOONG
@@ -25,6 +25,7 @@
 #define ASMJIT_LOONG_LA64ASSEMBLER_H_INCLUDED
 
 #include "../core/assembler.h"
+#include "../core/zonevector.h"
 #include "../loong/la64emitter.h"
 #include "../loong/la64operand.h"
 
@@ -38,6 +39,28 @@ ASMJIT_BEGIN_SUB_NAMESPACE(la64)
 // ============================================================================
 
 //! AArch64 assembler implementation.
+//!
+//! Branches that cannot reach their target are rewritten into long branch
+//! sequences (veneers) automatically:
+//!
+//!   - A conditional branch (`beq`, `bne`, `blt`, `bge`, `bltu`, `bgeu`) to a
+//!     label bound out of its ±128KB range is emitted as an inverted branch
+//!     that skips `b label`, or `pcaddu18i t8` + `jirl zero, t8` if even `b`
+//!     cannot reach it.
+//!   - `b` and `bl` to a label bound out of their ±128MB range are emitted as
+//!     `pcaddu18i t8` + `jirl zero, t8` and `pcaddu18i ra` + `jirl ra, ra`.
+//!   - Conditional branches to labels that are not bound yet are tracked and
+//!     before they would go out of range a veneer pool is emitted, which is
+//!     jumped over and which contains `b label` for each of them. The pending
+//!     branches are then redirected to their veneers.
+//!
+//! Veneer pools are only emitted before instructions and alignment, so data
+//! embedded between a branch and its target should not be larger than a few
+//! hundred bytes.
+//!
+//! \note Long branch sequences clobber `t8` (and `ra` in case of `bl`), so
+//! `t8` must not hold a live value across a branch that may be out of range.
+//! \ref la64::Compiler never allocates `t8` for this reason.
 class ASMJIT_VIRTAPI Assembler
   : public BaseAssembler,
     public EmitterExplicitT<Assembler> {
@@ -45,6 +68,22 @@ class ASMJIT_VIRTAPI Assembler
 public:
   typedef BaseAssembler Base;
 
+  //! Conditional branch to a label that is not bound yet.
+  struct PendingBranch {
+    //! Target label.
+    LabelEntry* label;
+    //! Link of the branch, which is moved to its veneer if emitted.
+    LabelLink* link;
+  };
+
+  //! Conditional branches to labels that are not bound yet, which may need
+  //! a veneer.
+  ZoneVector<PendingBranch> _pendingBranches;
+  //! Offset in the current section at which a veneer pool must be emitted.
+  size_t _veneerDeadline;
+  //! Number of veneers emitted, including long branch sequences.
+  uint32_t _veneerCount;
+
   //! \name Construction / Destruction
   //! \{
 
@@ -62,7 +101,24 @@ public:
   //! Gets the current code alignment of the current mode (ARM vs THUMB).
   inline uint32_t codeAlignment() const noexcept { return isInThumbMode() ? 2 : 4; }
 
+  //! Returns the number of veneers and long branch sequences emitted so far.
+  inline uint32_t veneerCount() const noexcept { return _veneerCount; }
+
+  //! \}
+
+  //! \cond INTERNAL
+  //! \name Internal
+  //! \{
+
+  //! Emits a veneer pool for all pending branches of the current section if
+  //! the first of them would go out of range before `offset() + extraSize`.
+  ASMJIT_API Error _emitVeneerPool(size_t extraSize = 0);
+  //! Removes pending branches to bound labels and recalculates the veneer
+  //! deadline of the current section.
+  ASMJIT_API void _updateVeneerDeadline() noexcept;
+
   //! \}
+  //! \endcond
 
   //! \name Emit
   //! \{
@@ -71,6 +127,13 @@ public:
 
   //! \}
 
+  //! \name Sections
+  //! \{
+
+  ASMJIT_API Error section(Section* section) override;
+
+  //! \}
+
   //! \name Align
   //! \{
 
@@ -24,8 +24,10 @@
 #include "../core/api-build_p.h"
 #if !defined(ASMJIT_NO_LOONG) && !defined(ASMJIT_NO_BUILDER)
 
+#include "../core/schedpass.h"
 #include "../loong/la64assembler.h"
 #include "../loong/la64builder.h"
+#include "../loong/la64peepholepass.h"
 
 ASMJIT_BEGIN_SUB_NAMESPACE(la64)
 
@@ -63,6 +65,112 @@ Error Builder::onAttach(CodeHolder* code) noexcept {
   return Base::onAttach(code);
 }
 
+// ============================================================================
+// [asmjit::la64::Builder - Unit]
+// ============================================================================
+
+#if defined(ASMJIT_TEST)
+UNIT(la64_builder_peephole_pass) {
+  Environment env(Environment::kArchLOONGARCH64);
+  CodeHolder code;
+  code.init(env);
+
+  Builder cb(&code);
+  PeepholePass* pass = cb.newPassT<PeepholePass>();
+  EXPECT(cb.addPass(pass) == kErrorOk);
+
+  Label L_Next = cb.newLabel();
+  Label L_Chain = cb.newLabel();
+
+  cb.or_(a0, a0, zero);       // Removed.
+  cb.or_(a1, a2, zero);       // Kept.
+  cb.addi_d(a0, a0, 0);       // Removed.
+  cb.addi_w(a0, a0, 0);       // Kept, sign extends the lower 32 bits.
+  cb.beq(a0, a1, L_Chain);    // Retargeted to L_Next, and then removed.
+  cb.b(L_Next);               // Removed.
+  cb.bind(L_Next);
+  cb.jirl(zero, ra, 0);
+  cb.bind(L_Chain);
+  cb.b(L_Next);
+
+  EXPECT(cb.runPasses() == kErrorOk);
+
+  static const uint32_t expectedIds[] = {
+    Inst::kIdOr_, Inst::kIdAddi_w, Inst::kIdJirl, Inst::kIdB
+  };
+
+  uint32_t count = 0;
+  for (BaseNode* node = cb.firstNode(); node; node = node->next()) {
+    if (!node->isInst())
+      continue;
+
+    InstNode* inst = node->as<InstNode>();
+    EXPECT(count < ASMJIT_ARRAY_SIZE(expectedIds));
+    EXPECT(inst->id() == expectedIds[count],
+           "Instruction #%u has an unexpected id %u", count, inst->id());
+    count++;
+  }
+  EXPECT(count == ASMJIT_ARRAY_SIZE(expectedIds));
+
+  EXPECT(pass->ruleCounter(PeepholePass::kRuleRedundantMove) == 1);
+  EXPECT(pass->ruleCounter(PeepholePass::kRuleIdentityOp) == 1);
+  EXPECT(pass->ruleCounter(PeepholePass::kRuleJumpToNext) == 2);
+  EXPECT(pass->ruleCounter(PeepholePass::kRuleJumpChain) == 1);
+}
+#endif
+
+#if defined(ASMJIT_TEST) && !defined(ASMJIT_NO_INTROSPECTION)
+UNIT(la64_builder_sched_pass) {
+  Environment env(Environment::kArchLOONGARCH64);
+  CodeHolder code;
+  code.init(env);
+
+  Builder cb(&code);
+  EXPECT(cb.addPassT<SchedPass>() == kErrorOk);
+
+  // Two dependency chains emitted back-to-back, followed by a store and a
+  // load, which must stay in order as they can alias.
+  cb.mul_d(a0, a1, a2);
+  cb.addi_d(a0, a0, 1);
+  cb.mul_d(a3, a1, a2);
+  cb.addi_d(a3, a3, 1);
+  cb.st_d(a0, a4, 0);
+  cb.ld_d(a5, a6, 0);
+
+  // Nothing is moved across a branch.
+  cb.jirl(zero, ra, 0);
+  cb.mul_d(a0, a1, a2);
+  cb.addi_d(a0, a0, 1);
+
+  EXPECT(cb.runPasses() == kErrorOk);
+
+  static const uint32_t expectedIds[] = {
+    Inst::kIdMul_d, Inst::kIdMul_d, Inst::kIdAddi_d, Inst::kIdSt_d, Inst::kIdLd_d, Inst::kIdAddi_d,
+    Inst::kIdJirl, Inst::kIdMul_d, Inst::kIdAddi_d
+  };
+
+  const Operand expectedOps[] = {
+    a0, a3, a0, a0, a5, a3,
+    zero, a0, a0
+  };
+
+  uint32_t count = 0;
+  for (BaseNode* node = cb.firstNode(); node; node = node->next()) {
+    if (!node->isInst())
+      continue;
+
+    InstNode* inst = node->as<InstNode>();
+    EXPECT(count < ASMJIT_ARRAY_SIZE(expectedIds));
+    EXPECT(inst->id() == expectedIds[count],
+           "Instruction #%u has an unexpected id %u", count, inst->id());
+    EXPECT(inst->op(0) == expectedOps[count],
+           "Instruction #%u has an unexpected first operand", count);
+    count++;
+  }
+  EXPECT(count == ASMJIT_ARRAY_SIZE(expectedIds));
+}
+#endif
+
 ASMJIT_END_SUB_NAMESPACE
 
 #endif // !ASMJIT_NO_LOONG && !ASMJIT_NO_BUILDER
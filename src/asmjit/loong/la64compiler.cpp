@@ -72,6 +72,52 @@ Error Compiler::onAttach(CodeHolder* code) noexcept {
   return kErrorOk;
 }
 
+// ============================================================================
+// [asmjit::la64::Compiler - Unit]
+// ============================================================================
+
+#if defined(ASMJIT_TEST)
+UNIT(la64_compiler_reserved_regs) {
+  Environment env(Environment::kArchLOONGARCH64);
+  CodeHolder code;
+  code.init(env);
+
+  Compiler cc(&code);
+  cc.addFunc(FuncSignatureT<int64_t, int64_t>(CallConv::kIdHost));
+
+  // Keep more values alive than there are registers, so every allocatable
+  // register gets used.
+  Gp arg = cc.newInt64("arg");
+  cc.setArg(0, arg);
+
+  Gp values[32];
+  for (uint32_t i = 0; i < ASMJIT_ARRAY_SIZE(values); i++) {
+    values[i] = cc.newInt64("v%u", i);
+    cc.add_d(values[i], arg, arg);
+  }
+
+  for (uint32_t i = 1; i < ASMJIT_ARRAY_SIZE(values); i++)
+    cc.add_d(values[0], values[0], values[i]);
+
+  cc.ret(values[0]);
+  cc.endFunc();
+  EXPECT(cc.runPasses() == kErrorOk);
+
+  // T8 is clobbered by long branches, it must never be allocated.
+  for (BaseNode* node = cc.firstNode(); node; node = node->next()) {
+    if (!node->isInst())
+      continue;
+
+    InstNode* inst = node->as<InstNode>();
+    for (uint32_t i = 0; i < inst->opCount(); i++) {
+      const Operand& op = inst->op(i);
+      EXPECT(!(op.isPhysReg() && op.as<BaseReg>().isGp() && op.id() == 20),
+             "T8 was allocated by the register allocator");
+    }
+  }
+}
+#endif
+
 ASMJIT_END_SUB_NAMESPACE
 
 #endif // !ASMJIT_NO_LOONG && !ASMJIT_NO_COMPILER
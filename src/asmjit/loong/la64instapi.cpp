@@ -148,12 +148,13 @@ static const InstRWInfoData instRWInfoData[] = {
 static const uint8_t elementTypeSize[8] = { 0, 1, 2, 4, 8, 4, 4, 0 };
 
 Error InstInternal::queryRWInfo(uint32_t arch, const BaseInst& inst, const Operand_* operands, size_t opCount, InstRWInfo* out) noexcept {
-  // Only called when `arch` matches X86 family.
-  ASMJIT_ASSERT(Environment::isFamilyARM(arch));
+  // Only called when `arch` matches LOONGARCH family.
+  ASMJIT_ASSERT(Environment::isFamilyLOONGARCH(arch));
+  DebugUtils::unused(arch);
 
   // Get the instruction data.
   uint32_t instId = inst.id();
-  if (ASMJIT_UNLIKELY(!Inst::isDefinedId(instId)))
+  if (ASMJIT_UNLIKELY(!InstDB::hasInfo(instId)))
     return DebugUtils::errored(kErrorInvalidInstruction);
 
   out->_instFlags = 0;
@@ -242,6 +243,200 @@ Error InstInternal::queryFeatures(uint32_t arch, const BaseInst& inst, const Ope
 }
 #endif // !ASMJIT_NO_INTROSPECTION
 
+// ============================================================================
+// [asmjit::la64::InstInternal - QuerySchedInfo]
+// ============================================================================
+
+#ifndef ASMJIT_NO_INTROSPECTION
+struct SchedInfoData {
+  uint16_t instId;
+  uint8_t latency;
+  uint8_t flags;
+};
+
+// Approximate latencies and memory/barrier flags of instructions on LA464
+// cores. The table must be sorted by instruction id, all other instructions
+// take 1 cycle and don't access memory.
+static const SchedInfoData schedInfoData[] = {
+  #define B InstSchedInfo::kFlagBarrier
+  #define R InstSchedInfo::kFlagMemRead
+  #define W InstSchedInfo::kFlagMemWrite
+
+  { Inst::kIdAmadd_d, 1, B },          { Inst::kIdAmadd_db_d, 1, B },       { Inst::kIdAmadd_db_w, 1, B },
+  { Inst::kIdAmadd_w, 1, B },          { Inst::kIdAmand_d, 1, B },          { Inst::kIdAmand_db_d, 1, B },
+  { Inst::kIdAmand_db_w, 1, B },       { Inst::kIdAmand_w, 1, B },          { Inst::kIdAmmax_d, 1, B },
+  { Inst::kIdAmmax_db_d, 1, B },       { Inst::kIdAmmax_db_du, 1, B },      { Inst::kIdAmmax_db_w, 1, B },
+  { Inst::kIdAmmax_db_wu, 1, B },      { Inst::kIdAmmax_du, 1, B },         { Inst::kIdAmmax_w, 1, B },
+  { Inst::kIdAmmax_wu, 1, B },         { Inst::kIdAmmin_d, 1, B },          { Inst::kIdAmmin_db_d, 1, B },
+  { Inst::kIdAmmin_db_du, 1, B },      { Inst::kIdAmmin_db_w, 1, B },       { Inst::kIdAmmin_db_wu, 1, B },
+  { Inst::kIdAmmin_du, 1, B },         { Inst::kIdAmmin_w, 1, B },          { Inst::kIdAmmin_wu, 1, B },
+  { Inst::kIdAmor_d, 1, B },           { Inst::kIdAmor_db_d, 1, B },        { Inst::kIdAmor_db_w, 1, B },
+  { Inst::kIdAmor_w, 1, B },           { Inst::kIdAmswap_d, 1, B },         { Inst::kIdAmswap_db_d, 1, B },
+  { Inst::kIdAmswap_db_w, 1, B },      { Inst::kIdAmswap_w, 1, B },         { Inst::kIdAmxor_d, 1, B },
+  { Inst::kIdAmxor_db_d, 1, B },       { Inst::kIdAmxor_db_w, 1, B },       { Inst::kIdAmxor_w, 1, B },
+  { Inst::kIdAsrtgt_d, 1, B },         { Inst::kIdAsrtle_d, 1, B },         { Inst::kIdB, 1, B },
+  { Inst::kIdBceqz, 1, B },            { Inst::kIdBcnez, 1, B },            { Inst::kIdBeq, 1, B },
+  { Inst::kIdBge, 1, B },              { Inst::kIdBgeu, 1, B },             { Inst::kIdBl, 1, B },
+  { Inst::kIdBlt, 1, B },              { Inst::kIdBltu, 1, B },             { Inst::kIdBne, 1, B },
+  { Inst::kIdBreak_, 1, B },           { Inst::kIdCacop, 1, B },            { Inst::kIdCpucfg, 1, B },
+  { Inst::kIdCsrrd, 1, B },            { Inst::kIdCsrwr, 1, B },            { Inst::kIdCsrxchg, 1, B },
+  { Inst::kIdDbar, 1, B },             { Inst::kIdDbcl, 1, B },             { Inst::kIdDiv_d, 12, 0 },
+  { Inst::kIdDiv_du, 12, 0 },          { Inst::kIdDiv_w, 12, 0 },           { Inst::kIdDiv_wu, 12, 0 },
+  { Inst::kIdErtn, 1, B },             { Inst::kIdFadd_d, 4, 0 },           { Inst::kIdFadd_s, 4, 0 },
+  { Inst::kIdFcvt_d_s, 4, 0 },         { Inst::kIdFcvt_s_d, 4, 0 },         { Inst::kIdFdiv_d, 12, 0 },
+  { Inst::kIdFdiv_s, 12, 0 },          { Inst::kIdFfint_d_l, 4, 0 },        { Inst::kIdFfint_d_w, 4, 0 },
+  { Inst::kIdFfint_s_l, 4, 0 },        { Inst::kIdFfint_s_w, 4, 0 },        { Inst::kIdFld_d, 5, R },
+  { Inst::kIdFld_s, 5, R },            { Inst::kIdFldgt_d, 5, R },          { Inst::kIdFldgt_s, 5, R },
+  { Inst::kIdFldle_d, 5, R },          { Inst::kIdFldle_s, 5, R },          { Inst::kIdFldx_d, 5, R },
+  { Inst::kIdFldx_s, 5, R },           { Inst::kIdFmadd_d, 4, 0 },          { Inst::kIdFmadd_s, 4, 0 },
+  { Inst::kIdFmul_d, 4, 0 },           { Inst::kIdFmul_s, 4, 0 },           { Inst::kIdFrecip_d, 12, 0 },
+  { Inst::kIdFrecip_s, 12, 0 },        { Inst::kIdFrsqrt_d, 12, 0 },        { Inst::kIdFrsqrt_s, 12, 0 },
+  { Inst::kIdFsqrt_d, 16, 0 },         { Inst::kIdFsqrt_s, 16, 0 },         { Inst::kIdFst_d, 1, W },
+  { Inst::kIdFst_s, 1, W },            { Inst::kIdFstgt_d, 1, W },          { Inst::kIdFstgt_s, 1, W },
+  { Inst::kIdFstle_d, 1, W },          { Inst::kIdFstle_s, 1, W },          { Inst::kIdFstx_d, 1, W },
+  { Inst::kIdFstx_s, 1, W },           { Inst::kIdFsub_d, 4, 0 },           { Inst::kIdFsub_s, 4, 0 },
+  { Inst::kIdFtint_l_d, 4, 0 },        { Inst::kIdFtint_l_s, 4, 0 },        { Inst::kIdFtint_w_d, 4, 0 },
+  { Inst::kIdFtint_w_s, 4, 0 },        { Inst::kIdFtintrm_l_d, 4, 0 },      { Inst::kIdFtintrm_l_s, 4, 0 },
+  { Inst::kIdFtintrm_w_d, 4, 0 },      { Inst::kIdFtintrm_w_s, 4, 0 },      { Inst::kIdFtintrne_l_d, 4, 0 },
+  { Inst::kIdFtintrne_l_s, 4, 0 },     { Inst::kIdFtintrne_w_d, 4, 0 },     { Inst::kIdFtintrne_w_s, 4, 0 },
+  { Inst::kIdFtintrp_l_d, 4, 0 },      { Inst::kIdFtintrp_l_s, 4, 0 },      { Inst::kIdFtintrp_w_d, 4, 0 },
+  { Inst::kIdFtintrp_w_s, 4, 0 },      { Inst::kIdFtintrz_l_d, 4, 0 },      { Inst::kIdFtintrz_l_s, 4, 0 },
+  { Inst::kIdFtintrz_w_d, 4, 0 },      { Inst::kIdFtintrz_w_s, 4, 0 },      { Inst::kIdIbar, 1, B },
+  { Inst::kIdIdle, 1, B },             { Inst::kIdInvtlb, 1, B },           { Inst::kIdIocsrrd_b, 1, B },
+  { Inst::kIdIocsrrd_d, 1, B },        { Inst::kIdIocsrrd_h, 1, B },        { Inst::kIdIocsrrd_w, 1, B },
+  { Inst::kIdIocsrwr_b, 1, B },        { Inst::kIdIocsrwr_d, 1, B },        { Inst::kIdIocsrwr_h, 1, B },
+  { Inst::kIdIocsrwr_w, 1, B },        { Inst::kIdJirl, 1, B },             { Inst::kIdLd_b, 4, R },
+  { Inst::kIdLd_bu, 4, R },            { Inst::kIdLd_d, 4, R },             { Inst::kIdLd_h, 4, R },
+  { Inst::kIdLd_hu, 4, R },            { Inst::kIdLd_w, 4, R },             { Inst::kIdLd_wu, 4, R },
+  { Inst::kIdLddir, 1, B },            { Inst::kIdLdgt_b, 4, R },           { Inst::kIdLdgt_d, 4, R },
+  { Inst::kIdLdgt_h, 4, R },           { Inst::kIdLdgt_w, 4, R },           { Inst::kIdLdle_b, 4, R },
+  { Inst::kIdLdle_d, 4, R },           { Inst::kIdLdle_h, 4, R },           { Inst::kIdLdle_w, 4, R },
+  { Inst::kIdLdpte, 1, B },            { Inst::kIdLdptr_d, 4, R },          { Inst::kIdLdptr_w, 4, R },
+  { Inst::kIdLdx_b, 4, R },            { Inst::kIdLdx_bu, 4, R },           { Inst::kIdLdx_d, 4, R },
+  { Inst::kIdLdx_h, 4, R },            { Inst::kIdLdx_hu, 4, R },           { Inst::kIdLdx_w, 4, R },
+  { Inst::kIdLdx_wu, 4, R },           { Inst::kIdLl_d, 1, B },             { Inst::kIdLl_w, 1, B },
+  { Inst::kIdMod_d, 12, 0 },           { Inst::kIdMod_du, 12, 0 },          { Inst::kIdMod_w, 12, 0 },
+  { Inst::kIdMod_wu, 12, 0 },          { Inst::kIdMovfcsr2gr, 1, B },       { Inst::kIdMovgr2fcsr, 1, B },
+  { Inst::kIdMul_d, 4, 0 },            { Inst::kIdMul_w, 4, 0 },            { Inst::kIdMulh_d, 4, 0 },
+  { Inst::kIdMulh_du, 4, 0 },          { Inst::kIdMulh_w, 4, 0 },           { Inst::kIdMulh_wu, 4, 0 },
+  { Inst::kIdMulw_d_w, 4, 0 },         { Inst::kIdMulw_d_wu, 4, 0 },        { Inst::kIdPcaddi, 1, B },
+  { Inst::kIdPcaddu12i, 1, B },        { Inst::kIdPcaddu18i, 1, B },        { Inst::kIdPcalau12i, 1, B },
+  { Inst::kIdPreld, 1, R },            { Inst::kIdRdtime_d, 1, B },         { Inst::kIdRdtimeh_w, 1, B },
+  { Inst::kIdRdtimel_w, 1, B },        { Inst::kIdSc_d, 1, B },             { Inst::kIdSc_w, 1, B },
+  { Inst::kIdSt_b, 1, W },             { Inst::kIdSt_d, 1, W },             { Inst::kIdSt_h, 1, W },
+  { Inst::kIdSt_w, 1, W },             { Inst::kIdStgt_b, 1, W },           { Inst::kIdStgt_d, 1, W },
+  { Inst::kIdStgt_h, 1, W },           { Inst::kIdStgt_w, 1, W },           { Inst::kIdStle_b, 1, W },
+  { Inst::kIdStle_d, 1, W },           { Inst::kIdStle_h, 1, W },           { Inst::kIdStle_w, 1, W },
+  { Inst::kIdStptr_d, 1, W },          { Inst::kIdStptr_w, 1, W },          { Inst::kIdStx_b, 1, W },
+  { Inst::kIdStx_d, 1, W },            { Inst::kIdStx_h, 1, W },            { Inst::kIdStx_w, 1, W },
+  { Inst::kIdSyscall, 1, B },          { Inst::kIdTlbclr, 1, B },           { Inst::kIdTlbfill, 1, B },
+  { Inst::kIdTlbflush, 1, B },         { Inst::kIdTlbrd, 1, B },            { Inst::kIdTlbsrch, 1, B },
+  { Inst::kIdTlbwr, 1, B },            { Inst::kIdVdiv_b, 12, 0 },          { Inst::kIdVdiv_bu, 12, 0 },
+  { Inst::kIdVdiv_d, 12, 0 },          { Inst::kIdVdiv_du, 12, 0 },         { Inst::kIdVdiv_h, 12, 0 },
+  { Inst::kIdVdiv_hu, 12, 0 },         { Inst::kIdVdiv_w, 12, 0 },          { Inst::kIdVdiv_wu, 12, 0 },
+  { Inst::kIdVfadd_d, 4, 0 },          { Inst::kIdVfadd_s, 4, 0 },          { Inst::kIdVfcvt_h_s, 4, 0 },
+  { Inst::kIdVfcvt_s_d, 4, 0 },        { Inst::kIdVfcvth_d_s, 4, 0 },       { Inst::kIdVfcvth_s_h, 4, 0 },
+  { Inst::kIdVfcvtl_d_s, 4, 0 },       { Inst::kIdVfcvtl_s_h, 4, 0 },       { Inst::kIdVfdiv_d, 12, 0 },
+  { Inst::kIdVfdiv_s, 12, 0 },         { Inst::kIdVffint_d_l, 4, 0 },       { Inst::kIdVffint_d_lu, 4, 0 },
+  { Inst::kIdVffint_s_l, 4, 0 },       { Inst::kIdVffint_s_w, 4, 0 },       { Inst::kIdVffint_s_wu, 4, 0 },
+  { Inst::kIdVffinth_d_w, 4, 0 },      { Inst::kIdVffintl_d_w, 4, 0 },      { Inst::kIdVfmadd_d, 4, 0 },
+  { Inst::kIdVfmadd_s, 4, 0 },         { Inst::kIdVfmsub_d, 4, 0 },         { Inst::kIdVfmsub_s, 4, 0 },
+  { Inst::kIdVfmul_d, 4, 0 },          { Inst::kIdVfmul_s, 4, 0 },          { Inst::kIdVfnmadd_d, 4, 0 },
+  { Inst::kIdVfnmadd_s, 4, 0 },        { Inst::kIdVfnmsub_d, 4, 0 },        { Inst::kIdVfnmsub_s, 4, 0 },
+  { Inst::kIdVfrecip_d, 12, 0 },       { Inst::kIdVfrecip_s, 12, 0 },       { Inst::kIdVfrsqrt_d, 12, 0 },
+  { Inst::kIdVfrsqrt_s, 12, 0 },       { Inst::kIdVfsqrt_d, 16, 0 },        { Inst::kIdVfsqrt_s, 16, 0 },
+  { Inst::kIdVfsub_d, 4, 0 },          { Inst::kIdVfsub_s, 4, 0 },          { Inst::kIdVftint_l_d, 4, 0 },
+  { Inst::kIdVftint_lu_d, 4, 0 },      { Inst::kIdVftint_w_d, 4, 0 },       { Inst::kIdVftint_w_s, 4, 0 },
+  { Inst::kIdVftint_wu_s, 4, 0 },      { Inst::kIdVftinth_l_s, 4, 0 },      { Inst::kIdVftintl_l_s, 4, 0 },
+  { Inst::kIdVftintrm_l_d, 4, 0 },     { Inst::kIdVftintrm_w_d, 4, 0 },     { Inst::kIdVftintrm_w_s, 4, 0 },
+  { Inst::kIdVftintrmh_l_s, 4, 0 },    { Inst::kIdVftintrml_l_s, 4, 0 },    { Inst::kIdVftintrne_l_d, 4, 0 },
+  { Inst::kIdVftintrne_w_d, 4, 0 },    { Inst::kIdVftintrne_w_s, 4, 0 },    { Inst::kIdVftintrneh_l_s, 4, 0 },
+  { Inst::kIdVftintrnel_l_s, 4, 0 },   { Inst::kIdVftintrp_l_d, 4, 0 },     { Inst::kIdVftintrp_w_d, 4, 0 },
+  { Inst::kIdVftintrp_w_s, 4, 0 },     { Inst::kIdVftintrph_l_s, 4, 0 },    { Inst::kIdVftintrpl_l_s, 4, 0 },
+  { Inst::kIdVftintrz_l_d, 4, 0 },     { Inst::kIdVftintrz_lu_d, 4, 0 },    { Inst::kIdVftintrz_w_d, 4, 0 },
+  { Inst::kIdVftintrz_w_s, 4, 0 },     { Inst::kIdVftintrz_wu_s, 4, 0 },    { Inst::kIdVftintrzh_l_s, 4, 0 },
+  { Inst::kIdVftintrzl_l_s, 4, 0 },    { Inst::kIdVld, 5, R },              { Inst::kIdVldrepl_b, 5, R },
+  { Inst::kIdVldrepl_d, 5, R },        { Inst::kIdVldrepl_h, 5, R },        { Inst::kIdVldrepl_w, 5, R },
+  { Inst::kIdVldx, 5, R },             { Inst::kIdVmadd_b, 4, 0 },          { Inst::kIdVmadd_d, 4, 0 },
+  { Inst::kIdVmadd_h, 4, 0 },          { Inst::kIdVmadd_w, 4, 0 },          { Inst::kIdVmaddwev_d_w, 4, 0 },
+  { Inst::kIdVmaddwev_d_wu, 4, 0 },    { Inst::kIdVmaddwev_d_wu_w, 4, 0 },  { Inst::kIdVmaddwev_h_b, 4, 0 },
+  { Inst::kIdVmaddwev_h_bu, 4, 0 },    { Inst::kIdVmaddwev_h_bu_b, 4, 0 },  { Inst::kIdVmaddwev_q_d, 4, 0 },
+  { Inst::kIdVmaddwev_q_du, 4, 0 },    { Inst::kIdVmaddwev_q_du_d, 4, 0 },  { Inst::kIdVmaddwev_w_h, 4, 0 },
+  { Inst::kIdVmaddwev_w_hu, 4, 0 },    { Inst::kIdVmaddwev_w_hu_h, 4, 0 },  { Inst::kIdVmaddwod_d_w, 4, 0 },
+  { Inst::kIdVmaddwod_d_wu, 4, 0 },    { Inst::kIdVmaddwod_d_wu_w, 4, 0 },  { Inst::kIdVmaddwod_h_b, 4, 0 },
+  { Inst::kIdVmaddwod_h_bu, 4, 0 },    { Inst::kIdVmaddwod_h_bu_b, 4, 0 },  { Inst::kIdVmaddwod_q_d, 4, 0 },
+  { Inst::kIdVmaddwod_q_du, 4, 0 },    { Inst::kIdVmaddwod_q_du_d, 4, 0 },  { Inst::kIdVmaddwod_w_h, 4, 0 },
+  { Inst::kIdVmaddwod_w_hu, 4, 0 },    { Inst::kIdVmaddwod_w_hu_h, 4, 0 },  { Inst::kIdVmod_b, 12, 0 },
+  { Inst::kIdVmod_bu, 12, 0 },         { Inst::kIdVmod_d, 12, 0 },          { Inst::kIdVmod_du, 12, 0 },
+  { Inst::kIdVmod_h, 12, 0 },          { Inst::kIdVmod_hu, 12, 0 },         { Inst::kIdVmod_w, 12, 0 },
+  { Inst::kIdVmod_wu, 12, 0 },         { Inst::kIdVmsub_b, 4, 0 },          { Inst::kIdVmsub_d, 4, 0 },
+  { Inst::kIdVmsub_h, 4, 0 },          { Inst::kIdVmsub_w, 4, 0 },          { Inst::kIdVmuh_b, 4, 0 },
+  { Inst::kIdVmuh_bu, 4, 0 },          { Inst::kIdVmuh_d, 4, 0 },           { Inst::kIdVmuh_du, 4, 0 },
+  { Inst::kIdVmuh_h, 4, 0 },           { Inst::kIdVmuh_hu, 4, 0 },          { Inst::kIdVmuh_w, 4, 0 },
+  { Inst::kIdVmuh_wu, 4, 0 },          { Inst::kIdVmul_b, 4, 0 },           { Inst::kIdVmul_d, 4, 0 },
+  { Inst::kIdVmul_h, 4, 0 },           { Inst::kIdVmul_w, 4, 0 },           { Inst::kIdVmulwev_d_w, 4, 0 },
+  { Inst::kIdVmulwev_d_wu, 4, 0 },     { Inst::kIdVmulwev_d_wu_w, 4, 0 },   { Inst::kIdVmulwev_h_b, 4, 0 },
+  { Inst::kIdVmulwev_h_bu, 4, 0 },     { Inst::kIdVmulwev_h_bu_b, 4, 0 },   { Inst::kIdVmulwev_q_d, 4, 0 },
+  { Inst::kIdVmulwev_q_du, 4, 0 },     { Inst::kIdVmulwev_q_du_d, 4, 0 },   { Inst::kIdVmulwev_w_h, 4, 0 },
+  { Inst::kIdVmulwev_w_hu, 4, 0 },     { Inst::kIdVmulwev_w_hu_h, 4, 0 },   { Inst::kIdVmulwod_d_w, 4, 0 },
+  { Inst::kIdVmulwod_d_wu, 4, 0 },     { Inst::kIdVmulwod_d_wu_w, 4, 0 },   { Inst::kIdVmulwod_h_b, 4, 0 },
+  { Inst::kIdVmulwod_h_bu, 4, 0 },     { Inst::kIdVmulwod_h_bu_b, 4, 0 },   { Inst::kIdVmulwod_q_d, 4, 0 },
+  { Inst::kIdVmulwod_q_du, 4, 0 },     { Inst::kIdVmulwod_q_du_d, 4, 0 },   { Inst::kIdVmulwod_w_h, 4, 0 },
+  { Inst::kIdVmulwod_w_hu, 4, 0 },     { Inst::kIdVmulwod_w_hu_h, 4, 0 },   { Inst::kIdVst, 1, W },
+  { Inst::kIdVstelm_b, 1, W },         { Inst::kIdVstelm_d, 1, W },         { Inst::kIdVstelm_h, 1, W },
+  { Inst::kIdVstelm_w, 1, W },         { Inst::kIdVstx, 1, W },             { Inst::kIdBlr, 1, B },
+  { Inst::kIdBr, 1, B },               { Inst::kIdCbnz, 1, B },             { Inst::kIdCbz, 1, B },
+  { Inst::kIdRet, 1, B },              { Inst::kIdTbnz, 1, B },             { Inst::kIdTbz, 1, B }
+
+  #undef W
+  #undef R
+  #undef B
+};
+
+static const SchedInfoData* schedInfoOf(uint32_t instId) noexcept {
+  size_t lo = 0;
+  size_t hi = ASMJIT_ARRAY_SIZE(schedInfoData);
+
+  while (lo < hi) {
+    size_t mid = (lo + hi) / 2u;
+    uint32_t midId = schedInfoData[mid].instId;
+
+    if (midId == instId)
+      return &schedInfoData[mid];
+
+    if (midId < instId)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  return nullptr;
+}
+
+Error InstInternal::querySchedInfo(uint32_t arch, const BaseInst& inst, const Operand_* operands, size_t opCount, InstSchedInfo* out) noexcept {
+  DebugUtils::unused(arch, operands, opCount);
+
+  uint32_t instId = inst.id();
+  if (ASMJIT_UNLIKELY(!Inst::isDefinedId(instId)))
+    return DebugUtils::errored(kErrorInvalidInstruction);
+
+  // RW information of LoongArch instructions reports all operands as read,
+  // however, the first operand is the destination of all instructions except
+  // stores and branches (branches are barriers and stores only read it, so
+  // considering it written is conservative).
+  out->reset();
+  out->addFlags(InstSchedInfo::kFlagWriteFirstOp);
+
+  const SchedInfoData* data = schedInfoOf(instId);
+  if (data) {
+    out->addFlags(data->flags);
+    out->setLatency(data->latency);
+  }
+
+  return kErrorOk;
+}
+#endif // !ASMJIT_NO_INTROSPECTION
+
 // ============================================================================
 // [asmjit::a64::InstInternal - Unit]
 // ============================================================================
@@ -250,6 +445,17 @@ Error InstInternal::queryFeatures(uint32_t arch, const BaseInst& inst, const Ope
 UNIT(arm_inst_api_text) {
   // TODO:
 }
+
+UNIT(la64_inst_api_rw_info) {
+  InstRWInfo rwInfo;
+  Operand ops[] = { a0, a1, a2 };
+
+  EXPECT(InstInternal::queryRWInfo(Environment::kArchLOONGARCH64, BaseInst(Inst::kIdAdd_d), ops, 3, &rwInfo) == kErrorOk);
+
+  // ARM leftovers have no LoongArch information.
+  EXPECT(!InstDB::hasInfo(Inst::kIdAdd));
+  EXPECT(InstInternal::queryRWInfo(Environment::kArchLOONGARCH64, BaseInst(Inst::kIdAdd), ops, 3, &rwInfo) == kErrorInvalidInstruction);
+}
 #endif
 
 ASMJIT_END_SUB_NAMESPACE
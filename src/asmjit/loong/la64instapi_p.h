@@ -47,6 +47,7 @@ Error validate(uint32_t arch, const BaseInst& inst, const Operand_* operands, si
 #ifndef ASMJIT_NO_INTROSPECTION
 Error queryRWInfo(uint32_t arch, const BaseInst& inst, const Operand_* operands, size_t opCount, InstRWInfo* out) noexcept;
 Error queryFeatures(uint32_t arch, const BaseInst& inst, const Operand_* operands, size_t opCount, BaseFeatures* out) noexcept;
+Error querySchedInfo(uint32_t arch, const BaseInst& inst, const Operand_* operands, size_t opCount, InstSchedInfo* out) noexcept;
 #endif // !ASMJIT_NO_INTROSPECTION
 
 } // {InstInternal}
@@ -1895,6 +1895,8 @@ const InstInfo _instInfoLTable[] = {
   INSTL(xvfcmp_sune_d,  lasxXXX, (0b00001100101011001, 0, 5, 10, 0), 0, 0, 411, 18398), //xvfcmp.sune.d
 };
 
+const uint32_t _instInfoLTableSize = ASMJIT_ARRAY_SIZE(_instInfoLTable);
+
 
 #undef F
 #undef INST
@@ -82,14 +82,21 @@ struct InstInfo {
 
 ASMJIT_VARAPI const InstInfo _instInfoTable[];
 ASMJIT_VARAPI const InstInfo _instInfoLTable[];
+//! Number of entries of `_instInfoLTable`.
+ASMJIT_VARAPI const uint32_t _instInfoLTableSize;
+
+//! Tests whether the instruction `instId` has an entry in `_instInfoLTable`.
+//! Ids that follow the last LoongArch instruction are ARM leftovers, which
+//! are defined, but have no information.
+static inline bool hasInfo(uint32_t instId) noexcept { return instId < _instInfoLTableSize; }
 
 static inline const InstInfo& infoById(uint32_t instId) noexcept {
-  ASMJIT_ASSERT(Inst::isDefinedId(instId));
+  ASMJIT_ASSERT(hasInfo(instId));
   return _instInfoLTable[instId];
 }
 
 static inline const InstInfo& infoLById(uint32_t instId) noexcept {
-  ASMJIT_ASSERT(Inst::isDefinedId(instId));
+  ASMJIT_ASSERT(hasInfo(instId));
   return _instInfoLTable[instId];
 }
 
@@ -0,0 +1,166 @@
+// AsmJit - Machine code generation for C++
+//
+//  * Official AsmJit Home Page: https://asmjit.com
+//  * Official Github Repository: https://github.com/asmjit/asmjit
+//
+// Copyright (c) 2008-2020 The AsmJit Authors
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#include "../core/api-build_p.h"
+#if !defined(ASMJIT_NO_LOONG) && !defined(ASMJIT_NO_BUILDER)
+
+#include "../loong/la64globals.h"
+#include "../loong/la64operand.h"
+#include "../loong/la64peepholepass.h"
+
+ASMJIT_BEGIN_SUB_NAMESPACE(la64)
+
+// ============================================================================
+// [asmjit::la64::PeepholePass - Helpers]
+// ============================================================================
+
+static ASMJIT_INLINE bool PeepholePass_isSameReg(const Operand& a, const Operand& b) noexcept {
+  return a.isReg() && b.isReg() && a.as<BaseReg>().isSame(b.as<BaseReg>());
+}
+
+static ASMJIT_INLINE bool PeepholePass_isZeroReg(const Operand& op) noexcept {
+  return op.isReg() && op.as<BaseReg>().isGp() && op.id() == Gp::kIdZr;
+}
+
+static ASMJIT_INLINE bool PeepholePass_isZeroImm(const Operand& op) noexcept {
+  return op.isImm() && op.as<Imm>().value() == 0;
+}
+
+// ============================================================================
+// [asmjit::la64::PeepholePass - Construction / Destruction]
+// ============================================================================
+
+PeepholePass::PeepholePass() noexcept
+  : BasePeepholePass("LA64PeepholePass") {}
+PeepholePass::~PeepholePass() noexcept {}
+
+// ============================================================================
+// [asmjit::la64::PeepholePass - Peephole Interface]
+// ============================================================================
+
+uint32_t PeepholePass::jumpTypeOf(const InstNode* node) const noexcept {
+  uint32_t opCount = node->opCount();
+  if (!opCount || !node->op(opCount - 1).isLabel())
+    return kJumpNone;
+
+  // BL and JIRL write the link register, so they are never reported.
+  switch (node->id()) {
+    case Inst::kIdB:
+      return kJumpUnconditional;
+
+    case Inst::kIdBeq:
+    case Inst::kIdBne:
+    case Inst::kIdBlt:
+    case Inst::kIdBge:
+    case Inst::kIdBltu:
+    case Inst::kIdBgeu:
+    case Inst::kIdBceqz:
+    case Inst::kIdBcnez:
+      return kJumpConditional;
+
+    default:
+      return kJumpNone;
+  }
+}
+
+bool PeepholePass::isRedundantInst(const InstNode* node, uint32_t* ruleOut) const noexcept {
+  uint32_t opCount = node->opCount();
+  if (opCount < 2)
+    return false;
+
+  const Operand& o0 = node->op(0);
+  const Operand& o1 = node->op(1);
+
+  if (!o0.isReg() || PeepholePass_isZeroReg(o0))
+    return false;
+
+  if (opCount == 2) {
+    if (node->id() == Inst::kIdFmov_d && PeepholePass_isSameReg(o0, o1)) {
+      *ruleOut = kRuleRedundantMove;
+      return true;
+    }
+    return false;
+  }
+
+  if (opCount != 3)
+    return false;
+
+  const Operand& o2 = node->op(2);
+
+  switch (node->id()) {
+    // `move rd, rj` is an alias of `or rd, rj, zero`.
+    case Inst::kIdOr_:
+      if ((PeepholePass_isSameReg(o0, o1) && (PeepholePass_isZeroReg(o2) || PeepholePass_isSameReg(o0, o2))) ||
+          (PeepholePass_isSameReg(o0, o2) && PeepholePass_isZeroReg(o1))) {
+        *ruleOut = kRuleRedundantMove;
+        return true;
+      }
+      return false;
+
+    case Inst::kIdAdd_d:
+      if ((PeepholePass_isSameReg(o0, o1) && PeepholePass_isZeroReg(o2)) ||
+          (PeepholePass_isSameReg(o0, o2) && PeepholePass_isZeroReg(o1))) {
+        *ruleOut = kRuleIdentityOp;
+        return true;
+      }
+      return false;
+
+    case Inst::kIdSub_d:
+      if (PeepholePass_isSameReg(o0, o1) && PeepholePass_isZeroReg(o2)) {
+        *ruleOut = kRuleIdentityOp;
+        return true;
+      }
+      return false;
+
+    case Inst::kIdAddi_d:
+    case Inst::kIdOri:
+    case Inst::kIdXori:
+    case Inst::kIdSlli_d:
+    case Inst::kIdSrli_d:
+    case Inst::kIdSrai_d:
+    case Inst::kIdRotri_d:
+      if (PeepholePass_isSameReg(o0, o1) && PeepholePass_isZeroImm(o2)) {
+        *ruleOut = kRuleIdentityOp;
+        return true;
+      }
+      return false;
+
+    default:
+      return false;
+  }
+}
+
+// ============================================================================
+// [asmjit::la64::PeepholePass - Run]
+// ============================================================================
+
+Error PeepholePass::run(Zone* zone, Logger* logger) {
+  if (!Environment::isFamilyLOONGARCH(_cb->arch()))
+    return DebugUtils::errored(kErrorInvalidArch);
+
+  return Base::run(zone, logger);
+}
+
+ASMJIT_END_SUB_NAMESPACE
+
+#endif // !ASMJIT_NO_LOONG && !ASMJIT_NO_BUILDER
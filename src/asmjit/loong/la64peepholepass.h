@@ -0,0 +1,84 @@
+// AsmJit - Machine code generation for C++
+//
+//  * Official AsmJit Home Page: https://asmjit.com
+//  * Official Github Repository: https://github.com/asmjit/asmjit
+//
+// Copyright (c) 2008-2020 The AsmJit Authors
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#ifndef ASMJIT_LOONG_LA64PEEPHOLEPASS_H_INCLUDED
+#define ASMJIT_LOONG_LA64PEEPHOLEPASS_H_INCLUDED
+
+#include "../core/api-config.h"
+#ifndef ASMJIT_NO_BUILDER
+
+#include "../core/peepholepass.h"
+
+ASMJIT_BEGIN_SUB_NAMESPACE(la64)
+
+//! \addtogroup asmjit_la64
+//! \{
+
+// ============================================================================
+// [asmjit::la64::PeepholePass]
+// ============================================================================
+
+//! LoongArch64 peephole optimization pass.
+//!
+//! In addition to jump rules provided by \ref BasePeepholePass it removes:
+//!
+//!   - Moves of a register to itself (`or a0, a0, zero`, `fmov.d fa0, fa0`).
+//!   - 64-bit operations that don't change their destination (`addi.d a0, a0, 0`,
+//!     `slli.d a0, a0, 0`, `add.d a0, a0, zero`, ...).
+//!
+//! 32-bit operations are never removed as they sign extend their result.
+class ASMJIT_VIRTAPI PeepholePass : public BasePeepholePass {
+public:
+  ASMJIT_NONCOPYABLE(PeepholePass)
+  typedef BasePeepholePass Base;
+
+  //! \name Construction & Destruction
+  //! \{
+
+  ASMJIT_API PeepholePass() noexcept;
+  ASMJIT_API virtual ~PeepholePass() noexcept;
+
+  //! \}
+
+  //! \name Peephole Interface
+  //! \{
+
+  ASMJIT_API uint32_t jumpTypeOf(const InstNode* node) const noexcept override;
+  ASMJIT_API bool isRedundantInst(const InstNode* node, uint32_t* ruleOut) const noexcept override;
+
+  //! \}
+
+  //! \name Pass Interface
+  //! \{
+
+  ASMJIT_API Error run(Zone* zone, Logger* logger) override;
+
+  //! \}
+};
+
+//! \}
+
+ASMJIT_END_SUB_NAMESPACE
+
+#endif // !ASMJIT_NO_BUILDER
+#endif // ASMJIT_LOONG_LA64PEEPHOLEPASS_H_INCLUDED
@@ -73,6 +73,32 @@ static ASMJIT_INLINE uint32_t raRegRwFlags(uint32_t flags) noexcept {
   return raUseOutFlagsFromRWFlags(flags);
 }
 
+//! Tests whether `instId` with the given operands defines its first operand from
+//! constants only (immediates and the zero register), so it can be emitted again.
+static ASMJIT_INLINE bool raIsRematerializable(uint32_t instId, const Operand* opArray, uint32_t opCount) noexcept {
+  switch (instId) {
+    case Inst::kIdAddi_d:
+    case Inst::kIdAddi_w:
+    case Inst::kIdLu12i_w:
+    case Inst::kIdOri:
+      break;
+
+    default:
+      return false;
+  }
+
+  if (!opCount || !opArray[0].isReg())
+    return false;
+
+  for (uint32_t i = 1; i < opCount; i++) {
+    const Operand& op = opArray[i];
+    if (!op.isImm() && !(op.isReg() && op.as<Gp>().isPhysReg() && op.as<Gp>().isZR()))
+      return false;
+  }
+
+  return true;
+}
+
 static ASMJIT_INLINE uint32_t raMemBaseRwFlags(uint32_t flags) noexcept {
   constexpr uint32_t shift = Support::constCtz(OpRWInfo::kMemBaseRW);
   return raUseOutFlagsFromRWFlags((flags >> shift) & OpRWInfo::kRW);
@@ -223,6 +249,7 @@ Error RACFGBuilder::onInst(InstNode* inst, uint32_t& controlType, RAInstBuilder&
           if (mem.isRegHome()) {
             RAWorkReg* workReg;
             ASMJIT_PROPAGATE(_pass->virtIndexAsWorkReg(Operand::virtIdToIndex(mem.baseId()), &workReg));
+            workReg->addFlags(RAWorkReg::kFlagStackReferenced);
             _pass->getOrCreateStackSlot(workReg);
           }
           else if (mem.hasBaseReg()) {
@@ -279,6 +306,10 @@ Error RACFGBuilder::onInst(InstNode* inst, uint32_t& controlType, RAInstBuilder&
       }
     }
 
+    // Rematerializable definition of the only register used by the instruction.
+    if (ib.tiedRegCount() == 1 && ib[0]->isWriteOnly() && raIsRematerializable(instId, opArray, opCount))
+      ib.addAggregatedFlags(RAInst::kFlagIsRematerializable);
+
     // controlType = instInfo.controlType();
     controlType = getControlType(instId, inst->instOptions());
   }
@@ -596,6 +627,7 @@ void ARMRAPass::onInit() noexcept {
   makeUnavailable(Reg::kGroupGp, Gp::kIdSp);
   //makeUnavailable(Reg::kGroupGp, Gp::kIdOs); // OS-specific use, usually TLS.
   makeUnavailable(Reg::kGroupGp, Gp::kIdTp); // OS-specific use, usually TLS.
+  makeUnavailable(Reg::kGroupGp, 20);        // T8 is clobbered by long branches emitted by the assembler.
 
   _sp = sp;
   _fp = fp;
@@ -603,6 +635,10 @@ void ARMRAPass::onInit() noexcept {
 
 void ARMRAPass::onDone() noexcept {}
 
+BaseRAPass* ARMRAPass::newWorker(Zone* zone) noexcept {
+  return zone->newT<ARMRAPass>();
+}
+
 // ============================================================================
 // [asmjit::a64::ARMRAPass - BuildCFG]
 // ============================================================================
@@ -78,6 +78,7 @@ public:
 
   void onInit() noexcept override;
   void onDone() noexcept override;
+  BaseRAPass* newWorker(Zone* zone) noexcept override;
 
   // --------------------------------------------------------------------------
   // [CFG]
@@ -107,6 +107,7 @@
 
 #include "asmjit-scope-begin.h"
 #include "x86/x86assembler.h"
+#include "x86/x86branchrelaxpass.h"
 #include "x86/x86builder.h"
 #include "x86/x86compiler.h"
 #include "x86/x86emitter.h"
@@ -114,6 +115,7 @@
 #include "x86/x86globals.h"
 #include "x86/x86instdb.h"
 #include "x86/x86operand.h"
+#include "x86/x86peepholepass.h"
 #include "asmjit-scope-end.h"
 
 #endif // ASMJIT_X86_H_INCLUDED
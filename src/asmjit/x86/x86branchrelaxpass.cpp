@@ -0,0 +1,274 @@
+// AsmJit - Machine code generation for C++
+//
+//  * Official AsmJit Home Page: https://asmjit.com
+//  * Official Github Repository: https://github.com/asmjit/asmjit
+//
+// Copyright (c) 2008-2020 The AsmJit Authors
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+
+#include "../core/api-build_p.h"
+#if !defined(ASMJIT_NO_X86) && !defined(ASMJIT_NO_BUILDER)
+
+#include "../core/logger.h"
+#include "../core/zonevector.h"
+#include "../x86/x86assembler.h"
+#include "../x86/x86branchrelaxpass.h"
+
+ASMJIT_BEGIN_SUB_NAMESPACE(x86)
+
+// ============================================================================
+// [asmjit::x86::BranchRelaxPass - Layout]
+// ============================================================================
+
+static constexpr uint32_t kRelaxNone = 0xFFFFFFFFu;
+
+//! Item of a code layout - everything the assembler would emit, in order.
+struct RelaxItem {
+  enum Type : uint32_t {
+    //! Code or data of a fixed size (`value` is the size).
+    kTypeFixed = 0,
+    //! Alignment (`value` is the alignment).
+    kTypeAlign = 1,
+    //! Label binding (`value` is the label id).
+    kTypeLabel = 2,
+    //! Section switch (`value` is the section id).
+    kTypeSection = 3,
+    //! Jump that can be relaxed (`value` is the index to `RelaxJump` array).
+    kTypeJump = 4
+  };
+
+  uint32_t type;
+  uint32_t value;
+};
+
+//! Jump that can be encoded with both 8-bit and 32-bit displacement.
+struct RelaxJump {
+  InstNode* node;
+  uint32_t labelId;
+  uint32_t sectionId;
+  uint64_t offset;
+  uint8_t shortSize;
+  uint8_t longSize;
+  bool isShort;
+};
+
+static ASMJIT_INLINE bool BranchRelaxPass_isRelaxable(const InstNode* node) noexcept {
+  uint32_t instId = node->id();
+  uint32_t opCount = node->opCount();
+
+  // JECXZ only has a short form, all other instructions in the JA..JZ range do have both.
+  if (instId != Inst::kIdJmp && (instId < Inst::kIdJa || instId > Inst::kIdJz || instId == Inst::kIdJecxz))
+    return false;
+
+  return opCount == 1 &&
+         node->op(0).isLabel() &&
+         !(node->instOptions() & (Inst::kOptionShortForm | Inst::kOptionLongForm));
+}
+
+// ============================================================================
+// [asmjit::x86::BranchRelaxPass - Construction / Destruction]
+// ============================================================================
+
+BranchRelaxPass::BranchRelaxPass() noexcept
+  : Pass("X86BranchRelaxPass") {}
+BranchRelaxPass::~BranchRelaxPass() noexcept {}
+
+// ============================================================================
+// [asmjit::x86::BranchRelaxPass - Run]
+// ============================================================================
+
+Error BranchRelaxPass::run(Zone* zone, Logger* logger) {
+  if (!Environment::isFamilyX86(_cb->arch()))
+    return DebugUtils::errored(kErrorInvalidArch);
+
+  CodeHolder* code = _cb->code();
+  ZoneAllocator allocator(zone);
+
+  ZoneVector<RelaxItem> items;
+  ZoneVector<RelaxJump> jumps;
+  ZoneVector<uint32_t> labelSections;
+  ZoneVector<uint64_t> labelOffsets;
+  ZoneVector<uint64_t> sectionOffsets;
+
+  _relaxedCount = 0;
+  _jumpCount = 0;
+
+  // Instructions are measured by encoding them by a scratch assembler, which
+  // has the same labels as `code`, but none of them is bound, so all jumps are
+  // encoded with the displacement size given by their options.
+  CodeHolder scratch;
+  ASMJIT_PROPAGATE(scratch.init(code->environment(), code->baseAddress()));
+
+  for (uint32_t i = 0; i < code->labelCount(); i++) {
+    LabelEntry* le;
+    ASMJIT_PROPAGATE(scratch.newLabelEntry(&le));
+  }
+
+  Assembler a(&scratch);
+  a.addEncodingOptions(_cb->encodingOptions());
+  a.addValidationOptions(_cb->validationOptions());
+
+  for (BaseNode* node = _cb->firstNode(); node; node = node->next()) {
+    if (node->isInst()) {
+      InstNode* inst = node->as<InstNode>();
+
+      size_t start = a.offset();
+      ASMJIT_PROPAGATE(a.emitInst(inst->baseInst(), inst->operands(), inst->opCount()));
+      size_t longSize = a.offset() - start;
+
+      if (BranchRelaxPass_isRelaxable(inst)) {
+        BaseInst shortInst(inst->baseInst());
+        shortInst.addOptions(Inst::kOptionShortForm);
+
+        start = a.offset();
+        ASMJIT_PROPAGATE(a.emitInst(shortInst, inst->operands(), inst->opCount()));
+        size_t shortSize = a.offset() - start;
+
+        if (shortSize < longSize) {
+          RelaxJump jump { inst, inst->op(0).id(), kRelaxNone, 0, uint8_t(shortSize), uint8_t(longSize), true };
+          ASMJIT_PROPAGATE(items.append(&allocator, RelaxItem { RelaxItem::kTypeJump, jumps.size() }));
+          ASMJIT_PROPAGATE(jumps.append(&allocator, jump));
+          continue;
+        }
+      }
+
+      ASMJIT_PROPAGATE(items.append(&allocator, RelaxItem { RelaxItem::kTypeFixed, uint32_t(longSize) }));
+    }
+    else if (node->isLabel()) {
+      if (node->isConstPool()) {
+        ConstPoolNode* constPool = node->as<ConstPoolNode>();
+        ASMJIT_PROPAGATE(items.append(&allocator, RelaxItem { RelaxItem::kTypeAlign, uint32_t(constPool->constPool().alignment()) }));
+        ASMJIT_PROPAGATE(items.append(&allocator, RelaxItem { RelaxItem::kTypeLabel, constPool->labelId() }));
+        ASMJIT_PROPAGATE(items.append(&allocator, RelaxItem { RelaxItem::kTypeFixed, uint32_t(constPool->constPool().size()) }));
+      }
+      else {
+        ASMJIT_PROPAGATE(items.append(&allocator, RelaxItem { RelaxItem::kTypeLabel, node->as<LabelNode>()->labelId() }));
+      }
+    }
+    else if (node->isAlign()) {
+      ASMJIT_PROPAGATE(items.append(&allocator, RelaxItem { RelaxItem::kTypeAlign, node->as<AlignNode>()->alignment() }));
+    }
+    else if (node->isEmbedData()) {
+      EmbedDataNode* embed = node->as<EmbedDataNode>();
+      ASMJIT_PROPAGATE(items.append(&allocator, RelaxItem { RelaxItem::kTypeFixed, uint32_t(embed->dataSize() * embed->repeatCount()) }));
+    }
+    else if (node->isEmbedLabel()) {
+      ASMJIT_PROPAGATE(items.append(&allocator, RelaxItem { RelaxItem::kTypeFixed, node->as<EmbedLabelNode>()->dataSize() }));
+    }
+    else if (node->isEmbedLabelDelta()) {
+      ASMJIT_PROPAGATE(items.append(&allocator, RelaxItem { RelaxItem::kTypeFixed, node->as<EmbedLabelDeltaNode>()->dataSize() }));
+    }
+    else if (node->isSection()) {
+      ASMJIT_PROPAGATE(items.append(&allocator, RelaxItem { RelaxItem::kTypeSection, node->as<SectionNode>()->id() }));
+    }
+  }
+
+  _jumpCount = jumps.size();
+  if (jumps.empty())
+    return kErrorOk;
+
+  ASMJIT_PROPAGATE(labelSections.resize(&allocator, code->labelCount()));
+  ASMJIT_PROPAGATE(labelOffsets.resize(&allocator, code->labelCount()));
+  ASMJIT_PROPAGATE(sectionOffsets.resize(&allocator, code->sectionCount()));
+
+  // Start with all jumps short and use the long form for each jump, which
+  // displacement doesn't fit into 8 bits, until the layout doesn't change.
+  // Jumps never become short again, so the number of iterations is bounded.
+  bool changed;
+  do {
+    for (uint32_t& sectionId : labelSections)
+      sectionId = kRelaxNone;
+
+    // The assembler appends to the code each section already holds, which
+    // matters when the code is aligned. Labels bound by previous emitters are
+    // not tracked, so jumps to them are always long.
+    for (uint32_t i = 0; i < sectionOffsets.size(); i++)
+      sectionOffsets[i] = code->sectionById(i)->bufferSize();
+
+    uint32_t sectionId = 0;
+    uint64_t offset = sectionOffsets[0];
+
+    for (const RelaxItem& item : items) {
+      switch (item.type) {
+        case RelaxItem::kTypeFixed:
+          offset += item.value;
+          break;
+
+        case RelaxItem::kTypeAlign:
+          if (item.value > 1)
+            offset = Support::alignUp<uint64_t>(offset, item.value);
+          break;
+
+        case RelaxItem::kTypeLabel:
+          labelSections[item.value] = sectionId;
+          labelOffsets[item.value] = offset;
+          break;
+
+        case RelaxItem::kTypeSection:
+          sectionOffsets[sectionId] = offset;
+          sectionId = item.value;
+          offset = sectionOffsets[sectionId];
+          break;
+
+        case RelaxItem::kTypeJump: {
+          RelaxJump& jump = jumps[item.value];
+          jump.sectionId = sectionId;
+          jump.offset = offset;
+          offset += jump.isShort ? jump.shortSize : jump.longSize;
+          break;
+        }
+      }
+    }
+
+    changed = false;
+    for (RelaxJump& jump : jumps) {
+      if (!jump.isShort)
+        continue;
+
+      bool fits = false;
+      if (labelSections[jump.labelId] == jump.sectionId) {
+        int64_t displacement = int64_t(labelOffsets[jump.labelId] - (jump.offset + jump.shortSize));
+        fits = Support::isInt8(displacement);
+      }
+
+      if (!fits) {
+        jump.isShort = false;
+        changed = true;
+      }
+    }
+  } while (changed);
+
+  for (RelaxJump& jump : jumps) {
+    jump.node->addInstOptions(jump.isShort ? Inst::kOptionShortForm : Inst::kOptionLongForm);
+    _relaxedCount += uint32_t(jump.isShort);
+  }
+
+#ifndef ASMJIT_NO_LOGGING
+  if (logger && logger->hasFlag(FormatOptions::kFlagDebugPasses))
+    logger->logf("[%s] Relaxed %u of %u jumps\n", name(), _relaxedCount, _jumpCount);
+#else
+  DebugUtils::unused(logger);
+#endif
+
+  return kErrorOk;
+}
+
+ASMJIT_END_SUB_NAMESPACE
+
+#endif // !ASMJIT_NO_X86 && !ASMJIT_NO_BUILDER
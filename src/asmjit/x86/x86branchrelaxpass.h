@@ -0,0 +1,101 @@
+// AsmJit - Machine code generation for C++
+//
+//  * Official AsmJit Home Page: https://asmjit.com
+//  * Official Github Repository: https://github.com/asmjit/asmjit
+//
+// Copyright (c) 2008-2020 The AsmJit Authors
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#ifndef ASMJIT_X86_X86BRANCHRELAXPASS_H_INCLUDED
+#define ASMJIT_X86_X86BRANCHRELAXPASS_H_INCLUDED
+
+#include "../core/api-config.h"
+#ifndef ASMJIT_NO_BUILDER
+
+#include "../core/builder.h"
+
+ASMJIT_BEGIN_SUB_NAMESPACE(x86)
+
+//! \addtogroup asmjit_x86
+//! \{
+
+// ============================================================================
+// [asmjit::x86::BranchRelaxPass]
+// ============================================================================
+
+//! X86/X64 branch relaxation pass.
+//!
+//! Assembler is single-pass, so it encodes each jump to a label that is not
+//! bound yet with a 32-bit displacement unless \ref Inst::kOptionShortForm
+//! is used. This pass calculates the layout of the code before it's passed to
+//! the assembler and marks each JMP and Jcc instruction, which target is close
+//! enough, by \ref Inst::kOptionShortForm so it's encoded with an 8-bit
+//! displacement. Other jumps are marked by \ref Inst::kOptionLongForm so the
+//! final layout is exactly the layout calculated by the pass. The layout of
+//! each section starts at the end of the code the section already holds.
+//!
+//! Jumps that already use \ref Inst::kOptionShortForm or \ref Inst::kOptionLongForm
+//! are not changed. The pass must be the last pass that changes the code, so
+//! when used with \ref BaseCompiler it must be added after all other passes:
+//!
+//! ```
+//! x86::Compiler cc(&code);
+//! cc.addPassT<x86::BranchRelaxPass>();
+//! ```
+class ASMJIT_VIRTAPI BranchRelaxPass : public Pass {
+public:
+  ASMJIT_NONCOPYABLE(BranchRelaxPass)
+  typedef Pass Base;
+
+  //! Number of jumps relaxed to short form by the last run.
+  uint32_t _relaxedCount = 0;
+  //! Number of jumps considered by the last run.
+  uint32_t _jumpCount = 0;
+
+  //! \name Construction & Destruction
+  //! \{
+
+  ASMJIT_API BranchRelaxPass() noexcept;
+  ASMJIT_API virtual ~BranchRelaxPass() noexcept;
+
+  //! \}
+
+  //! \name Accessors
+  //! \{
+
+  //! Returns the number of jumps relaxed to short form by the last run.
+  inline uint32_t relaxedCount() const noexcept { return _relaxedCount; }
+  //! Returns the number of jumps considered by the last run.
+  inline uint32_t jumpCount() const noexcept { return _jumpCount; }
+
+  //! \}
+
+  //! \name Pass Interface
+  //! \{
+
+  ASMJIT_API Error run(Zone* zone, Logger* logger) override;
+
+  //! \}
+};
+
+//! \}
+
+ASMJIT_END_SUB_NAMESPACE
+
+#endif // !ASMJIT_NO_BUILDER
+#endif // ASMJIT_X86_X86BRANCHRELAXPASS_H_INCLUDED
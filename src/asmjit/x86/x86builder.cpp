@@ -24,8 +24,11 @@
 #include "../core/api-build_p.h"
 #if !defined(ASMJIT_NO_X86) && !defined(ASMJIT_NO_BUILDER)
 
+#include "../core/schedpass.h"
 #include "../x86/x86assembler.h"
+#include "../x86/x86branchrelaxpass.h"
 #include "../x86/x86builder.h"
+#include "../x86/x86peepholepass.h"
 
 ASMJIT_BEGIN_SUB_NAMESPACE(x86)
 
@@ -63,6 +66,243 @@ Error Builder::onAttach(CodeHolder* code) noexcept {
   return Base::onAttach(code);
 }
 
+// ============================================================================
+// [asmjit::x86::Builder - Unit]
+// ============================================================================
+
+#if defined(ASMJIT_TEST)
+UNIT(x86_builder_branch_relax_pass) {
+  Environment env(Environment::kArchX64);
+  CodeHolder code;
+  code.init(env);
+
+  Builder cb(&code);
+  BranchRelaxPass* pass = cb.newPassT<BranchRelaxPass>();
+  EXPECT(cb.addPass(pass) == kErrorOk);
+
+  static const uint8_t padding[1] = { 0xCC };
+
+  Label L_Near = cb.newLabel();
+  Label L_Edge = cb.newLabel();
+  Label L_Far = cb.newLabel();
+
+  cb.jmp(L_Edge);                                    // [0] Relaxed, 2 bytes (displacement 127).
+  cb.jz(L_Near);                                     // [2] Relaxed, 2 bytes.
+  cb.jnz(L_Far);                                     // [4] Kept, 6 bytes.
+  cb.bind(L_Near);
+  cb.embedDataArray(Type::kIdU8, padding, 1, 119);   // [10] 119 bytes.
+  cb.bind(L_Edge);
+  cb.align(kAlignCode, 16);                          // [129] 15 bytes.
+  cb.embedDataArray(Type::kIdU8, padding, 1, 200);   // [144] 200 bytes.
+  cb.bind(L_Far);
+  cb.ret();                                          // [344] 1 byte.
+  cb.jmp(L_Near);                                    // [345] Backward, kept, 5 bytes.
+
+  EXPECT(cb.finalize() == kErrorOk);
+  EXPECT(pass->jumpCount() == 4);
+  EXPECT(pass->relaxedCount() == 2);
+
+  const CodeBuffer& buf = code.textSection()->buffer();
+  EXPECT(buf.size() == 350);
+  EXPECT(buf[0] == 0xEB && buf[1] == 0x7F);
+  EXPECT(buf[2] == 0x74 && buf[3] == 0x06);
+  EXPECT(buf[4] == 0x0F && buf[5] == 0x85);
+  EXPECT(buf[345] == 0xE9);
+}
+
+UNIT(x86_builder_branch_relax_pass_nonempty_section) {
+  Environment env(Environment::kArchX64);
+  CodeHolder code;
+  code.init(env);
+
+  {
+    Assembler a(&code);
+    a.embedUInt8(0xCC, 63);
+  }
+
+  Builder cb(&code);
+  BranchRelaxPass* pass = cb.newPassT<BranchRelaxPass>();
+  EXPECT(cb.addPass(pass) == kErrorOk);
+
+  static const uint8_t padding[1] = { 0xCC };
+  Label L_Far = cb.newLabel();
+
+  cb.jmp(L_Far);                                     // [63] Kept, 5 bytes (displacement 128).
+  cb.align(kAlignCode, 64);                          // [68] 60 bytes.
+  cb.embedDataArray(Type::kIdU8, padding, 1, 65);    // [128] 65 bytes.
+  cb.bind(L_Far);
+  cb.ret();                                          // [193] 1 byte.
+
+  EXPECT(cb.finalize() == kErrorOk);
+  EXPECT(pass->jumpCount() == 1);
+  EXPECT(pass->relaxedCount() == 0);
+
+  const CodeBuffer& buf = code.textSection()->buffer();
+  EXPECT(buf.size() == 194);
+  EXPECT(buf[63] == 0xE9);
+}
+
+UNIT(x86_builder_peephole_pass) {
+  Environment env(Environment::kArchX64);
+  CodeHolder code;
+  code.init(env);
+
+  Builder cb(&code);
+  PeepholePass* pass = cb.newPassT<PeepholePass>();
+  EXPECT(cb.addPass(pass) == kErrorOk);
+
+  Label L_Next = cb.newLabel();
+  Label L_Chain = cb.newLabel();
+
+  cb.mov(rax, rax);       // Removed.
+  cb.mov(eax, eax);       // Kept, clears the upper 32 bits of RAX.
+  cb.movaps(xmm1, xmm1);  // Removed.
+  cb.shl(rcx, 0);         // Removed.
+  cb.add(rdx, 0);         // Removed, CMP overwrites all flags it writes.
+  cb.cmp(rdx, rcx);
+  cb.add(rsi, 0);         // Kept, flags are read by JZ (and then by the code at L_Next).
+  cb.jz(L_Chain);         // Retargeted to L_Next, and then removed.
+  cb.jmp(L_Next);         // Removed.
+  cb.bind(L_Next);
+  cb.ret();
+  cb.bind(L_Chain);
+  cb.jmp(L_Next);
+
+  EXPECT(cb.runPasses() == kErrorOk);
+
+  static const uint32_t expectedIds[] = {
+    Inst::kIdMov, Inst::kIdCmp, Inst::kIdAdd, Inst::kIdRet, Inst::kIdJmp
+  };
+
+  uint32_t count = 0;
+  for (BaseNode* node = cb.firstNode(); node; node = node->next()) {
+    if (!node->isInst())
+      continue;
+
+    InstNode* inst = node->as<InstNode>();
+    EXPECT(count < ASMJIT_ARRAY_SIZE(expectedIds));
+    EXPECT(inst->id() == expectedIds[count],
+           "Instruction #%u has an unexpected id %u", count, inst->id());
+    count++;
+  }
+  EXPECT(count == ASMJIT_ARRAY_SIZE(expectedIds));
+
+  EXPECT(pass->ruleCounter(PeepholePass::kRuleRedundantMove) == 2);
+  EXPECT(pass->ruleCounter(PeepholePass::kRuleIdentityOp) == 2);
+  EXPECT(pass->ruleCounter(PeepholePass::kRuleJumpToNext) == 2);
+  EXPECT(pass->ruleCounter(PeepholePass::kRuleJumpChain) == 1);
+}
+
+UNIT(x86_builder_peephole_pass_short_jumps) {
+  Environment env(Environment::kArchX64);
+  CodeHolder code;
+  code.init(env);
+
+  Builder cb(&code);
+  PeepholePass* pass = cb.newPassT<PeepholePass>();
+  EXPECT(cb.addPass(pass) == kErrorOk);
+
+  Label L_Chain = cb.newLabel();
+  Label L_Far = cb.newLabel();
+
+  cb.jecxz(rcx, L_Chain);     // Kept, JECXZ only has a rel8 form.
+  cb.short_().jnz(L_Chain);   // Kept, forced to use a rel8 form.
+  cb.short_().jmp(L_Chain);   // Kept, forced to use a rel8 form.
+  cb.jz(L_Chain);             // Retargeted to L_Far.
+  cb.bind(L_Chain);
+  cb.jmp(L_Far);
+  cb.embedUInt8(0x90, 200);
+  cb.bind(L_Far);
+  cb.ret();
+
+  EXPECT(cb.runPasses() == kErrorOk);
+
+  static const uint32_t expectedIds[] = { Inst::kIdJecxz, Inst::kIdJnz, Inst::kIdJmp, Inst::kIdJz };
+  static const uint32_t expectedTargets[] = { L_Chain.id(), L_Chain.id(), L_Chain.id(), L_Far.id() };
+
+  uint32_t count = 0;
+  for (BaseNode* node = cb.firstNode(); node && count < ASMJIT_ARRAY_SIZE(expectedIds); node = node->next()) {
+    if (!node->isInst())
+      continue;
+
+    InstNode* inst = node->as<InstNode>();
+    EXPECT(inst->id() == expectedIds[count],
+           "Instruction #%u has an unexpected id %u", count, inst->id());
+    EXPECT(inst->op(inst->opCount() - 1).id() == expectedTargets[count],
+           "Instruction #%u has an unexpected target", count);
+    count++;
+  }
+  EXPECT(count == ASMJIT_ARRAY_SIZE(expectedIds));
+
+  EXPECT(pass->ruleCounter(PeepholePass::kRuleJumpChain) == 1);
+  EXPECT(cb.finalize() == kErrorOk);
+}
+#endif
+
+#if defined(ASMJIT_TEST) && !defined(ASMJIT_NO_INTROSPECTION)
+UNIT(x86_builder_sched_pass) {
+  Environment env(Environment::kArchX64);
+  CodeHolder code;
+  code.init(env);
+
+  Builder cb(&code);
+  EXPECT(cb.addPassT<SchedPass>() == kErrorOk);
+
+  // Two dependency chains emitted back-to-back, followed by a store and a
+  // load, which must stay in order as they can alias.
+  cb.imul(eax, ecx);
+  cb.add(eax, 1);
+  cb.imul(edx, ecx);
+  cb.add(edx, 1);
+  cb.mov(ptr(rdi), eax);
+  cb.mov(ebx, ptr(rsi));
+
+  // Nothing is moved across a label.
+  cb.bind(cb.newLabel());
+  cb.imul(eax, ecx);
+  cb.add(eax, 1);
+  cb.ret();
+
+  // ROL only writes CF and OF, so JNZ must still see ZF written by DEC.
+  Label L0 = cb.newLabel();
+  cb.bind(L0);
+  cb.imul(eax, eax);
+  cb.add(eax, ebx);
+  cb.dec(ecx);
+  cb.rol(edx, 3);
+  cb.jnz(L0);
+
+  EXPECT(cb.runPasses() == kErrorOk);
+
+  static const uint32_t expectedIds[] = {
+    Inst::kIdImul, Inst::kIdImul, Inst::kIdAdd, Inst::kIdMov, Inst::kIdMov, Inst::kIdAdd,
+    Inst::kIdImul, Inst::kIdAdd, Inst::kIdRet,
+    Inst::kIdImul, Inst::kIdAdd, Inst::kIdDec, Inst::kIdRol, Inst::kIdJnz
+  };
+
+  const Operand expectedOps[] = {
+    eax, edx, eax, ptr(rdi), ebx, edx,
+    eax, eax, Operand(),
+    eax, eax, ecx, edx, L0
+  };
+
+  uint32_t count = 0;
+  for (BaseNode* node = cb.firstNode(); node; node = node->next()) {
+    if (!node->isInst())
+      continue;
+
+    InstNode* inst = node->as<InstNode>();
+    EXPECT(count < ASMJIT_ARRAY_SIZE(expectedIds));
+    EXPECT(inst->id() == expectedIds[count],
+           "Instruction #%u has an unexpected id %u", count, inst->id());
+    EXPECT(inst->op(0) == expectedOps[count],
+           "Instruction #%u has an unexpected first operand", count);
+    count++;
+  }
+  EXPECT(count == ASMJIT_ARRAY_SIZE(expectedIds));
+}
+#endif
+
 ASMJIT_END_SUB_NAMESPACE
 
 #endif // !ASMJIT_NO_X86 && !ASMJIT_NO_BUILDER
@@ -72,6 +72,95 @@ Error Compiler::onAttach(CodeHolder* code) noexcept {
   return kErrorOk;
 }
 
+// ============================================================================
+// [asmjit::x86::Compiler - Unit]
+// ============================================================================
+
+#if defined(ASMJIT_TEST)
+// Emits `funcCount` functions, each calling the previous one in a loop that
+// keeps more values alive than there are registers, and compiles them by
+// using at most `threadCount` threads. The number of threads the register
+// allocator actually used is stored to `usedThreadCount`.
+static Error Compiler_compileTestFunctions(CodeHolder& code, uint32_t funcCount, uint32_t threadCount, uint32_t* usedThreadCount) noexcept {
+  Environment env(Environment::kArchX64);
+  ASMJIT_PROPAGATE(code.init(env));
+
+  Compiler cc(&code);
+  cc.setRAThreadCount(threadCount);
+
+  FuncNode* prevFunc = nullptr;
+  for (uint32_t funcIndex = 0; funcIndex < funcCount; funcIndex++) {
+    FuncNode* func = cc.addFunc(FuncSignatureT<int, int>(CallConv::kIdHost));
+
+    Gp arg = cc.newInt32("arg");
+    Gp counter = cc.newInt32("counter");
+    Gp values[20];
+
+    cc.setArg(0, arg);
+    cc.mov(counter, arg);
+
+    for (uint32_t i = 0; i < ASMJIT_ARRAY_SIZE(values); i++) {
+      values[i] = cc.newInt32("v%u", i);
+      cc.lea(values[i], ptr(arg, int32_t(i + funcIndex)));
+    }
+
+    Label L_Loop = cc.newLabel();
+    cc.bind(L_Loop);
+
+    for (uint32_t i = 1; i < ASMJIT_ARRAY_SIZE(values); i++)
+      cc.add(values[i], values[i - 1]);
+
+    if (prevFunc) {
+      InvokeNode* invokeNode;
+      cc.invoke(&invokeNode, prevFunc->label(), FuncSignatureT<int, int>(CallConv::kIdHost));
+      invokeNode->setArg(0, values[funcIndex % ASMJIT_ARRAY_SIZE(values)]);
+      invokeNode->setRet(0, values[0]);
+    }
+
+    cc.dec(counter);
+    cc.jnz(L_Loop);
+
+    for (uint32_t i = 1; i < ASMJIT_ARRAY_SIZE(values); i++)
+      cc.xor_(values[0], values[i]);
+
+    cc.ret(values[0]);
+    cc.endFunc();
+
+    prevFunc = func;
+  }
+
+  ASMJIT_PROPAGATE(cc.finalize());
+
+  BaseRAPass* pass = static_cast<BaseRAPass*>(cc.passByName("BaseRAPass"));
+  *usedThreadCount = pass ? pass->lastThreadCount() : 0;
+  return kErrorOk;
+}
+
+UNIT(x86_compiler_ra_threads) {
+  const uint32_t kFuncCount = 24;
+
+  CodeHolder serial;
+  uint32_t usedThreadCount;
+  EXPECT(Compiler_compileTestFunctions(serial, kFuncCount, 1, &usedThreadCount) == kErrorOk);
+  EXPECT(usedThreadCount == 1);
+
+  for (uint32_t threadCount = 2; threadCount <= 8; threadCount *= 2) {
+    INFO("Checking whether %u threads emit the same code as the serial register allocator", threadCount);
+
+    CodeHolder concurrent;
+    EXPECT(Compiler_compileTestFunctions(concurrent, kFuncCount, threadCount, &usedThreadCount) == kErrorOk);
+    EXPECT(usedThreadCount == threadCount,
+           "Register allocator used %u threads instead of %u", usedThreadCount, threadCount);
+
+    const CodeBuffer& a = serial.textSection()->buffer();
+    const CodeBuffer& b = concurrent.textSection()->buffer();
+
+    EXPECT(a.size() == b.size());
+    EXPECT(memcmp(a.data(), b.data(), a.size()) == 0);
+  }
+}
+#endif
+
 ASMJIT_END_SUB_NAMESPACE
 
 #endif // !ASMJIT_NO_X86 && !ASMJIT_NO_COMPILER
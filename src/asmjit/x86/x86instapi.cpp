@@ -922,6 +922,10 @@ Error InstInternal::queryRWInfo(uint32_t arch, const BaseInst& inst, const Opera
           op.addOpFlags(OpRWInfo::kMemBaseRead);
         if (memOp.hasIndexReg() && !(op.opFlags() & OpRWInfo::kMemIndexRW))
           op.addOpFlags(OpRWInfo::kMemIndexRead);
+
+        // LEA only uses the memory operand to calculate an address.
+        if (instId == Inst::kIdLea)
+          op.addOpFlags(OpRWInfo::kMemFake);
       }
     }
 
@@ -1645,6 +1649,177 @@ Error InstInternal::queryFeatures(uint32_t arch, const BaseInst& inst, const Ope
 }
 #endif // !ASMJIT_NO_INTROSPECTION
 
+// ============================================================================
+// [asmjit::x86::InstInternal - QuerySchedInfo]
+// ============================================================================
+
+#ifndef ASMJIT_NO_INTROSPECTION
+//! Latency of an instruction that is not a single cycle operation.
+struct SchedLatencyData {
+  uint16_t instId;
+  uint16_t latency;
+};
+
+// Approximate latencies of register forms on recent Intel and AMD cores. The
+// table must be sorted by instruction id, all other instructions take 1 cycle.
+static const SchedLatencyData schedLatencyData[] = {
+  { Inst::kIdAddpd, 4 },         { Inst::kIdAddps, 4 },         { Inst::kIdAddsd, 4 },
+  { Inst::kIdAddss, 4 },         { Inst::kIdAddsubpd, 4 },      { Inst::kIdAddsubps, 4 },
+  { Inst::kIdBsf, 3 },           { Inst::kIdBsr, 3 },           { Inst::kIdCrc32, 3 },
+  { Inst::kIdCvtdq2pd, 4 },      { Inst::kIdCvtdq2ps, 4 },      { Inst::kIdCvtpd2dq, 4 },
+  { Inst::kIdCvtpd2ps, 4 },      { Inst::kIdCvtps2dq, 4 },      { Inst::kIdCvtps2pd, 4 },
+  { Inst::kIdCvtsd2ss, 4 },      { Inst::kIdCvtss2sd, 4 },      { Inst::kIdCvttpd2dq, 4 },
+  { Inst::kIdCvttps2dq, 4 },     { Inst::kIdDivpd, 14 },        { Inst::kIdDivps, 11 },
+  { Inst::kIdDivsd, 14 },        { Inst::kIdDivss, 11 },        { Inst::kIdDppd, 9 },
+  { Inst::kIdDpps, 13 },         { Inst::kIdHaddpd, 4 },        { Inst::kIdHaddps, 4 },
+  { Inst::kIdHsubpd, 4 },        { Inst::kIdHsubps, 4 },        { Inst::kIdImul, 3 },
+  { Inst::kIdLzcnt, 3 },         { Inst::kIdMaxpd, 4 },         { Inst::kIdMaxps, 4 },
+  { Inst::kIdMaxsd, 4 },         { Inst::kIdMaxss, 4 },         { Inst::kIdMinpd, 4 },
+  { Inst::kIdMinps, 4 },         { Inst::kIdMinsd, 4 },         { Inst::kIdMinss, 4 },
+  { Inst::kIdMulpd, 4 },         { Inst::kIdMulps, 4 },         { Inst::kIdMulsd, 4 },
+  { Inst::kIdMulss, 4 },         { Inst::kIdPdep, 3 },          { Inst::kIdPext, 3 },
+  { Inst::kIdPmaddubsw, 5 },     { Inst::kIdPmaddwd, 5 },       { Inst::kIdPmuldq, 5 },
+  { Inst::kIdPmulhrsw, 5 },      { Inst::kIdPmulhuw, 5 },       { Inst::kIdPmulhw, 5 },
+  { Inst::kIdPmulld, 10 },       { Inst::kIdPmullw, 5 },        { Inst::kIdPmuludq, 5 },
+  { Inst::kIdPopcnt, 3 },        { Inst::kIdRcpps, 4 },         { Inst::kIdRcpss, 4 },
+  { Inst::kIdRoundpd, 8 },       { Inst::kIdRoundps, 8 },       { Inst::kIdRoundsd, 8 },
+  { Inst::kIdRoundss, 8 },       { Inst::kIdRsqrtps, 4 },       { Inst::kIdRsqrtss, 4 },
+  { Inst::kIdSqrtpd, 18 },       { Inst::kIdSqrtps, 12 },       { Inst::kIdSqrtsd, 18 },
+  { Inst::kIdSqrtss, 12 },       { Inst::kIdSubpd, 4 },         { Inst::kIdSubps, 4 },
+  { Inst::kIdSubsd, 4 },         { Inst::kIdSubss, 4 },         { Inst::kIdTzcnt, 3 },
+  { Inst::kIdVaddpd, 4 },        { Inst::kIdVaddps, 4 },        { Inst::kIdVaddsd, 4 },
+  { Inst::kIdVaddss, 4 },        { Inst::kIdVaddsubpd, 4 },     { Inst::kIdVaddsubps, 4 },
+  { Inst::kIdVcvtdq2pd, 4 },     { Inst::kIdVcvtdq2ps, 4 },     { Inst::kIdVcvtpd2dq, 4 },
+  { Inst::kIdVcvtpd2ps, 4 },     { Inst::kIdVcvtps2dq, 4 },     { Inst::kIdVcvtps2pd, 4 },
+  { Inst::kIdVcvtsd2ss, 4 },     { Inst::kIdVcvtss2sd, 4 },     { Inst::kIdVcvttpd2dq, 4 },
+  { Inst::kIdVcvttps2dq, 4 },    { Inst::kIdVdivpd, 14 },       { Inst::kIdVdivps, 11 },
+  { Inst::kIdVdivsd, 14 },       { Inst::kIdVdivss, 11 },       { Inst::kIdVdppd, 9 },
+  { Inst::kIdVdpps, 13 },        { Inst::kIdVfmadd132pd, 4 },   { Inst::kIdVfmadd132ps, 4 },
+  { Inst::kIdVfmadd132sd, 4 },   { Inst::kIdVfmadd132ss, 4 },   { Inst::kIdVfmadd213pd, 4 },
+  { Inst::kIdVfmadd213ps, 4 },   { Inst::kIdVfmadd213sd, 4 },   { Inst::kIdVfmadd213ss, 4 },
+  { Inst::kIdVfmadd231pd, 4 },   { Inst::kIdVfmadd231ps, 4 },   { Inst::kIdVfmadd231sd, 4 },
+  { Inst::kIdVfmadd231ss, 4 },   { Inst::kIdVfmsub132pd, 4 },   { Inst::kIdVfmsub132ps, 4 },
+  { Inst::kIdVfmsub132sd, 4 },   { Inst::kIdVfmsub132ss, 4 },   { Inst::kIdVfmsub213pd, 4 },
+  { Inst::kIdVfmsub213ps, 4 },   { Inst::kIdVfmsub213sd, 4 },   { Inst::kIdVfmsub213ss, 4 },
+  { Inst::kIdVfmsub231pd, 4 },   { Inst::kIdVfmsub231ps, 4 },   { Inst::kIdVfmsub231sd, 4 },
+  { Inst::kIdVfmsub231ss, 4 },   { Inst::kIdVfnmadd132pd, 4 },  { Inst::kIdVfnmadd132ps, 4 },
+  { Inst::kIdVfnmadd132sd, 4 },  { Inst::kIdVfnmadd132ss, 4 },  { Inst::kIdVfnmadd213pd, 4 },
+  { Inst::kIdVfnmadd213ps, 4 },  { Inst::kIdVfnmadd213sd, 4 },  { Inst::kIdVfnmadd213ss, 4 },
+  { Inst::kIdVfnmadd231pd, 4 },  { Inst::kIdVfnmadd231ps, 4 },  { Inst::kIdVfnmadd231sd, 4 },
+  { Inst::kIdVfnmadd231ss, 4 },  { Inst::kIdVfnmsub132pd, 4 },  { Inst::kIdVfnmsub132ps, 4 },
+  { Inst::kIdVfnmsub132sd, 4 },  { Inst::kIdVfnmsub132ss, 4 },  { Inst::kIdVfnmsub213pd, 4 },
+  { Inst::kIdVfnmsub213ps, 4 },  { Inst::kIdVfnmsub213sd, 4 },  { Inst::kIdVfnmsub213ss, 4 },
+  { Inst::kIdVfnmsub231pd, 4 },  { Inst::kIdVfnmsub231ps, 4 },  { Inst::kIdVfnmsub231sd, 4 },
+  { Inst::kIdVfnmsub231ss, 4 },  { Inst::kIdVhaddpd, 4 },       { Inst::kIdVhaddps, 4 },
+  { Inst::kIdVhsubpd, 4 },       { Inst::kIdVhsubps, 4 },       { Inst::kIdVmaxpd, 4 },
+  { Inst::kIdVmaxps, 4 },        { Inst::kIdVmaxsd, 4 },        { Inst::kIdVmaxss, 4 },
+  { Inst::kIdVminpd, 4 },        { Inst::kIdVminps, 4 },        { Inst::kIdVminsd, 4 },
+  { Inst::kIdVminss, 4 },        { Inst::kIdVmulpd, 4 },        { Inst::kIdVmulps, 4 },
+  { Inst::kIdVmulsd, 4 },        { Inst::kIdVmulss, 4 },        { Inst::kIdVpmaddubsw, 5 },
+  { Inst::kIdVpmaddwd, 5 },      { Inst::kIdVpmuldq, 5 },       { Inst::kIdVpmulhrsw, 5 },
+  { Inst::kIdVpmulhuw, 5 },      { Inst::kIdVpmulhw, 5 },       { Inst::kIdVpmulld, 10 },
+  { Inst::kIdVpmullw, 5 },       { Inst::kIdVpmuludq, 5 },      { Inst::kIdVrcpps, 4 },
+  { Inst::kIdVrcpss, 4 },        { Inst::kIdVroundpd, 8 },      { Inst::kIdVroundps, 8 },
+  { Inst::kIdVroundsd, 8 },      { Inst::kIdVroundss, 8 },      { Inst::kIdVrsqrtps, 4 },
+  { Inst::kIdVrsqrtss, 4 },      { Inst::kIdVsqrtpd, 18 },      { Inst::kIdVsqrtps, 12 },
+  { Inst::kIdVsqrtsd, 18 },      { Inst::kIdVsqrtss, 12 },      { Inst::kIdVsubpd, 4 },
+  { Inst::kIdVsubps, 4 },        { Inst::kIdVsubsd, 4 },        { Inst::kIdVsubss, 4 }
+};
+
+// Latency added to instructions that read a memory operand (L1 hit).
+static constexpr uint32_t kSchedLoadLatency = 5;
+
+static uint32_t schedLatencyOf(uint32_t instId) noexcept {
+  size_t lo = 0;
+  size_t hi = ASMJIT_ARRAY_SIZE(schedLatencyData);
+
+  while (lo < hi) {
+    size_t mid = (lo + hi) / 2u;
+    uint32_t midId = schedLatencyData[mid].instId;
+
+    if (midId == instId)
+      return schedLatencyData[mid].latency;
+
+    if (midId < instId)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  return 1;
+}
+
+#ifndef ASMJIT_NO_VALIDATION
+// Implicit operands are not part of `InstRWInfo` so instructions that can have
+// them (MUL, DIV, CDQ, CMPXCHG, string instructions, ...) are never moved. Only
+// signatures that have the same number of explicit operands are considered, so
+// for example two and three operand IMUL can be moved, but not one operand IMUL.
+static bool schedHasImplicitOperands(const InstDB::CommonInfo& commonInfo, size_t opCount) noexcept {
+  for (const InstDB::InstSignature* sig = commonInfo.signatureData(); sig != commonInfo.signatureEnd(); sig++)
+    if (sig->implicit && size_t(sig->opCount - sig->implicit) == opCount)
+      return true;
+  return false;
+}
+#endif
+
+Error InstInternal::querySchedInfo(uint32_t arch, const BaseInst& inst, const Operand_* operands, size_t opCount, InstSchedInfo* out) noexcept {
+  // Only called when `arch` matches X86 family.
+  DebugUtils::unused(arch);
+  ASMJIT_ASSERT(Environment::isFamilyX86(arch));
+
+  uint32_t instId = inst.id();
+  if (ASMJIT_UNLIKELY(!Inst::isDefinedId(instId)))
+    return DebugUtils::errored(kErrorInvalidInstruction);
+
+  const InstDB::CommonInfo& commonInfo = InstDB::infoById(instId).commonInfo();
+  out->reset();
+
+  // Instructions without operands are either fences or they have implicit
+  // operands (CPUID, RDTSC, VZEROUPPER, ...), FPU and MMX instructions share
+  // a state that is not tracked by registers, string and stack instructions
+  // implicitly use and modify registers and memory, and prefixed instructions
+  // have side effects that must be kept in order.
+  if (!opCount ||
+      commonInfo.controlType() != BaseInst::kControlNone ||
+      commonInfo.isFpu() ||
+      commonInfo.isMmx() ||
+      (commonInfo.hasRepPrefix() && !commonInfo.isRepIgnored()) ||
+      instId == Inst::kIdPush || instId == Inst::kIdPop || instId == Inst::kIdEnter ||
+      inst.hasOption(Inst::kOptionLock | Inst::kOptionRep | Inst::kOptionRepne | Inst::kOptionXAcquire | Inst::kOptionXRelease)) {
+    out->addFlags(InstSchedInfo::kFlagBarrier);
+    return kErrorOk;
+  }
+
+#ifndef ASMJIT_NO_VALIDATION
+  while (opCount && operands[opCount - 1].isNone())
+    opCount--;
+
+  if (schedHasImplicitOperands(commonInfo, opCount)) {
+    out->addFlags(InstSchedInfo::kFlagBarrier);
+    return kErrorOk;
+  }
+#else
+  // Implicit operands cannot be checked without instruction signatures.
+  out->addFlags(InstSchedInfo::kFlagBarrier);
+  return kErrorOk;
+#endif
+
+  uint32_t latency = schedLatencyOf(instId);
+
+  // The first operand is the destination of loads, a memory operand there
+  // means a store (or read-modify-write), which result is not waited for.
+  for (size_t i = 1; i < opCount; i++) {
+    if (operands[i].isMem() && instId != Inst::kIdLea) {
+      latency += kSchedLoadLatency;
+      break;
+    }
+  }
+
+  out->setLatency(latency);
+  return kErrorOk;
+}
+#endif // !ASMJIT_NO_INTROSPECTION
+
 // ============================================================================
 // [asmjit::x86::InstInternal - Unit]
 // ============================================================================
@@ -0,0 +1,211 @@
+// AsmJit - Machine code generation for C++
+//
+//  * Official AsmJit Home Page: https://asmjit.com
+//  * Official Github Repository: https://github.com/asmjit/asmjit
+//
+// Copyright (c) 2008-2020 The AsmJit Authors
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#include "../core/api-build_p.h"
+#if !defined(ASMJIT_NO_X86) && !defined(ASMJIT_NO_BUILDER)
+
+#include "../x86/x86instdb_p.h"
+#include "../x86/x86operand.h"
+#include "../x86/x86peepholepass.h"
+
+ASMJIT_BEGIN_SUB_NAMESPACE(x86)
+
+// ============================================================================
+// [asmjit::x86::PeepholePass - Helpers]
+// ============================================================================
+
+// Tests whether writing `reg` has no effect other than writing its value. This
+// is not the case of 32-bit GP registers in 64-bit mode, which are zero extended.
+static ASMJIT_INLINE bool PeepholePass_isPlainGpWrite(const BaseBuilder* cb, const Operand& op) noexcept {
+  return op.isReg() && op.as<Reg>().isGp() && !(cb->is64Bit() && op.as<Reg>().type() == Reg::kTypeGpd);
+}
+
+static ASMJIT_INLINE bool PeepholePass_isSameReg(const Operand& a, const Operand& b) noexcept {
+  return a.isReg() && b.isReg() && a.as<BaseReg>().isSame(b.as<BaseReg>());
+}
+
+#ifndef ASMJIT_NO_INTROSPECTION
+// Tests whether CPU `flags` written by `node` are overwritten before they are
+// read. Only the straight-line code that follows `node` is checked, the flags
+// are considered live if a jump, label, or any other node is found first.
+static bool PeepholePass_areFlagsDead(const BaseBuilder* cb, const InstNode* node, uint32_t flags) noexcept {
+  const BaseNode* next = node->next();
+
+  while (next) {
+    if (!next->isComment()) {
+      if (next->type() != BaseNode::kNodeInst)
+        return false;
+
+      const InstNode* inst = next->as<InstNode>();
+      if (InstDB::infoById(inst->id()).commonInfo().controlType() != BaseInst::kControlNone)
+        return false;
+
+      InstRWInfo rwInfo;
+      if (InstAPI::queryRWInfo(cb->arch(), inst->baseInst(), inst->operands(), inst->opCount(), &rwInfo) != kErrorOk)
+        return false;
+
+      if (rwInfo.readFlags() & flags)
+        return false;
+
+      flags &= ~rwInfo.writeFlags();
+      if (!flags)
+        return true;
+    }
+    next = next->next();
+  }
+
+  return false;
+}
+#endif
+
+// ============================================================================
+// [asmjit::x86::PeepholePass - Construction / Destruction]
+// ============================================================================
+
+PeepholePass::PeepholePass() noexcept
+  : BasePeepholePass("X86PeepholePass") {}
+PeepholePass::~PeepholePass() noexcept {}
+
+// ============================================================================
+// [asmjit::x86::PeepholePass - Peephole Interface]
+// ============================================================================
+
+uint32_t PeepholePass::jumpTypeOf(const InstNode* node) const noexcept {
+  uint32_t opCount = node->opCount();
+  if (!opCount || !node->op(opCount - 1).isLabel())
+    return kJumpNone;
+
+  uint32_t instId = node->id();
+  if (instId == Inst::kIdJmp)
+    return kJumpUnconditional;
+
+  // JECXZ only has an 8-bit displacement, it cannot be retargeted safely.
+  if (instId == Inst::kIdJecxz)
+    return kJumpNone;
+
+  // JA..JZ range contains only conditional jumps (including JECXZ) and JMP.
+  if (instId >= Inst::kIdJa && instId <= Inst::kIdJz)
+    return kJumpConditional;
+
+  return kJumpNone;
+}
+
+bool PeepholePass::isRedundantInst(const InstNode* node, uint32_t* ruleOut) const noexcept {
+  const uint32_t kPrefixOptions = Inst::kOptionLock     |
+                                  Inst::kOptionRep      |
+                                  Inst::kOptionRepne    |
+                                  Inst::kOptionXAcquire |
+                                  Inst::kOptionXRelease ;
+
+  if (node->opCount() != 2 || node->hasExtraReg() || (node->instOptions() & kPrefixOptions))
+    return false;
+
+  const Operand& o0 = node->op(0);
+  const Operand& o1 = node->op(1);
+
+  switch (node->id()) {
+    case Inst::kIdMov:
+      if (PeepholePass_isPlainGpWrite(_cb, o0) && PeepholePass_isSameReg(o0, o1)) {
+        *ruleOut = kRuleRedundantMove;
+        return true;
+      }
+      return false;
+
+    // Legacy SSE instructions don't modify bits above 127, VEX encoded moves
+    // would clear them, so they are not redundant.
+    case Inst::kIdMovaps:
+    case Inst::kIdMovapd:
+    case Inst::kIdMovups:
+    case Inst::kIdMovupd:
+    case Inst::kIdMovdqa:
+    case Inst::kIdMovdqu:
+      if (Reg::isXmm(o0) && PeepholePass_isSameReg(o0, o1)) {
+        *ruleOut = kRuleRedundantMove;
+        return true;
+      }
+      return false;
+
+    // Shifts and rotations by zero don't modify any register or flag. The
+    // count is masked to 5 bits, or 6 bits if the operand is 64-bit.
+    case Inst::kIdShl:
+    case Inst::kIdShr:
+    case Inst::kIdSar:
+    case Inst::kIdRol:
+    case Inst::kIdRor: {
+      if (!PeepholePass_isPlainGpWrite(_cb, o0) || !o1.isImm())
+        return false;
+
+      uint64_t countMask = o0.as<Reg>().size() == 8 ? 0x3Fu : 0x1Fu;
+      if ((o1.as<Imm>().valueAs<uint64_t>() & countMask) != 0)
+        return false;
+
+      *ruleOut = kRuleIdentityOp;
+      return true;
+    }
+
+#ifndef ASMJIT_NO_INTROSPECTION
+    case Inst::kIdAdd:
+    case Inst::kIdSub:
+    case Inst::kIdOr:
+    case Inst::kIdXor:
+    case Inst::kIdAnd: {
+      if (!PeepholePass_isPlainGpWrite(_cb, o0) || !o1.isImm())
+        return false;
+
+      uint64_t sizeMask = Support::lsbMask<uint64_t>(o0.as<Reg>().size() * 8u);
+      uint64_t identity = node->id() == Inst::kIdAnd ? sizeMask : uint64_t(0);
+
+      if ((o1.as<Imm>().valueAs<uint64_t>() & sizeMask) != identity)
+        return false;
+
+      InstRWInfo rwInfo;
+      if (InstAPI::queryRWInfo(_cb->arch(), node->baseInst(), node->operands(), node->opCount(), &rwInfo) != kErrorOk)
+        return false;
+
+      if (!PeepholePass_areFlagsDead(_cb, node, rwInfo.writeFlags()))
+        return false;
+
+      *ruleOut = kRuleIdentityOp;
+      return true;
+    }
+#endif
+
+    default:
+      return false;
+  }
+}
+
+// ============================================================================
+// [asmjit::x86::PeepholePass - Run]
+// ============================================================================
+
+Error PeepholePass::run(Zone* zone, Logger* logger) {
+  if (!Environment::isFamilyX86(_cb->arch()))
+    return DebugUtils::errored(kErrorInvalidArch);
+
+  return Base::run(zone, logger);
+}
+
+ASMJIT_END_SUB_NAMESPACE
+
+#endif // !ASMJIT_NO_X86 && !ASMJIT_NO_BUILDER
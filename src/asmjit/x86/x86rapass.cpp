@@ -85,6 +85,29 @@ static ASMJIT_INLINE uint32_t raMemIndexRwFlags(uint32_t flags) noexcept {
   return raUseOutFlagsFromRWFlags((flags >> shift) & OpRWInfo::kRW);
 }
 
+//! Tests whether `instId` copies the whole content of its source register to its destination register.
+static ASMJIT_INLINE bool raIsRegMove(uint32_t instId) noexcept {
+  switch (instId) {
+    case Inst::kIdMov:
+    case Inst::kIdMovapd:
+    case Inst::kIdMovaps:
+    case Inst::kIdMovdqa:
+    case Inst::kIdMovdqu:
+    case Inst::kIdMovupd:
+    case Inst::kIdMovups:
+    case Inst::kIdVmovapd:
+    case Inst::kIdVmovaps:
+    case Inst::kIdVmovdqa:
+    case Inst::kIdVmovdqu:
+    case Inst::kIdVmovupd:
+    case Inst::kIdVmovups:
+      return true;
+
+    default:
+      return false;
+  }
+}
+
 // ============================================================================
 // [asmjit::x86::RACFGBuilder]
 // ============================================================================
@@ -269,6 +292,7 @@ Error RACFGBuilder::onInst(InstNode* inst, uint32_t& controlType, RAInstBuilder&
           if (mem.isRegHome()) {
             RAWorkReg* workReg;
             ASMJIT_PROPAGATE(_pass->virtIndexAsWorkReg(Operand::virtIdToIndex(mem.baseId()), &workReg));
+            workReg->addFlags(RAWorkReg::kFlagStackReferenced);
             _pass->getOrCreateStackSlot(workReg);
           }
           else if (mem.hasBaseReg()) {
@@ -426,6 +450,29 @@ Error RACFGBuilder::onInst(InstNode* inst, uint32_t& controlType, RAInstBuilder&
       }
     }
 
+    // Register to register copy of the whole register is a candidate for coalescing.
+    if (ib.tiedRegCount() == 2 && opCount == 2 && !inst->hasExtraReg() && raIsRegMove(instId)) {
+      const Operand& dst = opArray[0];
+      const Operand& src = opArray[1];
+
+      if (dst.isReg() && src.isReg() && dst.signature() == src.signature()) {
+        const RAWorkReg* dstWorkReg = _pass->workRegById(ib[0]->workId());
+        const RAWorkReg* srcWorkReg = _pass->workRegById(ib[1]->workId());
+
+        if (dstWorkReg->signature() == dst.signature() && srcWorkReg->signature() == src.signature())
+          ib.addAggregatedFlags(RAInst::kFlagIsMove);
+      }
+    }
+
+    // MOV reg, imm and LEA reg, [label] define the register from constants without
+    // changing flags, so they can be emitted again instead of reloading the register.
+    if (ib.tiedRegCount() == 1 && opCount == 2 && !inst->hasExtraReg() && ib[0]->isWriteOnly() && opArray[0].isReg()) {
+      const Operand& src = opArray[1];
+      if ((instId == Inst::kIdMov && src.isImm()) ||
+          (instId == Inst::kIdLea && src.isMem() && src.as<Mem>().hasBaseLabel() && !src.as<Mem>().hasIndex()))
+        ib.addAggregatedFlags(RAInst::kFlagIsRematerializable);
+    }
+
     controlType = instInfo.controlType();
   }
 
@@ -1180,6 +1227,10 @@ void X86RAPass::onInit() noexcept {
 
 void X86RAPass::onDone() noexcept {}
 
+BaseRAPass* X86RAPass::newWorker(Zone* zone) noexcept {
+  return zone->newT<X86RAPass>();
+}
+
 // ============================================================================
 // [asmjit::x86::X86RAPass - BuildCFG]
 // ============================================================================
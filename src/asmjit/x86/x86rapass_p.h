@@ -89,6 +89,7 @@ public:
 
   void onInit() noexcept override;
   void onDone() noexcept override;
+  BaseRAPass* newWorker(Zone* zone) noexcept override;
 
   // --------------------------------------------------------------------------
   // [CFG]
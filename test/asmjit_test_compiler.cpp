@@ -77,6 +77,11 @@ int TestApp::handleArgs(int argc, const char* const* argv) {
   if (cmd.hasArg("--verbose")) _verbose = true;
   if (cmd.hasArg("--dump-asm")) _dumpAsm = true;
   if (cmd.hasArg("--dump-hex")) _dumpHex = true;
+  if (cmd.hasArg("--linear-scan")) _linearScan = true;
+  if (cmd.hasArg("--sched")) _sched = true;
+  if (cmd.hasArg("--peephole")) _peephole = true;
+  if (cmd.hasArg("--relax")) _relax = true;
+  if (cmd.hasArg("--sparse-liveness")) _sparseLiveness = true;
 
   return 0;
 }
@@ -90,6 +95,11 @@ void TestApp::showInfo() {
   printf("  [%s] Verbose (use --verbose to turn verbose output ON)\n", _verbose ? "x" : " ");
   printf("  [%s] DumpAsm (use --dump-asm to turn assembler dumps ON)\n", _dumpAsm ? "x" : " ");
   printf("  [%s] DumpHex (use --dump-hex to dump binary in hexadecimal)\n", _dumpHex ? "x" : " ");
+  printf("  [%s] LinearScan (use --linear-scan to use the linear-scan register allocator)\n", _linearScan ? "x" : " ");
+  printf("  [%s] Sched (use --sched to schedule instructions after register allocation)\n", _sched ? "x" : " ");
+  printf("  [%s] Peephole (use --peephole to run the peephole optimizer after register allocation)\n", _peephole ? "x" : " ");
+  printf("  [%s] Relax (use --relax to encode jumps with 8-bit displacement where possible)\n", _relax ? "x" : " ");
+  printf("  [%s] SparseLiveness (use --sparse-liveness to use sparse liveness in all functions)\n", _sparseLiveness ? "x" : " ");
   printf("\n");
 }
 
@@ -149,6 +159,27 @@ int TestApp::run() {
     arm::Compiler cc(&code);
 #endif
 
+    if (_linearScan)
+      cc.setRAAllocator(BaseCompiler::kRAAllocatorLinearScan);
+
+    if (_sparseLiveness)
+      cc.setRAMaxDenseLiveBits(0);
+
+#if !defined(ASMJIT_NO_X86) && ASMJIT_ARCH_X86
+    if (_peephole)
+      cc.addPassT<x86::PeepholePass>();
+#endif
+
+#ifndef ASMJIT_NO_INTROSPECTION
+    if (_sched)
+      cc.addPassT<SchedPass>();
+#endif
+
+#if !defined(ASMJIT_NO_X86) && ASMJIT_ARCH_X86
+    if (_relax)
+      cc.addPassT<x86::BranchRelaxPass>();
+#endif
+
     perfTimer.start();
     test->compile(cc);
     perfTimer.stop();
@@ -84,6 +84,11 @@ public:
   bool _verbose = false;
   bool _dumpAsm = false;
   bool _dumpHex = false;
+  bool _linearScan = false;
+  bool _sched = false;
+  bool _peephole = false;
+  bool _relax = false;
+  bool _sparseLiveness = false;
 
   TestApp() noexcept {}
   ~TestApp() noexcept {}
@@ -59,6 +59,77 @@ public:
   virtual void compile(x86::Compiler& cc) = 0;
 };
 
+// Test case that inspects the code generated by `compile()` in `run()`, used by
+// tests that verify the quality of the register allocation. It remembers the
+// compiler, the tested function, and the label of the tested loop.
+class X86InspectTestCase : public X86TestCase {
+public:
+  const x86::Compiler* _cc = nullptr;
+  FuncNode* _funcNode = nullptr;
+  uint32_t _loopLabelId = Globals::kInvalidId;
+
+  X86InspectTestCase(const char* name = nullptr)
+    : X86TestCase(name) {}
+
+  FuncNode* addTestedFunc(x86::Compiler& cc, const FuncSignature& signature) {
+    _cc = &cc;
+    _funcNode = cc.addFunc(signature);
+    return _funcNode;
+  }
+
+  Label newLoopLabel(x86::Compiler& cc) {
+    Label label = cc.newLabel();
+    _loopLabelId = label.id();
+    return label;
+  }
+
+  inline bool is64Bit() const { return _cc->is64Bit(); }
+  inline uint32_t localStackSize() const { return _funcNode->frame().localStackSize(); }
+
+  // Sums `pred` of instructions between the loop label and the first jump back
+  // to it.
+  template<typename Predicate>
+  uint32_t countInLoop(const Predicate& pred) const {
+    uint32_t count = 0;
+    bool inLoop = false;
+
+    for (BaseNode* node = _cc->firstNode(); node; node = node->next()) {
+      if (node->isLabel() && node->as<LabelNode>()->labelId() == _loopLabelId)
+        inLoop = true;
+
+      if (inLoop && node->isInst()) {
+        const InstNode* inst = node->as<InstNode>();
+        count += uint32_t(pred(inst));
+
+        for (uint32_t i = 0; i < inst->opCount(); i++)
+          if (inst->op(i).isLabel() && inst->op(i).id() == _loopLabelId)
+            return count;
+      }
+    }
+
+    return count;
+  }
+
+  // Returns the number of stack accesses in the loop (spills and reloads).
+  uint32_t stackAccessesInLoop() const {
+    return countInLoop([](const InstNode* inst) {
+      uint32_t n = 0;
+      for (uint32_t i = 0; i < inst->opCount(); i++) {
+        const Operand& op = inst->op(i);
+        n += uint32_t(op.isMem() && op.as<x86::Mem>().hasBaseReg() && op.as<x86::Mem>().baseId() == x86::Gp::kIdSp);
+      }
+      return n;
+    });
+  }
+
+  // Returns the number of register to register moves in the loop.
+  uint32_t regMovesInLoop() const {
+    return countInLoop([](const InstNode* inst) {
+      return inst->id() == x86::Inst::kIdMov && inst->opCount() == 2 && inst->op(0).isReg() && inst->op(1).isReg();
+    });
+  }
+};
+
 // ============================================================================
 // [X86Test_AlignBase]
 // ============================================================================
@@ -2340,6 +2411,597 @@ public:
   }
 };
 
+// ============================================================================
+// [X86Test_AllocLoopSpills]
+// ============================================================================
+
+// Creates more virtual registers than available while a loop-carried counter
+// has only a few uses in a long loop. Registers used outside of the loop must
+// be spilled instead of the loop counter (verified in 64-bit mode only, 32-bit
+// mode doesn't have enough registers to keep the loop itself spill-free).
+class X86Test_AllocLoopSpills : public X86InspectTestCase {
+public:
+  X86Test_AllocLoopSpills() : X86InspectTestCase("AllocLoopSpills") {}
+
+  enum {
+    kOuterCount = 8,
+    kInnerCount = 6,
+    kRounds = 6,
+    kIterations = 10
+  };
+
+  static void add(TestApp& app) {
+    app.add(new X86Test_AllocLoopSpills());
+  }
+
+  virtual void compile(x86::Compiler& cc) {
+    // Checks the quality of the default allocator even if another one was selected.
+    cc.setRAAllocator(BaseCompiler::kRAAllocatorBinPack);
+
+    addTestedFunc(cc, FuncSignatureT<int, int, const int*>(CallConv::kIdHost));
+
+    x86::Gp n = cc.newInt32("n");
+    x86::Gp p = cc.newIntPtr("p");
+    x86::Gp acc = cc.newInt32("acc");
+    x86::Gp counter = cc.newInt32("counter");
+
+    cc.setArg(0, n);
+    cc.setArg(1, p);
+
+    uint32_t i, r;
+    x86::Gp o[kOuterCount];
+    x86::Gp t[kInnerCount];
+
+    // Variables used heavily outside of the loop, but live across it.
+    for (i = 0; i < kOuterCount; i++) {
+      o[i] = cc.newInt32("o%u", i);
+      cc.mov(o[i], int(i + 1));
+    }
+
+    for (r = 0; r < kRounds; r++)
+      for (i = 0; i < kOuterCount; i++)
+        cc.add(o[i], o[(i + 1) % kOuterCount]);
+
+    Label L_Loop = newLoopLabel(cc);
+
+    cc.xor_(acc, acc);
+    cc.mov(counter, n);
+    cc.bind(L_Loop);
+
+    for (i = 0; i < kInnerCount; i++) {
+      t[i] = cc.newInt32("t%u", i);
+      cc.mov(t[i], x86::dword_ptr(p, int(i * 4)));
+    }
+
+    for (r = 0; r < 4; r++)
+      for (i = 0; i < kInnerCount; i++)
+        cc.add(t[i], t[(i + 1) % kInnerCount]);
+
+    for (i = 0; i < kInnerCount; i++)
+      cc.add(acc, t[i]);
+
+    cc.dec(counter);
+    cc.jnz(L_Loop);
+
+    for (r = 0; r < kRounds; r++)
+      for (i = 0; i < kOuterCount; i++)
+        cc.add(o[i], o[(i + 1) % kOuterCount]);
+
+    for (i = 0; i < kOuterCount; i++)
+      cc.add(acc, o[i]);
+
+    cc.ret(acc);
+    cc.endFunc();
+  }
+
+  virtual bool run(void* _func, String& result, String& expect) {
+    typedef int (*Func)(int, const int*);
+    Func func = ptr_as_func<Func>(_func);
+
+    static const int data[kInnerCount] = { 1, 2, 3, 4, 5, 6 };
+    uint32_t i, r;
+    uint32_t o[kOuterCount];
+    uint32_t t[kInnerCount];
+    uint32_t acc = 0;
+
+    for (i = 0; i < kOuterCount; i++)
+      o[i] = i + 1;
+
+    for (r = 0; r < kRounds; r++)
+      for (i = 0; i < kOuterCount; i++)
+        o[i] += o[(i + 1) % kOuterCount];
+
+    for (uint32_t n = 0; n < kIterations; n++) {
+      for (i = 0; i < kInnerCount; i++)
+        t[i] = uint32_t(data[i]);
+
+      for (r = 0; r < 4; r++)
+        for (i = 0; i < kInnerCount; i++)
+          t[i] += t[(i + 1) % kInnerCount];
+
+      for (i = 0; i < kInnerCount; i++)
+        acc += t[i];
+    }
+
+    for (r = 0; r < kRounds; r++)
+      for (i = 0; i < kOuterCount; i++)
+        o[i] += o[(i + 1) % kOuterCount];
+
+    for (i = 0; i < kOuterCount; i++)
+      acc += o[i];
+
+    int resultRet = func(kIterations, data);
+    int expectRet = int(acc);
+
+    uint32_t resultSpills = is64Bit() ? stackAccessesInLoop() : 0;
+    uint32_t expectSpills = 0;
+
+    result.assignFormat("ret=%d, spillsInLoop=%u", resultRet, resultSpills);
+    expect.assignFormat("ret=%d, spillsInLoop=%u", expectRet, expectSpills);
+
+    return result == expect;
+  }
+};
+
+// ============================================================================
+// [X86Test_AllocLoopSplit]
+// ============================================================================
+
+// Values used within a loop are live across a region with more live registers
+// than available, so they cannot have a home register for their whole lifetime.
+// Their live ranges must be split so they stay in registers within the loop and
+// get reloaded before it (verified in 64-bit mode only).
+class X86Test_AllocLoopSplit : public X86InspectTestCase {
+public:
+  X86Test_AllocLoopSplit() : X86InspectTestCase("AllocLoopSplit") {}
+
+  enum {
+    kCoeffCount = 6,
+    kTmpCount = 12,
+    kIterations = 10
+  };
+
+  static void add(TestApp& app) {
+    app.add(new X86Test_AllocLoopSplit());
+  }
+
+  virtual void compile(x86::Compiler& cc) {
+    cc.setRAAllocator(BaseCompiler::kRAAllocatorBinPack);
+
+    addTestedFunc(cc, FuncSignatureT<int, int, const int*>(CallConv::kIdHost));
+
+    x86::Gp n = cc.newInt32("n");
+    x86::Gp p = cc.newIntPtr("p");
+    x86::Gp acc = cc.newInt32("acc");
+    x86::Gp counter = cc.newInt32("counter");
+    x86::Gp v = cc.newInt32("v");
+
+    cc.setArg(0, n);
+    cc.setArg(1, p);
+
+    uint32_t i, r;
+    x86::Gp c[kCoeffCount];
+    x86::Gp t[kTmpCount];
+
+    // Coefficients live across the whole function, used mostly by the loop.
+    for (i = 0; i < kCoeffCount; i++) {
+      c[i] = cc.newInt32("c%u", i);
+      cc.mov(c[i], x86::dword_ptr(p, int(i * 4)));
+    }
+
+    // A region with high register pressure before the loop.
+    cc.xor_(acc, acc);
+    for (i = 0; i < kTmpCount; i++) {
+      t[i] = cc.newInt32("t%u", i);
+      cc.mov(t[i], x86::dword_ptr(p, int(i * 4 + 4)));
+    }
+
+    for (r = 0; r < 6; r++)
+      for (i = 0; i < kTmpCount; i++)
+        cc.add(t[i], t[(i + 1) % kTmpCount]);
+
+    for (i = 0; i < kTmpCount; i++)
+      cc.add(acc, t[i]);
+
+    Label L_Loop = newLoopLabel(cc);
+
+    cc.mov(counter, n);
+    cc.bind(L_Loop);
+    cc.mov(v, x86::dword_ptr(p));
+
+    for (i = 0; i < kCoeffCount; i++) {
+      cc.imul(v, c[i]);
+      cc.add(v, c[i]);
+    }
+
+    cc.add(acc, v);
+    cc.dec(counter);
+    cc.jnz(L_Loop);
+
+    for (i = 0; i < kCoeffCount; i++)
+      cc.add(acc, c[i]);
+
+    cc.ret(acc);
+    cc.endFunc();
+  }
+
+  virtual bool run(void* _func, String& result, String& expect) {
+    typedef int (*Func)(int, const int*);
+    Func func = ptr_as_func<Func>(_func);
+
+    int data[kTmpCount + 1];
+    uint32_t i, r;
+
+    for (i = 0; i < kTmpCount + 1; i++)
+      data[i] = int(i * 3 + 1);
+
+    uint32_t t[kTmpCount];
+    uint32_t acc = 0;
+
+    for (i = 0; i < kTmpCount; i++)
+      t[i] = uint32_t(data[i + 1]);
+
+    for (r = 0; r < 6; r++)
+      for (i = 0; i < kTmpCount; i++)
+        t[i] += t[(i + 1) % kTmpCount];
+
+    for (i = 0; i < kTmpCount; i++)
+      acc += t[i];
+
+    for (uint32_t n = 0; n < kIterations; n++) {
+      uint32_t v = uint32_t(data[0]);
+      for (i = 0; i < kCoeffCount; i++) {
+        v *= uint32_t(data[i]);
+        v += uint32_t(data[i]);
+      }
+      acc += v;
+    }
+
+    for (i = 0; i < kCoeffCount; i++)
+      acc += uint32_t(data[i]);
+
+    int resultRet = func(kIterations, data);
+    int expectRet = int(acc);
+
+    uint32_t resultSpills = is64Bit() ? stackAccessesInLoop() : 0;
+    uint32_t expectSpills = 0;
+
+    result.assignFormat("ret=%d, spillsInLoop=%u", resultRet, resultSpills);
+    expect.assignFormat("ret=%d, spillsInLoop=%u", expectRet, expectSpills);
+
+    return result == expect;
+  }
+};
+
+// ============================================================================
+// [X86Test_AllocCoalesce]
+// ============================================================================
+
+// A loop body that copies a value through a chain of virtual registers. The
+// copies don't interfere with each other, so the register allocator coalesces
+// them and the loop body must not contain any register to register move.
+class X86Test_AllocCoalesce : public X86InspectTestCase {
+public:
+  X86Test_AllocCoalesce() : X86InspectTestCase("AllocCoalesce") {}
+
+  enum {
+    kChainLength = 6,
+    kIterations = 10
+  };
+
+  static void add(TestApp& app) {
+    app.add(new X86Test_AllocCoalesce());
+  }
+
+  virtual void compile(x86::Compiler& cc) {
+    cc.setRAAllocator(BaseCompiler::kRAAllocatorBinPack);
+
+    addTestedFunc(cc, FuncSignatureT<int, int, const int*>(CallConv::kIdHost));
+
+    x86::Gp n = cc.newInt32("n");
+    x86::Gp p = cc.newIntPtr("p");
+    x86::Gp acc = cc.newInt32("acc");
+
+    cc.setArg(0, n);
+    cc.setArg(1, p);
+
+    Label L_Loop = newLoopLabel(cc);
+
+    cc.xor_(acc, acc);
+    cc.bind(L_Loop);
+
+    x86::Gp prev = cc.newInt32("v0");
+    cc.mov(prev, x86::dword_ptr(p));
+
+    for (uint32_t i = 1; i < kChainLength; i++) {
+      x86::Gp v = cc.newInt32("v%u", i);
+      cc.mov(v, prev);
+      cc.add(v, int(i));
+      prev = v;
+    }
+
+    cc.add(acc, prev);
+    cc.dec(n);
+    cc.jnz(L_Loop);
+
+    cc.ret(acc);
+    cc.endFunc();
+  }
+
+  virtual bool run(void* _func, String& result, String& expect) {
+    typedef int (*Func)(int, const int*);
+    Func func = ptr_as_func<Func>(_func);
+
+    int data[1] = { 7 };
+    uint32_t acc = 0;
+
+    for (uint32_t n = 0; n < kIterations; n++) {
+      uint32_t v = uint32_t(data[0]);
+      for (uint32_t i = 1; i < kChainLength; i++)
+        v += i;
+      acc += v;
+    }
+
+    int resultRet = func(kIterations, data);
+    int expectRet = int(acc);
+
+    uint32_t resultMoves = regMovesInLoop();
+    uint32_t expectMoves = 0;
+
+    result.assignFormat("ret=%d, movesInLoop=%u", resultRet, resultMoves);
+    expect.assignFormat("ret=%d, movesInLoop=%u", expectRet, expectMoves);
+
+    return result == expect;
+  }
+};
+
+// ============================================================================
+// [X86Test_AllocRemat]
+// ============================================================================
+
+// Constants are live across a region with more live registers than available.
+// They are defined by `mov reg, imm` so the register allocator must recreate
+// them instead of spilling them, which means that the function doesn't need
+// any local stack (verified in 64-bit mode only).
+class X86Test_AllocRemat : public X86InspectTestCase {
+public:
+  X86Test_AllocRemat() : X86InspectTestCase("AllocRemat") {}
+
+  enum {
+    kConstCount = 6,
+    kTmpCount = 12
+  };
+
+  static void add(TestApp& app) {
+    app.add(new X86Test_AllocRemat());
+  }
+
+  virtual void compile(x86::Compiler& cc) {
+    addTestedFunc(cc, FuncSignatureT<int, const int*>(CallConv::kIdHost));
+
+    x86::Gp p = cc.newIntPtr("p");
+    x86::Gp acc = cc.newInt32("acc");
+
+    cc.setArg(0, p);
+
+    uint32_t i, r;
+    x86::Gp k[kConstCount];
+    x86::Gp t[kTmpCount];
+
+    for (i = 0; i < kConstCount; i++) {
+      k[i] = cc.newInt32("k%u", i);
+      cc.mov(k[i], int(1000 + i * 7));
+    }
+
+    cc.xor_(acc, acc);
+    cc.add(acc, k[0]);
+
+    // A region with high register pressure, constants are not used here.
+    for (i = 0; i < kTmpCount; i++) {
+      t[i] = cc.newInt32("t%u", i);
+      cc.mov(t[i], x86::dword_ptr(p, int(i * 4)));
+    }
+
+    for (r = 0; r < 6; r++)
+      for (i = 0; i < kTmpCount; i++)
+        cc.add(t[i], t[(i + 1) % kTmpCount]);
+
+    for (i = 0; i < kTmpCount; i++)
+      cc.add(acc, t[i]);
+
+    for (i = 0; i < kConstCount; i++)
+      cc.imul(acc, k[i]);
+
+    cc.ret(acc);
+    cc.endFunc();
+  }
+
+  virtual bool run(void* _func, String& result, String& expect) {
+    typedef int (*Func)(const int*);
+    Func func = ptr_as_func<Func>(_func);
+
+    int data[kTmpCount];
+    uint32_t i, r;
+
+    for (i = 0; i < kTmpCount; i++)
+      data[i] = int(i * 3 + 1);
+
+    uint32_t t[kTmpCount];
+    uint32_t acc = 1000;
+
+    for (i = 0; i < kTmpCount; i++)
+      t[i] = uint32_t(data[i]);
+
+    for (r = 0; r < 6; r++)
+      for (i = 0; i < kTmpCount; i++)
+        t[i] += t[(i + 1) % kTmpCount];
+
+    for (i = 0; i < kTmpCount; i++)
+      acc += t[i];
+
+    for (i = 0; i < kConstCount; i++)
+      acc *= uint32_t(1000 + i * 7);
+
+    int resultRet = func(data);
+    int expectRet = int(acc);
+
+    uint32_t resultStack = is64Bit() ? localStackSize() : 0;
+    uint32_t expectStack = 0;
+
+    result.assignFormat("ret=%d, localStack=%u", resultRet, resultStack);
+    expect.assignFormat("ret=%d, localStack=%u", expectRet, expectStack);
+
+    return result == expect;
+  }
+};
+
+// ============================================================================
+// [X86Test_AllocStackShare]
+// ============================================================================
+
+// Several independent phases, each having more live registers than available.
+// Registers of different phases never interfere, so their spill slots must share
+// memory and the local stack must be exactly as large as the stack used by the
+// phase that uses the most of it.
+class X86Test_AllocStackShare : public X86InspectTestCase {
+public:
+  X86Test_AllocStackShare() : X86InspectTestCase("AllocStackShare") {}
+
+  enum {
+    kPhaseCount = 4,
+    kTmpCount = 20
+  };
+
+  uint32_t _phaseLabelIds[kPhaseCount];
+
+  static void add(TestApp& app) {
+    app.add(new X86Test_AllocStackShare());
+  }
+
+  virtual void compile(x86::Compiler& cc) {
+    cc.setRAAllocator(BaseCompiler::kRAAllocatorBinPack);
+
+    addTestedFunc(cc, FuncSignatureT<int, const int*>(CallConv::kIdHost));
+
+    x86::Gp p = cc.newIntPtr("p");
+    x86::Gp acc = cc.newInt32("acc");
+
+    cc.setArg(0, p);
+    cc.xor_(acc, acc);
+
+    for (uint32_t phase = 0; phase < kPhaseCount; phase++) {
+      uint32_t i;
+      x86::Gp t[kTmpCount];
+
+      Label L_Phase = cc.newLabel();
+      _phaseLabelIds[phase] = L_Phase.id();
+      cc.bind(L_Phase);
+
+      for (i = 0; i < kTmpCount; i++) {
+        t[i] = cc.newInt32("t%u_%u", phase, i);
+        cc.mov(t[i], x86::dword_ptr(p, int(i * 4)));
+      }
+
+      for (i = 0; i < kTmpCount; i++)
+        cc.add(t[i], t[(i + phase + 1) % kTmpCount]);
+
+      for (i = 0; i < kTmpCount; i++)
+        cc.add(acc, t[i]);
+    }
+
+    cc.ret(acc);
+    cc.endFunc();
+  }
+
+  // Returns the number of bytes of the local stack accessed by each phase,
+  // which is the size of its simultaneously live spill set.
+  void phaseStackUsage(uint32_t out[kPhaseCount]) const {
+    uint64_t masks[kPhaseCount] {};
+    uint32_t phase = kPhaseCount;
+
+    for (BaseNode* node = _cc->firstNode(); node; node = node->next()) {
+      if (node->isLabel()) {
+        uint32_t labelId = node->as<LabelNode>()->labelId();
+        for (uint32_t i = 0; i < kPhaseCount; i++)
+          if (_phaseLabelIds[i] == labelId)
+            phase = i;
+      }
+
+      if (phase == kPhaseCount || !node->isInst())
+        continue;
+
+      const InstNode* inst = node->as<InstNode>();
+      for (uint32_t i = 0; i < inst->opCount(); i++) {
+        const Operand& op = inst->op(i);
+        if (!op.isMem())
+          continue;
+
+        const x86::Mem& m = op.as<x86::Mem>();
+        if (!m.hasBaseReg() || m.baseId() != x86::Gp::kIdSp)
+          continue;
+
+        // Track 4-byte units, which is the smallest slot size used here.
+        uint32_t first = uint32_t(m.offsetLo32()) / 4;
+        uint32_t last = (uint32_t(m.offsetLo32()) + Support::max<uint32_t>(m.size(), 4) - 1) / 4;
+        for (uint32_t unit = first; unit <= last && unit < 64; unit++)
+          masks[phase] |= uint64_t(1) << unit;
+      }
+    }
+
+    for (uint32_t i = 0; i < kPhaseCount; i++)
+      out[i] = Support::popcnt(masks[i]) * 4;
+  }
+
+  virtual bool run(void* _func, String& result, String& expect) {
+    typedef int (*Func)(const int*);
+    Func func = ptr_as_func<Func>(_func);
+
+    int data[kTmpCount];
+    uint32_t i;
+
+    for (i = 0; i < kTmpCount; i++)
+      data[i] = int(i * 5 + 3);
+
+    uint32_t acc = 0;
+    for (uint32_t phase = 0; phase < kPhaseCount; phase++) {
+      uint32_t t[kTmpCount];
+
+      for (i = 0; i < kTmpCount; i++)
+        t[i] = uint32_t(data[i]);
+
+      for (i = 0; i < kTmpCount; i++)
+        t[i] += t[(i + phase + 1) % kTmpCount];
+
+      for (i = 0; i < kTmpCount; i++)
+        acc += t[i];
+    }
+
+    int resultRet = func(data);
+    int expectRet = int(acc);
+
+    // Every phase must spill more than `acc`, otherwise there is nothing to
+    // share. Without sharing the phases would use disjoint slots and the local
+    // stack would be greater than the stack used by any single phase.
+    uint32_t phaseStack[kPhaseCount];
+    phaseStackUsage(phaseStack);
+
+    uint32_t maxPhaseStack = 0;
+    bool allSpill = true;
+
+    for (i = 0; i < kPhaseCount; i++) {
+      maxPhaseStack = Support::max(maxPhaseStack, phaseStack[i]);
+      allSpill &= phaseStack[i] > 4;
+    }
+
+    uint32_t localStack = localStackSize();
+
+    result.assignFormat("ret=%d, localStack=%u, allSpill=%c", resultRet, localStack, allSpill ? 'Y' : 'N');
+    expect.assignFormat("ret=%d, localStack=%u, allSpill=Y", expectRet, maxPhaseStack);
+
+    return result == expect;
+  }
+};
+
 // ============================================================================
 // [X86Test_FuncCallBase1]
 // ============================================================================
@@ -4283,6 +4945,11 @@ void compiler_add_x86_tests(TestApp& app) {
   app.addT<X86Test_AllocMemcpy>();
   app.addT<X86Test_AllocExtraBlock>();
   app.addT<X86Test_AllocAlphaBlend>();
+  app.addT<X86Test_AllocLoopSpills>();
+  app.addT<X86Test_AllocLoopSplit>();
+  app.addT<X86Test_AllocCoalesce>();
+  app.addT<X86Test_AllocRemat>();
+  app.addT<X86Test_AllocStackShare>();
 
   // Function call tests.
   app.addT<X86Test_FuncCallBase1>();
@@ -177,6 +177,336 @@ static uint32_t testFunc(JitRuntime& rt, uint32_t emitterType) noexcept {
   return !(out[0] == 5 && out[1] == 8 && out[2] == 4 && out[3] == 9);
 }
 
+static uint32_t testBatch(JitRuntime& rt) noexcept {
+  enum : uint32_t { kFuncCount = 100 };
+
+  printf("Using JitRuntime::addBatch() with %u functions:\n", unsigned(kFuncCount));
+
+  CodeHolder codes[kFuncCount];
+  CodeHolder* codePtrs[kFuncCount];
+  void* funcs[kFuncCount];
+
+  for (uint32_t i = 0; i < kFuncCount; i++) {
+    codes[i].init(rt.environment());
+    codePtrs[i] = &codes[i];
+
+    x86::Assembler a(&codes[i]);
+    a.mov(x86::eax, i);
+    a.ret();
+  }
+
+  Error err = rt.addBatch(funcs, codePtrs, kFuncCount);
+  if (err) {
+    printf("** FAILURE: JitRuntime::addBatch() failed (%s) **\n", DebugUtils::errorAsString(err));
+    return 1;
+  }
+
+  uint32_t nFailed = 0;
+  for (uint32_t i = 0; i < kFuncCount; i++) {
+    uint32_t result = ptr_as_func<uint32_t (*)(void)>(funcs[i])();
+    if (result != i)
+      nFailed++;
+  }
+
+  // Each function must be releasable individually.
+  for (uint32_t i = 0; i < kFuncCount; i++) {
+    if (rt.release(funcs[i]) != kErrorOk)
+      nFailed++;
+  }
+
+  printf("Result = %u of %u functions returned the expected value\n\n", unsigned(kFuncCount - nFailed), unsigned(kFuncCount));
+  return nFailed != 0;
+}
+
+// Counts instruction cache flushes to verify they are deferred and merged.
+class FlushCountingRuntime : public JitRuntime {
+public:
+  uint32_t flushCount = 0;
+
+  void flush(const void* p, size_t size) noexcept override {
+    flushCount++;
+    JitRuntime::flush(p, size);
+  }
+};
+
+static uint32_t testPublication() noexcept {
+  enum : uint32_t { kFuncCount = 100 };
+
+  printf("Using JitRuntime::beginPublication() and commit() with %u functions:\n", unsigned(kFuncCount));
+
+  FlushCountingRuntime rt;
+  uint32_t (*funcs[kFuncCount])(void);
+
+  if (rt.beginPublication() != kErrorOk || rt.beginPublication() != kErrorInvalidState) {
+    printf("** FAILURE: JitRuntime::beginPublication() failed **\n");
+    return 1;
+  }
+
+  uint32_t nFailed = 0;
+  for (uint32_t i = 0; i < kFuncCount; i++) {
+    CodeHolder code;
+    code.init(rt.environment());
+
+    x86::Assembler a(&code);
+    a.mov(x86::eax, i);
+    a.ret();
+
+    if (rt.add(&funcs[i], &code) != kErrorOk) {
+      funcs[i] = nullptr;
+      nFailed++;
+    }
+  }
+
+  if (rt.flushCount != 0) {
+    printf("** FAILURE: JitRuntime flushed %u times while the publication window was open **\n", unsigned(rt.flushCount));
+    nFailed++;
+  }
+
+  if (rt.commit() != kErrorOk || rt.commit() != kErrorInvalidState) {
+    printf("** FAILURE: JitRuntime::commit() failed **\n");
+    return 1;
+  }
+
+  // All functions were allocated from the same block, so the adjacent ranges must have been merged.
+  printf("Flushed %u merged ranges\n", unsigned(rt.flushCount));
+  if (rt.flushCount == 0 || rt.flushCount >= kFuncCount)
+    nFailed++;
+
+  for (uint32_t i = 0; i < kFuncCount; i++) {
+    if (!funcs[i])
+      continue;
+
+    if (funcs[i]() != i)
+      nFailed++;
+    rt.release(funcs[i]);
+  }
+
+  printf("Result = %u of %u functions returned the expected value\n\n", unsigned(kFuncCount - nFailed), unsigned(kFuncCount));
+  return nFailed != 0;
+}
+
+static uint32_t testBatchedProtection() noexcept {
+  enum : uint32_t { kFuncCount = 100 };
+
+  printf("Using JitRuntime with kOptionUseBatchedProtection and %u functions:\n", unsigned(kFuncCount));
+
+  JitAllocator::CreateParams params {};
+  params.options = JitAllocator::kOptionUseBatchedProtection;
+
+  JitRuntime rt(&params);
+  uint32_t (*funcs[kFuncCount])(void);
+  uint32_t nFailed = 0;
+
+  // The first half is protected by each add(), the second half by commit().
+  for (uint32_t i = 0; i < kFuncCount; i++) {
+    if (i == kFuncCount / 2)
+      rt.beginPublication();
+
+    CodeHolder code;
+    code.init(rt.environment());
+
+    x86::Assembler a(&code);
+    a.mov(x86::eax, i);
+    a.ret();
+
+    if (rt.add(&funcs[i], &code) != kErrorOk) {
+      funcs[i] = nullptr;
+      nFailed++;
+    }
+  }
+
+  if (rt.commit() != kErrorOk)
+    nFailed++;
+
+  for (uint32_t i = 0; i < kFuncCount; i++) {
+    if (!funcs[i])
+      continue;
+
+    if (funcs[i]() != i)
+      nFailed++;
+    rt.release(funcs[i]);
+  }
+
+  printf("Result = %u of %u functions returned the expected value\n\n", unsigned(kFuncCount - nFailed), unsigned(kFuncCount));
+  return nFailed != 0;
+}
+
+// Relocates moved functions by using the CodeHolder each function was created from.
+class CodeMoveHandler : public JitAllocator::MoveHandler {
+public:
+  CodeHolder* _codes;
+  void** _funcs;
+  uint32_t _count;
+
+  CodeMoveHandler(CodeHolder* codes, void** funcs, uint32_t count) noexcept
+    : _codes(codes),
+      _funcs(funcs),
+      _count(count) {}
+
+  bool canMove(void* roPtr, size_t size) noexcept override {
+    (void)size;
+    return indexOf(roPtr) != _count;
+  }
+
+  Error relocate(const JitAllocator::Move& move) noexcept override {
+    uint32_t index = indexOf(move.oldRo);
+    CodeHolder& code = _codes[index];
+
+    ASMJIT_PROPAGATE(code.relocateToBase(uint64_t(uintptr_t(move.newRo))));
+    ASMJIT_PROPAGATE(code.copyFlattenedData(move.newRw, move.size, CodeHolder::kCopyPadSectionBuffer));
+
+    _funcs[index] = move.newRo;
+    return kErrorOk;
+  }
+
+  uint32_t indexOf(void* func) const noexcept {
+    uint32_t i = 0;
+    while (i < _count && _funcs[i] != func)
+      i++;
+    return i;
+  }
+};
+
+static uint32_t testCompaction() noexcept {
+  enum : uint32_t { kFuncCount = 1500 };
+
+  printf("Using JitAllocator::compact() with %u functions:\n", unsigned(kFuncCount));
+
+  // Use a large granularity so the functions occupy multiple blocks.
+  JitAllocator::CreateParams params {};
+  params.granularity = 256;
+
+  JitRuntime rt(&params);
+  CodeHolder* codes = new CodeHolder[kFuncCount];
+  void* funcs[kFuncCount];
+  uint32_t nFailed = 0;
+
+  // Each function returns its own address read from an absolute address, so it must be relocated when moved.
+  for (uint32_t i = 0; i < kFuncCount; i++) {
+    codes[i].init(rt.environment());
+
+    x86::Assembler a(&codes[i]);
+    Label entry = a.newLabel();
+    Label data = a.newLabel();
+
+    a.bind(entry);
+    a.mov(a.zax(), x86::ptr(data));
+    a.ret();
+    a.bind(data);
+    a.embedLabel(entry);
+
+    if (rt.add(&funcs[i], &codes[i]) != kErrorOk) {
+      funcs[i] = nullptr;
+      nFailed++;
+    }
+  }
+
+  // Keep every 10th function.
+  for (uint32_t i = 0; i < kFuncCount; i++) {
+    if (i % 10 != 0 && funcs[i]) {
+      rt.release(funcs[i]);
+      funcs[i] = nullptr;
+    }
+  }
+
+  CodeMoveHandler handler(codes, funcs, kFuncCount);
+  JitAllocator::CompactResult result;
+
+  if (rt.allocator()->compact(&handler, &result) != kErrorOk)
+    nFailed++;
+
+  printf("Moved %zu functions, released %zu blocks\n", result.movedCount(), result.releasedBlockCount());
+  if (result.releasedBlockCount() == 0)
+    nFailed++;
+
+  for (uint32_t i = 0; i < kFuncCount; i++) {
+    if (!funcs[i])
+      continue;
+
+    rt.flush(funcs[i], codes[i].codeSize());
+    if (ptr_as_func<void* (*)(void)>(funcs[i])() != funcs[i])
+      nFailed++;
+    rt.release(funcs[i]);
+  }
+
+  delete[] codes;
+
+  printf("Result = %s\n\n", nFailed ? "Failed" : "Ok");
+  return nFailed != 0;
+}
+
+static uint32_t testZeroCopy(uint32_t allocatorOptions) noexcept {
+  printf("Using JitRuntime::attachZeroCopyBuffer() (options=0x%08X):\n", unsigned(allocatorOptions));
+
+  JitAllocator::CreateParams params {};
+  params.options = allocatorOptions;
+
+  JitRuntime rt(&params);
+  uint32_t nFailed = 0;
+
+  // The function returns its own address, so it must be relocated in place.
+  {
+    CodeHolder code;
+    code.init(rt.environment());
+
+    if (rt.attachZeroCopyBuffer(&code, 4096) != kErrorOk)
+      return 1;
+
+    void* rw = code.textSection()->data();
+    x86::Assembler a(&code);
+    Label entry = a.newLabel();
+    Label data = a.newLabel();
+
+    a.bind(entry);
+    a.mov(a.zax(), x86::ptr(data));
+    a.ret();
+    a.bind(data);
+    a.embedLabel(entry);
+
+    void* (*func)(void);
+    if (rt.add(&func, &code) != kErrorOk)
+      return 1;
+
+    // The function must be in the memory it was emitted to.
+    void* ro;
+    size_t size;
+    if (rt.allocator()->queryRW(rw, &ro, &size) != kErrorOk || ro != (void*)func || size >= 4096)
+      nFailed++;
+
+    if (code.textSection()->bufferSize() != 0)
+      nFailed++;
+
+    if (func() != (void*)func)
+      nFailed++;
+    rt.release(func);
+  }
+
+  // Emitting more than the capacity must fail, the buffer must be released by detach.
+  {
+    CodeHolder code;
+    code.init(rt.environment());
+
+    if (rt.attachZeroCopyBuffer(&code, 16) != kErrorOk)
+      return 1;
+
+    x86::Assembler a(&code);
+    for (uint32_t i = 0; i < 16; i++)
+      a.mov(x86::eax, i);
+
+    if (a.mov(x86::eax, 0) != kErrorTooLarge)
+      nFailed++;
+
+    if (rt.detachZeroCopyBuffer(&code) != kErrorOk)
+      nFailed++;
+  }
+
+  if (rt.allocator()->statistics().usedSize() != 0)
+    nFailed++;
+
+  printf("Result = %s\n\n", nFailed ? "Failed" : "Ok");
+  return nFailed != 0;
+}
+
 int main() {
   printf("AsmJit Emitters Test-Suite v%u.%u.%u\n",
     unsigned((ASMJIT_LIBRARY_VERSION >> 16)       ),
@@ -197,6 +527,13 @@ int main() {
   nFailed += testFunc(rt, BaseEmitter::kTypeCompiler);
 #endif
 
+  nFailed += testBatch(rt);
+  nFailed += testPublication();
+  nFailed += testBatchedProtection();
+  nFailed += testCompaction();
+  nFailed += testZeroCopy(0);
+  nFailed += testZeroCopy(JitAllocator::kOptionUseDualMapping);
+
   if (!nFailed)
     printf("** SUCCESS **\n");
   else
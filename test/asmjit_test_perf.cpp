@@ -27,9 +27,48 @@
 #include <string.h>
 
 #include "cmdline.h"
+#include "performancetimer.h"
 
 using namespace asmjit;
 
+// Creates, populates, and destroys `count` CodeHolders, which is dominated by
+// zone block allocations when `ZoneBlockPool` is disabled.
+static double benchmarkCodeHolderInitReset(uint32_t count, bool usePool) noexcept {
+  ZoneBlockPool::setEnabled(usePool);
+  ZoneBlockPool::resetStatistics();
+
+  PerformanceTimer timer;
+  timer.start();
+
+  for (uint32_t i = 0; i < count; i++) {
+    CodeHolder code;
+    code.init(hostEnvironment());
+
+    LabelEntry* le;
+    for (uint32_t j = 0; j < 256; j++)
+      code.newLabelEntry(&le);
+
+    Section* section;
+    code.newSection(&section, ".data", SIZE_MAX, 0, 8);
+  }
+
+  timer.stop();
+  return timer.duration();
+}
+
+static void benchmarkZoneBlockPool(uint32_t numIterations) noexcept {
+  printf("CodeHolder init/reset (with and without ZoneBlockPool):\n");
+
+  double withoutPool = benchmarkCodeHolderInitReset(numIterations, false);
+  printf("  [Core] %-9s %-16s | Time:%8.4f [ms]\n", "Code", "[no-pool]", withoutPool);
+
+  double withPool = benchmarkCodeHolderInitReset(numIterations, true);
+  ZoneBlockPool::Statistics stats = ZoneBlockPool::statistics();
+  printf("  [Core] %-9s %-16s | Time:%8.4f [ms] | Hits:%zu | Misses:%zu\n", "Code", "[pool]", withPool, stats.hitCount(), stats.missCount());
+
+  printf("\n");
+}
+
 #if !defined(ASMJIT_NO_X86)
 void benchmarkX86Emitters(uint32_t numIterations, bool testX86, bool testX64) noexcept;
 #endif
@@ -57,6 +96,8 @@ int main(int argc, char* argv[]) {
 
   const char* arch = cmdLine.valueOf("--arch", "all");
 
+  benchmarkZoneBlockPool(numIterations);
+
 #if !defined(ASMJIT_NO_X86)
   bool testX86 = strcmp(arch, "all") == 0 || strcmp(arch, "x86") == 0;
   bool testX64 = strcmp(arch, "all") == 0 || strcmp(arch, "x64") == 0;
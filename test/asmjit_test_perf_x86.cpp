@@ -29,6 +29,7 @@
 #include <limits>
 #include <stdio.h>
 #include <string.h>
+#include <vector>
 
 #include "asmjit_test_misc.h"
 #include "asmjit_test_perf.h"
@@ -4958,6 +4959,12 @@ static void benchmarkX86Function(uint32_t arch, uint32_t numIterations, const ch
     emitterFn(cc, true);
     cc.finalize();
   });
+
+  bench<x86::Builder>(code, arch, numIterations, "[relaxed]", [&](x86::Builder& cc) {
+    cc.addPassT<x86::BranchRelaxPass>();
+    emitterFn(cc, true);
+    cc.finalize();
+  });
 #endif
 
 #ifndef ASMJIT_NO_COMPILER
@@ -4969,8 +4976,242 @@ static void benchmarkX86Function(uint32_t arch, uint32_t numIterations, const ch
     emitterFn(cc, true);
     cc.finalize();
   });
+
+  bench<x86::Compiler>(code, arch, numIterations, "[linear-scan]", [&](x86::Compiler& cc) {
+    cc.setRAAllocator(BaseCompiler::kRAAllocatorLinearScan);
+    emitterFn(cc, true);
+    cc.finalize();
+  });
+
+  bench<x86::Compiler>(code, arch, numIterations, "[relaxed]", [&](x86::Compiler& cc) {
+    cc.addPassT<x86::BranchRelaxPass>();
+    emitterFn(cc, true);
+    cc.finalize();
+  });
+#endif
+
+  printf("\n");
+}
+
+#ifndef ASMJIT_NO_COMPILER
+// Generates nested loops that keep more values alive than there are registers,
+// which makes the register allocator the dominant part of `finalize()`.
+static void generateRegPressure(x86::Compiler& cc, uint32_t valueCount) {
+  using namespace asmjit::x86;
+
+  cc.addFunc(FuncSignatureT<int, int, const int*>(CallConv::kIdHost));
+
+  Gp n = cc.newInt32("n");
+  Gp p = cc.newIntPtr("p");
+  Gp i = cc.newInt32("i");
+  Gp j = cc.newInt32("j");
+
+  cc.setArg(0, n);
+  cc.setArg(1, p);
+
+  std::vector<Gp> values;
+  for (uint32_t k = 0; k < valueCount; k++) {
+    values.push_back(cc.newInt32("v%u", k));
+    cc.mov(values[k], dword_ptr(p, int32_t(k * 4u)));
+  }
+
+  Label L_Outer = cc.newLabel();
+  Label L_Inner = cc.newLabel();
+
+  cc.mov(i, n);
+  cc.bind(L_Outer);
+  cc.mov(j, n);
+  cc.bind(L_Inner);
+
+  for (uint32_t k = 1; k < valueCount; k++) {
+    cc.add(values[k], values[k - 1]);
+    cc.xor_(values[k - 1], dword_ptr(p, int32_t(k * 4u)));
+  }
+
+  cc.dec(j);
+  cc.jnz(L_Inner);
+
+  for (uint32_t k = 0; k < valueCount; k += 2)
+    cc.imul(values[k], values[valueCount - 1 - k]);
+
+  cc.dec(i);
+  cc.jnz(L_Outer);
+
+  for (uint32_t k = 1; k < valueCount; k++)
+    cc.add(values[0], values[k]);
+
+  cc.ret(values[0]);
+  cc.endFunc();
+}
+
+// Generates a function of `blockCount` blocks, each using `tempsPerBlock`
+// registers that are local to the block and a few that are live across all
+// of them, which stresses the liveness analysis of large functions.
+static void generateLargeFunction(x86::Compiler& cc, uint32_t blockCount, uint32_t tempsPerBlock) {
+  using namespace asmjit::x86;
+
+  cc.addFunc(FuncSignatureT<int, int, const int*>(CallConv::kIdHost));
+
+  Gp n = cc.newInt32("n");
+  Gp p = cc.newIntPtr("p");
+  Gp acc[4];
+
+  cc.setArg(0, n);
+  cc.setArg(1, p);
+
+  for (uint32_t k = 0; k < ASMJIT_ARRAY_SIZE(acc); k++) {
+    acc[k] = cc.newInt32("acc%u", k);
+    cc.mov(acc[k], n);
+  }
+
+  for (uint32_t b = 0; b < blockCount; b += 2) {
+    Label L_Skip = cc.newLabel();
+
+    for (uint32_t k = 0; k < tempsPerBlock; k++) {
+      Gp t = cc.newInt32("t%u_%u", b, k);
+      cc.mov(t, dword_ptr(p, int32_t(k * 4u)));
+      cc.add(t, acc[k % 4]);
+      cc.xor_(acc[(k + 1) % 4], t);
+    }
+
+    cc.test(acc[0], 1);
+    cc.jz(L_Skip);
+    cc.add(acc[1], int32_t(b));
+    cc.bind(L_Skip);
+  }
+
+  for (uint32_t k = 1; k < ASMJIT_ARRAY_SIZE(acc); k++)
+    cc.add(acc[0], acc[k]);
+
+  cc.ret(acc[0]);
+  cc.endFunc();
+}
+
+// Compares compilation time and code size of register allocators.
+template<typename EmitterFn>
+static void benchmarkX86Allocators(uint32_t arch, uint32_t numIterations, const char* description, const EmitterFn& emitterFn) noexcept {
+  CodeHolder code;
+  printf("%s:\n", description);
+
+  bench<x86::Compiler>(code, arch, numIterations, "[bin-pack]", [&](x86::Compiler& cc) {
+    emitterFn(cc);
+    cc.finalize();
+  });
+
+  bench<x86::Compiler>(code, arch, numIterations, "[linear-scan]", [&](x86::Compiler& cc) {
+    cc.setRAAllocator(BaseCompiler::kRAAllocatorLinearScan);
+    emitterFn(cc);
+    cc.finalize();
+  });
+
+  printf("\n");
+}
 #endif
 
+// Binds many labels, each used by a jump that's resolved when the label is
+// bound, and leaves only a single cross-section link to be resolved by
+// `CodeHolder::resolveUnresolvedLinks()`, like finalizing a large module.
+static void generateManyLabels(x86::Assembler& a, uint32_t labelCount) {
+  using namespace asmjit::x86;
+
+  CodeHolder* code = a.code();
+  Section* farSection;
+  code->newSection(&farSection, ".far", SIZE_MAX, 0, 1);
+
+  Label L_Far = a.newLabel();
+  for (uint32_t i = 0; i < labelCount; i++) {
+    Label L = a.newLabel();
+    a.jnz(L);
+    a.inc(eax);
+    a.bind(L);
+  }
+  a.jmp(L_Far);
+
+  a.section(farSection);
+  a.bind(L_Far);
+  a.ret();
+}
+
+static void benchmarkX86Labels(uint32_t arch, uint32_t numIterations, uint32_t labelCount) noexcept {
+  CodeHolder code;
+  printf("ManyLabels<%u> (labels bound in place, a single cross-section link):\n", labelCount);
+
+  bench<x86::Assembler>(code, arch, numIterations, "[emit]", [&](x86::Assembler& a) {
+    generateManyLabels(a, labelCount);
+  });
+
+  bench<x86::Assembler>(code, arch, numIterations, "[resolved]", [&](x86::Assembler& a) {
+    generateManyLabels(a, labelCount);
+    code.flatten();
+    code.resolveUnresolvedLinks();
+  });
+
+  printf("\n");
+}
+
+// Emits a function that differs only in the `constant` loaded to EAX, so its
+// variants can be either assembled or cloned from a template and patched.
+static void generateSpecializedFunction(x86::Assembler& a, uint32_t constant, size_t* immOffset) {
+  a.mov(x86::eax, constant);
+  *immOffset = a.offset() - 4;
+  generateGpSequence(a, InstForm::kReg, true);
+}
+
+static void benchmarkX86Specialization(uint32_t arch, uint32_t numIterations) noexcept {
+  CodeHolder code;
+  printf("Specialization (GpSequence<Reg> variants that differ in a constant):\n");
+
+  bench<x86::Assembler>(code, arch, numIterations, "[assembled]", [&](x86::Assembler& a) {
+    size_t immOffset;
+    generateSpecializedFunction(a, 42, &immOffset);
+  });
+
+  // The template is assembled once, each variant is then a patched clone.
+  CodeHolder tmpl;
+  MyErrorHandler eh;
+
+  tmpl.init(Environment(arch));
+  tmpl.setErrorHandler(&eh);
+
+  size_t immOffset;
+  x86::Assembler a(&tmpl);
+  generateSpecializedFunction(a, 0, &immOffset);
+
+  OffsetFormat format;
+  format.resetToDataValue(4);
+
+  // CodeHolder functions don't report errors to the error handler, so fail
+  // the same way it would.
+  PatchPoint* pp = nullptr;
+  Error err = tmpl.newPatchPoint(&pp, 0, immOffset, format);
+  if (err) {
+    printf("ERROR: newPatchPoint() failed: %s\n", DebugUtils::errorAsString(err));
+    abort();
+  }
+
+  uint64_t codeSize = 0;
+  PerformanceTimer timer;
+  double duration = std::numeric_limits<double>::infinity();
+
+  for (uint32_t r = 0; r < numIterations; r++) {
+    timer.start();
+    err = tmpl.cloneInto(&code);
+    if (!err)
+      err = code.patch(pp->id(), 42);
+    timer.stop();
+
+    if (err) {
+      printf("ERROR: cloneInto() or patch() failed: %s\n", DebugUtils::errorAsString(err));
+      abort();
+    }
+
+    codeSize = code.codeSize();
+    duration = Support::min(duration, timer.duration());
+  }
+
+  printf("  [%s] %-9s %-16s | CodeSize:%5llu [B] | Time:%8.4f [ms] | Speed:%8.3f [MB/s]\n",
+    arch == Environment::kArchX86 ? "X86" : "X64", "Clone", "[patched]",
+    (unsigned long long)codeSize, duration, mbps(duration, codeSize));
   printf("\n");
 }
 
@@ -5045,6 +5286,35 @@ void benchmarkX86Emitters(uint32_t numIterations, bool testX86, bool testX64) {
       asmtest::generateSseAlphaBlend(emitter, emitPrologEpilog);
     });
   }
+
+  for (i = 0; i < n; i++)
+    benchmarkX86Labels(archs[i], Support::max<uint32_t>(numIterations / 1000, 1), 200000);
+
+  for (i = 0; i < n; i++)
+    benchmarkX86Specialization(archs[i], numIterations);
+
+#ifndef ASMJIT_NO_COMPILER
+  for (i = 0; i < n; i++) {
+    static const char description[] = "RegPressure<32> (nested loops with 32 live values)";
+    benchmarkX86Allocators(archs[i], numIterations, description, [](x86::Compiler& cc) {
+      generateRegPressure(cc, 32);
+    });
+  }
+
+  for (i = 0; i < n; i++) {
+    static const char description[] = "RegPressure<256> (nested loops with 256 live values)";
+    benchmarkX86Allocators(archs[i], numIterations / 10, description, [](x86::Compiler& cc) {
+      generateRegPressure(cc, 256);
+    });
+  }
+
+  for (i = 0; i < n; i++) {
+    static const char description[] = "LargeFunction<4000, 8> (4000 blocks, 16000 registers)";
+    benchmarkX86Allocators(archs[i], Support::max<uint32_t>(numIterations / 1000, 1), description, [](x86::Compiler& cc) {
+      generateLargeFunction(cc, 4000, 8);
+    });
+  }
+#endif
 }
 
 #endif // !ASMJIT_NO_X86